@@ -0,0 +1,27 @@
+-- Collect throughput numbers for a benchmark run and print them in a
+-- machine-readable form. Meant to be used through TOOLS/mpv-bench.sh,
+-- which runs mpv with --untimed --vo=null --ao=null and this script.
+--
+-- Output (one line per played file, on the terminal):
+--   BENCH file=<name> elapsed=<s> frames=<n> fps=<n> pipeline=<stats>
+
+local start_time = nil
+
+function mp_event(name, arg)
+    if name == "start" then
+        start_time = mp.get_timer()
+    elseif name == "end" and start_time ~= nil then
+        local elapsed = mp.get_timer() - start_time
+        local frames = tonumber(mp.property_get("vo-frame-count")) or 0
+        local fps = 0
+        if elapsed > 0 then
+            fps = frames / elapsed
+        end
+        local pipeline = mp.property_get("pipeline-stats") or ""
+        print(string.format("BENCH file=%s elapsed=%.3f frames=%d " ..
+                            "fps=%.2f pipeline='%s'",
+                            mp.property_get("filename") or "?",
+                            elapsed, frames, fps, pipeline))
+        start_time = nil
+    end
+end
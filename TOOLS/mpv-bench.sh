@@ -0,0 +1,28 @@
+#!/bin/sh
+# Run mpv headlessly over the given sample files, as fast as the pipeline
+# allows, and report throughput per file. This exercises the real demuxer,
+# decoder, and filter chain code paths; only output and timing are disabled.
+#
+# Usage: TOOLS/mpv-bench.sh [-m path/to/mpv] [extra mpv options --] file...
+#
+# Output lines look like:
+#   BENCH file=sample.mkv elapsed=4.223 frames=1440 fps=341.02 pipeline='...'
+# See TOOLS/lua/bench-stats.lua for the fields.
+
+set -e
+
+MPV=${MPV:-./build/mpv}
+TOOLS=$(dirname "$0")
+
+if [ "$1" = "-m" ]; then
+    MPV=$2
+    shift 2
+fi
+
+if [ $# -eq 0 ]; then
+    echo >&2 "usage: $0 [-m mpv] [mpv options --] file..."
+    exit 1
+fi
+
+"$MPV" --untimed --vo=null --ao=null --no-config --quiet --osd-level=0 \
+    --lua="$TOOLS/lua/bench-stats.lua" "$@" | grep '^BENCH '
@@ -27,6 +27,10 @@
 
 struct mp_audio_buffer {
     struct mp_audio *buffer;
+    // Skipped samples at the start of buffer's planes. Skipping only adjusts
+    // this offset, instead of moving the remaining data to the front each
+    // time; the data is compacted lazily when more write space is needed.
+    int offset;
 };
 
 struct mp_audio_buffer *mp_audio_buffer_create(void *talloc_ctx)
@@ -45,6 +49,7 @@ void mp_audio_buffer_reinit(struct mp_audio_buffer *ab, struct mp_audio *fmt)
     mp_audio_copy_config(ab->buffer, fmt);
     mp_audio_realloc(ab->buffer, 1);
     ab->buffer->samples = 0;
+    ab->offset = 0;
 }
 
 void mp_audio_buffer_reinit_fmt(struct mp_audio_buffer *ab, int format,
@@ -64,17 +69,43 @@ void mp_audio_buffer_get_format(struct mp_audio_buffer *ab,
     mp_audio_copy_config(out_fmt, ab->buffer);
 }
 
+// Resize the backing store to the next power of two >= samples, so that
+// fluctuating playback needs settle on a fixed allocation instead of
+// reallocating (and copying) repeatedly for small increments.
+static void buffer_realloc_min(struct mp_audio_buffer *ab, int samples)
+{
+    if (samples > mp_audio_get_allocated_size(ab->buffer)) {
+        int alloc = 1;
+        while (alloc < samples)
+            alloc *= 2;
+        mp_audio_realloc(ab->buffer, alloc);
+    }
+}
+
 // Make the total size of the internal buffer at least this number of samples.
 void mp_audio_buffer_preallocate_min(struct mp_audio_buffer *ab, int samples)
 {
-    mp_audio_realloc_min(ab->buffer, samples);
+    buffer_realloc_min(ab, samples);
+}
+
+// Move the not yet read data to the front of the allocation, so that the
+// space occupied by already skipped samples can be reused.
+static void compact(struct mp_audio_buffer *ab)
+{
+    if (!ab->offset)
+        return;
+    mp_audio_copy(ab->buffer, 0, ab->buffer, ab->offset,
+                  ab->buffer->samples - ab->offset);
+    ab->buffer->samples -= ab->offset;
+    ab->offset = 0;
 }
 
 // Get number of samples that can be written without forcing a resize of the
 // internal buffer.
 int mp_audio_buffer_get_write_available(struct mp_audio_buffer *ab)
 {
-    return mp_audio_get_allocated_size(ab->buffer) - ab->buffer->samples;
+    return mp_audio_get_allocated_size(ab->buffer)
+         - (ab->buffer->samples - ab->offset);
 }
 
 // Get a pointer to the end of the buffer (where writing would append). If the
@@ -85,7 +116,9 @@ void mp_audio_buffer_get_write_buffer(struct mp_audio_buffer *ab, int samples,
                                       struct mp_audio *out_buffer)
 {
     assert(samples >= 0);
-    mp_audio_realloc_min(ab->buffer, ab->buffer->samples + samples);
+    if (ab->buffer->samples + samples > mp_audio_get_allocated_size(ab->buffer))
+        compact(ab);
+    buffer_realloc_min(ab, ab->buffer->samples + samples);
     *out_buffer = *ab->buffer;
     out_buffer->samples = ab->buffer->samples + samples;
     mp_audio_skip_samples(out_buffer, ab->buffer->samples);
@@ -102,9 +135,12 @@ void mp_audio_buffer_finish_write(struct mp_audio_buffer *ab, int samples)
 // For now always copies the data.
 void mp_audio_buffer_append(struct mp_audio_buffer *ab, struct mp_audio *mpa)
 {
+    if (ab->buffer->samples + mpa->samples >
+        mp_audio_get_allocated_size(ab->buffer))
+        compact(ab);
     int offset = ab->buffer->samples;
     ab->buffer->samples += mpa->samples;
-    mp_audio_realloc_min(ab->buffer, ab->buffer->samples);
+    buffer_realloc_min(ab, ab->buffer->samples);
     mp_audio_copy(ab->buffer, offset, mpa, 0, mpa->samples);
 }
 
@@ -112,9 +148,16 @@ void mp_audio_buffer_append(struct mp_audio_buffer *ab, struct mp_audio *mpa)
 void mp_audio_buffer_prepend_silence(struct mp_audio_buffer *ab, int samples)
 {
     assert(samples >= 0);
+    if (samples <= ab->offset) {
+        // Reuse the already skipped space at the front.
+        ab->offset -= samples;
+        mp_audio_fill_silence(ab->buffer, ab->offset, samples);
+        return;
+    }
+    compact(ab);
     int oldlen = ab->buffer->samples;
     ab->buffer->samples += samples;
-    mp_audio_realloc_min(ab->buffer, ab->buffer->samples);
+    buffer_realloc_min(ab, ab->buffer->samples);
     mp_audio_copy(ab->buffer, samples, ab->buffer, 0, oldlen);
     mp_audio_fill_silence(ab->buffer, 0, samples);
 }
@@ -123,30 +166,35 @@ void mp_audio_buffer_prepend_silence(struct mp_audio_buffer *ab, int samples)
 void mp_audio_buffer_peek(struct mp_audio_buffer *ab, struct mp_audio *out_mpa)
 {
     *out_mpa = *ab->buffer;
+    mp_audio_skip_samples(out_mpa, ab->offset);
 }
 
 // Skip leading samples. (Used with mp_audio_buffer_peek() to read data.)
+// This is O(1); no data is copied.
 void mp_audio_buffer_skip(struct mp_audio_buffer *ab, int samples)
 {
-    assert(samples >= 0 && samples <= ab->buffer->samples);
-    mp_audio_copy(ab->buffer, 0, ab->buffer, samples,
-                  ab->buffer->samples - samples);
-    ab->buffer->samples -= samples;
+    assert(samples >= 0 && samples <= ab->buffer->samples - ab->offset);
+    ab->offset += samples;
+    if (ab->offset == ab->buffer->samples) {
+        ab->buffer->samples = 0;
+        ab->offset = 0;
+    }
 }
 
 void mp_audio_buffer_clear(struct mp_audio_buffer *ab)
 {
     ab->buffer->samples = 0;
+    ab->offset = 0;
 }
 
 // Return number of buffered audio samples
 int mp_audio_buffer_samples(struct mp_audio_buffer *ab)
 {
-    return ab->buffer->samples;
+    return ab->buffer->samples - ab->offset;
 }
 
 // Return amount of buffered audio in seconds.
 double mp_audio_buffer_seconds(struct mp_audio_buffer *ab)
 {
-    return ab->buffer->samples / (double)ab->buffer->rate;
+    return mp_audio_buffer_samples(ab) / (double)ab->buffer->rate;
 }
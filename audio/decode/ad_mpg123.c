@@ -314,23 +314,35 @@ static int decode_audio(struct dec_audio *da, struct mp_audio *buffer, int maxle
     if (!mp_audio_config_equals(&da->decoded, buffer))
         return 0;
 
-    size_t got_now = 0;
-    ret = mpg123_replace_buffer(con->handle, buf, maxlen * con->sample_size);
-    if (ret != MPG123_OK)
-        goto mpg123_fail;
+    /* Drain all frames libmpg123 has buffered in one go, instead of one
+     * frame per call. One frame is at most 1152 samples (see preinit()), so
+     * stop once the remaining space could not hold a full frame. */
+    int left = maxlen;
+    while (left >= 1152) {
+        size_t got_now = 0;
+        ret = mpg123_replace_buffer(con->handle, buf, left * con->sample_size);
+        if (ret != MPG123_OK)
+            goto mpg123_fail;
 
-    ret = mpg123_decode_frame(con->handle, NULL, NULL, &got_now);
+        ret = mpg123_decode_frame(con->handle, NULL, NULL, &got_now);
 
-    int got_samples = got_now / con->sample_size;
-    buffer->samples += got_samples;
-    da->pts_offset += got_samples;
+        int got_samples = got_now / con->sample_size;
+        buffer->samples += got_samples;
+        da->pts_offset += got_samples;
+        buf = (char *)buf + got_now;
+        left -= got_samples;
 
-    if (ret == MPG123_NEW_FORMAT) {
-        con->new_format = true;
-    } else if (ret == MPG123_NEED_MORE) {
-        con->need_data = true;
-    } else if (ret != MPG123_OK && ret != MPG123_DONE) {
-        goto mpg123_fail;
+        if (ret == MPG123_NEW_FORMAT) {
+            con->new_format = true;
+            break;
+        } else if (ret == MPG123_NEED_MORE) {
+            con->need_data = true;
+            break;
+        } else if (ret == MPG123_DONE) {
+            break;
+        } else if (ret != MPG123_OK) {
+            goto mpg123_fail;
+        }
     }
 
     update_info(da);
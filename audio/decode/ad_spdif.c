@@ -23,6 +23,7 @@
 
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
+#include <libavutil/intreadwrite.h>
 #include <libavutil/opt.h>
 
 #include "config.h"
@@ -35,6 +36,8 @@
 
 struct spdifContext {
     AVFormatContext *lavf_ctx;
+    enum AVCodecID   codec_id;
+    bool             dtshd;
     int              iec61937_packet_size;
     int              out_buffer_len;
     int              out_buffer_size;
@@ -42,6 +45,51 @@ struct spdifContext {
     bool             need_close;
 };
 
+// Wrap a frame in an IEC 61937 burst (preamble + byteswapped payload + zero
+// padding) directly in the output buffer, for the simple constant-rate cases.
+// Returns false if the frame needs the full lavf spdif muxer (TrueHD, DTS-HD,
+// 14 bit or little-endian DTS, ...).
+static bool format_burst_direct(struct spdifContext *ctx,
+                                uint8_t *data, int size)
+{
+    int data_type;
+    int burst_size;
+    if (ctx->codec_id == AV_CODEC_ID_AC3) {
+        if (size < 6 || AV_RB16(data) != 0x0B77)
+            return false;
+        data_type  = 0x01 | (data[5] & 0x07) << 8; // AC-3, bsmod in bits 8-10
+        burst_size = 6144;                         // 1536 samples
+    } else if (ctx->codec_id == AV_CODEC_ID_DTS && !ctx->dtshd) {
+        // Only 16 bit big-endian core streams (the common case).
+        if (size < 6 || AV_RB32(data) != 0x7FFE8001)
+            return false;
+        int blocks = ((data[4] & 0x01) << 6 | data[5] >> 2) + 1;
+        switch (blocks * 32) {
+        case 512:  data_type = 0x0B; break;
+        case 1024: data_type = 0x0C; break;
+        case 2048: data_type = 0x0D; break;
+        default:   return false;
+        }
+        burst_size = blocks * 32 * 4; // 2 channels, 16 bit
+    } else {
+        return false;
+    }
+    if ((size & 1) || size + 8 > burst_size || burst_size > ctx->out_buffer_size)
+        return false;
+    uint8_t *buf = ctx->out_buffer;
+    AV_WL16(buf + 0, 0xF872);     // Pa
+    AV_WL16(buf + 2, 0x4E1F);     // Pb
+    AV_WL16(buf + 4, data_type);  // Pc
+    AV_WL16(buf + 6, size << 3);  // Pd (payload length in bits)
+    for (int i = 0; i < size; i += 2) {
+        buf[8 + i]     = data[i + 1];
+        buf[8 + i + 1] = data[i];
+    }
+    memset(buf + 8 + size, 0, burst_size - 8 - size);
+    ctx->out_buffer_len = burst_size;
+    return true;
+}
+
 static int write_packet(void *p, uint8_t *buf, int buf_size)
 {
     struct spdifContext *ctx = p;
@@ -108,6 +156,9 @@ static int init(struct dec_audio *da, const char *decoder)
 
     stream->codec->codec_id = mp_codec_to_av_codec_id(decoder);
 
+    spdif_ctx->codec_id = stream->codec->codec_id;
+    spdif_ctx->dtshd    = da->opts->dtshd;
+
     AVDictionary *format_opts = NULL;
 
     int num_channels = 0;
@@ -209,8 +260,11 @@ static int decode_audio(struct dec_audio *da, struct mp_audio *buffer, int maxle
         da->pts        = mpkt->pts;
         da->pts_offset = 0;
     }
-    int ret = av_write_frame(lavf_ctx, &pkt);
-    avio_flush(lavf_ctx->pb);
+    int ret = 0;
+    if (!format_burst_direct(spdif_ctx, mpkt->buffer, mpkt->len)) {
+        ret = av_write_frame(lavf_ctx, &pkt);
+        avio_flush(lavf_ctx->pb);
+    }
     buffer->samples = spdif_ctx->out_buffer_len / sstride;
     da->pts_offset += buffer->samples;
     talloc_free(mpkt);
@@ -108,19 +108,21 @@ static int init_audio_codec(struct dec_audio *d_audio, const char *decoder)
 
 struct mp_decoder_list *audio_decoder_list(void)
 {
-    struct mp_decoder_list *list = talloc_zero(NULL, struct mp_decoder_list);
-    for (int i = 0; ad_drivers[i] != NULL; i++)
-        ad_drivers[i]->add_decoders(list);
-    return list;
+    // Built on first use and kept for the process lifetime; see
+    // video_decoder_list(). Callers must not free it.
+    static struct mp_decoder_list *cached;
+    if (!cached) {
+        cached = talloc_zero(NULL, struct mp_decoder_list);
+        for (int i = 0; ad_drivers[i] != NULL; i++)
+            ad_drivers[i]->add_decoders(cached);
+    }
+    return cached;
 }
 
 static struct mp_decoder_list *audio_select_decoders(const char *codec,
                                                      char *selection)
 {
-    struct mp_decoder_list *list = audio_decoder_list();
-    struct mp_decoder_list *new = mp_select_decoders(list, codec, selection);
-    talloc_free(list);
-    return new;
+    return mp_select_decoders(audio_decoder_list(), codec, selection);
 }
 
 static const struct ad_functions *find_driver(const char *name)
@@ -244,6 +244,7 @@ static struct af_instance *af_prepend(struct af_stream *s,
     new->prev = af->prev;
     af->prev = new;
     new->prev->next = new;
+    s->neg_cache_valid = false;
     return new;
 }
 
@@ -267,6 +268,7 @@ static struct af_instance *af_append(struct af_stream *s,
     new->next = af->next;
     af->next = new;
     new->next->prev = new;
+    s->neg_cache_valid = false;
     return new;
 }
 
@@ -286,6 +288,7 @@ static void af_remove(struct af_stream *s, struct af_instance *af)
     // Detach pointers
     af->prev->next = af->next;
     af->next->prev = af->prev;
+    s->neg_cache_valid = false;
 
     if (af->uninit)
         af->uninit(af);
@@ -507,6 +510,19 @@ static int af_fix_rate(struct af_stream *s, struct af_instance **p_af,
 // In that case, you should always rebuild the filter chain, or abort.
 static int af_reinit(struct af_stream *s)
 {
+    // Reconfiguring with unchanged formats (seeks, track switches back to
+    // the same codec) keeps the negotiated solution from the last run; the
+    // chain is already in the desired state.
+    if (s->neg_cache_valid &&
+        af_config_equals(&s->input, &s->neg_cache_input) &&
+        af_config_equals(&s->output, &s->neg_cache_output))
+    {
+        mp_msg(MSGT_AFILTER, MSGL_V,
+               "[libaf] Reusing previously negotiated filter chain.\n");
+        return AF_OK;
+    }
+    s->neg_cache_valid = false;
+
     remove_auto_inserted_filters(s);
     // Start with the second filter, as the first filter is the special input
     // filter which needs no initialization.
@@ -570,7 +586,18 @@ static int af_reinit(struct af_stream *s)
      * insert new filters or change the input format, the output format won't
      * change. (Audio outputs generally can't change format at runtime.) */
     af_copy_unset_fields(&s->output, &s->filter_output);
-    return af_config_equals(&s->output, &s->filter_output) ? AF_OK : AF_ERROR;
+    if (!af_config_equals(&s->output, &s->filter_output))
+        return AF_ERROR;
+
+    // Record the solved configuration. s->output is compared after
+    // af_copy_unset_fields(), since that's what it will contain when the
+    // caller requests the same thing again.
+    s->neg_cache_valid = true;
+    s->neg_cache_input = s->input;
+    s->neg_cache_output = s->output;
+    mp_audio_set_null_data(&s->neg_cache_input);
+    mp_audio_set_null_data(&s->neg_cache_output);
+    return AF_OK;
 
 negotiate_error:
     mp_msg(MSGT_AFILTER, MSGL_ERR, "[libaf] Unable to convert audio input "
@@ -86,6 +86,13 @@ struct af_stream {
     struct mp_audio output;
     struct mp_audio filter_output;
 
+    // Formats of the last successful negotiation. While the chain is
+    // unchanged and these still match input/output, af_reinit() can skip
+    // the trial-and-error conversion filter insertion entirely.
+    bool neg_cache_valid;
+    struct mp_audio neg_cache_input;
+    struct mp_audio neg_cache_output;
+
     struct MPOpts *opts;
 };
 
@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#include "common/cpudetect.h"
 #include "audio/format.h"
 #include "af.h"
 
@@ -70,6 +71,55 @@ static int control(struct af_instance *af, int cmd, void *arg)
 #define SHIFT(x) (((x)+1)*8)
 #endif
 
+#if HAVE_SSE2 && defined(__SSE2__) && BYTE_ORDER == LITTLE_ENDIAN
+
+#include <emmintrin.h>
+
+// Repack 32 bit samples to packed 24 bit, four samples per iteration. The
+// 16 byte stores cover 12 bytes of output, so the last samples are left to
+// the scalar loop to avoid writing past the destination. Returns the number
+// of samples converted.
+static int pack24_sse2(uint8_t *dst, const uint32_t *src, int num_samples)
+{
+    const __m128i m0 = _mm_set_epi32(0, 0, 0, 0x00ffffff);
+    const __m128i m1 = _mm_set_epi32(0, 0, 0x00ffffff, 0);
+    const __m128i m2 = _mm_set_epi32(0, 0x00ffffff, 0, 0);
+    const __m128i m3 = _mm_set_epi32(0x00ffffff, 0, 0, 0);
+    int i = 0;
+    for (; i + 6 <= num_samples; i += 4) {
+        // Drop the LSB of each sample, then compact the lanes' low 3 bytes.
+        __m128i v = _mm_srli_epi32(_mm_loadu_si128((const __m128i *)(src + i)), 8);
+        __m128i x = _mm_and_si128(v, m0);
+        x = _mm_or_si128(x, _mm_srli_si128(_mm_and_si128(v, m1), 1));
+        x = _mm_or_si128(x, _mm_srli_si128(_mm_and_si128(v, m2), 2));
+        x = _mm_or_si128(x, _mm_srli_si128(_mm_and_si128(v, m3), 3));
+        _mm_storeu_si128((__m128i *)(dst + i * 3), x);
+    }
+    return i;
+}
+
+// Inverse of pack24_sse2. The 16 byte loads read 12 bytes of input plus
+// overrun, so the last samples are again left to the scalar loop.
+static int unpack24_sse2(uint32_t *dst, const uint8_t *src, int num_samples)
+{
+    const __m128i m0 = _mm_set_epi32(0, 0, 0, 0xffffff00);
+    const __m128i m1 = _mm_set_epi32(0, 0, 0xffffff00, 0);
+    const __m128i m2 = _mm_set_epi32(0, 0xffffff00, 0, 0);
+    const __m128i m3 = _mm_set_epi32(0xffffff00, 0, 0, 0);
+    int i = 0;
+    for (; i + 6 <= num_samples; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+        __m128i x = _mm_and_si128(_mm_slli_si128(v, 1), m0);
+        x = _mm_or_si128(x, _mm_and_si128(_mm_slli_si128(v, 2), m1));
+        x = _mm_or_si128(x, _mm_and_si128(_mm_slli_si128(v, 3), m2));
+        x = _mm_or_si128(x, _mm_and_si128(_mm_slli_si128(v, 4), m3));
+        _mm_storeu_si128((__m128i *)(dst + i), x);
+    }
+    return i;
+}
+
+#endif
+
 static int filter(struct af_instance *af, struct mp_audio *data, int flags)
 {
     mp_audio_realloc_min(af->data, data->samples);
@@ -78,7 +128,13 @@ static int filter(struct af_instance *af, struct mp_audio *data, int flags)
     size_t len = mp_audio_psize(data) / data->bps;
 
     if (data->bps == 4) {
-        for (int s = 0; s < len; s++) {
+        int s = 0;
+#if HAVE_SSE2 && defined(__SSE2__) && BYTE_ORDER == LITTLE_ENDIAN
+        if (gCpuCaps.hasSSE2)
+            s = pack24_sse2((uint8_t *)out->planes[0],
+                            (uint32_t *)data->planes[0], len);
+#endif
+        for (; s < len; s++) {
             uint32_t val = *((uint32_t *)data->planes[0] + s);
             uint8_t *ptr = (uint8_t *)out->planes[0] + s * 3;
             ptr[0] = val >> SHIFT(0);
@@ -87,7 +143,13 @@ static int filter(struct af_instance *af, struct mp_audio *data, int flags)
         }
         mp_audio_set_format(data, af_fmt_change_bits(data->format, 24));
     } else {
-        for (int s = 0; s < len; s++) {
+        int s = 0;
+#if HAVE_SSE2 && defined(__SSE2__) && BYTE_ORDER == LITTLE_ENDIAN
+        if (gCpuCaps.hasSSE2)
+            s = unpack24_sse2((uint32_t *)out->planes[0],
+                              (uint8_t *)data->planes[0], len);
+#endif
+        for (; s < len; s++) {
             uint8_t *ptr = (uint8_t *)data->planes[0] + s * 3;
             uint32_t val = ptr[0] << SHIFT(0)
                          | ptr[1] << SHIFT(1)
@@ -65,6 +65,8 @@ typedef struct af_equalizer_s
   float   b[KM][L];	     	// B weights
   float   wq[AF_NCH][KM][L];  	// Circular buffer for W data
   float   g[AF_NCH][KM];      	// Gain factor for each channel and band
+  int     active[AF_NCH][KM];  	// Index of bands with nonzero gain
+  int     num_active[AF_NCH];  	// Number of entries in active
   int     K; 		   	// Number of used eq bands
   int     channels;        	// Number of channels
   float   gain_factor;     // applied at output to avoid clipping
@@ -114,6 +116,17 @@ static int control(struct af_instance* af, int cmd, void* arg)
     for(k=0;k<s->K;k++)
       bp2(s->a[k],s->b[k],F[k]/((float)af->data->rate),Q);
 
+    // Collect the bands in use for each channel. Gains are fixed for the
+    // lifetime of the filter, so bands with zero gain never contribute to
+    // the output and can be skipped entirely in filter().
+    for(i=0;i<AF_NCH;i++){
+      s->num_active[i]=0;
+      for(k=0;k<s->K;k++){
+	if(s->g[i][k] != 0.0)
+	  s->active[i][s->num_active[i]++]=k;
+      }
+    }
+
     // Calculate how much this plugin adds to the overall time delay
     af->delay = 2.0 / (double)af->data->rate;
 
@@ -151,17 +164,20 @@ static int filter(struct af_instance* af, struct mp_audio* data, int flags)
 
   while(ci--){
     float*	g   = s->g[ci];      // Gain factor
+    int*	act = s->active[ci]; // Bands with nonzero gain
+    int		na  = s->num_active[ci];
     float*	in  = ((float*)c->planes[0])+ci;
     float*	out = ((float*)c->planes[0])+ci;
     float* 	end = in + c->samples*c->nch; // Block loop end
 
     while(in < end){
-      register int	k  = 0;		// Frequency band index
+      register int	n  = 0;		// Active band index
       register float 	yt = *in; 	// Current input sample
       in+=nch;
 
       // Run the filters
-      for(;k<s->K;k++){
+      for(;n<na;n++){
+	register int k = act[n];	// Frequency band index
  	// Pointer to circular buffer wq
  	register float* wq = s->wq[ci][k];
  	// Calculate output from AR part of current filter
@@ -29,6 +29,7 @@
 
 #include <math.h>
 #include <libavutil/common.h>
+#include <libavcodec/avfft.h>
 
 #include "af.h"
 #include "dsp.h"
@@ -36,6 +37,15 @@
 /* HRTF filter coefficients and adjustable parameters */
 #include "af_hrtf.h"
 
+/* The convolutions are done in the frequency domain with overlap-save:
+   HRTF_BLOCK output samples per transform of HRTF_FFTLEN points. The
+   block must satisfy HRTF_BLOCK <= HRTF_FFTLEN - BASSFILTLEN + 1 (the
+   bass impulse is the longest kernel), and the HRTF kernels including
+   their pulse offsets fit in 128 taps. */
+#define HRTF_FFTNBITS	9
+#define HRTF_FFTLEN	(1 << HRTF_FFTNBITS)
+#define HRTF_BLOCK	256
+
 typedef struct af_hrtf_s {
     /* Lengths */
     int dlbuflen, hrflen, basslen;
@@ -72,26 +82,64 @@ typedef struct af_hrtf_s {
     int cyc_pos;
     int print_flag;
     int mode;
+    /* Overlap-save convolution state */
+    RDFTContext *rdft, *irdft;
+    float fftscale;
+    /* Frequency domain kernels (RDFT of the zero padded impulses) */
+    float *cf_ks, *af_ks, *of_ks, *ar_ks, *or_ks, *cr_ks, *ba_ks;
+    /* Signal transform scratch and the two output accumulators */
+    float *fscratch, *facc_l, *facc_r;
 } af_hrtf_t;
 
-/* Convolution on a ring buffer
- *    nx:	length of the ring buffer
- *    nk:	length of the convolution kernel
- *    sx:	ring buffer
- *    sk:	convolution kernel
- *    offset:	offset on the ring buffer, can be
- */
-static float conv(const int nx, const int nk, const float *sx, const float *sk,
-		  const int offset)
+/* acc += w * x * h on the half complex layout of av_rdft_calc(): bin 0
+   holds DC, bin 1 the Nyquist coefficient (both purely real), then
+   re/im pairs. */
+static void spec_madd(float *acc, const float *x, const float *h,
+		      const float w)
+{
+    int i;
+
+    acc[0] += w * x[0] * h[0];
+    acc[1] += w * x[1] * h[1];
+    for(i = 2; i < HRTF_FFTLEN; i += 2) {
+	acc[i]     += w * (x[i] * h[i]     - x[i + 1] * h[i + 1]);
+	acc[i + 1] += w * (x[i] * h[i + 1] + x[i + 1] * h[i]);
+    }
+}
+
+/* Transform the last HRTF_FFTLEN samples of one delay line (newest
+   sample at ring position k_last) and accumulate it convolved with the
+   kernels ksl, ksr into the left/right output spectra. */
+static void fft_conv_add(af_hrtf_t *s, const float *ring, const int k_last,
+			 const float *ksl, const float wl,
+			 const float *ksr, const float wr)
+{
+    float *fs = s->fscratch;
+    int t;
+
+    /* The ring buffer runs backwards in time with increasing index;
+       unwrap it into time order, newest sample last. */
+    for(t = 0; t < HRTF_FFTLEN; t++)
+	fs[HRTF_FFTLEN - 1 - t] = ring[(k_last + t) % s->dlbuflen];
+    av_rdft_calc(s->rdft, fs);
+    spec_madd(s->facc_l, fs, ksl, wl);
+    spec_madd(s->facc_r, fs, ksr, wr);
+}
+
+/* RDFT of an impulse response, zero padded to the transform length and
+   delayed by the pulse offset, with the round trip scaling folded in */
+static float *kernel_spec(af_hrtf_t *s, const float *ir, const int nk,
+			  const int offset)
 {
-    /* k = reminder of offset / nx */
-    int k = offset >= 0 ? offset % nx : nx + (offset % nx);
-
-    if(nk + k <= nx)
-	return af_filter_fir(nk, sx + k, sk);
-    else
-	return af_filter_fir(nk + k - nx, sx, sk + nx - k) +
-	    af_filter_fir(nx - k, sx + k, sk);
+    float *ks = calloc(HRTF_FFTLEN, sizeof(float));
+    int i;
+
+    if(!ks)
+	return NULL;
+    for(i = 0; i < nk; i++)
+	ks[offset + i] = ir[i] * s->fftscale;
+    av_rdft_calc(s->rdft, ks);
+    return ks;
 }
 
 /* Detect when the impulse response starts (significantly) */
@@ -340,6 +388,20 @@ static void uninit(struct af_instance *af)
 	free(s->fwrbuf_r);
 	free(s->fwrbuf_lr);
 	free(s->fwrbuf_rr);
+	free(s->fscratch);
+	free(s->facc_l);
+	free(s->facc_r);
+	free(s->cf_ks);
+	free(s->af_ks);
+	free(s->of_ks);
+	free(s->ar_ks);
+	free(s->or_ks);
+	free(s->cr_ks);
+	free(s->ba_ks);
+	if(s->rdft)
+	    av_rdft_end(s->rdft);
+	if(s->irdft)
+	    av_rdft_end(s->irdft);
 }
 
 /* Filter data through filter
@@ -359,8 +421,8 @@ static int filter(struct af_instance *af, struct mp_audio *data, int flags)
     short *in = data->planes[0]; // Input audio data
     short *out = NULL; // Output audio data
     short *end = in + data->samples * data->nch; // Loop end
-    float common, left, right, diff, left_b, right_b;
-    const int dblen = s->dlbuflen, hlen = s->hrflen, blen = s->basslen;
+    float left, right, diff;
+    const int dblen = s->dlbuflen;
 
     mp_audio_realloc_min(af->data, data->samples);
 
@@ -416,74 +478,71 @@ static int filter(struct af_instance *af, struct mp_audio *data, int flags)
      */
 
     while(in < end) {
-	const int k = s->cyc_pos;
-
-	update_ch(s, in, k);
+	int block = (end - in) / data->nch;
+	int b, k_last;
+	const float rear_gain = s->matrix_mode ? M1_76DB : 1;
+
+	if(block > HRTF_BLOCK)
+	    block = HRTF_BLOCK;
+
+	/* Phase 1: per sample state updates - matrix decoding, FWR
+	   steering and the delay lines. Nothing in here depends on the
+	   convolution results, so the convolutions of the whole block
+	   can be batched in the frequency domain below. */
+	for(b = 0; b < block; b++) {
+	    short *cur = in + b * data->nch;
+	    const int k = s->cyc_pos;
+
+	    update_ch(s, cur, k);
+
+	    /* Simulate a 7.5 ms -20 dB echo of the center channel in the
+	       front channels (like reflection from a room wall) - a kind of
+	       psycho-acoustically "cheating" to focus the center front
+	       channel, which is normally hard to be perceived as front */
+	    s->lf[k] += CFECHOAMPL * s->cf[(k + CFECHODELAY) % s->dlbuflen];
+	    s->rf[k] += CFECHOAMPL * s->cf[(k + CFECHODELAY) % s->dlbuflen];
+
+	    if((s->decode_mode == HRTF_MIX_51 ||
+		s->decode_mode == HRTF_MIX_MATRIX2CH) && s->matrix_mode) {
+	       /* In matrix decoding mode, the rear channel gain must be
+		  renormalized, as there is an additional channel. */
+	       matrix_decode(cur, k, 2, 3, 0, s->dlbuflen,
+			     s->lr_fwr, s->rr_fwr,
+			     s->lrprr_fwr, s->lrmrr_fwr,
+			     &(s->adapt_lr_gain), &(s->adapt_rr_gain),
+			     &(s->adapt_lrprr_gain), &(s->adapt_lrmrr_gain),
+			     s->lr, s->rr, NULL, NULL, s->cr);
+	    }
 
-	/* Simulate a 7.5 ms -20 dB echo of the center channel in the
-	   front channels (like reflection from a room wall) - a kind of
-	   psycho-acoustically "cheating" to focus the center front
-	   channel, which is normally hard to be perceived as front */
-	s->lf[k] += CFECHOAMPL * s->cf[(k + CFECHODELAY) % s->dlbuflen];
-	s->rf[k] += CFECHOAMPL * s->cf[(k + CFECHODELAY) % s->dlbuflen];
+	    (s->cyc_pos)--;
+	    if(s->cyc_pos < 0)
+		s->cyc_pos += dblen;
+	}
 
+	/* Phase 2: all convolutions of the block at once, accumulated
+	   in the frequency domain (the mixer matrix is linear). */
+	k_last = (s->cyc_pos + 1) % dblen;
+	memset(s->facc_l, 0, HRTF_FFTLEN * sizeof(float));
+	memset(s->facc_r, 0, HRTF_FFTLEN * sizeof(float));
 	switch (s->decode_mode) {
 	case HRTF_MIX_51:
 	case HRTF_MIX_MATRIX2CH:
 	   /* Mixer filter matrix */
-	   common = conv(dblen, hlen, s->cf, s->cf_ir, k + s->cf_o);
-	   if(s->matrix_mode) {
-	      /* In matrix decoding mode, the rear channel gain must be
-		 renormalized, as there is an additional channel. */
-	      matrix_decode(in, k, 2, 3, 0, s->dlbuflen,
-			    s->lr_fwr, s->rr_fwr,
-			    s->lrprr_fwr, s->lrmrr_fwr,
-			    &(s->adapt_lr_gain), &(s->adapt_rr_gain),
-			    &(s->adapt_lrprr_gain), &(s->adapt_lrmrr_gain),
-			    s->lr, s->rr, NULL, NULL, s->cr);
-	      common +=
-		 conv(dblen, hlen, s->cr, s->cr_ir, k + s->cr_o) *
-		 M1_76DB;
-	      left    =
-		 ( conv(dblen, hlen, s->lf, s->af_ir, k + s->af_o) +
-		   conv(dblen, hlen, s->rf, s->of_ir, k + s->of_o) +
-		   (conv(dblen, hlen, s->lr, s->ar_ir, k + s->ar_o) +
-		    conv(dblen, hlen, s->rr, s->or_ir, k + s->or_o)) *
-		   M1_76DB + common);
-	      right   =
-		 ( conv(dblen, hlen, s->rf, s->af_ir, k + s->af_o) +
-		   conv(dblen, hlen, s->lf, s->of_ir, k + s->of_o) +
-		   (conv(dblen, hlen, s->rr, s->ar_ir, k + s->ar_o) +
-		    conv(dblen, hlen, s->lr, s->or_ir, k + s->or_o)) *
-		   M1_76DB + common);
-	   } else {
-	      left    =
-		 ( conv(dblen, hlen, s->lf, s->af_ir, k + s->af_o) +
-		   conv(dblen, hlen, s->rf, s->of_ir, k + s->of_o) +
-		   conv(dblen, hlen, s->lr, s->ar_ir, k + s->ar_o) +
-		   conv(dblen, hlen, s->rr, s->or_ir, k + s->or_o) +
-		   common);
-	      right   =
-		 ( conv(dblen, hlen, s->rf, s->af_ir, k + s->af_o) +
-		   conv(dblen, hlen, s->lf, s->of_ir, k + s->of_o) +
-		   conv(dblen, hlen, s->rr, s->ar_ir, k + s->ar_o) +
-		   conv(dblen, hlen, s->lr, s->or_ir, k + s->or_o) +
-		   common);
-	   }
+	   fft_conv_add(s, s->cf, k_last, s->cf_ks, 1, s->cf_ks, 1);
+	   fft_conv_add(s, s->lf, k_last, s->af_ks, 1, s->of_ks, 1);
+	   fft_conv_add(s, s->rf, k_last, s->of_ks, 1, s->af_ks, 1);
+	   fft_conv_add(s, s->lr, k_last,
+			s->ar_ks, rear_gain, s->or_ks, rear_gain);
+	   fft_conv_add(s, s->rr, k_last,
+			s->or_ks, rear_gain, s->ar_ks, rear_gain);
+	   if(s->matrix_mode)
+	      fft_conv_add(s, s->cr, k_last,
+			   s->cr_ks, M1_76DB, s->cr_ks, M1_76DB);
 	   break;
 	case HRTF_MIX_STEREO:
-	   left    =
-	      ( conv(dblen, hlen, s->lf, s->af_ir, k + s->af_o) +
-		conv(dblen, hlen, s->rf, s->of_ir, k + s->of_o));
-	   right   =
-	      ( conv(dblen, hlen, s->rf, s->af_ir, k + s->af_o) +
-		conv(dblen, hlen, s->lf, s->of_ir, k + s->of_o));
+	   fft_conv_add(s, s->lf, k_last, s->af_ks, 1, s->of_ks, 1);
+	   fft_conv_add(s, s->rf, k_last, s->of_ks, 1, s->af_ks, 1);
 	   break;
-	default:
-	    /* make gcc happy */
-	    left = 0.0;
-	    right = 0.0;
-	    break;
 	}
 
 	/* Bass compensation for the lower frequency cut of the HRTF.  A
@@ -492,46 +551,56 @@ static int filter(struct af_instance *af, struct mp_audio *data, int flags)
 	   The bass will not have any real 3D perception, but that is
 	   OK (note at 180 Hz, the wavelength is about 2 m, and any
 	   spatial perception is impossible). */
-	left_b  = conv(dblen, blen, s->ba_l, s->ba_ir, k);
-	right_b = conv(dblen, blen, s->ba_r, s->ba_ir, k);
-	left  += (1 - BASSCROSS) * left_b  + BASSCROSS * right_b;
-	right += (1 - BASSCROSS) * right_b + BASSCROSS * left_b;
-	/* Also mix the LFE channel (if available) */
-	if(data->nch >= 6) {
-	    left  += in[5] * M3_01DB;
-	    right += in[5] * M3_01DB;
-	}
-
-	/* Amplitude renormalization. */
-	left  *= AMPLNORM;
-	right *= AMPLNORM;
+	fft_conv_add(s, s->ba_l, k_last,
+		     s->ba_ks, 1 - BASSCROSS, s->ba_ks, BASSCROSS);
+	fft_conv_add(s, s->ba_r, k_last,
+		     s->ba_ks, BASSCROSS, s->ba_ks, 1 - BASSCROSS);
+
+	av_rdft_calc(s->irdft, s->facc_l);
+	av_rdft_calc(s->irdft, s->facc_r);
+
+	/* Phase 3: renormalize and write out. The first HRTF_FFTLEN -
+	   block output samples of the inverse transform are discarded
+	   (overlap-save). */
+	for(b = 0; b < block; b++) {
+	    short *cur = in + b * data->nch;
+
+	    left  = s->facc_l[HRTF_FFTLEN - block + b];
+	    right = s->facc_r[HRTF_FFTLEN - block + b];
+	    /* Also mix the LFE channel (if available) */
+	    if(data->nch >= 6) {
+		left  += cur[5] * M3_01DB;
+		right += cur[5] * M3_01DB;
+	    }
 
-	switch (s->decode_mode) {
-	case HRTF_MIX_51:
-	case HRTF_MIX_STEREO:
-	   /* "Cheating": linear stereo expansion to amplify the 3D
-	      perception.  Note: Too much will destroy the acoustic space
-	      and may even result in headaches. */
-	   diff = STEXPAND2 * (left - right);
-	   out[0] = av_clip_int16(left  + diff);
-	   out[1] = av_clip_int16(right - diff);
-	   break;
-	case HRTF_MIX_MATRIX2CH:
-	   /* Do attempt any stereo expansion with matrix encoded
-	      sources.  The L, R channels are already stereo expanded
-	      by the steering, any further stereo expansion will sound
-	      very unnatural. */
-	   out[0] = av_clip_int16(left);
-	   out[1] = av_clip_int16(right);
-	   break;
+	    /* Amplitude renormalization. */
+	    left  *= AMPLNORM;
+	    right *= AMPLNORM;
+
+	    switch (s->decode_mode) {
+	    case HRTF_MIX_51:
+	    case HRTF_MIX_STEREO:
+	       /* "Cheating": linear stereo expansion to amplify the 3D
+		  perception.  Note: Too much will destroy the acoustic space
+		  and may even result in headaches. */
+	       diff = STEXPAND2 * (left - right);
+	       out[0] = av_clip_int16(left  + diff);
+	       out[1] = av_clip_int16(right - diff);
+	       break;
+	    case HRTF_MIX_MATRIX2CH:
+	       /* Do attempt any stereo expansion with matrix encoded
+		  sources.  The L, R channels are already stereo expanded
+		  by the steering, any further stereo expansion will sound
+		  very unnatural. */
+	       out[0] = av_clip_int16(left);
+	       out[1] = av_clip_int16(right);
+	       break;
+	    }
+	    out = &out[af->data->nch];
 	}
 
-	/* Next sample... */
-	in = &in[data->nch];
-	out = &out[af->data->nch];
-	(s->cyc_pos)--;
-	if(s->cyc_pos < 0)
-	    s->cyc_pos += dblen;
+	/* Next block... */
+	in += block * data->nch;
     }
 
     /* Set output data */
@@ -559,6 +628,9 @@ static int allocate(af_hrtf_t *s)
 	 malloc(s->dlbuflen * sizeof(float))) == NULL) return -1;
     if ((s->fwrbuf_rr =
 	 malloc(s->dlbuflen * sizeof(float))) == NULL) return -1;
+    if ((s->fscratch = malloc(HRTF_FFTLEN * sizeof(float))) == NULL) return -1;
+    if ((s->facc_l = malloc(HRTF_FFTLEN * sizeof(float))) == NULL) return -1;
+    if ((s->facc_r = malloc(HRTF_FFTLEN * sizeof(float))) == NULL) return -1;
     return 0;
 }
 
@@ -567,7 +639,7 @@ static int af_open(struct af_instance* af)
 {
     int i;
     af_hrtf_t *s;
-    float fc;
+    float fc, fwdscale;
 
     af->control = control;
     af->uninit = uninit;
@@ -607,7 +679,24 @@ static int af_open(struct af_instance* af)
 
     for(i = 0; i < s->dlbuflen; i++)
 	s->lf[i] = s->rf[i] = s->lr[i] = s->rr[i] = s->cf[i] =
-	    s->cr[i] = 0;
+	    s->cr[i] = s->ba_l[i] = s->ba_r[i] = 0;
+
+    s->rdft = av_rdft_init(HRTF_FFTNBITS, DFT_R2C);
+    s->irdft = av_rdft_init(HRTF_FFTNBITS, IDFT_C2R);
+    if(!s->rdft || !s->irdft) {
+ 	mp_msg(MSGT_AFILTER, MSGL_ERR, "[hrtf] Unable to initialize the "
+	       "FFT.\n");
+	return AF_ERROR;
+    }
+
+    /* Measure the scaling of the transform pair with a unit impulse
+       instead of hardcoding the library's convention. */
+    memset(s->fscratch, 0, HRTF_FFTLEN * sizeof(float));
+    s->fscratch[0] = 1;
+    av_rdft_calc(s->rdft, s->fscratch);
+    fwdscale = s->fscratch[0];
+    av_rdft_calc(s->irdft, s->fscratch);
+    s->fftscale = 1.0 / (fwdscale * s->fscratch[0]);
 
     s->lr_fwr =
 	s->rr_fwr = 0;
@@ -633,6 +722,19 @@ static int af_open(struct af_instance* af)
     for(i = 0; i < s->basslen; i++)
 	s->ba_ir[i] *= BASSGAIN;
 
+    s->cf_ks = kernel_spec(s, s->cf_ir, s->hrflen, s->cf_o);
+    s->af_ks = kernel_spec(s, s->af_ir, s->hrflen, s->af_o);
+    s->of_ks = kernel_spec(s, s->of_ir, s->hrflen, s->of_o);
+    s->ar_ks = kernel_spec(s, s->ar_ir, s->hrflen, s->ar_o);
+    s->or_ks = kernel_spec(s, s->or_ir, s->hrflen, s->or_o);
+    s->cr_ks = kernel_spec(s, s->cr_ir, s->hrflen, s->cr_o);
+    s->ba_ks = kernel_spec(s, s->ba_ir, s->basslen, 0);
+    if(!s->cf_ks || !s->af_ks || !s->of_ks || !s->ar_ks ||
+       !s->or_ks || !s->cr_ks || !s->ba_ks) {
+ 	mp_msg(MSGT_AFILTER, MSGL_ERR, "[hrtf] Memory allocation error.\n");
+	return AF_ERROR;
+    }
+
     return AF_OK;
 }
 
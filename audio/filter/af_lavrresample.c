@@ -75,6 +75,20 @@ struct af_resample_opts {
     struct mp_chmap out_channels;
 };
 
+// Number of retired resampler contexts kept for reuse. Track switches and
+// seek previews flip between a handful of configurations; reusing an already
+// opened context skips the filter bank initialization.
+#define RESAMPLE_CACHE_SIZE 4
+
+struct af_resample_cache_entry {
+    struct af_resample_opts ctx;
+    struct AVAudioResampleContext *avrctx;
+    struct AVAudioResampleContext *avrctx_out;
+    int reorder_in[MP_NUM_CHANNELS];
+    int reorder_out[MP_NUM_CHANNELS];
+    int64_t last_used;              // 0 if the slot is empty
+};
+
 struct af_resample {
     int allow_detach;
     char *avopts;
@@ -86,6 +100,8 @@ struct af_resample {
     int reorder_in[MP_NUM_CHANNELS];
     int reorder_out[MP_NUM_CHANNELS];
     uint8_t *reorder_buffer;
+    struct af_resample_cache_entry cache[RESAMPLE_CACHE_SIZE];
+    int64_t cache_counter;
 };
 
 #if HAVE_LIBAVRESAMPLE
@@ -113,21 +129,83 @@ static double af_resample_default_cutoff(int filter_size)
     return FFMAX(1.0 - 6.5 / (filter_size + 8), 0.80);
 }
 
+static struct af_resample_opts wanted_opts(struct af_resample *s,
+                                           struct mp_audio *in,
+                                           struct mp_audio *out)
+{
+    return (struct af_resample_opts) {
+        .filter_size  = s->opts.filter_size,
+        .phase_shift  = s->opts.phase_shift,
+        .linear       = s->opts.linear,
+        .cutoff       = s->opts.cutoff,
+        .in_rate      = in->rate,
+        .in_format    = in->format,
+        .in_channels  = in->channels,
+        .out_rate     = out->rate,
+        .out_format   = out->format,
+        .out_channels = out->channels,
+    };
+}
+
+static bool opts_equal(const struct af_resample_opts *a,
+                       const struct af_resample_opts *b)
+{
+    return a->in_rate     == b->in_rate &&
+           a->in_format   == b->in_format &&
+           mp_chmap_equals(&a->in_channels, &b->in_channels) &&
+           a->out_rate    == b->out_rate &&
+           a->out_format  == b->out_format &&
+           mp_chmap_equals(&a->out_channels, &b->out_channels) &&
+           a->filter_size == b->filter_size &&
+           a->phase_shift == b->phase_shift &&
+           a->linear      == b->linear &&
+           a->cutoff      == b->cutoff;
+}
+
 static bool needs_lavrctx_reconfigure(struct af_resample *s,
                                       struct mp_audio *in,
                                       struct mp_audio *out)
 {
-    return s->ctx.in_rate     != in->rate ||
-           s->ctx.in_format   != in->format ||
-           !mp_chmap_equals(&s->ctx.in_channels, &in->channels) ||
-           s->ctx.out_rate    != out->rate ||
-           s->ctx.out_format  != out->format ||
-           !mp_chmap_equals(&s->ctx.out_channels, &out->channels) ||
-           s->ctx.filter_size != s->opts.filter_size ||
-           s->ctx.phase_shift != s->opts.phase_shift ||
-           s->ctx.linear      != s->opts.linear ||
-           s->ctx.cutoff      != s->opts.cutoff;
+    struct af_resample_opts want = wanted_opts(s, in, out);
+    return !opts_equal(&s->ctx, &want);
+}
 
+static void cache_entry_free(struct af_resample_cache_entry *e)
+{
+    if (e->avrctx)
+        avresample_close(e->avrctx);
+    avresample_free(&e->avrctx);
+    if (e->avrctx_out)
+        avresample_close(e->avrctx_out);
+    avresample_free(&e->avrctx_out);
+    e->last_used = 0;
+}
+
+// Retire the current context into the cache (evicting the least recently
+// used entry if needed) instead of closing it.
+static void cache_stash(struct af_resample *s)
+{
+    struct af_resample_cache_entry *e = &s->cache[0];
+
+    if (!s->avrctx)
+        return;
+    for (int n = 0; n < RESAMPLE_CACHE_SIZE; n++) {
+        if (!s->cache[n].last_used) {
+            e = &s->cache[n];
+            break;
+        }
+        if (s->cache[n].last_used < e->last_used)
+            e = &s->cache[n];
+    }
+    cache_entry_free(e);
+    e->ctx = s->ctx;
+    e->avrctx = s->avrctx;
+    e->avrctx_out = s->avrctx_out;
+    memcpy(e->reorder_in, s->reorder_in, sizeof(e->reorder_in));
+    memcpy(e->reorder_out, s->reorder_out, sizeof(e->reorder_out));
+    e->last_used = ++s->cache_counter;
+    s->avrctx = NULL;
+    s->avrctx_out = NULL;
 }
 
 static bool test_conversion(int src_format, int dst_format)
@@ -147,19 +225,39 @@ static int configure_lavrr(struct af_instance *af, struct mp_audio *in,
     if (in_samplefmt == AV_SAMPLE_FMT_NONE || out_samplefmt == AV_SAMPLE_FMT_NONE)
         return AF_ERROR;
 
-    avresample_close(s->avrctx);
-    avresample_close(s->avrctx_out);
+    // Retire the current context while s->ctx still holds the opts it was
+    // configured for; only then install the new opts. Otherwise the stashed
+    // entry would be keyed under the new format and matched right back.
+    cache_stash(s);
+
+    s->ctx = wanted_opts(s, in, out);
+
+    for (int n = 0; n < RESAMPLE_CACHE_SIZE; n++) {
+        struct af_resample_cache_entry *e = &s->cache[n];
+        if (e->last_used && opts_equal(&e->ctx, &s->ctx)) {
+            s->avrctx = e->avrctx;
+            s->avrctx_out = e->avrctx_out;
+            memcpy(s->reorder_in, e->reorder_in, sizeof(s->reorder_in));
+            memcpy(s->reorder_out, e->reorder_out, sizeof(s->reorder_out));
+            e->avrctx = NULL;
+            e->avrctx_out = NULL;
+            e->last_used = 0;
+            // The context keeps its (sub-ms) filter history, exactly like
+            // AF_CONTROL_RESET does, but buffered output must go.
+            drop_all_output(s);
+            return AF_OK;
+        }
+    }
 
-    s->ctx.out_rate    = out->rate;
-    s->ctx.in_rate     = in->rate;
-    s->ctx.out_format  = out->format;
-    s->ctx.in_format   = in->format;
-    s->ctx.out_channels= out->channels;
-    s->ctx.in_channels = in->channels;
-    s->ctx.filter_size = s->opts.filter_size;
-    s->ctx.phase_shift = s->opts.phase_shift;
-    s->ctx.linear      = s->opts.linear;
-    s->ctx.cutoff      = s->opts.cutoff;
+    s->avrctx = avresample_alloc_context();
+    s->avrctx_out = avresample_alloc_context();
+    if (!s->avrctx || !s->avrctx_out) {
+        mp_msg(MSGT_AFILTER, MSGL_ERR, "[lavrresample] Cannot initialize "
+               "Libavresample Context. \n");
+        avresample_free(&s->avrctx);
+        avresample_free(&s->avrctx_out);
+        return AF_ERROR;
+    }
 
     av_opt_set_int(s->avrctx, "filter_size",        s->ctx.filter_size, 0);
     av_opt_set_int(s->avrctx, "phase_shift",        s->ctx.phase_shift, 0);
@@ -224,6 +322,8 @@ static int configure_lavrr(struct af_instance *af, struct mp_audio *in,
     {
         mp_msg(MSGT_AFILTER, MSGL_ERR, "[lavrresample] Cannot open "
                 "Libavresample Context. \n");
+        avresample_free(&s->avrctx);
+        avresample_free(&s->avrctx_out);
         return AF_ERROR;
     }
     return AF_OK;
@@ -282,7 +382,8 @@ static int control(struct af_instance *af, int cmd, void *arg)
         out->rate = *(int *)arg;
         return AF_OK;
     case AF_CONTROL_RESET:
-        drop_all_output(s);
+        if (s->avrctx)
+            drop_all_output(s);
         return AF_OK;
     }
     return AF_UNKNOWN;
@@ -300,6 +401,8 @@ static void uninit(struct af_instance *af)
     if (s->avrctx_out)
         avresample_close(s->avrctx_out);
     avresample_free(&s->avrctx_out);
+    for (int n = 0; n < RESAMPLE_CACHE_SIZE; n++)
+        cache_entry_free(&s->cache[n]);
 }
 
 static bool needs_reorder(int *reorder, int num_ch)
@@ -392,17 +495,8 @@ static int af_open(struct af_instance *af)
     if (s->opts.cutoff <= 0.0)
         s->opts.cutoff = af_resample_default_cutoff(s->opts.filter_size);
 
-    s->avrctx = avresample_alloc_context();
-    s->avrctx_out = avresample_alloc_context();
-
-    if (s->avrctx && s->avrctx_out) {
-        return AF_OK;
-    } else {
-        mp_msg(MSGT_AFILTER, MSGL_ERR, "[lavrresample] Cannot initialize "
-               "Libavresample Context. \n");
-        uninit(af);
-        return AF_ERROR;
-    }
+    // The resampler contexts are allocated on configuration.
+    return AF_OK;
 }
 
 #define OPT_BASE_STRUCT struct af_resample
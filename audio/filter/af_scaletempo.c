@@ -37,6 +37,7 @@
 #include <assert.h>
 
 #include "common/common.h"
+#include "common/cpudetect.h"
 
 #include "af.h"
 #include "options/m_option.h"
@@ -118,6 +119,56 @@ static int fill_queue(struct af_instance *af, struct mp_audio *data, int offset)
 
 #define UNROLL_PADDING (4 * 4)
 
+#if HAVE_SSE2 && defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// Signed 32x32->64 bit multiply of the even lanes (SSE2 only has the
+// unsigned variant; correct the result for negative inputs).
+static inline __m128i muldq(__m128i a, __m128i b)
+{
+    __m128i prod = _mm_mul_epu32(a, b);
+    __m128i fix  = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b),
+                                 _mm_and_si128(_mm_srai_epi32(b, 31), a));
+    return _mm_sub_epi64(prod, _mm_slli_epi64(fix, 32));
+}
+
+// Correlate the precomputed windowed overlap against one search position.
+// Like the unrolled scalar loop, this rounds num up to a multiple of 4 and
+// relies on UNROLL_PADDING at the end of both buffers.
+static int64_t corr_sum_s16_sse2(int32_t *ppc, int16_t *ps, long num)
+{
+    __m128i acc = _mm_setzero_si128();
+    for (long i = 0; i < num; i += 4) {
+        __m128i c = _mm_loadu_si128((__m128i *)(ppc + i));
+        __m128i v = _mm_loadl_epi64((__m128i *)(ps + i));
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // sign extend
+        acc = _mm_add_epi64(acc, muldq(c, v));
+        acc = _mm_add_epi64(acc, muldq(_mm_srli_si128(c, 4),
+                                       _mm_srli_si128(v, 4)));
+    }
+    int64_t sums[2];
+    _mm_storeu_si128((__m128i *)sums, acc);
+    return sums[0] + sums[1];
+}
+
+static float corr_sum_float_sse2(float *ppc, float *ps, int num)
+{
+    __m128 acc = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= num; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(ppc + i),
+                                         _mm_loadu_ps(ps + i)));
+    float sums[4];
+    _mm_storeu_ps(sums, acc);
+    float corr = sums[0] + sums[1] + sums[2] + sums[3];
+    for (; i < num; i++)
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+
+#endif
+
 static int best_overlap_offset_float(af_scaletempo_t *s)
 {
     float best_corr = INT_MIN;
@@ -132,11 +183,20 @@ static int best_overlap_offset_float(af_scaletempo_t *s)
 
     float *search_start = (float *)s->buf_queue + s->num_channels;
     for (int off = 0; off < s->frames_search; off++) {
-        float corr = 0;
-        float *ps = search_start;
-        ppc = s->buf_pre_corr;
-        for (int i = s->num_channels; i < s->samples_overlap; i++)
-            corr += *ppc++ **ps++;
+        float corr;
+#if HAVE_SSE2 && defined(__SSE2__)
+        if (gCpuCaps.hasSSE2) {
+            corr = corr_sum_float_sse2(s->buf_pre_corr, search_start,
+                                       s->samples_overlap - s->num_channels);
+        } else
+#endif
+        {
+            corr = 0;
+            float *ps = search_start;
+            ppc = s->buf_pre_corr;
+            for (int i = s->num_channels; i < s->samples_overlap; i++)
+                corr += *ppc++ **ps++;
+        }
         if (corr > best_corr) {
             best_corr = corr;
             best_off  = off;
@@ -161,19 +221,28 @@ static int best_overlap_offset_s16(af_scaletempo_t *s)
 
     int16_t *search_start = (int16_t *)s->buf_queue + s->num_channels;
     for (int off = 0; off < s->frames_search; off++) {
-        int64_t corr = 0;
-        int16_t *ps = search_start;
-        ppc = s->buf_pre_corr;
-        ppc += s->samples_overlap - s->num_channels;
-        ps  += s->samples_overlap - s->num_channels;
-        long i  = -(s->samples_overlap - s->num_channels);
-        do {
-            corr += ppc[i + 0] * ps[i + 0];
-            corr += ppc[i + 1] * ps[i + 1];
-            corr += ppc[i + 2] * ps[i + 2];
-            corr += ppc[i + 3] * ps[i + 3];
-            i += 4;
-        } while (i < 0);
+        int64_t corr;
+#if HAVE_SSE2 && defined(__SSE2__)
+        if (gCpuCaps.hasSSE2) {
+            corr = corr_sum_s16_sse2(s->buf_pre_corr, search_start,
+                                     s->samples_overlap - s->num_channels);
+        } else
+#endif
+        {
+            corr = 0;
+            int16_t *ps = search_start;
+            ppc = s->buf_pre_corr;
+            ppc += s->samples_overlap - s->num_channels;
+            ps  += s->samples_overlap - s->num_channels;
+            long i  = -(s->samples_overlap - s->num_channels);
+            do {
+                corr += ppc[i + 0] * ps[i + 0];
+                corr += ppc[i + 1] * ps[i + 1];
+                corr += ppc[i + 2] * ps[i + 2];
+                corr += ppc[i + 3] * ps[i + 3];
+                i += 4;
+            } while (i < 0);
+        }
         if (corr > best_corr) {
             best_corr = corr;
             best_off  = off;
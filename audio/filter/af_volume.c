@@ -27,10 +27,12 @@
 #include <limits.h>
 
 #include "common/common.h"
+#include "common/cpudetect.h"
 #include "af.h"
 
 struct priv {
     float level;                // Gain level for each channel
+    float level_cur;            // Gain the output was last filtered with
     int soft;                   // Enable/disable soft clipping
     int fast;                   // Use fix-point volume control
     float cfg_volume;
@@ -66,6 +68,73 @@ static int control(struct af_instance *af, int cmd, void *arg)
     return AF_UNKNOWN;
 }
 
+#if HAVE_SSE2 && defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// Same as the scalar S16 loop: x = (a[i] * vol) >> 8, clamped to int16_t.
+// vol must fit into int16_t.
+static void volume_s16_sse2(int16_t *a, int num_samples, int vol)
+{
+    __m128i k = _mm_set1_epi16(vol);
+    int i = 0;
+    for (; i + 8 <= num_samples; i += 8) {
+        __m128i v = _mm_loadu_si128((__m128i *)(a + i));
+        // Full 32 bit products from the 16x16 multiply
+        __m128i lo16 = _mm_mullo_epi16(v, k);
+        __m128i hi16 = _mm_mulhi_epi16(v, k);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(lo16, hi16), 8);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(lo16, hi16), 8);
+        _mm_storeu_si128((__m128i *)(a + i), _mm_packs_epi32(lo, hi));
+    }
+    for (; i < num_samples; i++) {
+        int x = (a[i] * vol) >> 8;
+        a[i] = MPCLAMP(x, SHRT_MIN, SHRT_MAX);
+    }
+}
+
+// Scale by vol, clamping to [-1, 1] (hard clipping only).
+static void volume_float_sse2(float *a, int num_samples, float vol)
+{
+    __m128 k = _mm_set1_ps(vol);
+    __m128 min = _mm_set1_ps(-1.0);
+    __m128 max = _mm_set1_ps(1.0);
+    int i = 0;
+    for (; i + 4 <= num_samples; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(a + i), k);
+        _mm_storeu_ps(a + i, _mm_min_ps(_mm_max_ps(v, min), max));
+    }
+    for (; i < num_samples; i++) {
+        float x = a[i] * vol;
+        a[i] = MPCLAMP(x, -1.0, 1.0);
+    }
+}
+
+#endif
+
+// Apply a linear gain ramp from 'from' to 'to' over num_samples samples.
+static void ramp_plane(struct af_instance *af, void *ptr, int num_samples,
+                       float from, float to)
+{
+    struct priv *s = af->priv;
+    float step = (to - from) / num_samples;
+
+    if (af_fmt_from_planar(af->data->format) == AF_FORMAT_S16) {
+        int16_t *a = ptr;
+        for (int i = 0; i < num_samples; i++) {
+            int vol = 256.0 * (from + step * i);
+            int x = (a[i] * vol) >> 8;
+            a[i] = MPCLAMP(x, SHRT_MIN, SHRT_MAX);
+        }
+    } else if (af_fmt_from_planar(af->data->format) == AF_FORMAT_FLOAT) {
+        float *a = ptr;
+        for (int i = 0; i < num_samples; i++) {
+            float x = a[i] * (from + step * i);
+            a[i] = s->soft ? af_softclip(x) : MPCLAMP(x, -1.0, 1.0);
+        }
+    }
+}
+
 static void filter_plane(struct af_instance *af, void *ptr, int num_samples)
 {
     struct priv *s = af->priv;
@@ -74,6 +143,12 @@ static void filter_plane(struct af_instance *af, void *ptr, int num_samples)
         int16_t *a = ptr;
         int vol = 256.0 * s->level;
         if (vol != 256) {
+#if HAVE_SSE2 && defined(__SSE2__)
+            if (gCpuCaps.hasSSE2 && vol == (int16_t)vol) {
+                volume_s16_sse2(a, num_samples, vol);
+                return;
+            }
+#endif
             for (int i = 0; i < num_samples; i++) {
                 int x = (a[i] * vol) >> 8;
                 a[i] = MPCLAMP(x, SHRT_MIN, SHRT_MAX);
@@ -83,6 +158,12 @@ static void filter_plane(struct af_instance *af, void *ptr, int num_samples)
         float *a = ptr;
         float vol = s->level;
         if (vol != 1.0) {
+#if HAVE_SSE2 && defined(__SSE2__)
+            if (gCpuCaps.hasSSE2 && !s->soft) {
+                volume_float_sse2(a, num_samples, vol);
+                return;
+            }
+#endif
             for (int i = 0; i < num_samples; i++) {
                 float x = a[i] * vol;
                 a[i] = s->soft ? af_softclip(x) : MPCLAMP(x, -1.0, 1.0);
@@ -93,8 +174,22 @@ static void filter_plane(struct af_instance *af, void *ptr, int num_samples)
 
 static int filter(struct af_instance *af, struct mp_audio *data, int f)
 {
+    struct priv *s = af->priv;
+    int ramp = 0;
+
+    if (s->level_cur != s->level && data->samples > 0) {
+        // Fade to the new gain over a few ms; applying it instantly produces
+        // an audible step ("zipper" noise) on every change of a volume drag.
+        ramp = MPMIN(data->samples, data->rate / 100) * data->spf;
+        for (int n = 0; n < data->num_planes; n++)
+            ramp_plane(af, data->planes[n], ramp, s->level_cur, s->level);
+        s->level_cur = s->level;
+    }
+
+    int bps = data->sstride / data->spf;
     for (int n = 0; n < data->num_planes; n++)
-        filter_plane(af, data->planes[n], data->samples * data->spf);
+        filter_plane(af, (char *)data->planes[n] + ramp * bps,
+                     data->samples * data->spf - ramp);
 
     return 0;
 }
@@ -105,6 +200,7 @@ static int af_open(struct af_instance *af)
     af->control = control;
     af->filter = filter;
     af_from_dB(1, &s->cfg_volume, &s->level, 20.0, -200.0, 60.0);
+    s->level_cur = s->level;
     return AF_OK;
 }
 
@@ -29,8 +29,10 @@
 
 #include "options/options.h"
 #include "options/m_config.h"
+#include "options/path.h"
 #include "common/msg.h"
 #include "common/global.h"
+#include "misc/ring.h"
 
 extern const struct ao_driver audio_out_oss;
 extern const struct ao_driver audio_out_coreaudio;
@@ -165,6 +167,15 @@ static struct ao *ao_create(bool probing, struct mpv_global *global,
     if (!af_fmt_is_planar(ao->format))
         ao->sstride *= ao->channels.num;
     ao->bps = ao->samplerate * ao->sstride;
+    if (ao->driver->pull) {
+        assert(!af_fmt_is_planar(ao->format));
+        int samples = ao->pull_buffer_samples;
+        if (samples <= 0)
+            samples = ao->opts->low_latency
+                ? ao->samplerate / 20           // 50 ms
+                : ao->samplerate / 4;           // 250 ms
+        ao->pull_ring = mp_ring_new(ao, samples * ao->sstride);
+    }
     return ao;
 error:
     talloc_free(ao);
@@ -194,14 +205,30 @@ struct ao *ao_init_best(struct mpv_global *global,
         return NULL;
     }
 autoprobe:
+    // Try the AO that probed successfully last run first; see
+    // init_best_video_out().
+    {
+        char *cached = mp_read_cached_choice(NULL, "ao");
+        if (cached) {
+            struct ao *ao = ao_create(true, global, input_ctx, encode_lavc_ctx,
+                                      samplerate, format, channels, cached,
+                                      NULL);
+            talloc_free(cached);
+            if (ao)
+                return ao;
+        }
+    }
     // now try the rest...
     for (int i = 0; audio_out_drivers[i]; i++) {
         struct ao *ao = ao_create(true, global, input_ctx, encode_lavc_ctx,
                                   samplerate, format, channels,
                                   (char *)audio_out_drivers[i]->name, NULL);
-        if (ao)
+        if (ao) {
+            mp_write_cached_choice("ao", audio_out_drivers[i]->name);
             return ao;
+        }
     }
+    mp_write_cached_choice("ao", NULL);
     return NULL;
 }
 
@@ -213,9 +240,33 @@ void ao_uninit(struct ao *ao, bool cut_audio)
 
 int ao_play(struct ao *ao, void **data, int samples, int flags)
 {
+    if (ao->driver->pull) {
+        int written = mp_ring_write(ao->pull_ring, data[0],
+                                    samples * ao->sstride);
+        if (written > 0 && !ao->pull_started) {
+            // Pull AOs are expected to start their callback on resume().
+            ao->pull_started = true;
+            if (ao->driver->resume)
+                ao->driver->resume(ao);
+        }
+        return written / ao->sstride;
+    }
     return ao->driver->play(ao, data, samples, flags);
 }
 
+// Read len bytes of buffered audio into data, zero-filling whatever could
+// not be satisfied. Returns the number of bytes actually read. This is the
+// only entry point pull AOs may call from their audio thread/callback; it
+// never blocks and takes no locks.
+int ao_read_data(struct ao *ao, void *data, int len)
+{
+    assert(ao->driver->pull);
+    int got = mp_ring_read(ao->pull_ring, data, len);
+    if (got < len)
+        af_fill_silence((char *)data + got, len - got, ao->format);
+    return got;
+}
+
 int ao_control(struct ao *ao, enum aocontrol cmd, void *arg)
 {
     if (ao->driver->control)
@@ -225,6 +276,12 @@ int ao_control(struct ao *ao, enum aocontrol cmd, void *arg)
 
 double ao_get_delay(struct ao *ao)
 {
+    if (ao->driver->pull) {
+        double delay = mp_ring_buffered(ao->pull_ring) / (double)ao->bps;
+        if (ao->driver->get_delay)
+            delay += ao->driver->get_delay(ao);
+        return delay;
+    }
     if (!ao->driver->get_delay) {
         assert(ao->untimed);
         return 0;
@@ -234,13 +291,20 @@ double ao_get_delay(struct ao *ao)
 
 int ao_get_space(struct ao *ao)
 {
+    if (ao->driver->pull)
+        return mp_ring_available(ao->pull_ring) / ao->sstride;
     return ao->driver->get_space(ao);
 }
 
 void ao_reset(struct ao *ao)
 {
+    // Stop the driver's reader first, so the ring can be safely emptied.
     if (ao->driver->reset)
         ao->driver->reset(ao);
+    if (ao->driver->pull) {
+        mp_ring_reset(ao->pull_ring);
+        ao->pull_started = false;
+    }
 }
 
 void ao_pause(struct ao *ao)
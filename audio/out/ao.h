@@ -46,9 +46,16 @@ typedef struct ao_control_vol {
 } ao_control_vol_t;
 
 struct ao;
+struct mp_ring;
 
 struct ao_driver {
     bool encode;
+    // The AO has its own thread or callback consuming audio, and reads the
+    // data with ao_read_data() instead of implementing get_space/play. The
+    // common code buffers audio in a lock-free ring the callback can read
+    // from directly, without per-fragment wakeups of the playloop. Pull AOs
+    // must use packed (non-planar) sample formats.
+    bool pull;
     const char *name;
     const char *description;
     int (*control)(struct ao *ao, enum aocontrol cmd, void *arg);
@@ -57,6 +64,8 @@ struct ao_driver {
     void (*reset)(struct ao*ao);
     int (*get_space)(struct ao *ao);
     int (*play)(struct ao *ao, void **data, int samples, int flags);
+    // For pull AOs, this should return the device-side delay only; the
+    // buffered audio in the ring is added by the common code.
     float (*get_delay)(struct ao *ao);
     void (*pause)(struct ao *ao);
     void (*resume)(struct ao *ao);
@@ -83,6 +92,10 @@ struct ao {
     bool untimed;
     bool no_persistent_volume;  // the AO does the equivalent of af_volume
     bool per_application_mixer; // like above, but volume persists (per app)
+    struct mp_ring *pull_ring;  // buffered audio for pull AOs
+    int pull_buffer_samples;    // ring size; can be set by init(), otherwise
+                                // a default is used
+    bool pull_started;          // playback was started on first play()
     const struct ao_driver *driver;
     void *priv;
     struct encode_lavc_context *encode_lavc_ctx;
@@ -106,6 +119,7 @@ void ao_pause(struct ao *ao);
 void ao_resume(struct ao *ao);
 
 int ao_play_silence(struct ao *ao, int samples);
+int ao_read_data(struct ao *ao, void *data, int len);
 
 bool ao_chmap_sel_adjust(struct ao *ao, const struct mp_chmap_sel *s,
                          struct mp_chmap *map);
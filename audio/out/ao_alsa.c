@@ -48,6 +48,7 @@
 #include "ao.h"
 #include "audio/format.h"
 #include "audio/reorder_ch.h"
+#include "osdep/timer.h"
 
 struct priv {
     snd_pcm_t *alsa;
@@ -58,6 +59,12 @@ struct priv {
     int buffersize; // in frames
     int outburst; // in frames
 
+    // Cached device status, so that get_space() and get_delay() share one
+    // snd_pcm_status ioctl per playloop wakeup instead of issuing their own.
+    int64_t status_time; // mp_time_us() of the snapshot, 0 if invalid
+    snd_pcm_sframes_t status_avail;
+    snd_pcm_sframes_t status_delay;
+
     int cfg_block;
     char *cfg_device;
     char *cfg_mixer_device;
@@ -67,8 +74,13 @@ struct priv {
 };
 
 #define BUFFER_TIME 500000  // 0.5 s
+#define BUFFER_TIME_LOW_LATENCY 50000  // 50 ms
 #define FRAGCOUNT 16
 
+// How long a status snapshot stays valid; covers successive calls from the
+// same playloop iteration, but not the next wakeup.
+#define STATUS_VALID_US 1000
+
 #define CHECK_ALSA_ERROR(message) \
     do { \
         if (err < 0) { \
@@ -486,8 +498,10 @@ static int init(struct ao *ao)
             (p->alsa, alsa_hwparams, &ao->samplerate, NULL);
     CHECK_ALSA_ERROR("Unable to set samplerate-2");
 
+    unsigned int buffer_time =
+        ao->opts->low_latency ? BUFFER_TIME_LOW_LATENCY : BUFFER_TIME;
     err = snd_pcm_hw_params_set_buffer_time_near
-            (p->alsa, alsa_hwparams, &(unsigned int){BUFFER_TIME}, NULL);
+            (p->alsa, alsa_hwparams, &buffer_time, NULL);
     CHECK_ALSA_ERROR("Unable to set buffer time near");
 
     err = snd_pcm_hw_params_set_periods_near
@@ -583,6 +597,7 @@ static void audio_pause(struct ao *ao)
 
     if (p->can_pause) {
         p->delay_before_pause = get_delay(ao);
+        p->status_time = 0;
         err = snd_pcm_pause(p->alsa, 1);
         CHECK_ALSA_ERROR("pcm pause error");
     } else {
@@ -604,6 +619,7 @@ static void audio_resume(struct ao *ao)
     struct priv *p = ao->priv;
     int err;
 
+    p->status_time = 0;
     if (snd_pcm_state(p->alsa) == SND_PCM_STATE_SUSPENDED) {
         MP_INFO(ao, "PCM in suspend mode, trying to resume.\n");
         while ((err = snd_pcm_resume(p->alsa)) == -EAGAIN)
@@ -631,6 +647,7 @@ static void reset(struct ao *ao)
 
     p->prepause_frames = 0;
     p->delay_before_pause = 0;
+    p->status_time = 0;
     err = snd_pcm_drop(p->alsa);
     CHECK_ALSA_ERROR("pcm prepare error");
     err = snd_pcm_prepare(p->alsa);
@@ -673,26 +690,44 @@ static int play(struct ao *ao, void **data, int samples, int flags)
         }
     } while (res == 0);
 
+    p->status_time = 0;
     return res < 0 ? -1 : res;
 
 alsa_error:
     return -1;
 }
 
-/* how many byes are free in the buffer */
-static int get_space(struct ao *ao)
+static int update_status(struct ao *ao)
 {
     struct priv *p = ao->priv;
-    snd_pcm_status_t *status;
-    int err;
+    int64_t now = mp_time_us();
+
+    if (p->status_time && now - p->status_time <= STATUS_VALID_US)
+        return 0;
 
+    snd_pcm_status_t *status;
     snd_pcm_status_alloca(&status);
 
-    err = snd_pcm_status(p->alsa, status);
+    int err = snd_pcm_status(p->alsa, status);
+    if (err < 0)
+        return err;
+
+    p->status_avail = snd_pcm_status_get_avail(status);
+    p->status_delay = snd_pcm_status_get_delay(status);
+    p->status_time = now;
+    return 0;
+}
+
+/* how many byes are free in the buffer */
+static int get_space(struct ao *ao)
+{
+    struct priv *p = ao->priv;
+
+    int err = update_status(ao);
     CHECK_ALSA_ERROR("cannot get pcm status");
 
-    unsigned space = snd_pcm_status_get_avail(status);
-    if (space > p->buffersize) // Buffer underrun?
+    snd_pcm_sframes_t space = p->status_avail;
+    if (space < 0 || space > p->buffersize) // Buffer underrun?
         space = p->buffersize;
     return space;
 
@@ -704,17 +739,18 @@ alsa_error:
 static float get_delay(struct ao *ao)
 {
     struct priv *p = ao->priv;
-    snd_pcm_sframes_t delay;
 
     if (snd_pcm_state(p->alsa) == SND_PCM_STATE_PAUSED)
         return p->delay_before_pause;
 
-    if (snd_pcm_delay(p->alsa, &delay) < 0)
+    if (update_status(ao) < 0)
         return 0;
 
+    snd_pcm_sframes_t delay = p->status_delay;
     if (delay < 0) {
         /* underrun - move the application pointer forward to catch up */
         snd_pcm_forward(p->alsa, -delay);
+        p->status_time = 0;
         delay = 0;
     }
     return (float)delay / (float)ao->samplerate;
@@ -25,11 +25,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <libavutil/common.h>
 
 #include "talloc.h"
 
+#include "osdep/threads.h"
+
 #include "options/m_option.h"
 #include "audio/format.h"
 #include "audio/reorder_ch.h"
@@ -42,11 +47,35 @@
 #include <io.h>
 #endif
 
+// Size of each accumulation buffer. play() fills one while the writer
+// thread flushes the other, so dumping is not bound by write() latency.
+#define BUFFER_SIZE (4 * 1024 * 1024)
+
+// Grow the output file in steps of this size ahead of the writes.
+#define PREALLOC_STEP (32 * 1024 * 1024)
+
 struct priv {
     char *outputfilename;
     int waveheader;
     uint64_t data_length;
     FILE *fp;
+
+    long header_size;
+
+    // Buffered writing (see writer_thread)
+    pthread_t writer;
+    bool writer_running;
+    bool writer_exit;
+    bool write_error;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    uint8_t *buf[2];        // [0] is being filled, [1] is being flushed
+    int buf_len;            // bytes used in buf[0]
+    int flush_len;          // bytes left to flush from buf[1], 0 if idle
+
+    uint64_t flushed;       // file bytes written by the writer thread
+    uint64_t prealloc;      // file bytes preallocated so far
+    bool prealloc_failed;   // unsupported (e.g. pipe), don't retry
 };
 
 #define WAV_ID_RIFF 0x46464952 /* "RIFF" */
@@ -111,6 +140,63 @@ static void write_wave_header(struct ao *ao, FILE *fp, uint64_t data_length)
     fput32le(data_length, fp);
 }
 
+static void *writer_thread(void *arg)
+{
+    struct ao *ao = arg;
+    struct priv *priv = ao->priv;
+
+    mpthread_set_role("audio");
+    pthread_mutex_lock(&priv->lock);
+    while (1) {
+        while (!priv->flush_len && !priv->writer_exit)
+            pthread_cond_wait(&priv->wakeup, &priv->lock);
+        if (priv->flush_len) {
+            int len = priv->flush_len;
+            pthread_mutex_unlock(&priv->lock);
+
+#ifndef __MINGW32__
+            if (!priv->prealloc_failed &&
+                priv->flushed + len > priv->prealloc)
+            {
+                priv->prealloc += PREALLOC_STEP;
+                if (posix_fallocate(fileno(priv->fp), 0,
+                                    priv->header_size + priv->prealloc))
+                    priv->prealloc_failed = true;
+            }
+#endif
+            bool ok = fwrite(priv->buf[1], len, 1, priv->fp) == 1;
+            priv->flushed += len;
+
+            pthread_mutex_lock(&priv->lock);
+            if (!ok && !priv->write_error) {
+                priv->write_error = true;
+                MP_ERR(ao, "Error writing to output file!\n");
+            }
+            priv->flush_len = 0;
+            pthread_cond_broadcast(&priv->wakeup);
+        } else {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&priv->lock);
+    return NULL;
+}
+
+// Hand buf[0] to the writer thread. Must be called with priv->lock held.
+static void start_flush(struct priv *priv)
+{
+    while (priv->flush_len)
+        pthread_cond_wait(&priv->wakeup, &priv->lock);
+    if (!priv->buf_len)
+        return;
+    uint8_t *tmp = priv->buf[1];
+    priv->buf[1] = priv->buf[0];
+    priv->buf[0] = tmp;
+    priv->flush_len = priv->buf_len;
+    priv->buf_len = 0;
+    pthread_cond_broadcast(&priv->wakeup);
+}
+
 static int init(struct ao *ao)
 {
     struct priv *priv = ao->priv;
@@ -159,8 +245,23 @@ static int init(struct ao *ao)
     }
     if (priv->waveheader)  // Reserve space for wave header
         write_wave_header(ao, priv->fp, 0x7ffff000);
+    priv->header_size = ftell(priv->fp);
+    if (priv->header_size < 0)
+        priv->header_size = 0;
     ao->untimed = true;
 
+    priv->buf[0] = talloc_size(priv, BUFFER_SIZE);
+    priv->buf[1] = talloc_size(priv, BUFFER_SIZE);
+    pthread_mutex_init(&priv->lock, NULL);
+    pthread_cond_init(&priv->wakeup, NULL);
+    if (pthread_create(&priv->writer, NULL, writer_thread, ao)) {
+        // Writes stay synchronous in play()
+        pthread_cond_destroy(&priv->wakeup);
+        pthread_mutex_destroy(&priv->lock);
+    } else {
+        priv->writer_running = true;
+    }
+
     return 0;
 }
 
@@ -169,6 +270,29 @@ static void uninit(struct ao *ao, bool cut_audio)
 {
     struct priv *priv = ao->priv;
 
+    if (priv->writer_running) {
+        pthread_mutex_lock(&priv->lock);
+        start_flush(priv);              // flush the partial last buffer
+        while (priv->flush_len)
+            pthread_cond_wait(&priv->wakeup, &priv->lock);
+        priv->writer_exit = true;
+        pthread_cond_broadcast(&priv->wakeup);
+        pthread_mutex_unlock(&priv->lock);
+        pthread_join(priv->writer, NULL);
+        pthread_cond_destroy(&priv->wakeup);
+        pthread_mutex_destroy(&priv->lock);
+    }
+
+#ifndef __MINGW32__
+    if (priv->prealloc > 0) {
+        // Cut the file back from the preallocated size to the real one.
+        fflush(priv->fp);
+        if (ftruncate(fileno(priv->fp),
+                      priv->header_size + priv->data_length))
+            MP_ERR(ao, "Could not truncate preallocated output file!\n");
+    }
+#endif
+
     if (priv->waveheader) {    // Rewrite wave header
         bool broken_seek = false;
 #ifdef __MINGW32__
@@ -201,7 +325,29 @@ static int play(struct ao *ao, void **data, int samples, int flags)
     struct priv *priv = ao->priv;
     int len = samples * ao->sstride;
 
-    fwrite(data[0], len, 1, priv->fp);
+    if (!priv->writer_running) {
+        fwrite(data[0], len, 1, priv->fp);
+        priv->data_length += len;
+        return len / ao->sstride;
+    }
+
+    uint8_t *src = data[0];
+    int left = len;
+    pthread_mutex_lock(&priv->lock);
+    while (left > 0) {
+        int space = BUFFER_SIZE - priv->buf_len;
+        if (!space) {
+            start_flush(priv);
+            continue;
+        }
+        int copy = MPMIN(space, left);
+        memcpy(priv->buf[0] + priv->buf_len, src, copy);
+        priv->buf_len += copy;
+        src += copy;
+        left -= copy;
+    }
+    pthread_mutex_unlock(&priv->lock);
+
     priv->data_length += len;
     return len / ao->sstride;
 }
@@ -27,7 +27,6 @@
 #include "options/m_option.h"
 #include "osdep/timer.h"
 
-#include <libavutil/fifo.h>
 #include <libavutil/common.h>
 #include <SDL.h>
 
@@ -36,11 +35,6 @@
 
 struct priv
 {
-    AVFifoBuffer *buffer;
-    SDL_mutex *buffer_mutex;
-    SDL_cond *underrun_cond;
-    bool unpause;
-    bool paused;
 #ifdef ESTIMATE_DELAY
     int64_t callback_time0;
     int64_t callback_time1;
@@ -52,29 +46,16 @@ struct priv
 static void audio_callback(void *userdata, Uint8 *stream, int len)
 {
     struct ao *ao = userdata;
-    struct priv *priv = ao->priv;
-
-    SDL_LockMutex(priv->buffer_mutex);
 
 #ifdef ESTIMATE_DELAY
+    struct priv *priv = ao->priv;
     priv->callback_time1 = priv->callback_time0;
     priv->callback_time0 = mp_time_us();
 #endif
 
-    while (len > 0 && !priv->paused) {
-        int got = av_fifo_size(priv->buffer);
-        if (got > len)
-            got = len;
-        if (got > 0) {
-            av_fifo_generic_read(priv->buffer, stream, got, NULL);
-            len -= got;
-            stream += got;
-        }
-        if (len > 0)
-            SDL_CondWait(priv->underrun_cond, priv->buffer_mutex);
-    }
-
-    SDL_UnlockMutex(priv->buffer_mutex);
+    // Zero-fills on underrun (instead of waiting for more data like the
+    // old fifo did, which could block the SDL audio thread forever).
+    ao_read_data(ao, stream, len);
 }
 
 static void uninit(struct ao *ao, bool cut_audio)
@@ -83,17 +64,7 @@ static void uninit(struct ao *ao, bool cut_audio)
     if (!priv)
         return;
 
-    // abort the callback
-    priv->paused = 1;
-
     if (SDL_WasInit(SDL_INIT_AUDIO)) {
-        if (priv->buffer_mutex)
-            SDL_LockMutex(priv->buffer_mutex);
-        if (priv->underrun_cond)
-            SDL_CondSignal(priv->underrun_cond);
-        if (priv->buffer_mutex)
-            SDL_UnlockMutex(priv->buffer_mutex);
-
         // make sure the callback exits
         SDL_LockAudio();
 
@@ -101,14 +72,6 @@ static void uninit(struct ao *ao, bool cut_audio)
         SDL_QuitSubSystem(SDL_INIT_AUDIO);
     }
 
-    // get rid of the mutex
-    if (priv->underrun_cond)
-        SDL_DestroyCond(priv->underrun_cond);
-    if (priv->buffer_mutex)
-        SDL_DestroyMutex(priv->buffer_mutex);
-    if (priv->buffer)
-        av_fifo_free(priv->buffer);
-
     talloc_free(ao->priv);
     ao->priv = NULL;
 }
@@ -226,104 +189,42 @@ static int init(struct ao *ao)
     }
 
     ao->samplerate = obtained.freq;
-    priv->buffer = av_fifo_alloc(obtained.size * priv->bufcnt);
-    priv->buffer_mutex = SDL_CreateMutex();
-    if (!priv->buffer_mutex) {
-        MP_ERR(ao, "SDL_CreateMutex failed\n");
-        uninit(ao, true);
-        return -1;
-    }
-    priv->underrun_cond = SDL_CreateCond();
-    if (!priv->underrun_cond) {
-        MP_ERR(ao, "SDL_CreateCond failed\n");
-        uninit(ao, true);
-        return -1;
-    }
+    int framesize = af_fmt2bits(ao->format) / 8 * ao->channels.num;
+    ao->pull_buffer_samples = obtained.size * priv->bufcnt / framesize;
 
-    priv->unpause = 1;
-    priv->paused = 1;
+#ifdef ESTIMATE_DELAY
     priv->callback_time0 = priv->callback_time1 = mp_time_us();
+#endif
 
     return 1;
 }
 
 static void reset(struct ao *ao)
 {
-    struct priv *priv = ao->priv;
-    SDL_LockMutex(priv->buffer_mutex);
-    av_fifo_reset(priv->buffer);
-    SDL_UnlockMutex(priv->buffer_mutex);
-}
-
-static int get_space(struct ao *ao)
-{
-    struct priv *priv = ao->priv;
-    SDL_LockMutex(priv->buffer_mutex);
-    int space = av_fifo_space(priv->buffer);
-    SDL_UnlockMutex(priv->buffer_mutex);
-    return space / ao->sstride;
+    // stop the callback, so the common code can safely reset the ring
+    SDL_PauseAudio(SDL_TRUE);
 }
 
 static void pause(struct ao *ao)
 {
-    struct priv *priv = ao->priv;
     SDL_PauseAudio(SDL_TRUE);
-    priv->unpause = 0;
-    priv->paused = 1;
-    SDL_CondSignal(priv->underrun_cond);
-}
-
-static void do_resume(struct ao *ao)
-{
-    struct priv *priv = ao->priv;
-    priv->paused = 0;
-    SDL_PauseAudio(SDL_FALSE);
 }
 
 static void resume(struct ao *ao)
 {
-    struct priv *priv = ao->priv;
-    SDL_LockMutex(priv->buffer_mutex);
-    int free = av_fifo_space(priv->buffer);
-    SDL_UnlockMutex(priv->buffer_mutex);
-    if (free)
-        priv->unpause = 1;
-    else
-        do_resume(ao);
-}
-
-static int play(struct ao *ao, void **data, int samples, int flags)
-{
-    struct priv *priv = ao->priv;
-    int len = samples * ao->sstride;
-    SDL_LockMutex(priv->buffer_mutex);
-    int free = av_fifo_space(priv->buffer);
-    if (len > free) len = free;
-    av_fifo_generic_write(priv->buffer, data[0], len, NULL);
-    SDL_CondSignal(priv->underrun_cond);
-    SDL_UnlockMutex(priv->buffer_mutex);
-    if (priv->unpause) {
-        priv->unpause = 0;
-        do_resume(ao);
-    }
-    return len / ao->sstride;
+    SDL_PauseAudio(SDL_FALSE);
 }
 
 static float get_delay(struct ao *ao)
 {
-    struct priv *priv = ao->priv;
-    SDL_LockMutex(priv->buffer_mutex);
-    int sz = av_fifo_size(priv->buffer);
 #ifdef ESTIMATE_DELAY
+    struct priv *priv = ao->priv;
+
+    SDL_LockAudio();
     int64_t callback_time0 = priv->callback_time0;
     int64_t callback_time1 = priv->callback_time1;
-#endif
-    SDL_UnlockMutex(priv->buffer_mutex);
-
-    // delay component: our FIFO's length
-    float delay = sz / (float) ao->bps;
+    SDL_UnlockAudio();
 
-#ifdef ESTIMATE_DELAY
     // delay component: outstanding audio living in SDL
 
     int64_t current_time = mp_time_us();
@@ -341,10 +242,10 @@ static float get_delay(struct ao *ao)
     // provided by the callback
     buffer_interval += callback_interval;
 
-    delay += buffer_interval / 1000000.0;
+    return buffer_interval / 1000000.0;
+#else
+    return 0;
 #endif
-
-    return delay;
 }
 
 #define OPT_BASE_STRUCT struct priv
@@ -352,10 +253,9 @@ static float get_delay(struct ao *ao)
 const struct ao_driver audio_out_sdl = {
     .description = "SDL Audio",
     .name      = "sdl",
+    .pull      = true,
     .init      = init,
     .uninit    = uninit,
-    .get_space = get_space,
-    .play      = play,
     .get_delay = get_delay,
     .pause     = pause,
     .resume    = resume,
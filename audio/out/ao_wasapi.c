@@ -111,6 +111,7 @@ typedef struct wasapi_state {
     REFERENCE_TIME
         defaultRequestedDuration; /* default wasapi default block size, in 100-nanosecond units */
     UINT32 bufferFrameCount; /* wasapi buffer block size, number of frames, frame size at format.nBlockAlign */
+    REFERENCE_TIME streamLatency; /* stream latency reported by wasapi, in 100-nanosecond units */
 
     /* WASAPI handles, owned by other thread */
     IMMDevice *pDevice;
@@ -598,6 +599,11 @@ reinit:
     hr = IAudioClient_GetBufferSize(state->pAudioClient,
                                     &state->bufferFrameCount);
     EXIT_ON_ERROR(hr);
+    /* device/driver side latency on top of our own buffering, needed for
+       correct get_delay(); failure just means we underreport the delay */
+    if (IAudioClient_GetStreamLatency(state->pAudioClient,
+                                      &state->streamLatency) != S_OK)
+        state->streamLatency = 0;
     state->buffer_block_size = state->format.Format.nChannels *
                                state->format.Format.wBitsPerSample / 8 *
                                state->bufferFrameCount;
@@ -1367,8 +1373,12 @@ static float get_delay(struct ao *ao)
     if (!ao || !ao->priv)
         return -1.0f;
     struct wasapi_state *state = (struct wasapi_state *)ao->priv;
+    /* data still queued in our ring, plus the device buffer the feed thread
+       writes into, plus whatever extra latency wasapi reported for the stream */
     return (float)(RING_BUFFER_COUNT * state->buffer_block_size - get_space(ao) * ao->sstride) /
-           (float)state->format.Format.nAvgBytesPerSec;
+           (float)state->format.Format.nAvgBytesPerSec +
+           (float)state->bufferFrameCount / (float)state->format.Format.nSamplesPerSec +
+           (float)state->streamLatency / 1e7f;
 }
 
 #define OPT_BASE_STRUCT struct wasapi_state
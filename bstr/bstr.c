@@ -59,10 +59,8 @@ int bstrcasecmp(struct bstr str1, struct bstr str2)
 
 int bstrchr(struct bstr str, int c)
 {
-    for (int i = 0; i < str.len; i++)
-        if (str.start[i] == c)
-            return i;
-    return -1;
+    unsigned char *p = memchr(str.start, c, str.len);
+    return p ? p - str.start : -1;
 }
 
 int bstrrchr(struct bstr str, int c)
@@ -93,9 +91,20 @@ int bstrspn(struct bstr str, const char *accept)
 
 int bstr_find(struct bstr haystack, struct bstr needle)
 {
-    for (int i = 0; i < haystack.len; i++)
-        if (bstr_startswith(bstr_splice(haystack, i, haystack.len), needle))
-            return i;
+    if (!needle.len)
+        return haystack.len ? 0 : -1;
+    // Let memchr() skip to candidate positions (it's typically vectorized),
+    // and compare the rest of the needle only there.
+    unsigned char *start = haystack.start;
+    unsigned char *end = start + haystack.len;
+    for (unsigned char *p = start; end - p >= needle.len;) {
+        p = memchr(p, needle.start[0], end - p - (needle.len - 1));
+        if (!p)
+            break;
+        if (memcmp(p, needle.start, needle.len) == 0)
+            return p - start;
+        p++;
+    }
     return -1;
 }
 
@@ -120,7 +120,9 @@ void mp_set_av_packet(AVPacket *dst, struct demux_packet *mpkt, AVRational *tb)
 void mp_set_avcodec_threads(AVCodecContext *avctx, int threads)
 {
     if (threads == 0) {
-        threads = default_thread_count();
+        // Frame threads do real work per thread; SMT siblings only get in
+        // the way, so size by physical cores.
+        threads = physical_core_count();
         if (threads < 1) {
             mp_msg(MSGT_GLOBAL, MSGL_WARN, "Could not determine "
                    "thread count to use, defaulting to 1.\n");
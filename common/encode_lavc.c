@@ -94,6 +94,10 @@ static bool value_has_flag(const char *value, const char *flag)
     return ret;
 }
 
+// Maximum number of encoded packets buffered for the muxer thread. When the
+// queue is full (muxer stalled on I/O), encode_lavc_write_frame() blocks.
+#define MUX_QUEUE_MAX 64
+
 #define CHECK_FAIL(ctx, val) \
     if (ctx && (ctx->failed || ctx->finished)) { \
         mp_msg(MSGT_ENCODE, MSGL_ERR, \
@@ -231,6 +235,57 @@ struct encode_lavc_context *encode_lavc_init(struct encode_output_conf *options)
     return ctx;
 }
 
+static void *mux_thread(void *arg)
+{
+    struct encode_lavc_context *ctx = arg;
+
+    pthread_mutex_lock(&ctx->mux_lock);
+    while (1) {
+        if (!ctx->num_mux_queue) {
+            if (ctx->mux_exit)
+                break;
+            pthread_cond_wait(&ctx->mux_wakeup, &ctx->mux_lock);
+            continue;
+        }
+        AVPacket packet = ctx->mux_queue[0];
+        ctx->num_mux_queue -= 1;
+        memmove(ctx->mux_queue, ctx->mux_queue + 1,
+                ctx->num_mux_queue * sizeof(AVPacket));
+        pthread_cond_broadcast(&ctx->mux_wakeup);
+        pthread_mutex_unlock(&ctx->mux_lock);
+
+        // takes ownership of the packet data
+        int r = av_interleaved_write_frame(ctx->avc, &packet);
+
+        pthread_mutex_lock(&ctx->mux_lock);
+        if (r < 0 && !ctx->mux_error)
+            ctx->mux_error = r;
+    }
+    pthread_mutex_unlock(&ctx->mux_lock);
+    return NULL;
+}
+
+// Drain the packet queue and terminate the muxer thread. Must be called
+// before writing the trailer or touching ctx->avc from the calling thread.
+static void mux_stop(struct encode_lavc_context *ctx)
+{
+    if (!ctx->mux_thread_valid)
+        return;
+
+    pthread_mutex_lock(&ctx->mux_lock);
+    ctx->mux_exit = true;
+    pthread_cond_broadcast(&ctx->mux_wakeup);
+    pthread_mutex_unlock(&ctx->mux_lock);
+    pthread_join(ctx->mux_thread, NULL);
+    pthread_cond_destroy(&ctx->mux_wakeup);
+    pthread_mutex_destroy(&ctx->mux_lock);
+    ctx->mux_thread_valid = false;
+
+    if (ctx->mux_error)
+        mp_msg(MSGT_ENCODE, MSGL_ERR,
+               "encode-lavc: error writing queued packets\n");
+}
+
 int encode_lavc_start(struct encode_lavc_context *ctx)
 {
     AVDictionaryEntry *de;
@@ -294,6 +349,19 @@ int encode_lavc_start(struct encode_lavc_context *ctx)
     av_dict_free(&ctx->foptions);
 
     ctx->header_written = 1;
+
+    ctx->mux_queue = talloc_array(ctx, AVPacket, MUX_QUEUE_MAX);
+    pthread_mutex_init(&ctx->mux_lock, NULL);
+    pthread_cond_init(&ctx->mux_wakeup, NULL);
+    if (pthread_create(&ctx->mux_thread, NULL, mux_thread, ctx) == 0) {
+        ctx->mux_thread_valid = true;
+    } else {
+        mp_msg(MSGT_ENCODE, MSGL_WARN, "encode-lavc: could not create muxer "
+               "thread, writing packets synchronously\n");
+        pthread_cond_destroy(&ctx->mux_wakeup);
+        pthread_mutex_destroy(&ctx->mux_lock);
+    }
+
     return 1;
 }
 
@@ -319,6 +387,8 @@ void encode_lavc_finish(struct encode_lavc_context *ctx)
     if (ctx->finished)
         return;
 
+    mux_stop(ctx);
+
     if (ctx->avc) {
         if (ctx->header_written > 0)
             av_write_trailer(ctx->avc);  // this is allowed to fail
@@ -748,6 +818,29 @@ int encode_lavc_write_frame(struct encode_lavc_context *ctx, AVPacket *packet)
         break;
     }
 
+    if (ctx->mux_thread_valid) {
+        pthread_mutex_lock(&ctx->mux_lock);
+        r = ctx->mux_error;
+        while (!r && ctx->num_mux_queue == MUX_QUEUE_MAX) {
+            pthread_cond_wait(&ctx->mux_wakeup, &ctx->mux_lock);
+            r = ctx->mux_error;
+        }
+        if (!r) {
+            // The packet data lives in an encoder-owned buffer that may be
+            // recycled for the next frame, so the queued copy must own it.
+            AVPacket *dst = &ctx->mux_queue[ctx->num_mux_queue];
+            *dst = *packet;
+            if (av_dup_packet(dst) >= 0) {
+                ctx->num_mux_queue += 1;
+                pthread_cond_broadcast(&ctx->mux_wakeup);
+            } else {
+                r = AVERROR(ENOMEM);
+            }
+        }
+        pthread_mutex_unlock(&ctx->mux_lock);
+        return r;
+    }
+
     r = av_interleaved_write_frame(ctx->avc, packet);
 
     return r;
@@ -22,6 +22,8 @@
 #ifndef MPLAYER_ENCODE_LAVC_H
 #define MPLAYER_ENCODE_LAVC_H
 
+#include <pthread.h>
+
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/avstring.h>
@@ -70,6 +72,18 @@ struct encode_lavc_context {
     bool video_first;
     bool audio_first;
 
+    // Muxer thread. encode_lavc_write_frame() queues packets here; the
+    // thread feeds them to av_interleaved_write_frame() (which does the
+    // DTS interleaving), so the encoders never block on muxer I/O.
+    pthread_t mux_thread;
+    bool mux_thread_valid;
+    pthread_mutex_t mux_lock;
+    pthread_cond_t mux_wakeup;
+    AVPacket *mux_queue;    // FIFO of packets owning their data
+    int num_mux_queue;
+    bool mux_exit;          // exit the thread once the queue is drained
+    int mux_error;          // first av_interleaved_write_frame() error
+
     // has encoding failed?
     bool failed;
     bool finished;
@@ -7,6 +7,8 @@
 struct mpv_global {
     struct MPOpts *opts;
     struct mp_log *log;
+    // Shared worker threads for background jobs (can be NULL).
+    struct mp_thread_pool *thread_pool;
 };
 
 #endif
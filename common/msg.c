@@ -22,6 +22,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "talloc.h"
 
@@ -60,6 +61,36 @@ static struct mp_log *legacy_logs[MSGT_MAX];
 /* maximum message length of mp_msg */
 #define MSGSIZE_MAX 6144
 
+// A message detached from its mp_log (which might be deallocated before the
+// message is printed in async mode).
+struct msg_entry {
+    int lev;
+    int mod;
+    char *prefix;           // may be NULL
+    char *verbose_prefix;
+    char *text;
+};
+
+// Maximum number of queued messages in async mode; overflow drops messages
+// (and counts them) instead of blocking the producer.
+#define ASYNC_QUEUE_SIZE 256
+
+// Writer thread state for async mode (enabled with MPV_MSG_ASYNC). Like the
+// rest of the mp_msg state, this should not be global.
+static struct {
+    pthread_t thread;
+    bool active;
+    bool terminate;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    struct msg_entry *queue[ASYNC_QUEUE_SIZE];
+    int head, num;
+    unsigned int dropped;
+} async_ctx = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wakeup = PTHREAD_COND_INITIALIZER,
+};
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -161,43 +192,39 @@ static void set_msg_color(FILE* stream, int lev)
     }
 }
 
-static void print_msg_module(FILE* stream, struct mp_log *log)
+static void print_msg_module(FILE* stream, int mod, const char *verbose_prefix)
 {
-    int mod = log->legacy_mod;
     int c2 = (mod + 1) % 15 + 1;
 
 #ifdef _WIN32
     HANDLE *wstream = stream == stderr ? hSTDERR : hSTDOUT;
     if (mp_msg_docolor())
         SetConsoleTextAttribute(wstream, ansi2win32[c2&7] | FOREGROUND_INTENSITY);
-    fprintf(stream, "%9s", log->verbose_prefix);
+    fprintf(stream, "%9s", verbose_prefix);
     if (mp_msg_docolor())
         SetConsoleTextAttribute(wstream, stdoutAttrs);
 #else
     if (mp_msg_docolor())
         fprintf(stream, "\033[%d;3%dm", c2 >> 3, c2 & 7);
-    fprintf(stream, "%9s", log->verbose_prefix);
+    fprintf(stream, "%9s", verbose_prefix);
     if (mp_msg_docolor())
         fprintf(stream, "\033[0;37m");
 #endif
     fprintf(stream, ": ");
 }
 
-static void mp_msg_log_va(struct mp_log *log, int lev, const char *format,
-                          va_list va)
+// Write a message to the terminal. Must be called from one thread only (the
+// caller's thread in sync mode, the writer thread in async mode), because of
+// the header/statusline state.
+static void print_entry(struct msg_entry *e)
 {
-    char tmp[MSGSIZE_MAX];
+    int lev = e->lev;
     FILE *stream =
         (mp_msg_stdout_in_use || (lev == MSGL_STATUS)) ? stderr : stdout;
     static int header = 1;
     // indicates if last line printed was a status line
     static int statusline;
 
-    if (!mp_msg_test_log(log, lev)) return; // do not display
-    vsnprintf(tmp, MSGSIZE_MAX, format, va);
-    tmp[MSGSIZE_MAX-2] = '\n';
-    tmp[MSGSIZE_MAX-1] = 0;
-
     /* A status line is normally intended to be overwritten by the next
      * status line, and does not end with a '\n'. If we're printing a normal
      * line instead after the status one print '\n' to change line. */
@@ -208,19 +235,19 @@ static void mp_msg_log_va(struct mp_log *log, int lev, const char *format,
     set_msg_color(stream, lev);
     if (header) {
         if (mp_msg_module) {
-            print_msg_module(stream, log);
+            print_msg_module(stream, e->mod, e->verbose_prefix);
             set_msg_color(stream, lev);
         } else if (lev >= MSGL_V || verbose) {
-            fprintf(stream, "[%s] ", log->verbose_prefix);
-        } else if (log->prefix) {
-            fprintf(stream, "[%s] ", log->prefix);
+            fprintf(stream, "[%s] ", e->verbose_prefix);
+        } else if (e->prefix) {
+            fprintf(stream, "[%s] ", e->prefix);
         }
     }
 
-    size_t len = strlen(tmp);
-    header = len && (tmp[len-1] == '\n' || tmp[len-1] == '\r');
+    size_t len = strlen(e->text);
+    header = len && (e->text[len-1] == '\n' || e->text[len-1] == '\r');
 
-    fprintf(stream, "%s", tmp);
+    fprintf(stream, "%s", e->text);
 
     if (mp_msg_docolor())
     {
@@ -234,6 +261,120 @@ static void mp_msg_log_va(struct mp_log *log, int lev, const char *format,
     fflush(stream);
 }
 
+// Queue the message for the writer thread. Returns false if async mode is
+// not active and the caller should print the message itself.
+static bool async_enqueue(struct mp_log *log, int lev, const char *text)
+{
+    pthread_mutex_lock(&async_ctx.lock);
+    bool active = async_ctx.active;
+    if (active) {
+        // Rate-limit status line updates: an unprinted status line would be
+        // overwritten by this one anyway, so replace it.
+        struct msg_entry *tail = async_ctx.num
+            ? async_ctx.queue[(async_ctx.head + async_ctx.num - 1)
+                              % ASYNC_QUEUE_SIZE]
+            : NULL;
+        if (lev == MSGL_STATUS && tail && tail->lev == MSGL_STATUS) {
+            talloc_free(tail->text);
+            tail->text = talloc_strdup(tail, text);
+        } else if (async_ctx.num == ASYNC_QUEUE_SIZE) {
+            // Never block on the (possibly very slow) terminal; count
+            // dropped messages instead.
+            async_ctx.dropped++;
+        } else {
+            struct msg_entry *e = talloc_zero(NULL, struct msg_entry);
+            e->lev = lev;
+            e->mod = log->legacy_mod;
+            e->prefix = talloc_strdup(e, log->prefix);
+            e->verbose_prefix = talloc_strdup(e, log->verbose_prefix);
+            e->text = talloc_strdup(e, text);
+            async_ctx.queue[(async_ctx.head + async_ctx.num)
+                            % ASYNC_QUEUE_SIZE] = e;
+            async_ctx.num++;
+            pthread_cond_signal(&async_ctx.wakeup);
+        }
+    }
+    pthread_mutex_unlock(&async_ctx.lock);
+    return active;
+}
+
+static void *async_writer_thread(void *arg)
+{
+    pthread_mutex_lock(&async_ctx.lock);
+    while (async_ctx.num || !async_ctx.terminate) {
+        if (!async_ctx.num) {
+            pthread_cond_wait(&async_ctx.wakeup, &async_ctx.lock);
+            continue;
+        }
+        struct msg_entry *e = async_ctx.queue[async_ctx.head];
+        async_ctx.head = (async_ctx.head + 1) % ASYNC_QUEUE_SIZE;
+        async_ctx.num--;
+        unsigned int dropped = async_ctx.dropped;
+        async_ctx.dropped = 0;
+        pthread_mutex_unlock(&async_ctx.lock);
+        if (dropped) {
+            struct msg_entry note = {
+                .lev = MSGL_WARN,
+                .mod = MSGT_GLOBAL,
+                .verbose_prefix = "global",
+                .text = talloc_asprintf(NULL, "%u log messages dropped\n",
+                                        dropped),
+            };
+            print_entry(&note);
+            talloc_free(note.text);
+        }
+        print_entry(e);
+        talloc_free(e);
+        pthread_mutex_lock(&async_ctx.lock);
+    }
+    pthread_mutex_unlock(&async_ctx.lock);
+    return NULL;
+}
+
+static void async_writer_start(void)
+{
+    if (async_ctx.active)
+        return;
+    async_ctx.terminate = false;
+    if (pthread_create(&async_ctx.thread, NULL, async_writer_thread, NULL) == 0)
+        async_ctx.active = true;
+}
+
+static void async_writer_stop(void)
+{
+    pthread_mutex_lock(&async_ctx.lock);
+    bool active = async_ctx.active;
+    async_ctx.active = false;       // new messages are printed synchronously
+    async_ctx.terminate = true;
+    pthread_cond_signal(&async_ctx.wakeup);
+    pthread_mutex_unlock(&async_ctx.lock);
+    if (active)
+        pthread_join(async_ctx.thread, NULL);
+}
+
+static void mp_msg_log_va(struct mp_log *log, int lev, const char *format,
+                          va_list va)
+{
+    char tmp[MSGSIZE_MAX];
+
+    if (!mp_msg_test_log(log, lev)) return; // do not display
+    vsnprintf(tmp, MSGSIZE_MAX, format, va);
+    tmp[MSGSIZE_MAX-2] = '\n';
+    tmp[MSGSIZE_MAX-1] = 0;
+
+    if (async_enqueue(log, lev, tmp))
+        return;
+
+    struct msg_entry e = {
+        .lev = lev,
+        .mod = log->legacy_mod,
+        .prefix = (char *)log->prefix,
+        .verbose_prefix = (char *)log->verbose_prefix,
+        .text = tmp,
+    };
+    print_entry(&e);
+}
+
 void mp_msg_va(int mod, int lev, const char *format, va_list va)
 {
     assert(initialized);
@@ -357,6 +498,13 @@ void mp_msg_init(struct mpv_global *global)
     }
     mp_msg_do_init();
 
+    // Decouple message output from the threads producing them: bounded
+    // queue drained by a writer thread, dropping on overflow. Mainly for
+    // setups where the terminal itself is slow (e.g. serial consoles).
+    char *async = getenv("MPV_MSG_ASYNC");
+    if (async && atoi(async))
+        async_writer_start();
+
     global->log = log;
     initialized = true;
 }
@@ -368,6 +516,7 @@ struct mpv_global *mp_log_get_global(struct mp_log *log)
 
 void mp_msg_uninit(struct mpv_global *global)
 {
+    async_writer_stop();
     talloc_free(global->log->root);
     global->log = NULL;
     initialized = false;
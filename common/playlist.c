@@ -68,6 +68,8 @@ void playlist_insert(struct playlist *pl, struct playlist_entry *after,
         pl->last = add;
     }
     add->pl = pl;
+    pl->num_entries += 1;
+    pl->cache_valid = false;
     talloc_steal(pl, add);
 }
 
@@ -98,6 +100,25 @@ static void playlist_unlink(struct playlist *pl, struct playlist_entry *entry)
     entry->next = entry->prev = NULL;
     // xxx: we'd want to reset the talloc parent of entry
     entry->pl = NULL;
+    pl->num_entries -= 1;
+    pl->cache_valid = false;
+}
+
+// Make sure pl->cache is an array of all entries in list order, and that
+// each entry's cache_index is its position in it.
+static void playlist_update_cache(struct playlist *pl)
+{
+    if (pl->cache_valid)
+        return;
+    pl->cache = talloc_realloc(pl, pl->cache, struct playlist_entry *,
+                               pl->num_entries);
+    int n = 0;
+    for (struct playlist_entry *e = pl->first; e; e = e->next) {
+        e->cache_index = n;
+        pl->cache[n++] = e;
+    }
+    assert(n == pl->num_entries);
+    pl->cache_valid = true;
 }
 
 void playlist_remove(struct playlist *pl, struct playlist_entry *entry)
@@ -133,36 +154,26 @@ void playlist_add_file(struct playlist *pl, const char *filename)
     playlist_add(pl, playlist_entry_new(filename));
 }
 
-static int playlist_count(struct playlist *pl)
-{
-    int c = 0;
-    for (struct playlist_entry *e = pl->first; e; e = e->next)
-        c++;
-    return c;
-}
-
 void playlist_shuffle(struct playlist *pl)
 {
-    struct playlist_entry *save_current = pl->current;
-    bool save_replaced = pl->current_was_replaced;
-    int count = playlist_count(pl);
-    struct playlist_entry **arr = talloc_array(NULL, struct playlist_entry *,
-                                               count);
-    for (int n = 0; n < count; n++) {
-        arr[n] = pl->first;
-        playlist_unlink(pl, pl->first);
-    }
-    for (int n = 0; n < count; n++) {
-        int other = (int)((double)(count) * rand() / (RAND_MAX + 1.0));
+    playlist_update_cache(pl);
+    struct playlist_entry **arr = pl->cache;
+    int count = pl->num_entries;
+    // Fisher-Yates
+    for (int n = count - 1; n > 0; n--) {
+        int other = (int)((double)(n + 1) * rand() / (RAND_MAX + 1.0));
         struct playlist_entry *tmp = arr[n];
         arr[n] = arr[other];
         arr[other] = tmp;
     }
-    for (int n = 0; n < count; n++)
-        playlist_add(pl, arr[n]);
-    talloc_free(arr);
-    pl->current = save_current;
-    pl->current_was_replaced = save_replaced;
+    // Relink the list in the new order; the shuffled cache stays valid.
+    pl->first = count ? arr[0] : NULL;
+    pl->last = count ? arr[count - 1] : NULL;
+    for (int n = 0; n < count; n++) {
+        arr[n]->prev = n > 0 ? arr[n - 1] : NULL;
+        arr[n]->next = n + 1 < count ? arr[n + 1] : NULL;
+        arr[n]->cache_index = n;
+    }
 }
 
 struct playlist_entry *playlist_get_next(struct playlist *pl, int direction)
@@ -211,31 +222,24 @@ void playlist_transfer_entries(struct playlist *pl, struct playlist *source_pl)
 // Return -1 if e is not on the list, or if e is NULL.
 int playlist_entry_to_index(struct playlist *pl, struct playlist_entry *e)
 {
-    struct playlist_entry *cur = pl->first;
-    int pos = 0;
-    if (!e)
+    if (!e || e->pl != pl)
         return -1;
-    while (cur && cur != e) {
-        cur = cur->next;
-        pos++;
-    }
-    return cur == e ? pos : -1;
+    playlist_update_cache(pl);
+    return e->cache_index;
 }
 
 int playlist_entry_count(struct playlist *pl)
 {
-    return playlist_entry_to_index(pl, pl->last) + 1;
+    return pl->num_entries;
 }
 
 // Return entry for which playlist_entry_to_index() would return index.
 // Return NULL if not found.
 struct playlist_entry *playlist_entry_from_index(struct playlist *pl, int index)
 {
-    struct playlist_entry *e = pl->first;
-    for (int n = 0; ; n++) {
-        if (!e || n == index)
-            return e;
-        e = e->next;
-    }
+    if (index < 0 || index >= pl->num_entries)
+        return NULL;
+    playlist_update_cache(pl);
+    return pl->cache[index];
 }
 
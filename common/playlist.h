@@ -41,6 +41,9 @@ struct playlist_entry {
     bool playback_short : 1;
     // Set to true if not at least 1 frame (audio or video) could be played.
     bool init_failed : 1;
+
+    // Index into playlist->cache. Valid only while playlist->cache_valid.
+    int cache_index;
 };
 
 struct playlist {
@@ -51,6 +54,13 @@ struct playlist {
     // current_was_replaced is set to true.
     struct playlist_entry *current;
     bool current_was_replaced;
+
+    int num_entries;
+
+    // Lazily rebuilt array of all entries for O(1) indexed access. Any
+    // modification of the list invalidates it.
+    struct playlist_entry **cache;
+    bool cache_valid;
 };
 
 void playlist_entry_add_param(struct playlist_entry *e, bstr name, bstr value);
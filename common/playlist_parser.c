@@ -94,6 +94,14 @@ play_tree_parser_get_line(play_tree_parser_t* p) {
 
     if(resize) {
       char *tmp;
+      /* Reclaim already consumed lines before growing the buffer */
+      if(!p->keep && p->iter != p->buffer) {
+        p->buffer_end -= p->iter - p->buffer;
+        memmove(p->buffer,p->iter,p->buffer_end + 1);
+        p->iter = p->buffer;
+        resize = 0;
+        continue;
+      }
       r = p->iter - p->buffer;
       end = p->buffer + p->buffer_end;
       if (p->buffer_size > INT_MAX - BUF_STEP)
@@ -142,13 +150,11 @@ play_tree_parser_get_line(play_tree_parser_t* p) {
   if(end[0] != '\0')
     end++;
 
-  if(!p->keep) {
-    if(end[0] != '\0') {
-      p->buffer_end -= end-p->iter;
-      memmove(p->buffer,end,p->buffer_end);
-    } else
-      p->buffer_end = 0;
-    p->buffer[p->buffer_end] = '\0';
+  /* Consumed lines are compacted away lazily (see above); moving the
+   * remaining data down for every line makes large playlists quadratic. */
+  if(!p->keep && end[0] == '\0') {
+    p->buffer_end = 0;
+    p->buffer[0] = '\0';
     p->iter = p->buffer;
   } else
     p->iter = end;
@@ -21,3 +21,7 @@
 
 #define mp_memory_barrier()           __sync_synchronize()
 #define mp_atomic_add_and_fetch(a, b) __sync_add_and_fetch(a, b)
+
+// Returns true if *a was equal to b and has been set to c.
+#define mp_atomic_bool_compare_and_swap(a, b, c) \
+    __sync_bool_compare_and_swap(a, b, c)
@@ -15,11 +15,15 @@
  * with mpv.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
+#include <pthread.h>
+
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/common.h>
 #include "codec_tags.h"
 #include "stheader.h"
+#include "common/common.h"
 #include "common/av_common.h"
 
 /* The following tables map FourCCs to codec names (as defined by libavcodec).
@@ -344,14 +348,37 @@ static const int mp_fourcc_video_aliases[][2] = {
     {0},
 };
 
-static const char *lookup_tag(const struct mp_codec_tag *mp_table,
+// Copies of the tables above, sorted by tag for bsearch(). The sentinel
+// entries are excluded from the search ranges.
+static struct mp_codec_tag audio_tags_sorted[MP_ARRAY_SIZE(mp_audio_codec_tags)];
+static struct mp_codec_tag video_tags_sorted[MP_ARRAY_SIZE(mp_video_codec_tags)];
+static pthread_once_t sort_tags_init = PTHREAD_ONCE_INIT;
+
+static int tag_cmp(const void *pa, const void *pb)
+{
+    const struct mp_codec_tag *a = pa, *b = pb;
+    return a->tag < b->tag ? -1 : (a->tag > b->tag ? 1 : 0);
+}
+
+static void sort_tags(void)
+{
+    memcpy(audio_tags_sorted, mp_audio_codec_tags, sizeof(audio_tags_sorted));
+    memcpy(video_tags_sorted, mp_video_codec_tags, sizeof(video_tags_sorted));
+    qsort(audio_tags_sorted, MP_ARRAY_SIZE(audio_tags_sorted) - 1,
+          sizeof(struct mp_codec_tag), tag_cmp);
+    qsort(video_tags_sorted, MP_ARRAY_SIZE(video_tags_sorted) - 1,
+          sizeof(struct mp_codec_tag), tag_cmp);
+}
+
+static const char *lookup_tag(const struct mp_codec_tag *mp_table, size_t count,
                               const struct AVCodecTag *av_table,
                               uint32_t tag)
 {
-    for (int n = 0; mp_table[n].codec; n++) {
-        if (mp_table[n].tag == tag)
-            return mp_table[n].codec;
-    }
+    struct mp_codec_tag key = { .tag = tag };
+    const struct mp_codec_tag *e = bsearch(&key, mp_table, count,
+                                           sizeof(key), tag_cmp);
+    if (e)
+        return e->codec;
     const struct AVCodecTag *av_tags[] = {av_table, NULL};
     int id = av_codec_get_id(av_tags, tag);
     return id == AV_CODEC_ID_NONE ? NULL : mp_codec_from_av_codec_id(id);
@@ -359,14 +386,17 @@ static const char *lookup_tag(const struct mp_codec_tag *mp_table,
 
 void mp_set_codec_from_tag(struct sh_stream *sh)
 {
+    pthread_once(&sort_tags_init, sort_tags);
     switch (sh->type) {
     case STREAM_VIDEO:
-        sh->codec = lookup_tag(mp_video_codec_tags,
+        sh->codec = lookup_tag(video_tags_sorted,
+                               MP_ARRAY_SIZE(video_tags_sorted) - 1,
                                avformat_get_riff_video_tags(),
                                sh->format);
         break;
     case STREAM_AUDIO:
-        sh->codec = lookup_tag(mp_audio_codec_tags,
+        sh->codec = lookup_tag(audio_tags_sorted,
+                               MP_ARRAY_SIZE(audio_tags_sorted) - 1,
                                avformat_get_riff_audio_tags(),
                                sh->format);
         break;
@@ -24,18 +24,22 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 
 #include "config.h"
 #include "options/options.h"
+#include "options/path.h"
 #include "common/av_common.h"
 #include "talloc.h"
 #include "common/msg.h"
 
 #include "stream/stream.h"
+#include "misc/intern.h"
 #include "demux.h"
+#include "packet_pool.h"
 #include "stheader.h"
 #include "mf.h"
 
@@ -92,11 +96,243 @@ struct demux_stream {
     int eof;               // end of demuxed stream? (true if all buffer empty)
     int packs;            // number of packets in buffer
     int bytes;            // total bytes of packets in buffer
+    int spilled_packs;     // queued packets whose payload is in the spill file
+    int64_t spilled_bytes; // total payload bytes in the spill file
     struct demux_packet *head;
     struct demux_packet *tail;
 };
 
+// Readahead watermarks for the demuxer thread. The thread demuxes ahead of
+// playback until every selected audio/video stream is above the high
+// watermark (or the hard MAX_PACKS/MAX_PACK_BYTES limits trigger), and is
+// woken up again when a stream drops below the low watermark. Subtitle
+// streams are sparse and are excluded - they fill up as a side effect of
+// demuxing the other streams.
+#define THREAD_LOW_PACKS  16
+#define THREAD_HIGH_PACKS 64
+#define THREAD_HIGH_BYTES (4 * 1024 * 1024)
+
+// Badly interleaved files (e.g. audio muxed seconds ahead of video) force one
+// stream's queue to hold everything between the two stream positions. Above
+// this much queued payload on a single stream, payloads are moved to a temp
+// file and read back on dequeue, so such files cost disk instead of hundreds
+// of MB of RAM. Queued duration above the skew threshold only triggers the
+// bad-interleaving diagnostic.
+#define QUEUE_SPILL_BYTES (16 * 1024 * 1024)
+#define INTERLEAVE_SKEW_SECS 2.0
+
+// State of the optional readahead thread. All packet queue fields in
+// struct demux_stream are protected by this lock while the thread runs; the
+// thread drops the lock while it is inside the demuxer's fill_buffer (the
+// demuxer's private state is accessed by the thread only, and
+// demuxer_add_packet() takes the lock internally).
+struct demux_thread {
+    demuxer_t *demuxer;
+    pthread_t thread;
+    bool active;            // thread was created and must be joined
+    bool terminate;
+    bool in_fill;           // thread is inside ->fill_buffer, lock dropped
+    int pause_count;        // keep the thread out of ->fill_buffer if > 0
+    bool eof;               // ->fill_buffer returned EOF; reset on flush
+    struct demux_stream *request; // stream a blocked reader is waiting on
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+};
+
+#if HAVE_ZLIB
+#include <zlib.h>
+
+// Compress queued packet payloads above this size; smaller packets aren't
+// worth the zlib call overhead.
+#define COMPRESS_MIN_SIZE 4096
+
+// Compress the packet payload in place (see --demuxer-queue-compression).
+// Failure (or an incompressible payload) just keeps the raw data.
+static void compress_packet(struct demux_packet *dp)
+{
+    if (dp->len < COMPRESS_MIN_SIZE || dp->uncompressed_len ||
+        dp->avpacket || !dp->allocation || dp->buffer != dp->allocation)
+        return;
+    uLongf size = compressBound(dp->len);
+    unsigned char *tmp = malloc(size);
+    if (!tmp)
+        return;
+    if (compress2(tmp, &size, dp->buffer, dp->len, Z_BEST_SPEED) != Z_OK ||
+        size >= (uLongf)dp->len)
+    {
+        free(tmp);
+        return;
+    }
+    unsigned char *buf = packet_pool_alloc(size);
+    if (!buf) {
+        free(tmp);
+        return;
+    }
+    memcpy(buf, tmp, size);
+    free(tmp);
+    packet_pool_release(dp->allocation);
+    dp->buffer = buf;
+    dp->allocation = buf;
+    dp->uncompressed_len = dp->len;
+    dp->len = size;
+}
+
+static void uncompress_packet(struct demux_packet *dp)
+{
+    if (!dp->uncompressed_len)
+        return;
+    int len = dp->uncompressed_len;
+    unsigned char *buf = packet_pool_alloc(len + MP_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf) {
+        mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Memory allocation failure!\n");
+        abort();
+    }
+    uLongf size = len;
+    // Can't fail; the data was compressed by compress_packet() above.
+    if (uncompress(buf, &size, dp->buffer, dp->len) != Z_OK ||
+        size != (uLongf)len)
+    {
+        mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Error uncompressing packet!\n");
+        abort();
+    }
+    memset(buf + len, 0, MP_INPUT_BUFFER_PADDING_SIZE);
+    packet_pool_release(dp->allocation);
+    dp->buffer = buf;
+    dp->allocation = buf;
+    dp->len = len;
+    dp->uncompressed_len = 0;
+}
+#endif
+
 static void add_stream_chapters(struct demuxer *demuxer);
+static bool demux_check_queue_full(demuxer_t *demux);
+
+static void demux_lock(demuxer_t *demuxer)
+{
+    if (demuxer->thread)
+        pthread_mutex_lock(&demuxer->thread->lock);
+}
+
+static void demux_unlock(demuxer_t *demuxer)
+{
+    if (demuxer->thread)
+        pthread_mutex_unlock(&demuxer->thread->lock);
+}
+
+// Keep the demuxer thread out of the demuxer implementation, so the caller
+// can safely issue seeks and controls. Waits until a fill_buffer call in
+// progress has finished. Pairs with demux_unpause(); nesting is allowed.
+// No-op if the thread is not running.
+static void demux_pause(demuxer_t *demuxer)
+{
+    struct demux_thread *t = demuxer->thread;
+    if (!t)
+        return;
+    pthread_mutex_lock(&t->lock);
+    t->pause_count++;
+    while (t->in_fill)
+        pthread_cond_wait(&t->wakeup, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+}
+
+static void demux_unpause(demuxer_t *demuxer)
+{
+    struct demux_thread *t = demuxer->thread;
+    if (!t)
+        return;
+    pthread_mutex_lock(&t->lock);
+    assert(t->pause_count > 0);
+    t->pause_count--;
+    pthread_cond_signal(&t->wakeup);
+    pthread_mutex_unlock(&t->lock);
+}
+
+// Returns whether the thread should run ->fill_buffer now. Lock must be held.
+static bool thread_wants_more(demuxer_t *demux)
+{
+    struct demux_thread *t = demux->thread;
+    if (t->eof || demux_check_queue_full(demux))
+        return false;
+    if (t->request && !t->request->head)
+        return true;
+    for (int n = 0; n < demux->num_streams; n++) {
+        struct sh_stream *sh = demux->streams[n];
+        if (!sh->ds->selected || sh->type == STREAM_SUB)
+            continue;
+        if (sh->ds->packs < THREAD_HIGH_PACKS &&
+            sh->ds->bytes < THREAD_HIGH_BYTES)
+            return true;
+    }
+    return false;
+}
+
+static void *demux_thread(void *arg)
+{
+    struct demux_thread *t = arg;
+    demuxer_t *demux = t->demuxer;
+    pthread_mutex_lock(&t->lock);
+    while (!t->terminate) {
+        if (t->pause_count || !thread_wants_more(demux)) {
+            pthread_cond_signal(&t->wakeup);
+            pthread_cond_wait(&t->wakeup, &t->lock);
+            continue;
+        }
+        t->in_fill = true;
+        pthread_mutex_unlock(&t->lock);
+        int r = demux->desc->fill_buffer ? demux->desc->fill_buffer(demux) : 0;
+        pthread_mutex_lock(&t->lock);
+        t->in_fill = false;
+        if (!r)
+            t->eof = true;
+        // Readers and pause waiters can be blocked at the same time.
+        pthread_cond_broadcast(&t->wakeup);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+// Start a thread that demuxes ahead of playback into the per-stream packet
+// queues, so demux_read_packet() normally just dequeues from memory. Call
+// this once after opening the demuxer and selecting tracks. All later
+// demuxer accesses must go through the demux.c functions then.
+void demux_start_thread(struct demuxer *demuxer)
+{
+    if (demuxer->thread)
+        return;
+    struct demux_thread *t = talloc_zero(NULL, struct demux_thread);
+    t->demuxer = demuxer;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->wakeup, NULL);
+    demuxer->thread = t;
+    if (pthread_create(&t->thread, NULL, demux_thread, t) != 0) {
+        mp_msg(MSGT_DEMUXER, MSGL_ERR, "Starting demuxer thread failed.\n");
+        demuxer->thread = NULL;
+        pthread_mutex_destroy(&t->lock);
+        pthread_cond_destroy(&t->wakeup);
+        talloc_free(t);
+        return;
+    }
+    t->active = true;
+    mp_msg(MSGT_DEMUXER, MSGL_V, "Demuxer thread enabled.\n");
+}
+
+void demux_stop_thread(struct demuxer *demuxer)
+{
+    struct demux_thread *t = demuxer->thread;
+    if (!t)
+        return;
+    if (t->active) {
+        pthread_mutex_lock(&t->lock);
+        t->terminate = true;
+        pthread_cond_signal(&t->wakeup);
+        pthread_mutex_unlock(&t->lock);
+        pthread_join(t->thread, NULL);
+    }
+    demuxer->thread = NULL;
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->wakeup);
+    talloc_free(t);
+}
 
 static void ds_free_packs(struct demux_stream *ds)
 {
@@ -109,14 +345,80 @@ static void ds_free_packs(struct demux_stream *ds)
     ds->head = ds->tail = NULL;
     ds->packs = 0; // !!!!!
     ds->bytes = 0;
+    ds->spilled_packs = 0;
+    ds->spilled_bytes = 0;
     ds->eof = 0;
 }
 
+// Move the packet payload to the demuxer's queue spill file. The file is
+// append-only; spilled payloads are read back on dequeue. Called with the
+// lock held; the writes go to the page cache, so this is not a latency
+// concern. Packets whose payload isn't owned by the packet can't be spilled.
+static bool spill_packet(demuxer_t *demuxer, struct demux_packet *dp)
+{
+    if (!dp->len || (!dp->allocation && !dp->avpacket))
+        return false;
+    if (!demuxer->spill_file) {
+        // tmpfile() unlinks the file immediately, so nothing is left behind
+        // even if the player crashes.
+        demuxer->spill_file = tmpfile();
+        if (!demuxer->spill_file) {
+            mp_msg(MSGT_DEMUXER, MSGL_WARN,
+                   "Could not create queue spill file.\n");
+            demuxer->spill_failed = true;
+            return false;
+        }
+    }
+    int fd = fileno(demuxer->spill_file);
+    if (lseek(fd, demuxer->spill_used, SEEK_SET) < 0 ||
+        write(fd, dp->buffer, dp->len) != dp->len)
+    {
+        mp_msg(MSGT_DEMUXER, MSGL_WARN, "Queue spill write error.\n");
+        fclose(demuxer->spill_file);
+        demuxer->spill_file = NULL;
+        demuxer->spill_failed = true;
+        return false;
+    }
+    dp->spill_pos = demuxer->spill_used;
+    demuxer->spill_used += dp->len;
+    // Drop the in-memory backing.
+    talloc_free(dp->avpacket);
+    dp->avpacket = NULL;
+    packet_pool_release(dp->allocation);
+    dp->allocation = NULL;
+    dp->buffer = NULL;
+    return true;
+}
+
+static void unspill_packet(demuxer_t *demuxer, struct demux_packet *dp)
+{
+    if (dp->spill_pos < 0)
+        return;
+    unsigned char *buf = packet_pool_alloc(dp->len +
+                                           MP_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf) {
+        mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Memory allocation failure!\n");
+        abort();
+    }
+    int fd = fileno(demuxer->spill_file);
+    // Can't fail; the data was written by spill_packet() above.
+    if (lseek(fd, dp->spill_pos, SEEK_SET) < 0 ||
+        read(fd, buf, dp->len) != dp->len)
+    {
+        mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Error reading spilled packet!\n");
+        abort();
+    }
+    memset(buf + dp->len, 0, MP_INPUT_BUFFER_PADDING_SIZE);
+    dp->buffer = buf;
+    dp->allocation = buf;
+    dp->spill_pos = -1;
+}
+
 static void packet_destroy(void *ptr)
 {
     struct demux_packet *dp = ptr;
     talloc_free(dp->avpacket);
-    free(dp->allocation);
+    packet_pool_release(dp->allocation);
 }
 
 static struct demux_packet *create_packet(size_t len)
@@ -136,6 +438,7 @@ static struct demux_packet *create_packet(size_t len)
         .stream_pts = MP_NOPTS_VALUE,
         .pos = -1,
         .stream = -1,
+        .spill_pos = -1,
     };
     return dp;
 }
@@ -143,7 +446,7 @@ static struct demux_packet *create_packet(size_t len)
 struct demux_packet *new_demux_packet(size_t len)
 {
     struct demux_packet *dp = create_packet(len);
-    dp->buffer = malloc(len + MP_INPUT_BUFFER_PADDING_SIZE);
+    dp->buffer = packet_pool_alloc(len + MP_INPUT_BUFFER_PADDING_SIZE);
     if (!dp->buffer) {
         mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Memory allocation failure!\n");
         abort();
@@ -176,7 +479,8 @@ void resize_demux_packet(struct demux_packet *dp, size_t len)
         abort();
     }
     assert(dp->allocation);
-    dp->buffer = realloc(dp->buffer, len + MP_INPUT_BUFFER_PADDING_SIZE);
+    dp->buffer = packet_pool_realloc(dp->buffer,
+                                     len + MP_INPUT_BUFFER_PADDING_SIZE);
     if (!dp->buffer) {
         mp_msg(MSGT_DEMUXER, MSGL_FATAL, "Memory allocation failure!\n");
         abort();
@@ -274,11 +578,14 @@ void free_demuxer(demuxer_t *demuxer)
 {
     if (!demuxer)
         return;
+    demux_stop_thread(demuxer);
     if (demuxer->desc->close)
         demuxer->desc->close(demuxer);
     // free streams:
     for (int n = 0; n < demuxer->num_streams; n++)
         ds_free_packs(demuxer->streams[n]->ds);
+    if (demuxer->spill_file)
+        fclose(demuxer->spill_file);
     talloc_free(demuxer);
 }
 
@@ -313,12 +620,28 @@ int demuxer_add_packet(demuxer_t *demuxer, struct sh_stream *stream,
                        demux_packet_t *dp)
 {
     struct demux_stream *ds = stream ? stream->ds : NULL;
-    if (!dp || !ds || !ds->selected) {
+    if (!dp || !ds) {
+        talloc_free(dp);
+        return 0;
+    }
+
+#if HAVE_ZLIB
+    // Trade some CPU for a deeper queue in the same memory budget.
+    int comp = demuxer->opts ? demuxer->opts->demuxer_queue_compression : 0;
+    if (comp == 2 || (comp == 1 && stream->type == STREAM_AUDIO))
+        compress_packet(dp);
+#endif
+
+    demux_lock(demuxer);
+
+    if (!ds->selected) {
+        demux_unlock(demuxer);
         talloc_free(dp);
         return 0;
     }
 
     if (stream->type == STREAM_VIDEO && !dp->len) {
+        demux_unlock(demuxer);
         /* Video packets with size 0 are assumed to not correspond to frames,
          * but to indicate the absence of a frame in formats like AVI
          * that must have packets at fixed timestamp intervals. */
@@ -329,8 +652,20 @@ int demuxer_add_packet(demuxer_t *demuxer, struct sh_stream *stream,
     dp->stream = stream->index;
     dp->next = NULL;
 
-    ds->packs++;
-    ds->bytes += dp->len;
+    // Cap queue memory for badly interleaved files: above the soft limit,
+    // payloads go to the spill file and only the packet headers stay in RAM.
+    // Spilled packets are exempt from the hard queue limits.
+    if (!demuxer->spill_failed &&
+        (ds->bytes + dp->len > QUEUE_SPILL_BYTES || ds->packs >= MAX_PACKS / 2))
+        spill_packet(demuxer, dp);
+
+    if (dp->spill_pos >= 0) {
+        ds->spilled_packs++;
+        ds->spilled_bytes += dp->len;
+    } else {
+        ds->packs++;
+        ds->bytes += dp->len;
+    }
     if (ds->tail) {
         // next packet in stream
         ds->tail->next = dp;
@@ -355,6 +690,33 @@ int demuxer_add_packet(demuxer_t *demuxer, struct sh_stream *stream,
     if (stream->type != STREAM_VIDEO && dp->pts == MP_NOPTS_VALUE)
         dp->pts = dp->dts;
 
+    // Diagnose bad interleaving: seconds of one stream queued up while
+    // another selected stream got nothing to play.
+    if (!demuxer->warned_interleave && stream->type != STREAM_SUB &&
+        dp->pts != MP_NOPTS_VALUE && ds->head->pts != MP_NOPTS_VALUE &&
+        dp->pts - ds->head->pts > INTERLEAVE_SKEW_SECS)
+    {
+        for (int n = 0; n < demuxer->num_streams; n++) {
+            struct sh_stream *other = demuxer->streams[n];
+            if (other != stream && other->ds->selected && !other->ds->head &&
+                other->type != STREAM_SUB)
+            {
+                mp_msg(MSGT_DEMUXER, MSGL_WARN, "Badly interleaved file: "
+                       "%.1f seconds of %s queued while %s has no packets. "
+                       "Queued payloads will be spilled to disk if needed.\n",
+                       dp->pts - ds->head->pts,
+                       stream_type_name(stream->type),
+                       stream_type_name(other->type));
+                demuxer->warned_interleave = true;
+                break;
+            }
+        }
+    }
+
+    if (demuxer->thread)
+        pthread_cond_broadcast(&demuxer->thread->wakeup);
+    demux_unlock(demuxer);
+
     mp_msg(MSGT_DEMUXER, MSGL_DBG2,
            "DEMUX: Append packet to %s, len=%d  pts=%5.3f  pos=%"PRIu64" "
            "[packs: A=%d V=%d S=%d]\n", stream_type_name(stream->type),
@@ -418,6 +780,25 @@ static void ds_get_packets(struct sh_stream *sh)
     ds->eof = 1;
 }
 
+// Threaded equivalent of ds_get_packets(): wait until the stream has a
+// packet queued, EOF is reached, or the queues overflow. Lock must be held
+// (it is dropped while waiting).
+static void ds_wait_for_packet(struct sh_stream *sh)
+{
+    struct demux_stream *ds = sh->ds;
+    struct demux_thread *t = sh->demuxer->thread;
+    while (!ds->head) {
+        if (t->eof || (!t->in_fill && demux_check_queue_full(sh->demuxer))) {
+            ds->eof = 1;
+            break;
+        }
+        t->request = ds;
+        pthread_cond_signal(&t->wakeup);
+        pthread_cond_wait(&t->wakeup, &t->lock);
+    }
+    t->request = NULL;
+}
+
 // Read a packet from the given stream. The returned packet belongs to the
 // caller, who has to free it with talloc_free(). Might block. Returns NULL
 // on EOF.
@@ -425,21 +806,45 @@ struct demux_packet *demux_read_packet(struct sh_stream *sh)
 {
     struct demux_stream *ds = sh ? sh->ds : NULL;
     if (ds) {
-        ds_get_packets(sh);
+        struct demux_thread *t = sh->demuxer->thread;
+        if (t) {
+            pthread_mutex_lock(&t->lock);
+            ds_wait_for_packet(sh);
+        } else {
+            ds_get_packets(sh);
+        }
         struct demux_packet *pkt = ds->head;
         if (pkt) {
             ds->head = pkt->next;
             pkt->next = NULL;
             if (!ds->head)
                 ds->tail = NULL;
-            ds->bytes -= pkt->len;
-            ds->packs--;
+            if (pkt->spill_pos >= 0) {
+                ds->spilled_bytes -= pkt->len;
+                ds->spilled_packs--;
+                // Needs the lock (the file offset is shared with the spill
+                // writer); reads come from the page cache in practice.
+                unspill_packet(sh->demuxer, pkt);
+            } else {
+                ds->bytes -= pkt->len;
+                ds->packs--;
+            }
 
             if (pkt->stream_pts != MP_NOPTS_VALUE)
                 sh->demuxer->stream_pts = pkt->stream_pts;
-
-            return pkt;
         }
+        if (t) {
+            // Refill the readahead when it runs low.
+            if (ds->packs < THREAD_LOW_PACKS && thread_wants_more(sh->demuxer))
+                pthread_cond_signal(&t->wakeup);
+            pthread_mutex_unlock(&t->lock);
+        }
+#if HAVE_ZLIB
+        // Done outside the lock, so the demuxer thread isn't stalled.
+        if (pkt)
+            uncompress_packet(pkt);
+#endif
+        return pkt;
     }
     return NULL;
 }
@@ -449,18 +854,32 @@ struct demux_packet *demux_read_packet(struct sh_stream *sh)
 // packets from the queue.
 double demux_get_next_pts(struct sh_stream *sh)
 {
+    double pts = MP_NOPTS_VALUE;
     if (sh && sh->ds->selected) {
-        ds_get_packets(sh);
+        struct demux_thread *t = sh->demuxer->thread;
+        if (t) {
+            pthread_mutex_lock(&t->lock);
+            ds_wait_for_packet(sh);
+        } else {
+            ds_get_packets(sh);
+        }
         if (sh->ds->head)
-            return sh->ds->head->pts;
+            pts = sh->ds->head->pts;
+        if (t)
+            pthread_mutex_unlock(&t->lock);
     }
-    return MP_NOPTS_VALUE;
+    return pts;
 }
 
 // Return whether a packet is queued. Never blocks, never forces any reads.
 bool demux_has_packet(struct sh_stream *sh)
 {
-    return sh && sh->ds->head;
+    if (!sh)
+        return false;
+    demux_lock(sh->demuxer);
+    bool has_packet = !!sh->ds->head;
+    demux_unlock(sh->demuxer);
+    return has_packet;
 }
 
 // Same as demux_has_packet, but to be called internally by demuxers, as
@@ -565,6 +984,21 @@ static const int d_normal[]  = {DEMUX_CHECK_NORMAL, DEMUX_CHECK_UNSAFE, -1};
 static const int d_request[] = {DEMUX_CHECK_REQUEST, -1};
 static const int d_force[]   = {DEMUX_CHECK_FORCE, -1};
 
+// Key identifying a local file for the persistent probe cache, or NULL if
+// the stream is not a plain file. Size and mtime are part of the key, so a
+// changed file simply misses the cache.
+static char *probe_cache_key(void *talloc_ctx, struct stream *stream)
+{
+    if (!stream->url || mp_is_url(bstr0(stream->url)))
+        return NULL;
+    struct stat st;
+    if (stat(stream->url, &st) != 0 || !S_ISREG(st.st_mode))
+        return NULL;
+    return talloc_asprintf(talloc_ctx, "%lld:%lld:%s",
+                           (long long)st.st_size, (long long)st.st_mtime,
+                           stream->url);
+}
+
 struct demuxer *demux_open(struct stream *stream, char *force_format,
                            struct demuxer_params *params, struct MPOpts *opts)
 {
@@ -595,6 +1029,27 @@ struct demuxer *demux_open(struct stream *stream, char *force_format,
     // or stream filters will flush previous peeked data.
     stream_peek(stream, STREAM_BUFFER_SIZE);
 
+    void *tmp = talloc_new(NULL);
+    char *cache_key = check_desc ? NULL : probe_cache_key(tmp, stream);
+    if (cache_key) {
+        // Try whatever demuxer opened this file last time first, so that an
+        // unchanged file skips the probes of all demuxers before it.
+        char *cached = mp_read_cached_table(tmp, "demuxers", cache_key);
+        for (int n = 0; cached && demuxer_list[n]; n++) {
+            const struct demuxer_desc *desc = demuxer_list[n];
+            if (strcmp(desc->name, cached) == 0) {
+                struct demuxer *demuxer = open_given_type(opts, desc, stream,
+                                                          params,
+                                                          DEMUX_CHECK_NORMAL);
+                if (demuxer) {
+                    talloc_free(tmp);
+                    return demuxer;
+                }
+                break;
+            }
+        }
+    }
+
     // Test demuxers from first to last, one pass for each check_levels[] entry
     for (int pass = 0; check_levels[pass] != -1; pass++) {
         enum demux_check level = check_levels[pass];
@@ -603,20 +1058,33 @@ struct demuxer *demux_open(struct stream *stream, char *force_format,
             if (!check_desc || desc == check_desc) {
                 struct demuxer *demuxer = open_given_type(opts, desc, stream,
                                                           params, level);
-                if (demuxer)
+                if (demuxer) {
+                    if (cache_key)
+                        mp_write_cached_table("demuxers", cache_key,
+                                              desc->name);
+                    talloc_free(tmp);
                     return demuxer;
+                }
             }
         }
     }
 
+    talloc_free(tmp);
     return NULL;
 }
 
 void demux_flush(demuxer_t *demuxer)
 {
+    demux_pause(demuxer);
+    demux_lock(demuxer);
     for (int n = 0; n < demuxer->num_streams; n++)
         ds_free_packs(demuxer->streams[n]->ds);
     demuxer->warned_queue_overflow = false;
+    demuxer->spill_used = 0; // no spilled packets are left; reuse the file
+    if (demuxer->thread)
+        demuxer->thread->eof = false;
+    demux_unlock(demuxer);
+    demux_unpause(demuxer);
 }
 
 int demux_seek(demuxer_t *demuxer, float rel_seek_secs, int flags)
@@ -629,6 +1097,9 @@ int demux_seek(demuxer_t *demuxer, float rel_seek_secs, int flags)
     if (rel_seek_secs == MP_NOPTS_VALUE && (flags & SEEK_ABSOLUTE))
         return 0;
 
+    // Keep the demuxer thread out of the demuxer until the seek is done.
+    demux_pause(demuxer);
+
     // clear demux buffers:
     demux_flush(demuxer);
 
@@ -660,6 +1131,7 @@ int demux_seek(demuxer_t *demuxer, float rel_seek_secs, int flags)
         if (stream_control(demuxer->stream, STREAM_CTRL_SEEK_TO_TIME, &pts)
             != STREAM_UNSUPPORTED) {
             demux_control(demuxer, DEMUXER_CTRL_RESYNC, NULL);
+            demux_unpause(demuxer);
             return 1;
         }
     }
@@ -668,6 +1140,7 @@ int demux_seek(demuxer_t *demuxer, float rel_seek_secs, int flags)
     if (demuxer->desc->seek)
         demuxer->desc->seek(demuxer, rel_seek_secs, flags);
 
+    demux_unpause(demuxer);
     return 1;
 }
 
@@ -688,7 +1161,9 @@ void mp_tags_set_bstr(struct mp_tags *tags, bstr key, bstr value)
 
     MP_RESIZE_ARRAY(tags, tags->keys,   tags->num_keys + 1);
     MP_RESIZE_ARRAY(tags, tags->values, tags->num_keys + 1);
-    tags->keys[tags->num_keys]   = talloc_strndup(tags, key.start,   key.len);
+    // Tag keys come from a small shared vocabulary ("ARTIST", "TITLE", ...),
+    // so intern them instead of duplicating them per file.
+    tags->keys[tags->num_keys]   = (char *)mp_intern_bstr(key);
     tags->values[tags->num_keys] = talloc_strndup(tags, value.start, value.len);
     tags->num_keys++;
 }
@@ -767,11 +1242,15 @@ void demux_info_update(struct demuxer *demuxer)
 
 int demux_control(demuxer_t *demuxer, int cmd, void *arg)
 {
+    int r = DEMUXER_CTRL_NOTIMPL;
 
-    if (demuxer->desc->control)
-        return demuxer->desc->control(demuxer, cmd, arg);
+    if (demuxer->desc->control) {
+        demux_pause(demuxer);
+        r = demuxer->desc->control(demuxer, cmd, arg);
+        demux_unpause(demuxer);
+    }
 
-    return DEMUXER_CTRL_NOTIMPL;
+    return r;
 }
 
 struct sh_stream *demuxer_stream_by_demuxer_id(struct demuxer *d,
@@ -802,9 +1281,15 @@ void demuxer_select_track(struct demuxer *demuxer, struct sh_stream *stream,
 {
     // don't flush buffers if stream is already selected / unselected
     if (stream->ds->selected != selected) {
+        demux_pause(demuxer);
+        demux_lock(demuxer);
         stream->ds->selected = selected;
         ds_free_packs(stream->ds);
+        if (demuxer->thread)
+            demuxer->thread->eof = false;
+        demux_unlock(demuxer);
         demux_control(demuxer, DEMUXER_CTRL_SWITCHED_TRACKS, NULL);
+        demux_unpause(demuxer);
     }
 }
 
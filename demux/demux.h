@@ -21,6 +21,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -56,6 +57,9 @@ enum demux_ctrl {
     DEMUXER_CTRL_GET_START_TIME,
     DEMUXER_CTRL_RESYNC,
     DEMUXER_CTRL_IDENTIFY_PROGRAM,
+    // Make demuxer->attachments available; demuxers may defer reading
+    // attachment payloads (e.g. embedded fonts) until this is called.
+    DEMUXER_CTRL_READ_ATTACHMENTS,
 };
 
 #define SEEK_ABSOLUTE (1 << 0)
@@ -169,6 +173,13 @@ typedef struct demuxer {
     // File format allows PTS resets (even if the current file is without)
     bool ts_resets_possible;
     bool warned_queue_overflow;
+    bool warned_interleave;
+
+    // Packet queue spill file for badly interleaved files (internal to
+    // demux.c; see spill_packet()).
+    FILE *spill_file;
+    int64_t spill_used;
+    bool spill_failed;
 
     struct sh_stream **streams;
     int num_streams;
@@ -195,6 +206,9 @@ typedef struct demuxer {
     void *priv;   // demuxer-specific internal data
     struct MPOpts *opts;
     struct demuxer_params *params;
+
+    // Readahead thread state, internal to demux.c (NULL if no thread is used).
+    struct demux_thread *thread;
 } demuxer_t;
 
 typedef struct {
@@ -224,6 +238,9 @@ double demux_get_next_pts(struct sh_stream *sh);
 bool demux_has_packet(struct sh_stream *sh);
 bool demux_stream_eof(struct sh_stream *sh);
 
+void demux_start_thread(struct demuxer *demuxer);
+void demux_stop_thread(struct demuxer *demuxer);
+
 struct sh_stream *new_sh_stream(struct demuxer *demuxer, enum stream_type type);
 
 struct demuxer *demux_open(struct stream *stream, char *force_format,
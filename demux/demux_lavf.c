@@ -18,9 +18,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-// #include <stdio.h>
+#include <stdio.h>
 #include <stdlib.h>
-// #include <unistd.h>
+#include <unistd.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <string.h>
@@ -31,6 +31,7 @@
 #include <libavutil/avutil.h>
 #include <libavutil/avstring.h>
 #include <libavutil/mathematics.h>
+#include <libavutil/md5.h>
 #include <libavutil/opt.h>
 #include "compat/libav.h"
 
@@ -45,10 +46,16 @@
 #include "demux.h"
 #include "stheader.h"
 #include "options/m_option.h"
+#include "options/path.h"
 
 #define INITIAL_PROBE_SIZE STREAM_BUFFER_SIZE
 #define PROBE_BUF_SIZE FFMIN(STREAM_MAX_BUFFER_SIZE, 2 * 1024 * 1024)
 
+// Analysis limits used by --demuxer-lavf-fast-start. Enough to pick up the
+// parameters of the first audio and video stream of typical broadcast TS.
+#define FAST_START_PROBE_SIZE (256 * 1024)
+#define FAST_START_ANALYZE_DURATION 0.5
+
 #define OPT_BASE_STRUCT struct MPOpts
 
 // Should correspond to IO_BUFFER_SIZE in libavformat/aviobuf.c (not public)
@@ -66,12 +73,19 @@ const m_option_t lavfdopts_conf[] = {
     OPT_STRING("cryptokey", lavfdopts.cryptokey, 0),
     OPT_CHOICE("genpts-mode", lavfdopts.genptsmode, 0,
                ({"lavf", 1}, {"no", 0})),
+    OPT_FLAG("index-cache", lavfdopts.index_cache, 0),
+    OPT_FLAG("fast-start", lavfdopts.fast_start, 0),
     OPT_STRING("o", lavfdopts.avopt, 0),
     {NULL, NULL, 0, 0, 0, 0, NULL}
 };
 
 #define MAX_PKT_QUEUE 50
 
+struct lavf_seek_entry {
+    int64_t ts;   // timestamp in AV_TIME_BASE units (as priv->last_pts)
+    int64_t pos;  // byte position of the keyframe's packet
+};
+
 typedef struct lavf_priv {
     char *filename;
     const struct format_hack *format_hack;
@@ -83,6 +97,10 @@ typedef struct lavf_priv {
     int num_streams;
     int cur_program;
     char *mime_type;
+    struct lavf_seek_entry *seek_index;
+    int num_seek_index;
+    bool seek_index_enabled;
+    bool seek_index_dirty;
 } lavf_priv_t;
 
 struct format_hack {
@@ -119,7 +137,17 @@ static int mp_read(void *opaque, uint8_t *buf, int size)
     struct stream *stream = demuxer->stream;
     int ret;
 
-    ret = stream_read(stream, buf, size);
+    // Copy already buffered data directly into libavformat's buffer (for
+    // cached streams, straight out of the cache ringbuffer), so it crosses
+    // only one buffer on the way there. Short reads are fine with avio.
+    bstr data = stream_read_peek(stream);
+    if (data.len > 0) {
+        ret = FFMIN(data.len, size);
+        memcpy(buf, data.start, ret);
+        stream_read_consume(stream, ret);
+    } else {
+        ret = stream_read(stream, buf, size);
+    }
 
     mp_msg(MSGT_HEADER, MSGL_DBG2,
            "%d=mp_read(%p, %p, %d), pos: %"PRId64", eof:%d\n",
@@ -515,6 +543,182 @@ static void add_metadata(demuxer_t *demuxer, AVDictionary *metadata)
         demux_info_add(demuxer, t->key, t->value);
 }
 
+/* Sparse seek table for formats without an index, where lavf seeking
+ * degrades to bisecting through the stream layer (MPEG-TS/PS). Video
+ * keyframe positions seen during normal demuxing are recorded, and seeks
+ * into already-demuxed regions go directly to the recorded byte position.
+ * With index-cache=yes the table is persisted between runs, analogous to
+ * the mkv index cache. */
+
+#define SEEK_INDEX_MAGIC "mpv avindex "
+#define SEEK_INDEX_VERSION 1
+#define SEEK_INDEX_MIN_SPACING INT64_C(1000000) // AV_TIME_BASE units
+
+struct seek_index_header {
+    char magic[12];     // SEEK_INDEX_MAGIC, no terminating 0
+    uint32_t version;
+    uint64_t file_size; // identity check against the source file
+    uint32_t num_entries;
+};
+
+static bool seek_index_usable(lavf_priv_t *priv)
+{
+    /* Formats which resync from raw byte positions. AVI is deliberately
+     * not in the list: byte positions are not seekable there without the
+     * RIFF index, and lavf regenerates an index for index-less AVI. */
+    return matches_avinputformat_name(priv, "mpeg") ||
+           matches_avinputformat_name(priv, "mpegts") ||
+           matches_avinputformat_name(priv, "mpegtsraw");
+}
+
+static void seek_index_add(demuxer_t *demuxer, int64_t ts, int64_t pos)
+{
+    lavf_priv_t *priv = demuxer->priv;
+    struct lavf_seek_entry *e = priv->seek_index;
+    int lo = 0, hi = priv->num_seek_index;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (e[mid].ts <= ts)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    // Keep the table sparse; skip keyframes too close to recorded ones.
+    if (lo > 0 && ts - e[lo - 1].ts < SEEK_INDEX_MIN_SPACING)
+        return;
+    if (lo < priv->num_seek_index && e[lo].ts - ts < SEEK_INDEX_MIN_SPACING)
+        return;
+    MP_TARRAY_GROW(priv, priv->seek_index, priv->num_seek_index);
+    e = priv->seek_index;
+    memmove(&e[lo + 1], &e[lo], (priv->num_seek_index - lo) * sizeof(*e));
+    e[lo] = (struct lavf_seek_entry){ts, pos};
+    priv->num_seek_index++;
+    priv->seek_index_dirty = true;
+}
+
+/* Return the entry to seek to for the target timestamp (AV_TIME_BASE
+ * units), or -1 if the target does not fall into an indexed region. */
+static int seek_index_find(lavf_priv_t *priv, int64_t target, int avsflags)
+{
+    struct lavf_seek_entry *e = priv->seek_index;
+    int lo = 0, hi = priv->num_seek_index;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (e[mid].ts <= target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    int i = lo - 1; // last entry at or before the target
+    if (!(avsflags & AVSEEK_FLAG_BACKWARD)) {
+        if (i >= 0 && e[i].ts == target)
+            return i;
+        if (lo < priv->num_seek_index &&
+            e[lo].ts - target <= 2 * SEEK_INDEX_MIN_SPACING)
+            return lo;
+    }
+    if (i >= 0 && target - e[i].ts <= 2 * SEEK_INDEX_MIN_SPACING)
+        return i;
+    return -1;
+}
+
+// One cache file per source, keyed like the mkv index cache files.
+static char *get_seek_index_filename(struct demuxer *demuxer, void *talloc_ctx)
+{
+    uint8_t md5[16];
+    av_md5_sum(md5, demuxer->filename, strlen(demuxer->filename));
+    char *name = talloc_strdup(talloc_ctx, "lavf_index/");
+    for (int i = 0; i < 16; i++)
+        name = talloc_asprintf_append(name, "%02X", md5[i]);
+    return talloc_steal(talloc_ctx, mp_find_user_config_file(name));
+}
+
+static void load_seek_index(struct demuxer *demuxer)
+{
+    lavf_priv_t *priv = demuxer->priv;
+    struct MPOpts *opts = demuxer->opts;
+
+    if (!opts->lavfdopts.index_cache || !priv->seek_index_enabled ||
+        demuxer->stream->end_pos <= 0)
+        return;
+
+    void *tmp = talloc_new(NULL);
+    char *filename = get_seek_index_filename(demuxer, tmp);
+    FILE *file = filename ? fopen(filename, "rb") : NULL;
+    if (!file) {
+        talloc_free(tmp);
+        return;
+    }
+
+    struct seek_index_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, file) == 1 &&
+        memcmp(hdr.magic, SEEK_INDEX_MAGIC, sizeof(hdr.magic)) == 0 &&
+        hdr.version == SEEK_INDEX_VERSION &&
+        hdr.file_size == (uint64_t)demuxer->stream->end_pos &&
+        hdr.num_entries > 0 && hdr.num_entries < (1 << 26))
+    {
+        struct lavf_seek_entry *entries =
+            talloc_array(priv, struct lavf_seek_entry, hdr.num_entries);
+        if (fread(entries, sizeof(*entries), hdr.num_entries, file)
+                == hdr.num_entries)
+        {
+            talloc_free(priv->seek_index);
+            priv->seek_index = entries;
+            priv->num_seek_index = hdr.num_entries;
+            mp_msg(MSGT_DEMUX, MSGL_V, "demux_lavf: using cached seek index "
+                   "(%d entries).\n", priv->num_seek_index);
+        } else {
+            talloc_free(entries);
+        }
+    }
+
+    fclose(file);
+    talloc_free(tmp);
+}
+
+static void save_seek_index(struct demuxer *demuxer)
+{
+    lavf_priv_t *priv = demuxer->priv;
+    struct MPOpts *opts = demuxer->opts;
+
+    if (!opts->lavfdopts.index_cache || !priv->seek_index_dirty ||
+        !priv->num_seek_index || demuxer->stream->end_pos <= 0)
+        return;
+
+    mp_mk_config_dir("lavf_index");
+
+    void *tmp = talloc_new(NULL);
+    char *filename = get_seek_index_filename(demuxer, tmp);
+    FILE *file = filename ? fopen(filename, "wb") : NULL;
+    if (!file) {
+        talloc_free(tmp);
+        return;
+    }
+
+    struct seek_index_header hdr = {
+        .version = SEEK_INDEX_VERSION,
+        .file_size = demuxer->stream->end_pos,
+        .num_entries = priv->num_seek_index,
+    };
+    memcpy(hdr.magic, SEEK_INDEX_MAGIC, sizeof(hdr.magic));
+
+    if (fwrite(&hdr, sizeof(hdr), 1, file) != 1 ||
+        fwrite(priv->seek_index, sizeof(*priv->seek_index),
+               priv->num_seek_index, file) != priv->num_seek_index)
+    {
+        mp_msg(MSGT_DEMUX, MSGL_WARN,
+               "demux_lavf: failed to write seek index cache.\n");
+        fclose(file);
+        unlink(filename);
+    } else {
+        fclose(file);
+        mp_msg(MSGT_DEMUX, MSGL_V, "demux_lavf: saved %d seek index entries "
+               "to cache.\n", priv->num_seek_index);
+    }
+
+    talloc_free(tmp);
+}
+
 static int demux_open_lavf(demuxer_t *demuxer, enum demux_check check)
 {
     struct MPOpts *opts = demuxer->opts;
@@ -540,6 +744,20 @@ static int demux_open_lavf(demuxer_t *demuxer, enum demux_check check)
     if (opts->index_mode == 0)
         avfc->flags |= AVFMT_FLAG_IGNIDX;
 
+    // Make avformat_find_stream_info() return as soon as the parameters of
+    // the first streams are known, instead of analyzing the full probe
+    // window (multi-second on some TS streams). Streams the reduced
+    // analysis misses are added when their first packet shows up (see
+    // add_new_streams()), and the player picks them up as late-added
+    // tracks. Explicit probesize/analyzeduration options still win.
+    if (lavfdopts->fast_start) {
+        if (!lavfdopts->probesize &&
+            av_opt_set_int(avfc, "probesize", FAST_START_PROBE_SIZE, 0) < 0)
+            mp_msg(MSGT_HEADER, MSGL_ERR,
+                   "demux_lavf, couldn't set fast-start probesize\n");
+        analyze_duration = FAST_START_ANALYZE_DURATION;
+    }
+
     if (lavfdopts->probesize) {
         if (av_opt_set_int(avfc, "probesize", lavfdopts->probesize, 0) < 0)
             mp_msg(MSGT_HEADER, MSGL_ERR,
@@ -668,6 +886,10 @@ static int demux_open_lavf(demuxer_t *demuxer, enum demux_check check)
 
     demuxer->ts_resets_possible = priv->avif->flags & AVFMT_TS_DISCONT;
 
+    priv->seek_index_enabled = demuxer->seekable && seek_index_usable(priv) &&
+                               !(priv->avif->flags & AVFMT_NO_BYTE_SEEK);
+    load_seek_index(demuxer);
+
     return 0;
 }
 
@@ -718,6 +940,9 @@ static int demux_lavf_fill_buffer(demuxer_t *demux)
         dp->duration = pkt->convergence_duration * av_q2d(st->time_base);
     dp->pos = pkt->pos;
     dp->keyframe = pkt->flags & AV_PKT_FLAG_KEY;
+    if (priv->seek_index_enabled && stream->type == STREAM_VIDEO &&
+        dp->keyframe && dp->pos >= 0 && dp->pts != MP_NOPTS_VALUE)
+        seek_index_add(demux, dp->pts * AV_TIME_BASE, dp->pos);
     // Use only one stream for stream_pts, otherwise PTS might be jumpy.
     if (stream->type == STREAM_VIDEO) {
         double pts;
@@ -766,6 +991,20 @@ static void demux_seek_lavf(demuxer_t *demuxer, float rel_seek_secs, int flags)
         priv->last_pts += rel_seek_secs * AV_TIME_BASE;
     }
 
+    /* Seeks into regions that have been demuxed before can go straight to
+     * a recorded keyframe position, instead of letting lavf bisect through
+     * the stream layer (no index in MPEG-TS/PS). */
+    if (priv->num_seek_index && !(avsflags & AVSEEK_FLAG_BYTE)) {
+        int i = seek_index_find(priv, priv->last_pts, avsflags);
+        if (i >= 0 && av_seek_frame(priv->avfc, -1, priv->seek_index[i].pos,
+                                    avsflags | AVSEEK_FLAG_BYTE) >= 0)
+        {
+            mp_msg(MSGT_DEMUX, MSGL_V, "demux_lavf: seek using recorded "
+                   "keyframe position.\n");
+            return;
+        }
+    }
+
     if (!priv->avfc->iformat->read_seek2) {
         // Normal seeking.
         int r = av_seek_frame(priv->avfc, -1, priv->last_pts, avsflags);
@@ -917,6 +1156,7 @@ static void demux_close_lavf(demuxer_t *demuxer)
 {
     lavf_priv_t *priv = demuxer->priv;
     if (priv) {
+        save_seek_index(demuxer);
         if (priv->avfc) {
             av_freep(&priv->avfc->key);
             avformat_close_input(&priv->avfc);
@@ -22,12 +22,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "osdep/io.h"
 
 #include "talloc.h"
 #include "config.h"
 #include "common/msg.h"
+#include "misc/thread_pool.h"
 
 #include "stream/stream.h"
 #include "demux.h"
@@ -36,9 +38,95 @@
 
 #define MF_MAX_FILE_SIZE (1024 * 1024 * 256)
 
+// Number of files read ahead of the current frame by worker threads.
+#define MF_PREFETCH_COUNT 4
+
+struct mf_slot {
+    int frame;          // frame number held or being read, -1 if empty
+    bool busy;          // a worker thread is filling this slot
+    bstr data;
+};
+
+struct priv {
+    mf_t *mf;
+    // Prefetching of upcoming image files (mf:// pattern mode only).
+    struct mp_thread_pool *pool;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    struct mf_slot slots[MF_PREFETCH_COUNT];
+};
+
+struct mf_job {
+    struct priv *p;
+    struct mf_slot *slot;
+    char *filename;
+    struct MPOpts *opts;
+};
+
+static void prefetch_read(void *ctx)
+{
+    struct mf_job *job = ctx;
+    struct priv *p = job->p;
+
+    bstr data = {0};
+    struct stream *s = stream_open(job->filename, job->opts);
+    if (s) {
+        data = stream_read_complete(s, NULL, MF_MAX_FILE_SIZE);
+        free_stream(s);
+    }
+
+    pthread_mutex_lock(&p->lock);
+    job->slot->data = data;
+    job->slot->busy = false;
+    pthread_cond_broadcast(&p->wakeup);
+    pthread_mutex_unlock(&p->lock);
+    talloc_free(job);
+}
+
+// Queue reads for the next MF_PREFETCH_COUNT frames into free slots.
+// Must be called with p->lock held.
+static void prefetch_frames(demuxer_t *demuxer)
+{
+    struct priv *p = demuxer->priv;
+    mf_t *mf = p->mf;
+
+    for (int f = mf->curr_frame;
+         f < mf->curr_frame + MF_PREFETCH_COUNT && f < mf->nr_of_files; f++)
+    {
+        struct mf_slot *slot = NULL;
+        bool have = false;
+        for (int i = 0; i < MF_PREFETCH_COUNT; i++) {
+            struct mf_slot *sl = &p->slots[i];
+            if (sl->frame == f) {
+                have = true;
+                break;
+            }
+            if (!slot && !sl->busy &&
+                (sl->frame < mf->curr_frame ||
+                 sl->frame >= mf->curr_frame + MF_PREFETCH_COUNT))
+                slot = sl;
+        }
+        if (have || !slot || !mf->names[f])
+            continue;
+        talloc_free(slot->data.start);
+        slot->data = (bstr){0};
+        slot->frame = f;
+        slot->busy = true;
+        struct mf_job *job = talloc_ptrtype(NULL, job);
+        *job = (struct mf_job){
+            .p = p,
+            .slot = slot,
+            .filename = mf->names[f],
+            .opts = demuxer->opts,
+        };
+        mp_thread_pool_queue(p->pool, prefetch_read, job);
+    }
+}
+
 static void demux_seek_mf(demuxer_t *demuxer, float rel_seek_secs, int flags)
 {
-    mf_t *mf = demuxer->priv;
+    struct priv *p = demuxer->priv;
+    mf_t *mf = p->mf;
     int newpos = (flags & SEEK_ABSOLUTE) ? 0 : mf->curr_frame - 1;
 
     if (flags & SEEK_FACTOR)
@@ -57,35 +145,60 @@ static void demux_seek_mf(demuxer_t *demuxer, float rel_seek_secs, int flags)
 //     1 = successfully read a packet
 static int demux_mf_fill_buffer(demuxer_t *demuxer)
 {
-    mf_t *mf = demuxer->priv;
+    struct priv *p = demuxer->priv;
+    mf_t *mf = p->mf;
     if (mf->curr_frame >= mf->nr_of_files)
         return 0;
 
-    struct stream *entry_stream = NULL;
-    if (mf->streams)
-        entry_stream = mf->streams[mf->curr_frame];
-    struct stream *stream = entry_stream;
-    if (!stream) {
-        char *filename = mf->names[mf->curr_frame];
-        if (filename)
-            stream = stream_open(filename, demuxer->opts);
+    bstr data = {0};
+    bool have_data = false;
+
+    if (p->pool) {
+        pthread_mutex_lock(&p->lock);
+        prefetch_frames(demuxer);
+        for (int i = 0; i < MF_PREFETCH_COUNT; i++) {
+            struct mf_slot *slot = &p->slots[i];
+            if (slot->frame != mf->curr_frame)
+                continue;
+            while (slot->busy)
+                pthread_cond_wait(&p->wakeup, &p->lock);
+            data = slot->data;
+            slot->data = (bstr){0};
+            slot->frame = -1;
+            have_data = true;
+            break;
+        }
+        pthread_mutex_unlock(&p->lock);
     }
 
-    if (stream) {
-        stream_seek(stream, 0);
-        bstr data = stream_read_complete(stream, NULL, MF_MAX_FILE_SIZE);
-        if (data.len) {
-            demux_packet_t *dp = new_demux_packet(data.len);
-            memcpy(dp->buffer, data.start, data.len);
-            dp->pts = mf->curr_frame / mf->sh->fps;
-            dp->keyframe = true;
-            demuxer_add_packet(demuxer, demuxer->streams[0], dp);
+    if (!have_data) {
+        struct stream *entry_stream = NULL;
+        if (mf->streams)
+            entry_stream = mf->streams[mf->curr_frame];
+        struct stream *stream = entry_stream;
+        if (!stream) {
+            char *filename = mf->names[mf->curr_frame];
+            if (filename)
+                stream = stream_open(filename, demuxer->opts);
+        }
+
+        if (stream) {
+            stream_seek(stream, 0);
+            data = stream_read_complete(stream, NULL, MF_MAX_FILE_SIZE);
         }
-        talloc_free(data.start);
+
+        if (stream && stream != entry_stream)
+            free_stream(stream);
     }
 
-    if (stream && stream != entry_stream)
-        free_stream(stream);
+    if (data.len) {
+        demux_packet_t *dp = new_demux_packet(data.len);
+        memcpy(dp->buffer, data.start, data.len);
+        dp->pts = mf->curr_frame / mf->sh->fps;
+        dp->keyframe = true;
+        demuxer_add_packet(demuxer, demuxer->streams[0], dp);
+    }
+    talloc_free(data.start);
 
     mf->curr_frame++;
     return 1;
@@ -201,7 +314,19 @@ static int demux_open_mf(demuxer_t *demuxer, enum demux_check check)
     sh_video->fps = mf_fps;
 
     mf->sh = sh_video;
-    demuxer->priv = (void *)mf;
+
+    struct priv *p = talloc_zero(demuxer, struct priv);
+    p->mf = mf;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wakeup, NULL);
+    for (int i = 0; i < MF_PREFETCH_COUNT; i++)
+        p->slots[i].frame = -1;
+    // Only the pattern mode opens files by name, which is what the worker
+    // threads do; entries with an already opened stream are read in place.
+    if (!mf->streams && mf->nr_of_files > 1)
+        p->pool = mp_thread_pool_create(p, 2);
+
+    demuxer->priv = p;
     demuxer->seekable = true;
 
     return 0;
@@ -212,11 +337,22 @@ error:
 
 static void demux_close_mf(demuxer_t *demuxer)
 {
+    struct priv *p = demuxer->priv;
+    if (!p)
+        return;
+    // Freeing the pool waits for still queued reads to finish.
+    talloc_free(p->pool);
+    p->pool = NULL;
+    for (int i = 0; i < MF_PREFETCH_COUNT; i++)
+        talloc_free(p->slots[i].data.start);
+    pthread_cond_destroy(&p->wakeup);
+    pthread_mutex_destroy(&p->lock);
 }
 
 static int demux_control_mf(demuxer_t *demuxer, int cmd, void *arg)
 {
-    mf_t *mf = demuxer->priv;
+    struct priv *p = demuxer->priv;
+    mf_t *mf = p->mf;
 
     switch (cmd) {
     case DEMUXER_CTRL_GET_TIME_LENGTH:
@@ -27,11 +27,13 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <unistd.h>
 
 #include <libavutil/common.h>
 #include <libavutil/lzo.h>
 #include <libavutil/intreadwrite.h>
 #include <libavutil/avstring.h>
+#include <libavutil/md5.h>
 
 #include <libavcodec/version.h>
 
@@ -43,6 +45,7 @@
 
 #include "talloc.h"
 #include "options/options.h"
+#include "options/path.h"
 #include "bstr/bstr.h"
 #include "stream/stream.h"
 #include "demux.h"
@@ -174,7 +177,9 @@ typedef struct mkv_demuxer {
     mkv_index_t *indexes;
     int num_indexes;
     bool index_complete;
+    bool index_from_cache;
     uint64_t deferred_cues;
+    uint64_t deferred_attachments;
 
     int64_t *parsed_pos;
     int num_parsed_pos;
@@ -785,6 +790,135 @@ static void read_deferred_cues(demuxer_t *demuxer)
     }
 }
 
+/* On-disk seek index cache (--demuxer-mkv-index-cache). The cues of large
+ * files are re-parsed on every open, and cue-less files degrade to linear
+ * cluster scanning on the first seek; cache the mkv_index entries in the
+ * user config dir instead, so repeated playback of the same file gets an
+ * immediately binary-searchable index. Indexes built on the fly during
+ * playback are saved too (marked as incomplete), which incrementally fixes
+ * seeking in cue-less files. */
+
+#define INDEX_CACHE_MAGIC "mpv mkvindex"
+#define INDEX_CACHE_VERSION 1
+
+struct index_cache_header {
+    char magic[12];             // INDEX_CACHE_MAGIC, no terminating 0
+    uint32_t version;
+    uint64_t file_size;         // identity check against the source file
+    uint64_t segment_start;
+    uint32_t num_indexes;
+    uint32_t complete;          // value for mkv_d->index_complete
+};
+
+// One cache file per source, keyed like the watch_later files.
+static char *get_index_cache_filename(struct demuxer *demuxer, void *talloc_ctx)
+{
+    uint8_t md5[16];
+    av_md5_sum(md5, demuxer->filename, strlen(demuxer->filename));
+    char *name = talloc_strdup(talloc_ctx, "mkv_index/");
+    for (int i = 0; i < 16; i++)
+        name = talloc_asprintf_append(name, "%02X", md5[i]);
+    return talloc_steal(talloc_ctx, mp_find_user_config_file(name));
+}
+
+static void load_index_cache(struct demuxer *demuxer)
+{
+    mkv_demuxer_t *mkv_d = demuxer->priv;
+    struct MPOpts *opts = demuxer->opts;
+
+    if (!opts->mkv_index_cache || opts->index_mode == 0)
+        return;
+
+    void *tmp = talloc_new(NULL);
+    char *filename = get_index_cache_filename(demuxer, tmp);
+    FILE *file = filename ? fopen(filename, "rb") : NULL;
+    if (!file) {
+        talloc_free(tmp);
+        return;
+    }
+
+    struct index_cache_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, file) == 1 &&
+        memcmp(hdr.magic, INDEX_CACHE_MAGIC, sizeof(hdr.magic)) == 0 &&
+        hdr.version == INDEX_CACHE_VERSION &&
+        hdr.file_size == (uint64_t)demuxer->stream->end_pos &&
+        hdr.segment_start == (uint64_t)mkv_d->segment_start &&
+        hdr.num_indexes > 0 && hdr.num_indexes < (1 << 26))
+    {
+        // cue_index_add()/grow_array() expect the allocation to be rounded
+        // up to the next multiple of 32 entries.
+        uint32_t capacity = (hdr.num_indexes + 31) & ~31u;
+        mkv_index_t *indexes = malloc(capacity * sizeof(mkv_index_t));
+        if (indexes && fread(indexes, sizeof(mkv_index_t), hdr.num_indexes,
+                             file) == hdr.num_indexes)
+        {
+            free(mkv_d->indexes);
+            mkv_d->indexes = indexes;
+            mkv_d->num_indexes = hdr.num_indexes;
+            mkv_d->index_complete = hdr.complete;
+            mkv_d->index_from_cache = true;
+            if (mkv_d->index_complete) {
+                // No reason to parse cues anymore.
+                mkv_d->parsed_cues = true;
+                mkv_d->deferred_cues = 0;
+            }
+            mp_msg(MSGT_DEMUX, MSGL_V, "[mkv] Using cached index (%d "
+                   "entries%s).\n", mkv_d->num_indexes,
+                   mkv_d->index_complete ? "" : ", incomplete");
+        } else {
+            free(indexes);
+        }
+    }
+
+    fclose(file);
+    talloc_free(tmp);
+}
+
+static void save_index_cache(struct demuxer *demuxer)
+{
+    mkv_demuxer_t *mkv_d = demuxer->priv;
+    struct MPOpts *opts = demuxer->opts;
+
+    // An index loaded from the cache can only have shrunk, so don't rewrite.
+    if (!opts->mkv_index_cache || mkv_d->index_from_cache ||
+        !mkv_d->num_indexes)
+        return;
+
+    mp_mk_config_dir("mkv_index");
+
+    void *tmp = talloc_new(NULL);
+    char *filename = get_index_cache_filename(demuxer, tmp);
+    FILE *file = filename ? fopen(filename, "wb") : NULL;
+    if (!file) {
+        talloc_free(tmp);
+        return;
+    }
+
+    struct index_cache_header hdr = {
+        .version = INDEX_CACHE_VERSION,
+        .file_size = demuxer->stream->end_pos,
+        .segment_start = mkv_d->segment_start,
+        .num_indexes = mkv_d->num_indexes,
+        .complete = mkv_d->index_complete,
+    };
+    memcpy(hdr.magic, INDEX_CACHE_MAGIC, sizeof(hdr.magic));
+
+    if (fwrite(&hdr, sizeof(hdr), 1, file) != 1 ||
+        fwrite(mkv_d->indexes, sizeof(mkv_index_t), mkv_d->num_indexes, file)
+            != mkv_d->num_indexes)
+    {
+        mp_msg(MSGT_DEMUX, MSGL_WARN, "[mkv] Failed to write index cache.\n");
+        fclose(file);
+        unlink(filename);
+    } else {
+        fclose(file);
+        mp_msg(MSGT_DEMUX, MSGL_V, "[mkv] Saved %d index entries to cache.\n",
+               mkv_d->num_indexes);
+    }
+
+    talloc_free(tmp);
+}
+
 static int demux_mkv_read_chapters(struct demuxer *demuxer)
 {
     struct MPOpts *opts = demuxer->opts;
@@ -1000,9 +1134,47 @@ static int demux_mkv_read_attachments(demuxer_t *demuxer)
     return 0;
 }
 
+static void read_deferred_attachments(demuxer_t *demuxer)
+{
+    mkv_demuxer_t *mkv_d = demuxer->priv;
+    stream_t *s = demuxer->stream;
+
+    if (mkv_d->deferred_attachments && !mkv_d->parsed_attachments) {
+        int64_t pos = mkv_d->deferred_attachments;
+        int64_t old_filepos = stream_tell(s);
+        mkv_d->deferred_attachments = 0;
+        mkv_d->parsed_attachments = true;
+        if (!stream_seek(s, pos)) {
+            mp_msg(MSGT_DEMUX, MSGL_WARN,
+                   "[mkv] Failed to seek to attachments\n");
+            return;
+        }
+        if (ebml_read_id(s, NULL) != MATROSKA_ID_ATTACHMENTS) {
+            mp_msg(MSGT_DEMUX, MSGL_WARN, "[mkv] Expected element not found\n");
+        } else if (demux_mkv_read_attachments(demuxer) < 0) {
+            mp_msg(MSGT_DEMUX, MSGL_WARN,
+                   "[mkv] Failed to read attachments\n");
+        }
+        stream_seek(s, old_filepos);
+    }
+}
+
 static int read_header_element(struct demuxer *demuxer, uint32_t id,
                                int64_t at_filepos);
 
+struct mkv_seekhead_entry {
+    uint32_t id;
+    uint64_t pos;
+};
+
+static int cmp_seekhead_entry(const void *pa, const void *pb)
+{
+    const struct mkv_seekhead_entry *a = pa, *b = pb;
+    if (a->pos != b->pos)
+        return a->pos < b->pos ? -1 : 1;
+    return 0;
+}
+
 static int demux_mkv_read_seekhead(demuxer_t *demuxer)
 {
     struct mkv_demuxer *mkv_d = demuxer->priv;
@@ -1010,6 +1182,8 @@ static int demux_mkv_read_seekhead(demuxer_t *demuxer)
     int res = 0;
     struct ebml_seek_head seekhead = {0};
     struct ebml_parse_ctx parse_ctx = {0};
+    struct mkv_seekhead_entry *entries = NULL;
+    int num_entries = 0;
 
     mp_msg(MSGT_DEMUX, MSGL_V,
            "[mkv] /---- [ parsing seek head ] ---------\n");
@@ -1031,7 +1205,17 @@ static int demux_mkv_read_seekhead(demuxer_t *demuxer)
                    "end of file - incomplete file?\n");
             continue;
         }
-        int r = read_header_element(demuxer, seek->seek_id, pos);
+        struct mkv_seekhead_entry e = {seek->seek_id, pos};
+        MP_TARRAY_APPEND(parse_ctx.talloc_ctx, entries, num_entries, e);
+    }
+    /* Visit the targets in file order instead of declaration order, so the
+     * headers are read in a single forward pass; muxers are free to list
+     * them in any order, which otherwise causes backward seeks (expensive
+     * on network streams, and they flush the stream cache). */
+    if (entries)
+        qsort(entries, num_entries, sizeof(*entries), cmp_seekhead_entry);
+    for (int i = 0; i < num_entries; i++) {
+        int r = read_header_element(demuxer, entries[i].id, entries[i].pos);
         if (r <= -2) {
             res = r;
             goto out;
@@ -1127,10 +1311,15 @@ static int read_header_element(struct demuxer *demuxer, uint32_t id,
     case MATROSKA_ID_ATTACHMENTS:
         if (mkv_d->parsed_attachments)
             break;
-        if (at_filepos && !seek_pos_id(s, at_filepos, id))
-            return -1;
-        mkv_d->parsed_attachments = true;
-        return demux_mkv_read_attachments(demuxer);
+        // Read attachments when they are actually wanted, to avoid loading
+        // possibly tens of MBs of embedded fonts on opening.
+        if (at_filepos) {
+            mkv_d->deferred_attachments = at_filepos;
+            return 1;
+        }
+        if (!mkv_d->deferred_attachments)
+            mkv_d->deferred_attachments = pos;
+        break;
 
     case EBML_ID_VOID:
         break;
@@ -1720,6 +1909,7 @@ static void mkv_free(struct demuxer *demuxer)
     struct mkv_demuxer *mkv_d = demuxer->priv;
     if (!mkv_d)
         return;
+    save_index_cache(demuxer);
     for (int i = 0; i < mkv_d->num_tracks; i++)
         demux_mkv_free_trackentry(mkv_d->tracks[i]);
     free(mkv_d->indexes);
@@ -1826,6 +2016,8 @@ static int demux_mkv_open(demuxer_t *demuxer, enum demux_check check)
     if (demuxer->params && demuxer->params->matroska_was_valid)
         *demuxer->params->matroska_was_valid = true;
 
+    load_index_cache(demuxer);
+
     while (1) {
         uint32_t id = ebml_read_id(s, NULL);
         if (s->eof) {
@@ -2254,6 +2446,31 @@ static int read_block(demuxer_t *demuxer, struct block_info *block)
     length = ebml_read_length(s, NULL);
     if (length > 500000000)
         goto exit;
+
+    /* Parse the Block header from peeked data first, so that blocks of
+     * deselected tracks can be skipped without allocating and reading
+     * their payload. handle_block() drops them either way; this keeps the
+     * work per skipped block down to parsing a few header bytes. */
+    bstr hdr = stream_peek(s, 11); // max. track num vlen + time + flags
+    uint64_t hdr_num = ebml_read_vlen_uint(&hdr);
+    if (hdr_num != EBML_UINT_INVALID && hdr.len >= 3) {
+        mkv_track_t *track = NULL;
+        for (int i = 0; i < mkv_d->num_tracks; i++) {
+            if (mkv_d->tracks[i]->tnum == hdr_num)
+                track = mkv_d->tracks[i];
+        }
+        if (track && !demuxer_stream_is_selected(demuxer, track->stream)) {
+            int16_t hdr_time = hdr.start[0] << 8 | hdr.start[1];
+            block->track = track;
+            block->timecode = hdr_time * mkv_d->tc_scale + mkv_d->cluster_tc;
+            if (block->simple)
+                block->keyframe = hdr.start[2] & 0x80;
+            block->filepos = stream_tell(s);
+            stream_skip(s, length);
+            return 1;
+        }
+    }
+
     block->alloc = malloc(length + AV_LZO_INPUT_PADDING);
     if (!block->alloc)
         goto exit;
@@ -2758,6 +2975,9 @@ static int demux_mkv_control(demuxer_t *demuxer, int cmd, void *arg)
 
         *((double *) arg) = (double) mkv_d->duration;
         return DEMUXER_CTRL_OK;
+    case DEMUXER_CTRL_READ_ATTACHMENTS:
+        read_deferred_attachments(demuxer);
+        return DEMUXER_CTRL_OK;
     default:
         return DEMUXER_CTRL_NOTIMPL;
     }
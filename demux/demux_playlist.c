@@ -15,6 +15,10 @@
  * with mpv.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <dirent.h>
+#include <stdlib.h>
+#include <ctype.h>
+
 #include "common/common.h"
 #include "options/options.h"
 #include "common/msg.h"
@@ -82,6 +86,8 @@ static int parse_ref_init(struct pl_parser *p)
     bstr line = bstr_strip(pl_get_line(p));
     if (!bstr_equals0(line, "[Reference]"))
         return -1;
+    if (p->probing)
+        return 0;
     while (!pl_eof(p)) {
         line = bstr_strip(pl_get_line(p));
         if (bstr_case_startswith(line, bstr0("Ref"))) {
@@ -131,6 +137,60 @@ static int parse_pls(struct pl_parser *p)
     return 0;
 }
 
+// Filename order with runs of digits compared by value, so that "2.mp3"
+// sorts before "10.mp3".
+static int cmp_filename(const void *pa, const void *pb)
+{
+    bstr a = bstr0(*(char **)pa);
+    bstr b = bstr0(*(char **)pb);
+    while (a.len && b.len) {
+        unsigned char ca = a.start[0], cb = b.start[0];
+        if (isdigit(ca) && isdigit(cb)) {
+            bstr resta, restb;
+            long long va = bstrtoll(a, &resta, 10);
+            long long vb = bstrtoll(b, &restb, 10);
+            if (va != vb)
+                return va > vb ? 1 : -1;
+            a = resta;
+            b = restb;
+        } else {
+            if (ca != cb)
+                return ca > cb ? 1 : -1;
+            a = bstr_cut(a, 1);
+            b = bstr_cut(b, 1);
+        }
+    }
+    return a.len - b.len;
+}
+
+// Expand a directory into a playlist of its entries, in one readdir() sweep.
+// Subdirectories are added as plain entries; playing one of them expands it
+// again, so deep trees are walked incrementally instead of up front.
+static int parse_dir(struct pl_parser *p, struct demuxer *demuxer)
+{
+    char *path = demuxer->stream->path;
+    DIR *dir = opendir(path);
+    if (!dir)
+        return -1;
+    char **entries = NULL;
+    int num_entries = 0;
+    struct dirent *de;
+    while ((de = readdir(dir))) {
+        if (de->d_name[0] == '.')
+            continue;
+        MP_TARRAY_APPEND(p, entries, num_entries,
+                         talloc_strdup(p, de->d_name));
+    }
+    closedir(dir);
+    if (num_entries)
+        qsort(entries, num_entries, sizeof(entries[0]), cmp_filename);
+    for (int n = 0; n < num_entries; n++) {
+        char *entry = mp_path_join(p, bstr0(path), bstr0(entries[n]));
+        playlist_add_file(p->pl, entry);
+    }
+    return 0;
+}
+
 struct pl_format {
     const char *name;
     int (*parse)(struct pl_parser *p);
@@ -162,6 +222,14 @@ static int open_file(struct demuxer *demuxer, enum demux_check check)
     struct pl_parser *p = talloc_zero(NULL, struct pl_parser);
     p->pl = talloc_zero(p, struct playlist);
 
+    if (demuxer->stream->type == STREAMTYPE_DIR) {
+        bool ok = parse_dir(p, demuxer) >= 0;
+        demuxer->playlist = talloc_steal(demuxer, p->pl);
+        demuxer->filetype = "dir";
+        talloc_free(p);
+        return ok ? 0 : -1;
+    }
+
     bstr probe_buf = stream_peek(demuxer->stream, PROBE_SIZE);
     p->s = open_memory_stream(probe_buf.start, probe_buf.len);
     p->utf16 = stream_skip_bom(p->s);
@@ -1343,7 +1343,19 @@ static int d_open_file(struct demuxer *demuxer, enum demux_check check)
 
     demuxer->filetype = sr.name;
 
-    sub_data *sd = sub_read_file(demuxer->stream, &sr);
+    // Parse from an in-memory copy of the file. The line readers pull single
+    // lines and the autodetection re-scans from the start, which is very slow
+    // through the real (possibly cached) stream; from memory, the newline
+    // scan is a plain memchr over the buffer.
+    bstr buf = stream_read_complete(demuxer->stream, NULL, 100000000);
+    if (!buf.start)
+        return -1;
+    struct stream *ms = open_memory_stream(buf.start, buf.len);
+    talloc_free(buf.start);
+    ms->opts = demuxer->opts; // sub_read_file uses opts->sub_fps
+
+    sub_data *sd = sub_read_file(ms, &sr);
+    free_stream(ms);
     if (!sd)
         return -1;
 
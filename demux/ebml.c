@@ -50,6 +50,34 @@ uint32_t ebml_read_id(stream_t *s, int *length)
     int i, len_mask = 0x80;
     uint32_t id;
 
+    // Fast path: parse directly from the stream buffer. The varint width
+    // follows from the position of the marker bit (av_log2), so the common
+    // case costs one peek instead of up to 4 stream_read_char() calls. This
+    // matters because the cluster loop in demux_mkv.c comes through here for
+    // every element. stream_read_peek() borrows already buffered data without
+    // copying (for cached streams, straight out of the cache ringbuffer);
+    // only if too little is buffered, fall back to a copying peek.
+    bstr buf = stream_read_peek(s);
+    if (buf.len < 4)
+        buf = stream_peek(s, 4);
+    if (buf.len > 0 && buf.start[0]) {
+        int width = 8 - av_log2(buf.start[0]);
+        if (width > 4) {
+            stream_read_consume(s, 1);
+            return EBML_ID_INVALID;
+        }
+        if (width <= buf.len) {
+            id = buf.start[0];
+            for (int n = 1; n < width; n++)
+                id = (id << 8) | buf.start[n];
+            stream_read_consume(s, width);
+            if (length)
+                *length = width;
+            return id;
+        }
+    }
+
+    // Slow path for EOF and short buffers (stream_peek() consumed nothing).
     for (i = 0, id = stream_read_char(s); i < 4 && !(id & len_mask); i++)
         len_mask >>= 1;
     if (i >= 4)
@@ -119,6 +147,27 @@ uint64_t ebml_read_length(stream_t *s, int *length)
     int i, j, num_ffs = 0, len_mask = 0x80;
     uint64_t len;
 
+    // Fast path, same idea as in ebml_read_id(). A length of all 1-bits
+    // means "unknown", which the byte loop below detects by counting 0xFF
+    // bytes; comparing against the all-ones value is equivalent.
+    bstr buf = stream_read_peek(s);
+    if (buf.len < 8)
+        buf = stream_peek(s, 8);
+    if (buf.len > 0 && buf.start[0]) {
+        int width = 8 - av_log2(buf.start[0]);
+        if (width <= buf.len) {
+            len = buf.start[0] & (0xFF >> width);
+            for (int n = 1; n < width; n++)
+                len = (len << 8) | buf.start[n];
+            stream_read_consume(s, width);
+            if (length)
+                *length = width;
+            if (len == ((uint64_t)1 << (7 * width)) - 1) // unknown length
+                return EBML_UINT_INVALID;
+            return len;
+        }
+    }
+
     for (i = 0, len = stream_read_char(s); i < 8 && !(len & len_mask); i++)
         len_mask >>= 1;
     if (i >= 8)
@@ -31,6 +31,12 @@ typedef struct demux_packet {
     double stream_pts;
     int64_t pos; // position in source file byte stream
     unsigned char *buffer;
+    // If > 0, buffer holds the payload deflate-compressed while the packet
+    // sits in the demuxer queue; this is the original payload size.
+    int uncompressed_len;
+    // If >= 0, the payload sits in the demuxer's queue spill file at this
+    // offset (buffer is NULL then), and is read back on dequeue.
+    int64_t spill_pos;
     bool keyframe;
     int stream; // source stream index
     struct demux_packet *next;
@@ -0,0 +1,122 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "packet_pool.h"
+
+// Buffers are rounded up to power-of-two size classes between MIN_SHIFT and
+// MAX_SHIFT. Larger requests are served by plain malloc and freed on release.
+#define POOL_MIN_SHIFT 10               // 1 KiB
+#define POOL_MAX_SHIFT 20               // 1 MiB
+#define POOL_NUM_CLASSES (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+
+// Cap on cached buffers per size class, to bound idle memory use. The worst
+// case total is about 70 MiB, but in practice only the 2-3 classes matching
+// the file's packet sizes ever fill up.
+#define POOL_MAX_CACHED 32
+
+// Every buffer handed out is preceded by this header. Keep its size a
+// multiple of 16 so the payload stays suitably aligned.
+struct block {
+    size_t size;            // usable payload size
+    struct block *next;     // freelist link (unused while handed out)
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct block *freelist[POOL_NUM_CLASSES];
+static int num_cached[POOL_NUM_CLASSES];
+
+// Smallest size class that fits size, or -1 if the request is too large.
+static int size_to_class(size_t size)
+{
+    for (int c = 0; c < POOL_NUM_CLASSES; c++) {
+        if (size <= (size_t)1 << (POOL_MIN_SHIFT + c))
+            return c;
+    }
+    return -1;
+}
+
+void *packet_pool_alloc(size_t size)
+{
+    int c = size_to_class(size);
+    struct block *b = NULL;
+
+    if (c >= 0) {
+        pthread_mutex_lock(&pool_lock);
+        b = freelist[c];
+        if (b) {
+            freelist[c] = b->next;
+            num_cached[c]--;
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+
+    if (!b) {
+        size_t alloc = c >= 0 ? (size_t)1 << (POOL_MIN_SHIFT + c) : size;
+        b = malloc(sizeof(*b) + alloc);
+        if (!b)
+            return NULL;
+        b->size = alloc;
+    }
+
+    b->next = NULL;
+    return b + 1;
+}
+
+void *packet_pool_realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+        return packet_pool_alloc(size);
+
+    struct block *b = (struct block *)ptr - 1;
+    if (b->size >= size)
+        return ptr;
+
+    void *new = packet_pool_alloc(size);
+    if (!new)
+        return NULL;
+    memcpy(new, ptr, b->size);
+    packet_pool_release(ptr);
+    return new;
+}
+
+void packet_pool_release(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    struct block *b = (struct block *)ptr - 1;
+    int c = size_to_class(b->size);
+
+    // Cache only blocks of exact class size; everything else (oversized
+    // requests) goes straight back to the allocator.
+    if (c >= 0 && b->size == (size_t)1 << (POOL_MIN_SHIFT + c)) {
+        pthread_mutex_lock(&pool_lock);
+        if (num_cached[c] < POOL_MAX_CACHED) {
+            b->next = freelist[c];
+            freelist[c] = b;
+            num_cached[c]++;
+            b = NULL;
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+
+    free(b);
+}
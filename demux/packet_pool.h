@@ -0,0 +1,41 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPV_PACKET_POOL_H
+#define MPV_PACKET_POOL_H
+
+#include <stddef.h>
+
+/*
+ * Recycling allocator for demux packet payloads. Buffers are kept in
+ * per-size-class freelists when released, so steady-state demuxing (hundreds
+ * of small audio packets per second) does not hit malloc/free for every
+ * packet. Thread-safe; packets can be allocated on the demuxer thread and
+ * released on the playback thread.
+ */
+
+// Allocate a buffer of at least size bytes. Returns NULL on failure.
+void *packet_pool_alloc(size_t size);
+
+// Grow a buffer to at least size bytes, preserving its contents. Like
+// realloc(), ptr==NULL is allowed. Returns NULL on failure (ptr stays valid).
+void *packet_pool_realloc(void *ptr, size_t size);
+
+// Return a buffer to the pool (or free it). NULL is allowed.
+void packet_pool_release(void *ptr);
+
+#endif /* MPV_PACKET_POOL_H */
@@ -70,6 +70,7 @@ struct cmd_bind {
     int num_keys;
     char *cmd;
     char *location;     // filename/line number of definition
+    struct mp_cmd *parsed;  // cached parsed cmd (NULL if not parsed yet)
     bool is_builtin;
     struct cmd_bind_section *owner;
 };
@@ -161,6 +162,9 @@ static const struct mp_cmd_def mp_cmds[] = {
   { MP_CMD_SHOW_TEXT, "show_text", { ARG_STRING, OARG_INT(-1), OARG_INT(0) },
     .allow_auto_repeat = true},
   { MP_CMD_SHOW_PROGRESS, "show_progress",  .allow_auto_repeat = true},
+  { MP_CMD_DUMP_FRAME_STATS, "dump_frame_stats", },
+  { MP_CMD_DUMP_PERF_STATS, "dump_perf_stats", },
+  { MP_CMD_DUMP_ALLOC_STATS, "dump_alloc_stats", },
   { MP_CMD_SUB_ADD, "sub_add", { ARG_STRING } },
   { MP_CMD_SUB_REMOVE, "sub_remove", { OARG_INT(-1) } },
   { MP_CMD_SUB_RELOAD, "sub_reload", { OARG_INT(-1) } },
@@ -209,6 +213,8 @@ static const struct mp_cmd_def mp_cmds[] = {
 
   { MP_CMD_SET, "set", { ARG_STRING,  ARG_STRING } },
   { MP_CMD_GET_PROPERTY, "get_property", { ARG_STRING } },
+  { MP_CMD_GET_PROPERTIES, "get_properties", { ARG_STRING, ARG_STRING },
+    .vararg = true },
   { MP_CMD_ADD, "add", { ARG_STRING, OARG_DOUBLE(0) },
     .allow_auto_repeat = true},
   { MP_CMD_CYCLE, "cycle", {
@@ -517,9 +523,20 @@ struct input_fd {
     int pos, size;
 };
 
+// Entry of the per-section key lookup index (sorted by key).
+struct bind_index_entry {
+    int key;            // first key code of the bind's key sequence
+    int bind;           // index into cmd_bind_section.binds
+};
+
 struct cmd_bind_section {
     struct cmd_bind *binds;
     int num_binds;
+    // Index for fast bind lookup by first key code; rebuilt on demand
+    // whenever the binds change.
+    struct bind_index_entry *index;
+    int num_index;
+    bool index_dirty;
     char *section;
     struct mp_rect mouse_area;  // set at runtime, if at all
     bool mouse_area_set;        // mouse_area is valid and should be tested
@@ -529,7 +546,10 @@ struct cmd_bind_section {
 #define MAX_ACTIVE_SECTIONS 5
 
 struct active_section {
-    char *name;
+    // Resolved when the section is enabled, so key dispatch doesn't have to
+    // walk the section list doing string comparisons. Sections are never
+    // deallocated, so the pointer stays valid.
+    struct cmd_bind_section *bs;
     int flags;
 };
 
@@ -577,6 +597,18 @@ struct input_ctx {
 
     bool test;
 
+    // When set, queued seek commands count as abort commands (see
+    // mp_input_set_abort_on_seek()).
+    bool abort_on_seek;
+
+    // Cache of recently parsed command strings; scripts and autorepeated
+    // keys tend to resend the identical command many times per second.
+    struct parsed_cmd_cache {
+        char *str;          // original command string
+        struct mp_cmd *cmd; // parsed template, cloned for each use
+    } parse_cache[8];
+    int parse_cache_pos;    // next slot to replace (round robin)
+
     bool default_bindings;
     // List of command binding sections
     struct cmd_bind_section *cmd_bind_sections;
@@ -711,6 +743,15 @@ static bool queue_has_abort_cmds(struct cmd_queue *queue)
     return ret;
 }
 
+static bool queue_has_seek_cmds(struct cmd_queue *queue)
+{
+    for (struct mp_cmd *cmd = queue->first; cmd; cmd = cmd->queue_next) {
+        if (cmd->id == MP_CMD_SEEK)
+            return true;
+    }
+    return false;
+}
+
 static void queue_remove(struct cmd_queue *queue, struct mp_cmd *cmd)
 {
     struct mp_cmd **p_prev = &queue->first;
@@ -1119,6 +1160,18 @@ static struct mp_cmd *parse_cmd_str(struct mp_log *log, bstr *str, const char *l
 mp_cmd_t *mp_input_parse_cmd(struct input_ctx *ictx, bstr str, const char *loc)
 {
     bstr original = str;
+
+    input_lock(ictx);
+    for (int n = 0; n < MP_ARRAY_SIZE(ictx->parse_cache); n++) {
+        struct parsed_cmd_cache *e = &ictx->parse_cache[n];
+        if (e->cmd && bstr_equals0(original, e->str)) {
+            struct mp_cmd *res = mp_cmd_clone(e->cmd);
+            input_unlock(ictx);
+            return res;
+        }
+    }
+    input_unlock(ictx);
+
     struct mp_cmd *cmd = parse_cmd_str(ictx->log, &str, loc);
     if (!cmd)
         return NULL;
@@ -1154,6 +1207,16 @@ mp_cmd_t *mp_input_parse_cmd(struct input_ctx *ictx, bstr str, const char *loc)
         p_prev = &sub->queue_next;
     }
 
+    input_lock(ictx);
+    struct parsed_cmd_cache *e = &ictx->parse_cache[ictx->parse_cache_pos];
+    ictx->parse_cache_pos =
+        (ictx->parse_cache_pos + 1) % MP_ARRAY_SIZE(ictx->parse_cache);
+    talloc_free(e->str);
+    talloc_free(e->cmd);
+    e->str = bstrdup0(ictx, original);
+    e->cmd = talloc_steal(ictx, mp_cmd_clone(cmd));
+    input_unlock(ictx);
+
     return cmd;
 }
 
@@ -1389,26 +1452,67 @@ static struct cmd_bind_section *get_bind_section(struct input_ctx *ictx,
     return bind_section;
 }
 
-static struct cmd_bind *find_bind_for_key_section(struct input_ctx *ictx,
-                                                  char *section,
-                                                  int num_keys, int *keys)
+static int index_cmp(const void *pa, const void *pb)
 {
-    struct cmd_bind_section *bs = get_bind_section(ictx, bstr0(section));
+    const struct bind_index_entry *a = pa, *b = pb;
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+static void update_bind_index(struct cmd_bind_section *bs)
+{
+    bs->index = talloc_realloc(bs, bs->index, struct bind_index_entry,
+                               bs->num_binds);
+    bs->num_index = bs->num_binds;
+    for (int n = 0; n < bs->num_binds; n++)
+        bs->index[n] = (struct bind_index_entry){bs->binds[n].keys[0], n};
+    qsort(bs->index, bs->num_index, sizeof(bs->index[0]), index_cmp);
+    bs->index_dirty = false;
+}
 
+static struct cmd_bind *find_bind_for_key_bs(struct input_ctx *ictx,
+                                             struct cmd_bind_section *bs,
+                                             int num_keys, int *keys)
+{
     if (!num_keys || !bs->num_binds)
         return NULL;
 
-    // Prefer user-defined keys over builtin bindings
-    for (int builtin = 0; builtin < 2; builtin++) {
-        if (builtin && !ictx->default_bindings)
-            break;
-        for (int n = 0; n < bs->num_binds; n++) {
-            if (bs->binds[n].is_builtin == (bool)builtin &&
-                bind_matches_key(&bs->binds[n], num_keys, keys))
-                return &bs->binds[n];
+    if (bs->index_dirty)
+        update_bind_index(bs);
+
+    // Binds with the same first key are adjacent in the index; find the
+    // first of them.
+    int low = 0, high = bs->num_index;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (bs->index[mid].key < keys[0]) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
-    return NULL;
+
+    // Prefer user-defined keys over builtin bindings. For each exact key
+    // sequence, at most one user and one builtin bind exist (bind_keys()
+    // replaces duplicates), so the order within the index doesn't matter.
+    struct cmd_bind *builtin_bind = NULL;
+    for (int i = low; i < bs->num_index && bs->index[i].key == keys[0]; i++) {
+        struct cmd_bind *bind = &bs->binds[bs->index[i].bind];
+        if (!bind_matches_key(bind, num_keys, keys))
+            continue;
+        if (!bind->is_builtin)
+            return bind;
+        if (!builtin_bind)
+            builtin_bind = bind;
+    }
+    return ictx->default_bindings ? builtin_bind : NULL;
+}
+
+static struct cmd_bind *find_bind_for_key_section(struct input_ctx *ictx,
+                                                  char *section,
+                                                  int num_keys, int *keys)
+{
+    struct cmd_bind_section *bs = get_bind_section(ictx, bstr0(section));
+    return find_bind_for_key_bs(ictx, bs, num_keys, keys);
 }
 
 static bool any_mouse_buttons_down(int num_keys, int *keys)
@@ -1452,7 +1556,7 @@ static struct cmd_bind *find_any_bind_for_key(struct input_ctx *ictx,
 
     for (int i = ictx->num_active_sections - 1; i >= 0; i--) {
         struct active_section *s = &ictx->active_sections[i];
-        struct cmd_bind *bind = find_bind_for_key_section(ictx, s->name, n, keys);
+        struct cmd_bind *bind = find_bind_for_key_bs(ictx, s->bs, n, keys);
         if (bind) {
             struct cmd_bind_section *bs = bind->owner;
             if (!use_mouse || (bs->mouse_area_set && test_rect(&bs->mouse_area,
@@ -1490,7 +1594,11 @@ static mp_cmd_t *get_cmd_from_keys(struct input_ctx *ictx, char *force_section,
         talloc_free(key_buf);
         return NULL;
     }
-    mp_cmd_t *ret = mp_input_parse_cmd(ictx, bstr0(cmd->cmd), cmd->location);
+    // Parsing the command string is too expensive to redo on every repeated
+    // key (or mouse move) event, so cache the result in the bind.
+    if (!cmd->parsed)
+        cmd->parsed = mp_input_parse_cmd(ictx, bstr0(cmd->cmd), cmd->location);
+    mp_cmd_t *ret = mp_cmd_clone(cmd->parsed);
     if (ret) {
         ret->input_section = cmd->owner->section;
         if (mp_msg_test_log(ictx->log, MSGL_DBG2)) {
@@ -1904,12 +2012,28 @@ static void input_wait_read(struct input_ctx *ictx, int time)
 /**
  * \param time time to wait at most for an event in milliseconds
  */
-static void read_events(struct input_ctx *ictx, int time)
+// Time in ms until the next autorepeat event is due, or -1 if no repeat is
+// pending. Waiting exactly this long (instead of polling at repeat
+// granularity) makes repeats fire on schedule with no wakeups in between.
+static int autorepeat_deadline(struct input_ctx *ictx)
 {
-    if (ictx->num_key_down && ictx->ar_rate > 0) {
-        time = FFMIN(time, 1000 / ictx->ar_rate);
-        time = FFMIN(time, ictx->ar_delay);
+    if (ictx->ar_rate <= 0 || ictx->ar_state < 0 || !ictx->num_key_down
+        || (ictx->key_down[ictx->num_key_down - 1] & MP_NO_REPEAT_KEY))
+        return -1;
+    int64_t deadline;
+    if (ictx->ar_state == 0) {
+        deadline = ictx->last_key_down + (int64_t)ictx->ar_delay * 1000;
+    } else {
+        deadline = ictx->last_ar + 1000000 / ictx->ar_rate;
     }
+    return FFMAX((deadline - mp_time_us()) / 1000, 0);
+}
+
+static void read_events(struct input_ctx *ictx, int time)
+{
+    int ar_time = autorepeat_deadline(ictx);
+    if (ar_time >= 0)
+        time = FFMIN(time, ar_time);
     time = FFMAX(time, 0);
 
     while (1) {
@@ -2029,6 +2153,14 @@ void mp_cmd_free(mp_cmd_t *cmd)
     talloc_free(cmd);
 }
 
+static char *arena_add(char **arena, const void *data, size_t len)
+{
+    char *r = *arena;
+    memcpy(r, data, len);
+    *arena += len;
+    return r;
+}
+
 mp_cmd_t *mp_cmd_clone(mp_cmd_t *cmd)
 {
     mp_cmd_t *ret;
@@ -2037,11 +2169,33 @@ mp_cmd_t *mp_cmd_clone(mp_cmd_t *cmd)
     if (!cmd)
         return NULL;
 
-    ret = talloc_memdup(NULL, cmd, sizeof(mp_cmd_t));
-    ret->name = talloc_strdup(ret, cmd->name);
+    // Build the clone as a single contiguous allocation, with all owned
+    // strings in a trailing arena. Every dispatched command is a clone (the
+    // parse cache hands out clones), so command floods from scripts would
+    // otherwise do 3+nargs allocations per command. Later string
+    // replacements (e.g. property expansion) simply leave their arena slot
+    // unused and steal a new string into the command.
+    size_t extra = strlen(cmd->name) + 1 + cmd->original.len;
+    for (i = 0; i < cmd->nargs; i++) {
+        if (cmd->args[i].type->type == &m_option_type_string && cmd->args[i].v.s)
+            extra += strlen(cmd->args[i].v.s) + 1;
+    }
+    ret = talloc_size(NULL, sizeof(*ret) + extra);
+    *ret = *cmd;
+    char *arena = (char *)ret + sizeof(*ret);
+    ret->name = arena_add(&arena, cmd->name, strlen(cmd->name) + 1);
+    // The source command (e.g. an evicted cache entry) may be freed before
+    // the clone, so the original string must be duplicated as well.
+    if (cmd->original.start) {
+        ret->original.start =
+            (unsigned char *)arena_add(&arena, cmd->original.start,
+                                       cmd->original.len);
+    }
     for (i = 0; i < ret->nargs; i++) {
-        if (cmd->args[i].type->type == &m_option_type_string)
-            ret->args[i].v.s = talloc_strdup(ret, cmd->args[i].v.s);
+        if (cmd->args[i].type->type == &m_option_type_string && cmd->args[i].v.s) {
+            ret->args[i].v.s = arena_add(&arena, cmd->args[i].v.s,
+                                         strlen(cmd->args[i].v.s) + 1);
+        }
     }
 
     if (cmd->id == MP_CMD_COMMAND_LIST) {
@@ -2127,6 +2281,7 @@ static void bind_dealloc(struct cmd_bind *bind)
 {
     talloc_free(bind->cmd);
     talloc_free(bind->location);
+    talloc_free(bind->parsed);
 }
 
 static void bind_keys(struct input_ctx *ictx, bool builtin, bstr section,
@@ -2162,6 +2317,7 @@ static void bind_keys(struct input_ctx *ictx, bool builtin, bstr section,
         .num_keys = num_keys,
     };
     memcpy(bind->keys, keys, num_keys * sizeof(bind->keys[0]));
+    bs->index_dirty = true;
 }
 
 // restrict_section: every entry is forced to this section name
@@ -2270,7 +2426,7 @@ void mp_input_disable_section(struct input_ctx *ictx, char *name)
     // Remove old section, or make sure it's on top if re-enabled
     for (int i = ictx->num_active_sections - 1; i >= 0; i--) {
         struct active_section *as = &ictx->active_sections[i];
-        if (strcmp(as->name, name) == 0) {
+        if (strcmp(as->bs->section, name) == 0) {
             MP_TARRAY_REMOVE_AT(ictx->active_sections,
                                 ictx->num_active_sections, i);
         }
@@ -2289,12 +2445,12 @@ void mp_input_enable_section(struct input_ctx *ictx, char *name, int flags)
 
     if (ictx->num_active_sections < MAX_ACTIVE_SECTIONS) {
         ictx->active_sections[ictx->num_active_sections++] =
-            (struct active_section) {name, flags};
+            (struct active_section) {get_bind_section(ictx, bstr0(name)), flags};
     }
 
     MP_DBG(ictx, "active section stack:\n");
     for (int n = 0; n < ictx->num_active_sections; n++) {
-        MP_DBG(ictx, " %s %d\n", ictx->active_sections[n].name,
+        MP_DBG(ictx, " %s %d\n", ictx->active_sections[n].bs->section,
                ictx->active_sections[n].flags);
     }
 
@@ -2326,7 +2482,7 @@ static bool test_mouse(struct input_ctx *ictx, int x, int y, int rej_flags)
         struct active_section *as = &ictx->active_sections[i];
         if (as->flags & rej_flags)
             continue;
-        struct cmd_bind_section *s = get_bind_section(ictx, bstr0(as->name));
+        struct cmd_bind_section *s = as->bs;
         if (s->mouse_area_set && test_rect(&s->mouse_area, x, y)) {
             res = true;
             break;
@@ -2357,6 +2513,7 @@ static void remove_binds(struct cmd_bind_section *bs, bool builtin)
             bs->num_binds--;
         }
     }
+    bs->index_dirty = true;
 }
 
 void mp_input_define_section(struct input_ctx *ictx, char *name, char *location,
@@ -2590,12 +2747,28 @@ static bool test_abort(struct input_ctx *ictx)
                 "Aborting current processing.\n");
         return true;
     }
+    if (ictx->abort_on_seek && queue_has_seek_cmds(&ictx->cmd_queue)) {
+        MP_VERBOSE(ictx, "Aborting blocked operation for a newer seek.\n");
+        return true;
+    }
     return false;
 }
 
 /**
  * \param time time to wait for an interruption in milliseconds
  */
+// While enabled, a queued seek command makes mp_input_check_interrupt()
+// report an abort. The playloop enables this during blocking seek
+// operations, so that rapidly issued seeks (scrubbing on a network stream)
+// abort the stale in-flight seek at the next I/O boundary instead of
+// queueing behind it.
+void mp_input_set_abort_on_seek(struct input_ctx *ictx, bool enable)
+{
+    input_lock(ictx);
+    ictx->abort_on_seek = enable;
+    input_unlock(ictx);
+}
+
 int mp_input_check_interrupt(struct input_ctx *ictx, int time)
 {
     input_lock(ictx);
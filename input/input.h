@@ -57,9 +57,13 @@ enum mp_command_type {
     MP_CMD_SUB_RELOAD,
     MP_CMD_SET,
     MP_CMD_GET_PROPERTY,
+    MP_CMD_GET_PROPERTIES,
     MP_CMD_PRINT_TEXT,
     MP_CMD_SHOW_TEXT,
     MP_CMD_SHOW_PROGRESS,
+    MP_CMD_DUMP_FRAME_STATS,
+    MP_CMD_DUMP_PERF_STATS,
+    MP_CMD_DUMP_ALLOC_STATS,
     MP_CMD_ADD,
     MP_CMD_CYCLE,
     MP_CMD_MULTIPLY,
@@ -303,6 +307,9 @@ void mp_input_wakeup(struct input_ctx *ictx);
 // Interruptible usleep:  (used by demux)
 int mp_input_check_interrupt(struct input_ctx *ictx, int time);
 
+// Make queued seek commands count as interruption (see mp_input_check_interrupt).
+void mp_input_set_abort_on_seek(struct input_ctx *ictx, bool enable);
+
 // If this returns true, use Right Alt key as Alt Gr to produce special
 // characters. If false, count Right Alt as the modifier Alt key.
 bool mp_input_use_alt_gr(struct input_ctx *ictx);
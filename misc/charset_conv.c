@@ -141,10 +141,20 @@ const char *mp_charset_guess(bstr buf, const char *user_cp, int flags)
     if (!mp_charset_requires_guess(user_cp))
         return user_cp;
 
+    // The detectors are O(n) in the input size, but the decision is made
+    // from the first few KB; don't let multi-MB subtitle files delay
+    // startup. Truncation can split a multibyte sequence, so partial
+    // sequences at the end must not fail the UTF-8 check below.
+    bool cut = false;
+    if (buf.len > MP_CHARSET_GUESS_MAX) {
+        buf.len = MP_CHARSET_GUESS_MAX;
+        cut = true;
+    }
+
     // Do our own UTF-8 detection, because at least ENCA seems to get it
     // wrong sometimes (suggested by divVerent).
     int r = bstr_validate_utf8(buf);
-    if (r >= 0 || (r > -8 && (flags & MP_ICONV_ALLOW_CUTOFF)))
+    if (r >= 0 || (r > -8 && (cut || (flags & MP_ICONV_ALLOW_CUTOFF))))
         return "UTF-8";
 
     bstr params[3] = {{0}};
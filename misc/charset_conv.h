@@ -10,6 +10,10 @@ enum {
     MP_STRICT_UTF8 = 4,         // don't fall back to UTF-8-BROKEN when guessing
 };
 
+// mp_charset_guess() inspects at most this many bytes of its input; callers
+// assembling a detection buffer don't need to collect more than this.
+#define MP_CHARSET_GUESS_MAX (64 * 1024)
+
 bool mp_charset_is_utf8(const char *user_cp);
 bool mp_charset_requires_guess(const char *user_cp);
 const char *mp_charset_guess(bstr buf, const char *user_cp, int flags);
@@ -0,0 +1,89 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "intern.h"
+
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+// Open-addressed hash table of interned strings. Entries are allocated with
+// malloc and deliberately never freed: atoms live as long as the process.
+static char **table;
+static size_t table_size;   // allocated slots, power of two
+static size_t num_entries;
+
+static uint32_t hash_str(struct bstr s)
+{
+    uint32_t hash = 0x811c9dc5;     // FNV-1a
+    for (int n = 0; n < s.len; n++) {
+        hash ^= (unsigned char)s.start[n];
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+static char **find_slot(char **t, size_t size, struct bstr s)
+{
+    size_t i = hash_str(s) & (size - 1);
+    while (t[i]) {
+        if (strlen(t[i]) == s.len && memcmp(t[i], s.start, s.len) == 0)
+            break;
+        i = (i + 1) & (size - 1);
+    }
+    return &t[i];
+}
+
+const char *mp_intern_bstr(struct bstr s)
+{
+    pthread_mutex_lock(&intern_lock);
+    // Keep the load factor below 3/4.
+    if ((num_entries + 1) * 4 > table_size * 3) {
+        size_t new_size = table_size ? table_size * 2 : 64;
+        char **new_table = calloc(new_size, sizeof(char *));
+        if (!new_table)
+            abort();
+        for (size_t n = 0; n < table_size; n++) {
+            if (table[n])
+                *find_slot(new_table, new_size, bstr0(table[n])) = table[n];
+        }
+        free(table);
+        table = new_table;
+        table_size = new_size;
+    }
+    char **slot = find_slot(table, table_size, s);
+    if (!*slot) {
+        char *copy = malloc(s.len + 1);
+        if (!copy)
+            abort();
+        memcpy(copy, s.start, s.len);
+        copy[s.len] = '\0';
+        *slot = copy;
+        num_entries++;
+    }
+    const char *res = *slot;
+    pthread_mutex_unlock(&intern_lock);
+    return res;
+}
+
+const char *mp_intern(const char *s)
+{
+    return mp_intern_bstr(bstr0(s));
+}
@@ -0,0 +1,31 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MP_MISC_INTERN_H_
+#define MP_MISC_INTERN_H_
+
+#include "bstr/bstr.h"
+
+// Return the canonical copy of the given string. Interned strings are
+// immutable, shared between all users, and live until process exit; the
+// result must not be modified or freed. Two interned strings are equal
+// exactly if their pointers are equal. Intended for small strings from a
+// bounded set (like metadata tag keys), not for arbitrary user data.
+const char *mp_intern(const char *s);
+const char *mp_intern_bstr(struct bstr s);
+
+#endif
@@ -136,3 +136,95 @@ char *mp_ring_repr(struct mp_ring *buffer, void *talloc_ctx)
         mp_ring_buffered(buffer),
         mp_ring_available(buffer));
 }
+
+/* The MPSC ring uses the sequence number scheme by Dmitry Vyukov: slot
+ * number i starts with seq == i. A producer may fill a slot when seq equals
+ * the producer position, and publishes it by setting seq to pos + 1, which
+ * is what the consumer waits for. After reading, the consumer sets seq to
+ * pos + num_slots, the producer position of the slot in the next lap. */
+
+#define MP_RING_CACHE_LINE 64
+
+struct mp_mpsc_slot {
+    uint32_t seq;
+    int len;
+    unsigned char data[];
+};
+
+struct mp_mpsc_ring {
+    int num_slots;          // power of two
+    int slot_size;          // maximum payload size per message
+    int stride;             // distance between slots in bytes
+    unsigned char *slots;
+    // Producer and consumer positions on separate cache lines, so that
+    // competing producers do not keep invalidating the consumer's line.
+    union { uint32_t pos; unsigned char pad[MP_RING_CACHE_LINE]; } head, tail;
+};
+
+static struct mp_mpsc_slot *mp_mpsc_get_slot(struct mp_mpsc_ring *ring,
+                                             uint32_t pos)
+{
+    int index = pos & (ring->num_slots - 1);
+    return (struct mp_mpsc_slot *)(ring->slots + index * (size_t)ring->stride);
+}
+
+struct mp_mpsc_ring *mp_mpsc_ring_new(void *talloc_ctx, int slots,
+                                      int slot_size)
+{
+    int num_slots = 1;
+    while (num_slots < slots)
+        num_slots *= 2;
+
+    struct mp_mpsc_ring *ring = talloc_zero(talloc_ctx, struct mp_mpsc_ring);
+    *ring = (struct mp_mpsc_ring) {
+        .num_slots = num_slots,
+        .slot_size = slot_size,
+        .stride = FFALIGN(sizeof(struct mp_mpsc_slot) + slot_size, 8),
+    };
+    ring->slots = talloc_zero_size(ring, num_slots * (size_t)ring->stride);
+    for (uint32_t n = 0; n < num_slots; n++)
+        mp_mpsc_get_slot(ring, n)->seq = n;
+    return ring;
+}
+
+bool mp_mpsc_ring_write(struct mp_mpsc_ring *ring, const void *src, int len)
+{
+    if (len < 0 || len > ring->slot_size)
+        return false;
+    struct mp_mpsc_slot *slot;
+    uint32_t pos;
+    while (1) {
+        mp_memory_barrier();
+        pos = ring->head.pos;
+        slot = mp_mpsc_get_slot(ring, pos);
+        mp_memory_barrier();
+        int32_t dif = (int32_t)(slot->seq - pos);
+        if (dif == 0) {
+            if (mp_atomic_bool_compare_and_swap(&ring->head.pos, pos, pos + 1))
+                break;
+        } else if (dif < 0) {
+            return false; // consumer has not freed the slot yet: ring full
+        }
+        // Otherwise another producer claimed the slot first; retry.
+    }
+    slot->len = len;
+    memcpy(slot->data, src, len);
+    mp_memory_barrier();
+    slot->seq = pos + 1; // publish
+    return true;
+}
+
+int mp_mpsc_ring_read(struct mp_mpsc_ring *ring, void *dest, int len)
+{
+    uint32_t pos = ring->tail.pos;
+    struct mp_mpsc_slot *slot = mp_mpsc_get_slot(ring, pos);
+    mp_memory_barrier();
+    if ((int32_t)(slot->seq - (pos + 1)) != 0)
+        return -1; // oldest slot not published yet: ring empty
+    int read_len = FFMIN(len, slot->len);
+    memcpy(dest, slot->data, read_len);
+    mp_memory_barrier();
+    slot->seq = pos + ring->num_slots; // free the slot for the next lap
+    ring->tail.pos = pos + 1;
+    return read_len;
+}
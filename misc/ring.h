@@ -20,6 +20,8 @@
 #ifndef MPV_MP_RING_H
 #define MPV_MP_RING_H
 
+#include <stdbool.h>
+
 /**
  * A simple non-blocking SPSC (single producer, single consumer) ringbuffer
  * implementation. Thread safety is accomplished through atomic operations.
@@ -105,4 +107,47 @@ int mp_ring_buffered(struct mp_ring *buffer);
  */
 char *mp_ring_repr(struct mp_ring *buffer, void *talloc_ctx);
 
+/**
+ * A bounded non-blocking MPSC (multiple producers, single consumer) message
+ * ring. Unlike mp_ring, it transfers whole messages instead of a byte
+ * stream: each write claims one fixed-size slot with a CAS on the producer
+ * position, and per-slot sequence numbers make the slot visible to the
+ * consumer only once its payload is completely written. The producer and
+ * consumer positions live on separate cache lines.
+ */
+
+struct mp_mpsc_ring;
+
+/**
+ * Instantiate a new MPSC message ring
+ *
+ * talloc_ctx: talloc context of the newly created object
+ * slots:      number of message slots (rounded up to a power of two)
+ * slot_size:  maximum payload size per message in bytes
+ * return:     the newly created ring
+ */
+struct mp_mpsc_ring *mp_mpsc_ring_new(void *talloc_ctx, int slots,
+                                      int slot_size);
+
+/**
+ * Write one message to the ring (callable from any thread)
+ *
+ * ring:   target ring instance
+ * src:    message payload
+ * len:    payload size, at most the ring's slot_size
+ * return: true if the message was queued, false if the ring is full
+ *         (or len exceeds slot_size)
+ */
+bool mp_mpsc_ring_write(struct mp_mpsc_ring *ring, const void *src, int len);
+
+/**
+ * Read the oldest message from the ring (single consumer thread only)
+ *
+ * ring:   target ring instance
+ * dest:   destination buffer for the message payload
+ * len:    size of dest; longer messages are truncated
+ * return: payload size copied to dest, or -1 if the ring is empty
+ */
+int mp_mpsc_ring_read(struct mp_mpsc_ring *ring, void *dest, int len);
+
 #endif
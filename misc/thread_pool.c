@@ -0,0 +1,126 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "talloc.h"
+#include "common/common.h"
+#include "osdep/numcores.h"
+#include "osdep/threads.h"
+
+#include "thread_pool.h"
+
+struct thread_pool_job {
+    void (*fn)(void *ctx);
+    void *ctx;
+};
+
+struct mp_thread_pool {
+    pthread_t *threads;
+    int num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+
+    // --- the following fields are protected by lock
+    bool terminate;
+    struct thread_pool_job *jobs;
+    int num_jobs;
+};
+
+static void *worker_thread(void *arg)
+{
+    struct mp_thread_pool *pool = arg;
+
+    mpthread_set_role("worker");
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        if (pool->num_jobs) {
+            struct thread_pool_job job = pool->jobs[0];
+            MP_TARRAY_REMOVE_AT(pool->jobs, pool->num_jobs, 0);
+            pthread_mutex_unlock(&pool->lock);
+            job.fn(job.ctx);
+            pthread_mutex_lock(&pool->lock);
+        } else if (pool->terminate) {
+            break;
+        } else {
+            pthread_cond_wait(&pool->wakeup, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void thread_pool_dtor(void *ctx)
+{
+    struct mp_thread_pool *pool = ctx;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->terminate = true;
+    pthread_cond_broadcast(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int n = 0; n < pool->num_threads; n++)
+        pthread_join(pool->threads[n], NULL);
+
+    assert(pool->num_jobs == 0);
+
+    pthread_cond_destroy(&pool->wakeup);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+struct mp_thread_pool *mp_thread_pool_create(void *talloc_ctx, int num_threads)
+{
+    if (num_threads <= 0)
+        num_threads = MPMAX(1, physical_core_count());
+
+    struct mp_thread_pool *pool = talloc_zero(talloc_ctx, struct mp_thread_pool);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wakeup, NULL);
+    pool->threads = talloc_array(pool, pthread_t, num_threads);
+
+    for (int n = 0; n < num_threads; n++) {
+        if (pthread_create(&pool->threads[n], NULL, worker_thread, pool))
+            break;
+        pool->num_threads = n + 1;
+    }
+
+    if (!pool->num_threads) {
+        pthread_cond_destroy(&pool->wakeup);
+        pthread_mutex_destroy(&pool->lock);
+        talloc_free(pool);
+        return NULL;
+    }
+
+    talloc_set_destructor(pool, thread_pool_dtor);
+    return pool;
+}
+
+void mp_thread_pool_queue(struct mp_thread_pool *pool, void (*fn)(void *ctx),
+                          void *ctx)
+{
+    pthread_mutex_lock(&pool->lock);
+    assert(!pool->terminate);
+    struct thread_pool_job job = {fn, ctx};
+    MP_TARRAY_APPEND(pool, pool->jobs, pool->num_jobs, job);
+    pthread_cond_signal(&pool->wakeup);
+    pthread_mutex_unlock(&pool->lock);
+}
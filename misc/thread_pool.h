@@ -0,0 +1,35 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MPV_MP_THREAD_POOL_H
+#define MPV_MP_THREAD_POOL_H
+
+struct mp_thread_pool;
+
+// Create a thread pool with a fixed number of worker threads.
+// num_threads <= 0 means use the number of CPU cores.
+// Freeing the returned object waits until all queued work is done, then
+// terminates the workers.
+struct mp_thread_pool *mp_thread_pool_create(void *talloc_ctx, int num_threads);
+
+// Run fn(ctx) on one of the worker threads, as soon as one is free. Jobs
+// are started in the order they were queued. fn must not queue new jobs
+// while the pool is being destroyed.
+void mp_thread_pool_queue(struct mp_thread_pool *pool, void (*fn)(void *ctx),
+                          void *ctx);
+
+#endif
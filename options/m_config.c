@@ -439,22 +439,76 @@ static void m_config_add_option(struct m_config *config,
     add_negation_option(config, &co, parent_name);
 }
 
-struct m_config_option *m_config_get_co(const struct m_config *config,
-                                        struct bstr name)
+static int opt_index_cmp(const void *pa, const void *pb)
 {
+    const struct m_opt_index_entry *a = pa, *b = pb;
+    int r = strcmp(a->name, b->name);
+    // Duplicate names resolve to the first registered option.
+    return r ? r : (a->opt > b->opt) - (a->opt < b->opt);
+}
 
+// (Re)build the name lookup index for m_config_get_co().
+static void update_opt_index(struct m_config *config)
+{
+    config->opt_index = talloc_realloc(config, config->opt_index,
+                                       struct m_opt_index_entry,
+                                       config->num_opts);
+    config->wildcard_opts = talloc_realloc(config, config->wildcard_opts,
+                                           int, config->num_opts);
+    config->num_opt_index = 0;
+    config->num_wildcard_opts = 0;
     for (int n = 0; n < config->num_opts; n++) {
         struct m_config_option *co = &config->opts[n];
-        struct bstr coname = bstr0(co->name);
         if ((co->opt->type->flags & M_OPT_TYPE_ALLOW_WILDCARD)
-                && bstr_endswith0(coname, "*")) {
-            coname.len--;
-            if (bstrcmp(bstr_splice(name, 0, coname.len), coname) == 0)
-                return co;
-        } else if (bstrcmp(coname, name) == 0)
+                && bstr_endswith0(bstr0(co->name), "*"))
+        {
+            config->wildcard_opts[config->num_wildcard_opts++] = n;
+        } else {
+            config->opt_index[config->num_opt_index++] =
+                (struct m_opt_index_entry){co->name, n};
+        }
+    }
+    qsort(config->opt_index, config->num_opt_index,
+          sizeof(config->opt_index[0]), opt_index_cmp);
+    config->num_indexed_opts = config->num_opts;
+}
+
+struct m_config_option *m_config_get_co(const struct m_config *config,
+                                        struct bstr name)
+{
+    // The index is mutable state, but doesn't change visible behavior.
+    struct m_config *c = (struct m_config *)config;
+
+    if (c->num_indexed_opts != c->num_opts)
+        update_opt_index(c);
+
+    // Like the old linear scan, the first matching option in registration
+    // order wins (a wildcard option can shadow a later exact name).
+    int match = c->num_opts;
+
+    int low = 0, high = c->num_opt_index;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (bstrcmp0(name, c->opt_index[mid].name) > 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < c->num_opt_index && bstrcmp0(name, c->opt_index[low].name) == 0)
+        match = c->opt_index[low].opt;
+
+    for (int i = 0; i < c->num_wildcard_opts && c->wildcard_opts[i] < match;
+         i++)
+    {
+        struct m_config_option *co = &c->opts[c->wildcard_opts[i]];
+        struct bstr coname = bstr0(co->name);
+        coname.len--;
+        if (bstrcmp(bstr_splice(name, 0, coname.len), coname) == 0)
             return co;
     }
-    return NULL;
+
+    return match < c->num_opts ? &c->opts[match] : NULL;
 }
 
 const char *m_config_get_positional_option(const struct m_config *config, int p)
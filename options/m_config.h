@@ -45,6 +45,12 @@ struct m_config_option {
     const void *default_data;       // Raw default value
 };
 
+// Entry of the option name lookup index (see m_config.c).
+struct m_opt_index_entry {
+    const char *name;
+    int opt;            // index into m_config.opts
+};
+
 // Config object
 /** \ingroup Config */
 typedef struct m_config {
@@ -52,6 +58,13 @@ typedef struct m_config {
     struct m_config_option *opts; // all options, even suboptions
     int num_opts;
 
+    // Lookup cache for m_config_get_co(); rebuilt when options were added.
+    struct m_opt_index_entry *opt_index; // non-wildcard opts, sorted by name
+    int num_opt_index;
+    int *wildcard_opts; // indexes of wildcard opts, in registration order
+    int num_wildcard_opts;
+    int num_indexed_opts; // value of num_opts the index was built for
+
     // List of defined profiles.
     struct m_profile *profiles;
     // Depth when recursively including profiles.
@@ -83,6 +83,63 @@ static bool translate_legacy_property(const char *name, char *buffer,
     return true;
 }
 
+static int compare_prop_name(const void *pa, const void *pb)
+{
+    const m_option_t *const *a = pa;
+    const m_option_t *const *b = pb;
+    return strcmp((*a)->name, (*b)->name);
+}
+
+// Like m_option_list_find(), but binary search over a sorted index instead
+// of a linear scan. Property accesses happen at OSD update rate (scripts can
+// query dozens of properties per frame), so the linear scan shows up.
+// The index is built on first use and reused as long as the same list is
+// passed - in practice there is exactly one property list per player.
+// The few wildcard entries ("vf*") can't be binary searched and keep using
+// a linear scan as fallback.
+static const m_option_t *find_property(const m_option_t *prop_list,
+                                       const char *name)
+{
+    static const m_option_t *indexed_list;
+    static const m_option_t **index;
+    static int num_index, num_wildcard;
+    if (prop_list != indexed_list) {
+        talloc_free(index);
+        num_index = num_wildcard = 0;
+        int count = 0;
+        for (int n = 0; prop_list[n].name; n++)
+            count++;
+        index = talloc_array(NULL, const m_option_t *, count);
+        for (int n = 0; n < count; n++) {
+            const m_option_t *prop = &prop_list[n];
+            bool wildcard = (prop->type->flags & M_OPT_TYPE_ALLOW_WILDCARD) &&
+                            bstr_endswith0(bstr0(prop->name), "*");
+            if (wildcard) {
+                // wildcards grow from the end of the array
+                num_wildcard++;
+                index[count - num_wildcard] = prop;
+            } else {
+                index[num_index++] = prop;
+            }
+        }
+        qsort(index, num_index, sizeof(index[0]), compare_prop_name);
+        indexed_list = prop_list;
+    }
+    const m_option_t key = { .name = (char *)name };
+    const m_option_t *keyp = &key;
+    const m_option_t **e = bsearch(&keyp, index, num_index, sizeof(index[0]),
+                                   compare_prop_name);
+    if (e)
+        return *e;
+    for (int n = num_index; n < num_index + num_wildcard; n++) {
+        struct bstr lname = bstr0(index[n]->name);
+        lname.len--;
+        if (bstrcmp(bstr_splice(bstr0(name), 0, lname.len), lname) == 0)
+            return index[n];
+    }
+    return NULL;
+}
+
 static int do_action(const m_option_t *prop_list, const char *name,
                      int action, void *arg, void *ctx)
 {
@@ -94,7 +151,7 @@ static int do_action(const m_option_t *prop_list, const char *name,
         char base[len + 1];
         memcpy(base, name, len);
         base[len] = 0;
-        prop = m_option_list_find(prop_list, base);
+        prop = find_property(prop_list, base);
         ka = (struct m_property_action_arg) {
             .key = sep + 1,
             .action = action,
@@ -103,7 +160,7 @@ static int do_action(const m_option_t *prop_list, const char *name,
         action = M_PROPERTY_KEY_ACTION;
         arg = &ka;
     } else
-        prop = m_option_list_find(prop_list, name);
+        prop = find_property(prop_list, name);
     if (!prop)
         return M_PROPERTY_UNKNOWN;
     int (*control)(const m_option_t*, int, void*, void*) = prop->p;
@@ -197,6 +254,22 @@ int m_property_do(const m_option_t *prop_list, const char *in_name,
     }
 }
 
+int m_property_resolve(const m_option_t *prop_list, const char *name)
+{
+    char translated[64];
+    if (!translate_legacy_property(name, translated, sizeof(translated)))
+        return -1;
+    const m_option_t *prop = find_property(prop_list, translated);
+    return prop ? prop - prop_list : -1;
+}
+
+int m_property_do_by_id(const m_option_t *prop_list, int id, int action,
+                        void *arg, void *ctx)
+{
+    // ids are trusted to come from m_property_resolve() on the same list
+    return m_property_do(prop_list, prop_list[id].name, action, arg, ctx);
+}
+
 static int m_property_do_bstr(const m_option_t *prop_list, bstr name,
                               int action, void *arg, void *ctx)
 {
@@ -207,15 +280,16 @@ static int m_property_do_bstr(const m_option_t *prop_list, bstr name,
     return m_property_do(prop_list, name0, action, arg, ctx);
 }
 
-static void append_str(char **s, int *len, bstr append)
+static void append_str(void *ta_ctx, char **s, int *len, bstr append)
 {
-    MP_TARRAY_GROW(NULL, *s, *len + append.len);
+    MP_TARRAY_GROW(ta_ctx, *s, *len + append.len);
     memcpy(*s + *len, append.start, append.len);
     *len = *len + append.len;
 }
 
-static int expand_property(const m_option_t *prop_list, char **ret, int *ret_len,
-                           bstr prop, bool silent_error, void *ctx)
+static int expand_property(const m_option_t *prop_list, void *ta_ctx,
+                           char **ret, int *ret_len, bstr prop,
+                           bool silent_error, void *ctx)
 {
     bool cond_yes = bstr_eatstart0(&prop, "?");
     bool cond_no = !cond_yes && bstr_eatstart0(&prop, "!");
@@ -239,27 +313,60 @@ static int expand_property(const m_option_t *prop_list, char **ret, int *ret_len
         char *append = s;
         if (!s && !silent_error && !raw)
             append = (r == M_PROPERTY_UNAVAILABLE) ? "(unavailable)" : "(error)";
-        append_str(ret, ret_len, bstr0(append));
+        append_str(ta_ctx, ret, ret_len, bstr0(append));
     }
     talloc_free(s);
     return skip;
 }
 
-char *m_properties_expand_string(const m_option_t *prop_list,
-                                 const char *str0, void *ctx)
+enum expand_op_type {
+    EXPAND_OP_TEXT,     // copy literal text to the output
+    EXPAND_OP_PROP,     // expand a property (may start skipping output)
+    EXPAND_OP_END,      // end of a "${...}" (may stop skipping output)
+};
+
+struct m_expand_op {
+    enum expand_op_type type;
+    bstr text;          // TEXT: literal text, PROP: property name
+    bool have_fallback; // PROP: a fallback string follows
+    int level;          // PROP/END: "${" nesting depth, for skip tracking
+};
+
+struct m_expand_template {
+    char *source;       // copy of the compiled string; ops reference it
+    struct m_expand_op *ops;
+    int num_ops;
+    char *buf;          // output buffer, reused between runs
+    int buf_len;
+};
+
+static void template_add_text(struct m_expand_template *t, bstr text)
 {
-    char *ret = NULL;
-    int ret_len = 0;
-    bool skip = false;
-    int level = 0, skip_level = 0;
-    bstr str = bstr0(str0);
+    if (text.len) {
+        struct m_expand_op op = {EXPAND_OP_TEXT, text};
+        MP_TARRAY_APPEND(t, t->ops, t->num_ops, op);
+    }
+}
+
+struct m_expand_template *m_properties_expand_compile(void *talloc_ctx,
+                                                      const char *str0)
+{
+    struct m_expand_template *t =
+        talloc_zero(talloc_ctx, struct m_expand_template);
+    t->source = talloc_strdup(t, str0);
+    bstr str = bstr0(t->source);
+    int level = 0;
+    bstr lit = {str.start, 0}; // literal run under construction
 
     while (str.len) {
         if (level > 0 && bstr_eatstart0(&str, "}")) {
-            if (skip && level <= skip_level)
-                skip = false;
+            template_add_text(t, lit);
+            struct m_expand_op op = {EXPAND_OP_END, .level = level};
+            MP_TARRAY_APPEND(t, t->ops, t->num_ops, op);
             level--;
+            lit = (bstr){str.start, 0};
         } else if (bstr_startswith0(str, "${") && bstr_find0(str, "}") >= 0) {
+            template_add_text(t, lit);
             str = bstr_cut(str, 2);
             level++;
 
@@ -270,34 +377,78 @@ char *m_properties_expand_string(const m_option_t *prop_list,
             str = bstr_cut(str, term_pos);
             bool have_fallback = bstr_eatstart0(&str, ":");
 
-            if (!skip) {
-                skip = expand_property(prop_list, &ret, &ret_len, name,
-                                       have_fallback, ctx);
-                if (skip)
-                    skip_level = level;
-            }
+            struct m_expand_op op = {EXPAND_OP_PROP, name, have_fallback,
+                                     level};
+            MP_TARRAY_APPEND(t, t->ops, t->num_ops, op);
+            lit = (bstr){str.start, 0};
         } else if (level == 0 && bstr_eatstart0(&str, "$>")) {
-            append_str(&ret, &ret_len, str);
-            break;
+            template_add_text(t, lit);
+            template_add_text(t, str);
+            return t;
+        } else if (bstr_eatstart0(&str, "$$")) {
+            // Escapes are emitted as 1-char slices of the escape sequence
+            template_add_text(t, lit);
+            template_add_text(t, (bstr){str.start - 1, 1}); // the "$"
+            lit = (bstr){str.start, 0};
+        } else if (bstr_eatstart0(&str, "$}")) {
+            template_add_text(t, lit);
+            template_add_text(t, (bstr){str.start - 1, 1}); // the "}"
+            lit = (bstr){str.start, 0};
         } else {
-            char c;
-
             // Other combinations, e.g. "$x", are added verbatim
-            if (bstr_eatstart0(&str, "$$")) {
-                c = '$';
-            } else if (bstr_eatstart0(&str, "$}")) {
-                c = '}';
-            } else {
-                c = str.start[0];
-                str = bstr_cut(str, 1);
-            }
+            str = bstr_cut(str, 1);
+            lit.len++;
+        }
+    }
+    template_add_text(t, lit);
+    return t;
+}
 
+char *m_properties_expand_run(struct m_expand_template *t,
+                              const m_option_t *prop_list, void *ctx)
+{
+    t->buf_len = 0;
+    bool skip = false;
+    int skip_level = 0;
+
+    for (int n = 0; n < t->num_ops; n++) {
+        struct m_expand_op *op = &t->ops[n];
+        switch (op->type) {
+        case EXPAND_OP_TEXT:
             if (!skip)
-                MP_TARRAY_APPEND(NULL, ret, ret_len, c);
+                append_str(t, &t->buf, &t->buf_len, op->text);
+            break;
+        case EXPAND_OP_PROP:
+            if (!skip) {
+                skip = expand_property(prop_list, t, &t->buf, &t->buf_len,
+                                       op->text, op->have_fallback, ctx);
+                if (skip)
+                    skip_level = op->level;
+            }
+            break;
+        case EXPAND_OP_END:
+            if (skip && op->level <= skip_level)
+                skip = false;
+            break;
         }
     }
 
-    MP_TARRAY_APPEND(NULL, ret, ret_len, '\0');
+    MP_TARRAY_GROW(t, t->buf, t->buf_len);
+    t->buf[t->buf_len] = '\0';
+    return t->buf;
+}
+
+const char *m_expand_template_source(struct m_expand_template *t)
+{
+    return t->source;
+}
+
+char *m_properties_expand_string(const m_option_t *prop_list,
+                                 const char *str0, void *ctx)
+{
+    struct m_expand_template *t = m_properties_expand_compile(NULL, str0);
+    char *ret = talloc_strdup(NULL, m_properties_expand_run(t, prop_list, ctx));
+    talloc_free(t);
     return ret;
 }
 
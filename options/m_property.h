@@ -109,6 +109,16 @@ enum mp_property_return {
 int m_property_do(const struct m_option* prop_list, const char* property_name,
                   int action, void* arg, void *ctx);
 
+// Resolve a property name (without sub-paths) to an integer id, which is
+// stable for the lifetime of prop_list. Clients doing repeated accesses can
+// resolve the name once and use m_property_do_by_id() afterwards.
+// returns: the id, or -1 if the property doesn't exist
+int m_property_resolve(const struct m_option* prop_list, const char* name);
+
+// Access a property by an id from m_property_resolve() on the same list.
+int m_property_do_by_id(const struct m_option* prop_list, int id, int action,
+                        void* arg, void *ctx);
+
 // Print a list of properties.
 void m_properties_print_help_list(const struct m_option* list);
 
@@ -127,6 +137,25 @@ void m_properties_print_help_list(const struct m_option* list);
 char* m_properties_expand_string(const struct m_option* prop_list,
                                  const char *str, void *ctx);
 
+// Pre-parsed form of an expansion string for m_properties_expand_string().
+// Strings that are expanded repeatedly (status line, OSD message templates)
+// can be compiled once; rendering then skips the ${} parsing and reuses an
+// internal output buffer, so it causes no steady-state allocations.
+struct m_expand_template;
+
+// Compile str for later use with m_properties_expand_run(). The result is
+// allocated under talloc_ctx and freed with talloc_free().
+struct m_expand_template *m_properties_expand_compile(void *talloc_ctx,
+                                                      const char *str);
+
+// Render the template. The returned string is owned by the template and
+// valid until the next call or until the template is freed.
+char *m_properties_expand_run(struct m_expand_template *t,
+                              const struct m_option *prop_list, void *ctx);
+
+// Return the (unexpanded) string the template was compiled from.
+const char *m_expand_template_source(struct m_expand_template *t);
+
 // Trivial helpers for implementing properties.
 int m_property_int_ro(const struct m_option* prop, int action, void* arg,
                       int var);
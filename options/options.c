@@ -41,6 +41,7 @@
 #include "audio/decode/dec_audio.h"
 #include "player/core.h"
 #include "osdep/priority.h"
+#include "osdep/threads.h"
 
 int   network_bandwidth=0;
 int   network_cookies_enabled = 0;
@@ -119,6 +120,7 @@ static const m_option_t tvopts_conf[]={
     {"forcechan", &stream_tv_defaults.forcechan, CONF_TYPE_INT, CONF_RANGE, 1, 2, NULL},
     {"forceaudio", &stream_tv_defaults.force_audio, CONF_TYPE_FLAG, 0, 0, 1, NULL},
     {"buffersize", &stream_tv_defaults.buffer_size, CONF_TYPE_INT, CONF_RANGE, 16, 1024, NULL},
+    {"hwbuffers", &stream_tv_defaults.hw_buffers, CONF_TYPE_INT, CONF_RANGE, 2, 32, NULL},
     {"mjpeg", &stream_tv_defaults.mjpeg, CONF_TYPE_FLAG, 0, 0, 1, NULL},
     {"decimation", &stream_tv_defaults.decimation, CONF_TYPE_INT, CONF_RANGE, 1, 4, NULL},
     {"quality", &stream_tv_defaults.quality, CONF_TYPE_INT, CONF_RANGE, 0, 100, NULL},
@@ -330,6 +332,7 @@ const m_option_t mp_opts[] = {
 
     // handled in mplayer.c (looks at the raw argv[])
     {"leak-report", NULL, CONF_TYPE_STORE, CONF_GLOBAL | CONF_NOCFG },
+    {"alloc-stats", NULL, CONF_TYPE_STORE, CONF_GLOBAL | CONF_NOCFG },
 
     OPT_FLAG("shuffle", shuffle, CONF_GLOBAL | CONF_NOCFG),
 
@@ -342,6 +345,7 @@ const m_option_t mp_opts[] = {
 #if HAVE_PRIORITY
     {"priority", &proc_priority, CONF_TYPE_STRING, 0, 0, 0, NULL},
 #endif
+    {"thread-affinity", &mpthread_affinity, CONF_TYPE_STRING, CONF_GLOBAL, 0, 0, NULL},
     OPT_FLAG("config", load_config, CONF_GLOBAL | CONF_NOCFG | CONF_PRE_PARSE),
     OPT_STRINGLIST("reset-on-next-file", reset_options, CONF_GLOBAL),
 
@@ -359,6 +363,9 @@ const m_option_t mp_opts[] = {
     OPT_CHOICE_OR_INT("cache-default", stream_cache_def_size, 0, 32, 0x7fffffff,
                       ({"no", 0}),
                       OPTDEF_INT(320)),
+    OPT_CHOICE_OR_INT("cache-disk", stream_cache_disk_size, 0, 1024, 0x7fffffff,
+                      ({"no", 0})),
+    OPT_FLAG("cache-burst", stream_cache_burst, 0),
     OPT_FLOATRANGE("cache-min", stream_cache_min_percent, 0, 0, 99),
     OPT_FLOATRANGE("cache-seek-min", stream_cache_seek_min_percent, 0, 0, 99),
     OPT_CHOICE_OR_INT("cache-pause", stream_cache_pause, 0,
@@ -432,6 +439,9 @@ const m_option_t mp_opts[] = {
     OPT_STRING("audiofile", audio_stream, 0),
     OPT_INTRANGE("audiofile-cache", audio_stream_cache, 0, 50, 65536),
     OPT_STRING("demuxer", demuxer_name, 0),
+    OPT_CHOICE("demuxer-queue-compression", demuxer_queue_compression, 0,
+               ({"no", 0}, {"audio", 1}, {"all", 2})),
+    OPT_INTRANGE("memory-limit", memory_limit, 0, 0, 1 << 30),
     OPT_STRING("audio-demuxer", audio_demuxer_name, 0),
     OPT_STRING("sub-demuxer", sub_demuxer_name, 0),
 
@@ -470,6 +480,7 @@ const m_option_t mp_opts[] = {
     OPT_SETTINGSLIST("af*", af_settings, 0, &af_obj_list),
     OPT_SETTINGSLIST("vf-defaults", vf_defs, 0, &vf_obj_list),
     OPT_SETTINGSLIST("vf*", vf_settings, 0, &vf_obj_list),
+    OPT_FLAG("vf-pipeline", vf_pipeline, 0),
 
     OPT_CHOICE("deinterlace", deinterlace, M_OPT_OPTIONAL_PARAM,
                ({"auto", -1},
@@ -511,6 +522,7 @@ const m_option_t mp_opts[] = {
 
     OPT_FLAG("demuxer-mkv-subtitle-preroll", mkv_subtitle_preroll, 0),
     OPT_FLAG("mkv-subtitle-preroll", mkv_subtitle_preroll, 0), // old alias
+    OPT_FLAG("demuxer-mkv-index-cache", mkv_index_cache, 0),
 
 // ------------------------- subtitles options --------------------
 
@@ -577,7 +589,10 @@ const m_option_t mp_opts[] = {
                 {"no", 0},
                 {"yes", 1}, {"", 1})),
     OPT_STRING("volume-restore-data", mixer_restore_volume_data, 0),
-    OPT_FLAG("gapless-audio", gapless_audio, 0),
+    OPT_CHOICE("gapless-audio", gapless_audio, 0,
+               ({"no", 0},
+                {"yes", 1},
+                {"weak", -1})),
 
     // set screen dimensions (when not detectable or virtual!=visible)
     OPT_INTRANGE("screenw", vo.screenwidth, CONF_GLOBAL, 0, 4096),
@@ -657,6 +672,7 @@ const m_option_t mp_opts[] = {
                ({"0", 0}, {"1", 1}, {"2", 2}, {"3", 3})),
     OPT_INTRANGE("osd-duration", osd_duration, 0, 0, 3600000),
     OPT_FLAG("osd-fractions", osd_fractions, 0),
+    OPT_FLOATRANGE("osd-refresh-rate", osd_refresh_rate, 0, 0, 1000),
     OPT_FLOATRANGE("osd-scale", osd_scale, 0, 0, 100),
     OPT_FLAG("osd-scale-by-window", osd_scale_by_window, 0),
 
@@ -668,6 +684,7 @@ const m_option_t mp_opts[] = {
                 {"hard", 2})),
 
     OPT_FLAG("untimed", untimed, 0),
+    OPT_FLAG("low-latency", low_latency, 0),
 
     OPT_STRING("stream-capture", stream_capture, 0),
     OPT_STRING("stream-dump", stream_dump, 0),
@@ -691,6 +708,7 @@ const m_option_t mp_opts[] = {
 
     OPT_FLAG("load-unsafe-playlists", load_unsafe_playlists, 0),
     OPT_FLAG("merge-files", merge_files, 0),
+    OPT_FLAG("prefetch-playlist", prefetch_open, M_OPT_GLOBAL),
 
     // a-v sync stuff:
     OPT_FLAG("correct-pts", correct_pts, 0),
@@ -830,6 +848,7 @@ const struct MPOpts mp_default_opts = {
     .sub_speed = 1.0,
     .audio_output_channels = MP_CHMAP_INIT_STEREO,
     .audio_output_format = 0,  // AF_FORMAT_UNKNOWN
+    .gapless_audio = -1,
     .playback_speed = 1.,
     .movie_aspect = -1.,
     .field_dominance = -1,
@@ -85,7 +85,9 @@ typedef struct MPOpts {
     int osd_level;
     int osd_duration;
     int osd_fractions;
+    float osd_refresh_rate;
     int untimed;
+    int low_latency;
     char *stream_capture;
     char *stream_dump;
     int loop_times;
@@ -96,11 +98,14 @@ typedef struct MPOpts {
     double chapter_seek_threshold;
     int load_unsafe_playlists;
     int merge_files;
+    int prefetch_open;
     int quiet;
     int load_config;
     int use_filedir_conf;
     int stream_cache_size;
     int stream_cache_def_size;
+    int stream_cache_disk_size;
+    int stream_cache_burst;
     float stream_cache_min_percent;
     float stream_cache_seek_min_percent;
     int network_rtsp_transport;
@@ -159,10 +164,13 @@ typedef struct MPOpts {
 
     char *audio_stream;
     int audio_stream_cache;
+    int memory_limit;
+    int demuxer_queue_compression;
     char *demuxer_name;
     char *audio_demuxer_name;
     char *sub_demuxer_name;
     int mkv_subtitle_preroll;
+    int mkv_index_cache;
 
     struct image_writer_opts *screenshot_image_opts;
     char *screenshot_template;
@@ -176,6 +184,7 @@ typedef struct MPOpts {
     int dtshd;
     double playback_speed;
     struct m_obj_settings *vf_settings, *vf_defs;
+    int vf_pipeline;
     struct m_obj_settings *af_settings, *af_defs;
     int deinterlace;
     float movie_aspect;
@@ -240,6 +249,8 @@ typedef struct MPOpts {
         char *cryptokey;
         char *avopt;
         int genptsmode;
+        int index_cache;
+        int fast_start;
     } lavfdopts;
 
     struct input_conf {
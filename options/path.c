@@ -236,3 +236,112 @@ void mp_mk_config_dir(char *subdir)
     }
     talloc_free(tmp);
 }
+
+#define MP_CACHE_DIR "cache"
+
+static char *cached_choice_path(void *tmp, const char *name)
+{
+    char *fname = talloc_asprintf(tmp, MP_CACHE_DIR "/%s", name);
+    return talloc_steal(tmp, mp_find_user_config_file(fname));
+}
+
+char *mp_read_cached_choice(void *talloc_ctx, const char *name)
+{
+    void *tmp = talloc_new(NULL);
+    char *res = NULL;
+    char *path = cached_choice_path(tmp, name);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    if (f) {
+        char buf[80];
+        if (fgets(buf, sizeof(buf), f)) {
+            buf[strcspn(buf, "\n")] = '\0';
+            if (buf[0])
+                res = talloc_strdup(talloc_ctx, buf);
+        }
+        fclose(f);
+    }
+    talloc_free(tmp);
+    return res;
+}
+
+void mp_write_cached_choice(const char *name, const char *value)
+{
+    void *tmp = talloc_new(NULL);
+    mp_mk_config_dir(MP_CACHE_DIR);
+    char *path = cached_choice_path(tmp, name);
+    if (path) {
+        if (value) {
+            FILE *f = fopen(path, "w");
+            if (f) {
+                fprintf(f, "%s\n", value);
+                fclose(f);
+            }
+        } else {
+            unlink(path);
+        }
+    }
+    talloc_free(tmp);
+}
+
+#define MP_CACHE_TABLE_MAX 100
+
+char *mp_read_cached_table(void *talloc_ctx, const char *name, const char *key)
+{
+    void *tmp = talloc_new(NULL);
+    char *res = NULL;
+    char *path = cached_choice_path(tmp, name);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    if (f) {
+        char buf[4096];
+        size_t key_len = strlen(key);
+        while (fgets(buf, sizeof(buf), f)) {
+            buf[strcspn(buf, "\n")] = '\0';
+            if (strncmp(buf, key, key_len) == 0 && buf[key_len] == '\t') {
+                res = talloc_strdup(talloc_ctx, buf + key_len + 1);
+                break;
+            }
+        }
+        fclose(f);
+    }
+    talloc_free(tmp);
+    return res;
+}
+
+void mp_write_cached_table(const char *name, const char *key, const char *value)
+{
+    if (strpbrk(key, "\t\n") || (value && strpbrk(value, "\t\n")))
+        return;
+    void *tmp = talloc_new(NULL);
+    mp_mk_config_dir(MP_CACHE_DIR);
+    char *path = cached_choice_path(tmp, name);
+    if (!path)
+        goto done;
+    // Keep the old entries, with the updated key and everything beyond the
+    // size limit dropped; the new entry goes to the front.
+    char **lines = NULL;
+    int num_lines = 0;
+    size_t key_len = strlen(key);
+    FILE *f = fopen(path, "r");
+    if (f) {
+        char buf[4096];
+        while (fgets(buf, sizeof(buf), f)) {
+            buf[strcspn(buf, "\n")] = '\0';
+            if (strncmp(buf, key, key_len) == 0 && buf[key_len] == '\t')
+                continue;
+            if (num_lines >= MP_CACHE_TABLE_MAX - 1)
+                break;
+            MP_TARRAY_APPEND(tmp, lines, num_lines, talloc_strdup(tmp, buf));
+        }
+        fclose(f);
+    }
+    f = fopen(path, "w");
+    if (f) {
+        if (value)
+            fprintf(f, "%s\t%s\n", key, value);
+        for (int n = 0; n < num_lines; n++)
+            fprintf(f, "%s\n", lines[n]);
+        fclose(f);
+    }
+done:
+    talloc_free(tmp);
+}
@@ -72,4 +72,25 @@ bool mp_is_url(bstr path);
 
 void mp_mk_config_dir(char *subdir);
 
+/* Small persistent state stored in the user's cache directory, e.g. the last
+ * VO/AO driver that probed successfully. Returns the stored value (allocated
+ * under talloc_ctx), or NULL if there is none.
+ */
+char *mp_read_cached_choice(void *talloc_ctx, const char *name);
+
+// Store value for mp_read_cached_choice(). value==NULL removes the entry.
+void mp_write_cached_choice(const char *name, const char *value);
+
+/* Like mp_read_cached_choice(), but the file is a table with one entry per
+ * key. Returns the value stored for the key, or NULL. Keys and values must
+ * not contain tabs or line breaks.
+ */
+char *mp_read_cached_table(void *talloc_ctx, const char *name, const char *key);
+
+/* Store an entry for mp_read_cached_table(). The oldest entries are dropped
+ * when the table grows too large.
+ */
+void mp_write_cached_table(const char *name, const char *key,
+                           const char *value);
+
 #endif /* MPLAYER_PATH_H */
@@ -19,12 +19,22 @@
  */
 
 #include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "talloc.h"
 
 #include "config.h"
+#include "common/msg.h"
+#include "misc/thread_pool.h"
 #include "osdep/io.h"
 
+#ifdef __MINGW32__
+#include <io.h>
+#define fsync(fd) _commit(fd)
+#endif
+
 // Set the CLOEXEC flag on the given fd.
 // On error, false is returned (and errno set).
 bool mp_set_cloexec(int fd)
@@ -41,6 +51,91 @@ bool mp_set_cloexec(int fd)
     return true;
 }
 
+struct async_write_job {
+    char *filename;
+    size_t size;
+    bool do_fsync;
+    bool append;
+    // data follows the struct
+};
+
+static pthread_mutex_t async_write_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct mp_thread_pool *async_write_pool;
+
+static void run_async_write(void *arg)
+{
+    struct async_write_job *job = arg;
+    char *data = (char *)(job + 1);
+
+    int fd = open(job->filename,
+                  O_WRONLY | O_CREAT | O_BINARY | O_CLOEXEC |
+                  (job->append ? O_APPEND : O_TRUNC), 0666);
+    bool ok = fd >= 0;
+    size_t pos = 0;
+    while (ok && pos < job->size) {
+        ssize_t r = write(fd, data + pos, job->size - pos);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            ok = false;
+        } else {
+            pos += r;
+        }
+    }
+    if (fd >= 0) {
+        if (ok && job->do_fsync)
+            ok = fsync(fd) == 0;
+        ok = (close(fd) == 0) && ok;
+    }
+    if (!ok) {
+        mp_msg(MSGT_CPLAYER, MSGL_ERR, "Error writing file '%s'!\n",
+               job->filename);
+    }
+    talloc_free(job);
+}
+
+static void queue_async_write(const char *filename, const void *data,
+                              size_t size, bool do_fsync, bool append)
+{
+    struct async_write_job *job = talloc_size(NULL, sizeof(*job) + size);
+    *job = (struct async_write_job) {
+        .filename = talloc_strdup(job, filename),
+        .size = size,
+        .do_fsync = do_fsync,
+        .append = append,
+    };
+    memcpy(job + 1, data, size);
+
+    pthread_mutex_lock(&async_write_lock);
+    // A single worker keeps writes in queue order, so a newer version of a
+    // file can't be overwritten by a stale one.
+    if (!async_write_pool)
+        async_write_pool = mp_thread_pool_create(NULL, 1);
+    mp_thread_pool_queue(async_write_pool, run_async_write, job);
+    pthread_mutex_unlock(&async_write_lock);
+}
+
+void mp_write_file_async(const char *filename, const void *data, size_t size,
+                         bool do_fsync)
+{
+    queue_async_write(filename, data, size, do_fsync, false);
+}
+
+void mp_append_file_async(const char *filename, const void *data, size_t size)
+{
+    queue_async_write(filename, data, size, false, true);
+}
+
+void mp_flush_async_writes(void)
+{
+    pthread_mutex_lock(&async_write_lock);
+    struct mp_thread_pool *pool = async_write_pool;
+    async_write_pool = NULL;
+    pthread_mutex_unlock(&async_write_lock);
+    // Freeing the pool waits until all queued jobs are done.
+    talloc_free(pool);
+}
+
 #ifdef _WIN32
 
 #include <windows.h>
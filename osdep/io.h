@@ -37,6 +37,19 @@
 
 bool mp_set_cloexec(int fd);
 
+// Queue data to be written to the given file on a shared worker thread, so
+// that slow filesystems (e.g. NFS) don't block the caller. The data is
+// copied. If do_fsync is set, the file is fsync'd before it is closed.
+// Errors are reported to the terminal only.
+void mp_write_file_async(const char *filename, const void *data, size_t size,
+                         bool do_fsync);
+// Like mp_write_file_async(), but append to the file instead of replacing it.
+void mp_append_file_async(const char *filename, const void *data, size_t size);
+// Block until all writes queued so far have completed, and terminate the
+// worker thread. Must be called before process exit; calling
+// mp_write_file_async() afterwards restarts the worker.
+void mp_flush_async_writes(void);
+
 #ifdef _WIN32
 #include <wchar.h>
 wchar_t *mp_from_utf8(void *talloc_ctx, const char *s);
@@ -64,3 +64,38 @@ int default_thread_count(void)
 }
 
 #endif
+
+#if defined(__linux__)
+
+// Each entry lists all SMT siblings sharing a physical core; a CPU is
+// counted only if it's the first (lowest numbered) sibling, so that
+// Hyper-Threading doesn't inflate the result.
+int physical_core_count(void)
+{
+    int count = 0;
+    for (int cpu = 0; ; cpu++) {
+        char path[128];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+                 cpu);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            break;
+        int first = -1;
+        if (fscanf(f, "%d", &first) == 1 && first == cpu)
+            count++;
+        fclose(f);
+    }
+    if (count < 1)
+        return default_thread_count();
+    return count;
+}
+
+#else
+
+int physical_core_count(void)
+{
+    return default_thread_count();
+}
+
+#endif
@@ -1 +1,4 @@
 int default_thread_count(void);
+// Number of physical cores, not counting SMT/Hyper-Threading siblings.
+// Falls back to default_thread_count() if the topology is unknown.
+int physical_core_count(void);
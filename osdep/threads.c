@@ -17,10 +17,62 @@
 
 #include <time.h>
 #include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
 #include <sys/time.h>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "common/common.h"
 #include "threads.h"
 
+char *mpthread_affinity;
+
+// Find the entry for the given role in the option string, which has the form
+// "role:cpulist,role:cpulist,..." (e.g. "decode:4-7,audio:0"). A cpulist is
+// a comma-free subset like "2" or "4-7". Returns false if the role is absent.
+static bool get_role_spec(const char *role, char *out, size_t out_size)
+{
+    char *spec = mpthread_affinity;
+    size_t role_len = strlen(role);
+    while (spec && spec[0]) {
+        char *end = strchr(spec, ',');
+        size_t len = end ? (size_t)(end - spec) : strlen(spec);
+        if (len > role_len + 1 && strncmp(spec, role, role_len) == 0 &&
+            spec[role_len] == ':')
+        {
+            size_t cpus_len = len - role_len - 1;
+            if (cpus_len >= out_size)
+                cpus_len = out_size - 1;
+            memcpy(out, spec + role_len + 1, cpus_len);
+            out[cpus_len] = '\0';
+            return true;
+        }
+        spec = end ? end + 1 : NULL;
+    }
+    return false;
+}
+
+void mpthread_set_role(const char *role)
+{
+#if defined(__linux__)
+    char cpus[32];
+    if (!get_role_spec(role, cpus, sizeof(cpus)))
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    char *p = cpus;
+    int first = strtol(p, &p, 10);
+    int last = p[0] == '-' ? strtol(p + 1, &p, 10) : first;
+    for (int n = first; n <= last && n < CPU_SETSIZE; n++)
+        CPU_SET(n, &set);
+    if (first <= last)
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
 static void get_pthread_time(struct timespec *out_ts)
 {
 #if defined(_POSIX_TIMERS) && _POSIX_TIMERS > 0
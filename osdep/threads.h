@@ -6,4 +6,11 @@
 int mpthread_cond_timed_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
                              double timeout);
 
+// CPU affinity specification for --thread-affinity (set by option code).
+extern char *mpthread_affinity;
+
+// Apply the user's affinity/priority configuration for the named thread role
+// ("decode", "vo", "audio", "io", "worker") to the calling thread.
+void mpthread_set_role(const char *role);
+
 #endif
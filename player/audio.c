@@ -124,6 +124,15 @@ void reinit_audio_chain(struct MPContext *mpctx)
     struct mp_audio in_format;
     mp_audio_buffer_get_format(mpctx->d_audio->decode_buffer, &in_format);
 
+    // Weak gapless: keep the AO only if the new audio matches what it was
+    // opened for; otherwise drain and reopen it with the correct format,
+    // instead of converting everything to the old configuration.
+    if ((mpctx->initialized_flags & INITIALIZED_AO) &&
+        opts->gapless_audio < 0 &&
+        (!mpctx->ao_decoder_fmt ||
+         !mp_audio_config_equals(mpctx->ao_decoder_fmt, &in_format)))
+        uninit_player(mpctx, INITIALIZED_AO);
+
     int ao_srate = opts->force_srate;
     int ao_format = opts->audio_output_format;
     struct mp_chmap ao_channels = {0};
@@ -168,6 +177,14 @@ void reinit_audio_chain(struct MPContext *mpctx)
         ao->buffer = mp_audio_buffer_create(ao);
         mp_audio_buffer_reinit_fmt(ao->buffer, ao->format, &ao->channels,
                                    ao->samplerate);
+        // The playloop fills at most the free space of the device buffer per
+        // iteration; preallocating a second covers that for all AOs, so the
+        // buffer never has to grow (and copy) on the audio path.
+        mp_audio_buffer_preallocate_min(ao->buffer, ao->samplerate);
+
+        if (!mpctx->ao_decoder_fmt)
+            mpctx->ao_decoder_fmt = talloc(mpctx, struct mp_audio);
+        *mpctx->ao_decoder_fmt = in_format;
 
         char *s = mp_audio_fmt_to_str(ao->samplerate, &ao->channels, ao->format);
         MP_INFO(mpctx, "AO: [%s] %s\n", ao->driver->name, s);
@@ -74,9 +74,21 @@
 #include "core.h"
 #include "lua.h"
 
+// A property a script asked to be notified about (see mp_observe_property()).
+struct property_observer {
+    char *name;
+    double interval;    // minimum time between checks (seconds)
+    double next_check;  // mp_time_sec() after which to check again
+    char *last_value;   // NULL if the last query failed
+    int refcount;       // number of mp_observe_property() calls for name
+};
+
 struct command_ctx {
     int events;
 
+    struct property_observer **observers;
+    int num_observers;
+
     double last_seek_time;
     double last_seek_pts;
 
@@ -278,6 +290,13 @@ static int mp_property_stream_length(m_option_t *prop, int action,
                                stream->end_pos - stream->start_pos);
 }
 
+/// Bytes of talloc-managed memory reachable from the player core (RO)
+static int mp_property_memory_usage(m_option_t *prop, int action, void *arg,
+                                    MPContext *mpctx)
+{
+    return m_property_int64_ro(prop, action, arg, talloc_total_size(mpctx));
+}
+
 // Does some magic to handle "<name>/full" as time formatted with milliseconds.
 // Assumes prop is the type of the actual property.
 static int property_time(m_option_t *prop, int action, void *arg, double time)
@@ -345,6 +364,17 @@ static int mp_property_avsync(m_option_t *prop, int action, void *arg,
     return m_property_double_ro(prop, action, arg, mpctx->last_av_difference);
 }
 
+// Sum of audio time stretching done to keep A/V sync (drift monitoring).
+static int mp_property_total_avsync_change(m_option_t *prop, int action,
+                                           void *arg, MPContext *mpctx)
+{
+    if (!mpctx->d_audio || !mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+    if (mpctx->last_av_difference == MP_NOPTS_VALUE)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_double_ro(prop, action, arg, mpctx->total_avsync_change);
+}
+
 /// Current position in percent (RW)
 static int mp_property_percent_pos(m_option_t *prop, int action,
                                    void *arg, MPContext *mpctx)
@@ -784,6 +814,18 @@ static int mp_property_cache(m_option_t *prop, int action, void *arg,
     return m_property_int_ro(prop, action, arg, cache);
 }
 
+static int mp_property_cache_sleeping(m_option_t *prop, int action, void *arg,
+                                      void *ctx)
+{
+    MPContext *mpctx = ctx;
+    int sleeping = 0;
+    if (!mpctx->stream ||
+        stream_control(mpctx->stream, STREAM_CTRL_GET_CACHE_SLEEPING,
+                       &sleeping) != STREAM_OK)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_int_ro(prop, action, arg, sleeping);
+}
+
 static int mp_property_clock(m_option_t *prop, int action, void *arg,
                              MPContext *mpctx)
 {
@@ -1191,14 +1233,27 @@ static const char *deint_filters[] = {
     NULL
 };
 
+static int probe_deint_filter(struct MPContext *mpctx, const char *cmd,
+                              const char *filt)
+{
+    char filter[80];
+    // add a label so that removing the filter is easier
+    snprintf(filter, sizeof(filter), "@%s:%s", VF_DEINTERLACE_LABEL, filt);
+    return edit_filters(mpctx, STREAM_VIDEO, cmd, filter);
+}
+
 static int probe_deint_filters(struct MPContext *mpctx, const char *cmd)
 {
+#if HAVE_VAAPI_VPP
+    // Hardware decoded surfaces must stay in GPU memory; vf_vavpp deinterlaces
+    // them there, while the software filters would force a download of every
+    // frame to system memory first.
+    if (mpctx->d_video->decoder_output.imgfmt == IMGFMT_VAAPI
+        && probe_deint_filter(mpctx, cmd, "vavpp") >= 0)
+        return 0;
+#endif
     for (int n = 0; deint_filters[n]; n++) {
-        char filter[80];
-        // add a label so that removing the filter is easier
-        snprintf(filter, sizeof(filter), "@%s:%s", VF_DEINTERLACE_LABEL,
-                 deint_filters[n]);
-        if (edit_filters(mpctx, STREAM_VIDEO, cmd, filter) >= 0)
+        if (probe_deint_filter(mpctx, cmd, deint_filters[n]) >= 0)
             return 0;
     }
     return -1;
@@ -1547,6 +1602,118 @@ static int mp_property_window_scale(m_option_t *prop, int action, void *arg,
     return M_PROPERTY_NOT_IMPLEMENTED;
 }
 
+/// Number of frames the VO has queued ahead of display (RO)
+static int mp_property_vo_queued_frames(m_option_t *prop, int action,
+                                        void *arg, MPContext *mpctx)
+{
+    struct vo *vo = mpctx->video_out;
+    int depth[2];
+    if (!vo || !vo->config_ok ||
+        vo_control(vo, VOCTRL_GET_PRES_QUEUE_DEPTH, depth) != VO_TRUE)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_int_ro(prop, action, arg, depth[0]);
+}
+
+/// Number of frames buffered inside the video decoder (RO)
+static int mp_property_decoder_delay(m_option_t *prop, int action, void *arg,
+                                     MPContext *mpctx)
+{
+    if (!mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_int_ro(prop, action, arg,
+                             video_get_decoder_delay(mpctx->d_video));
+}
+
+/// Average GPU time of the VO's render passes (RO)
+static int mp_property_gpu_pass_times(m_option_t *prop, int action, void *arg,
+                                      MPContext *mpctx)
+{
+    struct vo *vo = mpctx->video_out;
+    double times[3];
+    if (!vo || !vo->config_ok ||
+        vo_control(vo, VOCTRL_GET_GPU_PASS_TIMES, times) != VO_TRUE)
+        return M_PROPERTY_UNAVAILABLE;
+    char *res = talloc_asprintf(NULL, "upload: %.2f ms, render: %.2f ms, "
+                                "osd: %.2f ms", times[0], times[1], times[2]);
+    int r = m_property_strdup_ro(prop, action, arg, res);
+    talloc_free(res);
+    return r;
+}
+
+/// Number of video frames shown since playback start (RO)
+static int mp_property_vo_frame_count(m_option_t *prop, int action, void *arg,
+                                      MPContext *mpctx)
+{
+    if (!mpctx->d_video)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_int64_ro(prop, action, arg, mpctx->shown_vframes);
+}
+
+/// Average/maximum duration of each video pipeline stage (RO)
+static int mp_property_pipeline_stats(m_option_t *prop, int action, void *arg,
+                                      MPContext *mpctx)
+{
+    if (!mpctx->num_frame_stats)
+        return M_PROPERTY_UNAVAILABLE;
+    int64_t sum[FSTAT_COUNT] = {0};
+    int64_t max[FSTAT_COUNT] = {0};
+    int count[FSTAT_COUNT] = {0};
+    for (int n = 0; n < mpctx->num_frame_stats; n++) {
+        struct frame_stat *st = &mpctx->frame_stats[n];
+        sum[st->stage] += st->duration_us;
+        max[st->stage] = MPMAX(max[st->stage], st->duration_us);
+        count[st->stage] += 1;
+    }
+    char *res = talloc_strdup(NULL, "");
+    for (int i = 0; i < FSTAT_COUNT; i++) {
+        if (!count[i])
+            continue;
+        res = talloc_asprintf_append(res, "%s%s: %.1f/%.1f ms",
+                                     res[0] ? ", " : "",
+                                     mp_frame_stat_stage_name(i),
+                                     sum[i] / (count[i] * 1000.0),
+                                     max[i] / 1000.0);
+    }
+    int r = m_property_strdup_ro(prop, action, arg, res);
+    talloc_free(res);
+    return r;
+}
+
+/// Windowed frame timing / buffering distributions (RO)
+static int mp_property_perf_stats(m_option_t *prop, int action, void *arg,
+                                  MPContext *mpctx)
+{
+    if (action != M_PROPERTY_KEY_ACTION)
+        return M_PROPERTY_NOT_IMPLEMENTED;
+
+    struct m_property_action_arg *ka = arg;
+
+    double window;
+    if (strcmp(ka->key, "1s") == 0) {
+        window = 1;
+    } else if (strcmp(ka->key, "10s") == 0) {
+        window = 10;
+    } else if (strcmp(ka->key, "60s") == 0) {
+        window = 60;
+    } else {
+        return M_PROPERTY_UNKNOWN;
+    }
+
+    switch (ka->action) {
+    case M_PROPERTY_GET:
+    case M_PROPERTY_PRINT:
+        if (!mpctx->num_frame_stats && !mpctx->num_load_stats)
+            return M_PROPERTY_UNAVAILABLE;
+        *(char **)ka->arg = mp_perf_stats_format(NULL, mpctx, window);
+        return M_PROPERTY_OK;
+    case M_PROPERTY_GET_TYPE:
+        *(struct m_option *)ka->arg = *prop;
+        return M_PROPERTY_OK;
+    }
+
+    return M_PROPERTY_NOT_IMPLEMENTED;
+}
+
 static int mp_property_osd_w(m_option_t *prop, int action, void *arg,
                              MPContext *mpctx)
 {
@@ -1890,9 +2057,13 @@ static const m_option_t mp_properties[] = {
       M_OPT_MIN, 0, 0, NULL },
     { "stream-time-pos", mp_property_stream_time_pos, CONF_TYPE_TIME,
       M_OPT_MIN, 0, 0, NULL },
+    { "memory-usage", mp_property_memory_usage, CONF_TYPE_INT64,
+      M_OPT_MIN, 0, 0, NULL },
     { "length", mp_property_length, CONF_TYPE_TIME,
       M_OPT_MIN, 0, 0, NULL },
     { "avsync", mp_property_avsync, CONF_TYPE_DOUBLE },
+    { "total-avsync-change", mp_property_total_avsync_change,
+      CONF_TYPE_DOUBLE },
     { "percent-pos", mp_property_percent_pos, CONF_TYPE_DOUBLE,
       M_OPT_RANGE, 0, 100, NULL },
     { "time-pos", mp_property_time_pos, CONF_TYPE_TIME,
@@ -1913,6 +2084,7 @@ static const m_option_t mp_properties[] = {
     { "chapter-metadata", mp_property_chapter_metadata, CONF_TYPE_STRING_LIST },
     M_OPTION_PROPERTY_CUSTOM("pause", mp_property_pause),
     { "cache", mp_property_cache, CONF_TYPE_INT },
+    { "cache-sleeping", mp_property_cache_sleeping, CONF_TYPE_FLAG },
     M_OPTION_PROPERTY("pts-association-mode"),
     M_OPTION_PROPERTY("hr-seek"),
     { "clock", mp_property_clock, CONF_TYPE_STRING,
@@ -1984,6 +2156,12 @@ static const m_option_t mp_properties[] = {
     { "dheight", mp_property_dheight, CONF_TYPE_INT },
     { "window-scale", mp_property_window_scale, CONF_TYPE_DOUBLE,
       CONF_RANGE, 0.125, 8 },
+    { "vo-queued-frames", mp_property_vo_queued_frames, CONF_TYPE_INT },
+    { "decoder-delay", mp_property_decoder_delay, CONF_TYPE_INT },
+    { "pipeline-stats", mp_property_pipeline_stats, CONF_TYPE_STRING },
+    { "gpu-pass-times", mp_property_gpu_pass_times, CONF_TYPE_STRING },
+    { "perf-stats", mp_property_perf_stats, CONF_TYPE_STRING },
+    { "vo-frame-count", mp_property_vo_frame_count, CONF_TYPE_INT64 },
     { "fps", mp_property_fps, CONF_TYPE_FLOAT,
       0, 0, 0, NULL },
     { "aspect", mp_property_aspect, CONF_TYPE_FLOAT,
@@ -2048,6 +2226,28 @@ char *mp_property_expand_string(struct MPContext *mpctx, const char *str)
     return m_properties_expand_string(mp_properties, str, mpctx);
 }
 
+// Render a template from m_properties_expand_compile(); see
+// m_properties_expand_run() for the returned string's lifetime.
+char *mp_property_expand_run(struct MPContext *mpctx,
+                             struct m_expand_template *t)
+{
+    return m_properties_expand_run(t, mp_properties, mpctx);
+}
+
+// Expand source, reusing the compiled template cached in *cache as long as
+// source does not change (for strings expanded every playloop iteration).
+// The returned string is owned by the template; see m_properties_expand_run().
+char *mp_property_expand_cached(struct MPContext *mpctx,
+                                struct m_expand_template **cache,
+                                const char *source)
+{
+    if (!*cache || strcmp(m_expand_template_source(*cache), source) != 0) {
+        talloc_free(*cache);
+        *cache = m_properties_expand_compile(mpctx, source);
+    }
+    return mp_property_expand_run(mpctx, *cache);
+}
+
 void property_print_help(void)
 {
     m_properties_print_help_list(mp_properties);
@@ -2678,6 +2878,25 @@ void run_command(MPContext *mpctx, mp_cmd_t *cmd)
         break;
     }
 
+    case MP_CMD_GET_PROPERTIES: {
+        // All properties are evaluated within this single command, i.e.
+        // without playloop iterations in between, so external controllers
+        // get one coherent state snapshot (separate get_property queries
+        // can return values from different playback states).
+        for (int n = 0; n < cmd->nargs; n++) {
+            char *name = cmd->args[n].v.s;
+            char *tmp;
+            int r = mp_property_do(name, M_PROPERTY_GET_STRING, &tmp, mpctx);
+            if (r <= 0) {
+                MP_INFO(mpctx, "ANS_%s=%s\n", name, property_error_string(r));
+                continue;
+            }
+            MP_INFO(mpctx, "ANS_%s=%s\n", name, tmp);
+            talloc_free(tmp);
+        }
+        break;
+    }
+
     case MP_CMD_FRAME_STEP:
         add_step_frame(mpctx, 1);
         break;
@@ -2861,6 +3080,37 @@ void run_command(MPContext *mpctx, mp_cmd_t *cmd)
                 (bar_osd ? OSD_SEEK_INFO_BAR : 0);
         break;
 
+    case MP_CMD_DUMP_FRAME_STATS: {
+        int num = mpctx->num_frame_stats;
+        int64_t now = mp_time_us();
+        MP_INFO(mpctx, "Frame stats (%d entries, oldest first):\n", num);
+        for (int i = 0; i < num; i++) {
+            int idx = (mpctx->frame_stats_pos + MAX_FRAME_STATS - num + i)
+                      % MAX_FRAME_STATS;
+            struct frame_stat *st = &mpctx->frame_stats[idx];
+            MP_INFO(mpctx, "%9.3f %-6s pts %9.3f took %7.3f ms\n",
+                    (st->start_us - now) / 1e6,
+                    mp_frame_stat_stage_name(st->stage),
+                    st->pts == MP_NOPTS_VALUE ? -1 : st->pts,
+                    st->duration_us / 1e3);
+        }
+        break;
+    }
+
+    case MP_CMD_DUMP_PERF_STATS: {
+        static const double windows[] = {1, 10, 60};
+        for (int i = 0; i < MP_ARRAY_SIZE(windows); i++) {
+            char *line = mp_perf_stats_format(NULL, mpctx, windows[i]);
+            MP_INFO(mpctx, "perf %s\n", line);
+            talloc_free(line);
+        }
+        break;
+    }
+
+    case MP_CMD_DUMP_ALLOC_STATS:
+        talloc_print_alloc_stats();
+        break;
+
 #if HAVE_TV
     case MP_CMD_TV_START_SCAN:
         if (get_tvh(mpctx))
@@ -3166,6 +3416,75 @@ static void handle_script_event(struct MPContext *mpctx, const char *name,
 #endif
 }
 
+/* Push change notifications for the given property to scripts, so they don't
+ * have to poll it. interval is the minimum delay in seconds between
+ * notifications (0 means once per playloop iteration). Observing the same
+ * property multiple times just bumps a refcount; the smallest requested
+ * interval wins.
+ */
+void mp_observe_property(struct MPContext *mpctx, const char *name,
+                         double interval)
+{
+    struct command_ctx *ctx = mpctx->command_ctx;
+    for (int n = 0; n < ctx->num_observers; n++) {
+        struct property_observer *obs = ctx->observers[n];
+        if (strcmp(obs->name, name) == 0) {
+            obs->interval = FFMIN(obs->interval, interval);
+            obs->refcount += 1;
+            return;
+        }
+    }
+    struct property_observer *obs = talloc_ptrtype(ctx, obs);
+    *obs = (struct property_observer) {
+        .name = talloc_strdup(obs, name),
+        .interval = interval,
+        .refcount = 1,
+    };
+    MP_TARRAY_APPEND(ctx, ctx->observers, ctx->num_observers, obs);
+}
+
+void mp_unobserve_property(struct MPContext *mpctx, const char *name)
+{
+    struct command_ctx *ctx = mpctx->command_ctx;
+    for (int n = 0; n < ctx->num_observers; n++) {
+        struct property_observer *obs = ctx->observers[n];
+        if (strcmp(obs->name, name) == 0) {
+            obs->refcount -= 1;
+            if (obs->refcount < 1) {
+                MP_TARRAY_REMOVE_AT(ctx->observers, ctx->num_observers, n);
+                talloc_free(obs);
+            }
+            return;
+        }
+    }
+}
+
+static void check_observed_properties(struct MPContext *mpctx)
+{
+    struct command_ctx *ctx = mpctx->command_ctx;
+    double now = mp_time_sec();
+    for (int n = 0; n < ctx->num_observers; n++) {
+        struct property_observer *obs = ctx->observers[n];
+        if (now < obs->next_check)
+            continue;
+        obs->next_check = now + obs->interval;
+        char *val = NULL;
+        mp_property_do(obs->name, M_PROPERTY_GET_STRING, &val, mpctx);
+        bool changed = !val != !obs->last_value ||
+                       (val && strcmp(val, obs->last_value) != 0);
+        if (changed) {
+            talloc_free(obs->last_value);
+            obs->last_value = talloc_steal(obs, val);
+#if HAVE_LUA
+            mp_lua_property_change(mpctx, obs->name,
+                                   val ? val : "");
+#endif
+        } else {
+            talloc_free(val);
+        }
+    }
+}
+
 void mp_flush_events(struct MPContext *mpctx)
 {
     struct command_ctx *ctx = mpctx->command_ctx;
@@ -3193,4 +3512,6 @@ void mp_flush_events(struct MPContext *mpctx)
                 ctx->last_seek_pts = MP_NOPTS_VALUE;
         }
     }
+
+    check_observed_properties(mpctx);
 }
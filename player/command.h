@@ -21,12 +21,18 @@
 
 struct MPContext;
 struct mp_cmd;
+struct m_expand_template;
 
 void command_init(struct MPContext *mpctx);
 void command_uninit(struct MPContext *mpctx);
 
 void run_command(struct MPContext *mpctx, struct mp_cmd *cmd);
 char *mp_property_expand_string(struct MPContext *mpctx, const char *str);
+char *mp_property_expand_run(struct MPContext *mpctx,
+                             struct m_expand_template *t);
+char *mp_property_expand_cached(struct MPContext *mpctx,
+                                struct m_expand_template **cache,
+                                const char *source);
 void property_print_help(void);
 int mp_property_do(const char* name, int action, void* val,
                    struct MPContext *mpctx);
@@ -45,6 +51,10 @@ enum mp_event {
 void mp_notify(struct MPContext *mpctx, enum mp_event event, void *arg);
 void mp_notify_property(struct MPContext *mpctx, const char *property);
 
+void mp_observe_property(struct MPContext *mpctx, const char *name,
+                         double interval);
+void mp_unobserve_property(struct MPContext *mpctx, const char *name);
+
 void mp_flush_events(struct MPContext *mpctx);
 
 #endif /* MPLAYER_COMMAND_H */
@@ -18,6 +18,9 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -32,6 +35,8 @@
 #include "osdep/io.h"
 
 #include "common/msg.h"
+#include "common/common.h"
+#include "bstr/bstr.h"
 #include "options/path.h"
 #include "options/m_config.h"
 #include "options/parse_configfile.h"
@@ -187,9 +192,11 @@ void mp_load_per_file_config(m_config_t *conf, const char * const file,
 }
 
 #define MP_WATCH_LATER_CONF "watch_later"
+#define MP_WATCH_LATER_DB "watch_later_db"
 
-char *mp_get_playback_resume_config_filename(const char *fname,
-                                             struct MPOpts *opts)
+// Returns the 32 character hex hash identifying the file in the watch-later
+// database (and in the legacy per-file config scheme), or NULL on failure.
+static char *mp_resume_hash(void *talloc_ctx, const char *fname)
 {
     char *res = NULL;
     void *tmp = talloc_new(NULL);
@@ -212,19 +219,190 @@ char *mp_get_playback_resume_config_filename(const char *fname,
 #endif
     uint8_t md5[16];
     av_md5_sum(md5, realpath, strlen(realpath));
-    char *conf = talloc_strdup(tmp, "");
+    res = talloc_strdup(talloc_ctx, "");
     for (int i = 0; i < 16; i++)
-        conf = talloc_asprintf_append(conf, "%02X", md5[i]);
-
-    conf = talloc_asprintf(tmp, "%s/%s", MP_WATCH_LATER_CONF, conf);
-
-    res = mp_find_user_config_file(conf);
+        res = talloc_asprintf_append(res, "%02X", md5[i]);
 
 exit:
     talloc_free(tmp);
     return res;
 }
 
+char *mp_get_playback_resume_config_filename(const char *fname,
+                                             struct MPOpts *opts)
+{
+    char *hash = mp_resume_hash(NULL, fname);
+    if (!hash)
+        return NULL;
+    char *conf = talloc_asprintf(NULL, "%s/%s", MP_WATCH_LATER_CONF, hash);
+    char *res = mp_find_user_config_file(conf);
+    talloc_free(conf);
+    talloc_free(hash);
+    return res;
+}
+
+/* Single-file watch-later database: an append-only text log of
+ * length-prefixed records, mirrored by an in-memory hash table. Lookups
+ * (one per playlist entry on every load) touch no files, unlike the legacy
+ * file-per-entry scheme, which cost an open/stat per candidate - noticeable
+ * on NFS home directories. Superseded and deleted records accumulated by
+ * the log are dropped when the database is rewritten on quit (see
+ * mp_write_watch_later_compacted()).
+ *
+ * Record format: "<32 hex chars> <payload length>\n<payload>\n", where the
+ * payload uses the same option=value syntax as the legacy per-file configs.
+ * A zero length payload marks a deleted entry. */
+
+struct resume_entry {
+    char hash[33];          // 32 hex chars + terminating 0
+    char *data;             // config text (NULL: deleted)
+};
+
+static struct resume_db {
+    void *ta_ctx;
+    char *filename;         // NULL: database not available
+    struct resume_entry *entries;
+    int num_entries;
+    int *table;             // hash -> index into entries (-1: empty)
+    int table_size;         // power of two
+    bool loaded;
+    bool dirty;             // entries changed; compact on quit
+    bool have_legacy_dir;   // pre-database per-file configs may exist
+} resume_db;
+
+static uint32_t resume_hash_bits(const char *hash)
+{
+    char prefix[9] = {0};
+    memcpy(prefix, hash, 8);
+    return strtoul(prefix, NULL, 16);
+}
+
+static int resume_db_find(const char *hash)
+{
+    struct resume_db *db = &resume_db;
+    if (!db->table_size)
+        return -1;
+    for (int i = resume_hash_bits(hash) & (db->table_size - 1);
+         db->table[i] >= 0; i = (i + 1) & (db->table_size - 1))
+    {
+        if (strcmp(db->entries[db->table[i]].hash, hash) == 0)
+            return db->table[i];
+    }
+    return -1;
+}
+
+static void resume_db_index(int idx)
+{
+    struct resume_db *db = &resume_db;
+    int i = resume_hash_bits(db->entries[idx].hash) & (db->table_size - 1);
+    while (db->table[i] >= 0)
+        i = (i + 1) & (db->table_size - 1);
+    db->table[i] = idx;
+}
+
+static void resume_db_set(const char *hash, const char *data)
+{
+    struct resume_db *db = &resume_db;
+    int idx = resume_db_find(hash);
+    if (idx >= 0) {
+        talloc_free(db->entries[idx].data);
+    } else {
+        // Keep the table at most half full.
+        if ((db->num_entries + 1) * 2 > db->table_size) {
+            db->table_size = MPMAX(db->table_size * 2, 64);
+            talloc_free(db->table);
+            db->table = talloc_array(db->ta_ctx, int, db->table_size);
+            for (int i = 0; i < db->table_size; i++)
+                db->table[i] = -1;
+            for (int i = 0; i < db->num_entries; i++)
+                resume_db_index(i);
+        }
+        struct resume_entry e = {.data = NULL};
+        snprintf(e.hash, sizeof(e.hash), "%s", hash);
+        idx = db->num_entries;
+        MP_TARRAY_APPEND(db->ta_ctx, db->entries, db->num_entries, e);
+        resume_db_index(idx);
+    }
+    db->entries[idx].data = data ? talloc_strdup(db->ta_ctx, data) : NULL;
+}
+
+static void resume_db_load(void)
+{
+    struct resume_db *db = &resume_db;
+    if (db->loaded)
+        return;
+    db->loaded = true;
+    db->ta_ctx = talloc_new(NULL);
+    db->filename = talloc_steal(db->ta_ctx,
+                                mp_find_user_config_file(MP_WATCH_LATER_DB));
+    char *legacy = mp_find_user_config_file(MP_WATCH_LATER_CONF);
+    db->have_legacy_dir = legacy && mp_path_exists(legacy);
+    talloc_free(legacy);
+    if (!db->filename)
+        return;
+    FILE *f = fopen(db->filename, "rb");
+    if (!f)
+        return;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        char hash[33];
+        size_t len;
+        if (sscanf(line, "%32[0-9A-F] %zu", hash, &len) != 2 ||
+            strlen(hash) != 32 || len > 0x100000)
+        {
+            // Corrupt or truncated record; ignore the tail of the log.
+            mp_msg(MSGT_CPLAYER, MSGL_WARN,
+                   "Damaged record in watch-later database.\n");
+            break;
+        }
+        char *data = talloc_size(NULL, len + 1);
+        if (fread(data, 1, len, f) != len) {
+            talloc_free(data);
+            break;
+        }
+        data[len] = 0;
+        fgetc(f); // record terminating '\n'
+        resume_db_set(hash, len ? data : NULL);
+        talloc_free(data);
+    }
+    fclose(f);
+}
+
+// Queue appending a record to the log on the async write worker.
+static void resume_db_append(const char *hash, const char *data)
+{
+    struct resume_db *db = &resume_db;
+    if (!db->filename)
+        return;
+    db->dirty = true;
+    char *rec = talloc_asprintf(NULL, "%s %zu\n%s\n", hash,
+                                data ? strlen(data) : 0, data ? data : "");
+    mp_append_file_async(db->filename, rec, strlen(rec));
+    talloc_free(rec);
+}
+
+// Rewrite the database with only the live entries. Called on quit; the
+// actual write happens on the async write worker.
+void mp_write_watch_later_compacted(void)
+{
+    struct resume_db *db = &resume_db;
+    if (!db->loaded || !db->dirty || !db->filename)
+        return;
+    char *s = talloc_strdup(NULL, "# mpv watch-later database\n");
+    for (int i = 0; i < db->num_entries; i++) {
+        struct resume_entry *e = &db->entries[i];
+        if (e->data) {
+            s = talloc_asprintf_append(s, "%s %zu\n%s\n", e->hash,
+                                       strlen(e->data), e->data);
+        }
+    }
+    mp_write_file_async(db->filename, s, strlen(s), true);
+    talloc_free(s);
+    db->dirty = false;
+}
+
 static const char *backup_properties[] = {
     "osd-level",
     //"loop",
@@ -284,20 +462,18 @@ void mp_write_watch_later_conf(struct MPContext *mpctx)
     if (pos == MP_NOPTS_VALUE)
         goto exit;
 
-    mp_mk_config_dir(MP_WATCH_LATER_CONF);
+    mp_mk_config_dir(NULL);
 
-    char *conffile = mp_get_playback_resume_config_filename(mpctx->filename,
-                                                            mpctx->opts);
-    talloc_steal(tmp, conffile);
-    if (!conffile)
+    resume_db_load();
+    char *hash = mp_resume_hash(tmp, mpctx->filename);
+    if (!hash)
         goto exit;
 
     MP_INFO(mpctx, "Saving state.\n");
 
-    FILE *file = fopen(conffile, "wb");
-    if (!file)
-        goto exit;
-    fprintf(file, "start=%f\n", pos);
+    // Format into memory and write asynchronously, so that a slow filesystem
+    // (NFS home directories) can't stall quitting or playlist advancement.
+    char *s = talloc_asprintf(tmp, "start=%f\n", pos);
     for (int i = 0; backup_properties[i]; i++) {
         const char *pname = backup_properties[i];
         char *val = NULL;
@@ -305,31 +481,74 @@ void mp_write_watch_later_conf(struct MPContext *mpctx)
         if (r == M_PROPERTY_OK) {
             if (needs_config_quoting(val)) {
                 // e.g. '%6%STRING'
-                fprintf(file, "%s=%%%d%%%s\n", pname, (int)strlen(val), val);
+                s = talloc_asprintf_append(s, "%s=%%%d%%%s\n", pname,
+                                           (int)strlen(val), val);
             } else {
-                fprintf(file, "%s=%s\n", pname, val);
+                s = talloc_asprintf_append(s, "%s=%s\n", pname, val);
             }
         }
         talloc_free(val);
     }
-    fclose(file);
+    resume_db_set(hash, s);
+    resume_db_append(hash, s);
 
 exit:
     talloc_free(tmp);
 }
 
+// Apply the option=value lines of a resume config stored in the database.
+// Same syntax as the config files written by older versions; since we only
+// ever parse our own output, a full config parser is not needed.
+static void apply_resume_config(m_config_t *conf, const char *data)
+{
+    bstr rest = bstr0(data);
+    while (rest.len) {
+        bstr line = bstr_strip_linebreaks(bstr_getline(rest, &rest));
+        bstr name, value;
+        if (!bstr_split_tok(line, "=", &name, &value))
+            continue;
+        if (bstr_startswith0(value, "%")) {
+            // e.g. '%6%STRING'
+            bstr t = bstr_cut(value, 1);
+            long long len = bstrtoll(t, &t, 10);
+            if (!bstr_startswith0(t, "%") || len > t.len - 1)
+                continue;
+            value = bstr_splice(t, 1, 1 + len);
+        }
+        m_config_set_option_ext(conf, name, value,
+                                M_SETOPT_FROM_CONFIG_FILE |
+                                M_SETOPT_PRESERVE_CMDLINE);
+    }
+}
+
 void mp_load_playback_resume(m_config_t *conf, const char *file)
 {
-    char *fname = mp_get_playback_resume_config_filename(file, conf->optstruct);
-    if (fname && mp_path_exists(fname)) {
+    resume_db_load();
+    void *tmp = talloc_new(NULL);
+    char *hash = mp_resume_hash(tmp, file);
+    int idx = hash ? resume_db_find(hash) : -1;
+    if (idx >= 0 && resume_db.entries[idx].data) {
         // Never apply the saved start position to following files
         m_config_backup_opt(conf, "start");
         mp_msg(MSGT_CPLAYER, MSGL_INFO, "Resuming playback. This behavior can "
                "be disabled with --no-resume-playback.\n");
-        try_load_config(conf, fname, M_SETOPT_PRESERVE_CMDLINE);
-        unlink(fname);
+        apply_resume_config(conf, resume_db.entries[idx].data);
+        resume_db_set(hash, NULL);
+        resume_db_append(hash, NULL);
+    } else if (resume_db.have_legacy_dir) {
+        // Configs written by older versions, one file per entry.
+        char *fname = mp_get_playback_resume_config_filename(file,
+                                                             conf->optstruct);
+        if (fname && mp_path_exists(fname)) {
+            m_config_backup_opt(conf, "start");
+            mp_msg(MSGT_CPLAYER, MSGL_INFO, "Resuming playback. This behavior "
+                   "can be disabled with --no-resume-playback.\n");
+            try_load_config(conf, fname, M_SETOPT_PRESERVE_CMDLINE);
+            unlink(fname);
+        }
+        talloc_free(fname);
     }
-    talloc_free(fname);
+    talloc_free(tmp);
 }
 
 // Returns the first file that has a resume config.
@@ -342,10 +561,18 @@ struct playlist_entry *mp_resume_playlist(struct playlist *playlist,
 {
     if (!opts->position_resume)
         return NULL;
+    resume_db_load();
     for (struct playlist_entry *e = playlist->first; e; e = e->next) {
-        char *conf = mp_get_playback_resume_config_filename(e->filename, opts);
-        bool exists = conf && mp_path_exists(conf);
-        talloc_free(conf);
+        char *hash = mp_resume_hash(NULL, e->filename);
+        int idx = hash ? resume_db_find(hash) : -1;
+        bool exists = idx >= 0 && resume_db.entries[idx].data;
+        talloc_free(hash);
+        if (!exists && resume_db.have_legacy_dir) {
+            char *conf = mp_get_playback_resume_config_filename(e->filename,
+                                                                opts);
+            exists = conf && mp_path_exists(conf);
+            talloc_free(conf);
+        }
         if (exists)
             return e;
     }
@@ -143,6 +143,44 @@ enum {
     MAX_NUM_VO_PTS = 100,
 };
 
+// Video pipeline stages instrumented with per-frame timings.
+enum frame_stat_stage {
+    FSTAT_DECODE,
+    FSTAT_FILTER,
+    FSTAT_DRAW,
+    FSTAT_FLIP,
+    FSTAT_COUNT,
+};
+
+struct frame_stat {
+    enum frame_stat_stage stage;
+    double pts;         // timestamp of the frame (MP_NOPTS_VALUE if unknown)
+    int64_t start_us;   // mp_time_us() when the stage began
+    int64_t duration_us;
+};
+
+// Number of frame_stat entries kept (a ring buffer of the most recent ones).
+// Sized to cover about a minute of 30 fps material across all stages, so
+// windowed queries (see mp_frame_stat_summary()) stay meaningful.
+#define MAX_FRAME_STATS 8192
+
+// Periodic sample of buffering state (see mp_record_load_stat()).
+struct load_stat {
+    int64_t time_us;    // mp_time_us() when the sample was taken
+    float audio_buffer; // seconds of audio buffered in the AO (-1 if no audio)
+    float cache_fill;   // stream cache fill in percent (-1 if no cache)
+};
+
+// Number of load_stat entries kept; samples are taken at most every 0.25s,
+// so this covers about a minute.
+#define MAX_LOAD_STATS 256
+
+// Windowed aggregate over recorded samples.
+struct frame_stat_summary {
+    int count;
+    double avg, p50, p99, max; // milliseconds
+};
+
 typedef struct MPContext {
     struct mpv_global *global;
     struct MPOpts *opts;
@@ -153,6 +191,17 @@ typedef struct MPContext {
     struct mp_osd_msg *osd_msg_stack;
     char *terminal_osd_text;
     char *last_window_title;
+    // Compiled --status-msg template, and reused line buffer for the default
+    // status line (capacity is kept across print_status() calls).
+    struct m_expand_template *status_msg_template;
+    struct m_expand_template *osd_status_msg_template;
+    struct m_expand_template *wintitle_template;
+    char *statusline;
+    // Copy of the status line as last written to the terminal, to skip
+    // rewriting it when it hasn't changed.
+    char *last_status_line;
+    double last_status_time;
+    double last_osd_time; // last rebuild of the fallback OSD status text
 
     int add_osd_seek_info; // bitfield of enum mp_osd_seek_info
     double osd_visible; // for the osd bar only
@@ -161,6 +210,8 @@ typedef struct MPContext {
     double osd_last_update;
 
     struct playlist *playlist;
+    struct prefetch_ctx *prefetch; // --prefetch-playlist state (loadfile.c)
+    char *dns_prewarmed; // last URL whose hostname was pre-resolved
     char *filename; // currently playing file
     struct mp_resolve_result *resolve_result;
     enum stop_play_reason stop_play;
@@ -174,6 +225,17 @@ typedef struct MPContext {
 
     int64_t shown_vframes, shown_aframes;
 
+    // Ring of per-frame stage timings (see mp_record_frame_stat()).
+    struct frame_stat *frame_stats; // MAX_FRAME_STATS entries once allocated
+    int frame_stats_pos;            // next write position
+    int num_frame_stats;            // number of valid entries
+
+    // Ring of buffering state samples (see mp_record_load_stat()).
+    struct load_stat *load_stats;   // MAX_LOAD_STATS entries once allocated
+    int load_stats_pos;
+    int num_load_stats;
+    int64_t last_load_stat_time;
+
     struct demuxer **sources;
     int num_sources;
 
@@ -203,12 +265,19 @@ typedef struct MPContext {
     struct dec_audio *d_audio;
     struct dec_sub *d_sub;
 
+    // Initialized decoder kept alive after its stream went away, for reuse
+    // by the next file if the codec configuration matches. See video.c.
+    struct parked_video_dec *parked_video_dec;
+
     // Uses: accessing metadata (consider ordered chapters case, where the main
     // demuxer defines metadata), or special purpose demuxers like TV.
     struct demuxer *master_demuxer;
 
     struct mixer *mixer;
     struct ao *ao;
+    // Decoder format the AO was opened for; used by weak gapless audio to
+    // decide whether the AO can be kept across files.
+    struct mp_audio *ao_decoder_fmt;
     struct vo *video_out;
 
     /* We're starting playback from scratch or after a seek. Show first
@@ -249,6 +318,10 @@ typedef struct MPContext {
     int drop_frame_cnt;
     // Number of frames dropped in a row.
     int dropped_frames;
+    // Decode-side skip policy engages on sustained lateness and stays on
+    // until playback has been on schedule for a while (hysteresis).
+    bool framedrop_engaged;
+    int ontime_frame_cnt;
     // A-V sync difference when last frame was displayed. Kept to display
     // the same value if the status line is updated at a time where no new
     // video frame is shown.
@@ -279,6 +352,7 @@ typedef struct MPContext {
 
     double last_heartbeat;
     double last_metadata_update;
+    double last_memory_check;
 
     double mouse_timer;
     unsigned int mouse_event_ts;
@@ -313,6 +387,9 @@ typedef struct MPContext {
      */
     struct ass_renderer *ass_renderer;
     struct ass_library *ass_library;
+    // Embedded fonts of the current file were added to ass_library (forces
+    // rebuilding the renderer on the next file).
+    bool ass_added_fonts;
 
     int last_dvb_step;
 
@@ -356,6 +433,7 @@ void mp_load_per_file_config(struct m_config *conf, const char * const file,
                              bool search_file_dir);
 void mp_load_playback_resume(struct m_config *conf, const char *file);
 void mp_write_watch_later_conf(struct MPContext *mpctx);
+void mp_write_watch_later_compacted(void);
 struct playlist_entry *mp_resume_playlist(struct playlist *playlist,
                                           struct MPOpts *opts);
 
@@ -384,6 +462,7 @@ struct playlist_entry *mp_next_file(struct MPContext *mpctx, int direction,
                                     bool force);
 void mp_set_playlist_entry(struct MPContext *mpctx, struct playlist_entry *e);
 void mp_play_files(struct MPContext *mpctx);
+void mp_prefetch_next_file(struct MPContext *mpctx);
 
 // main.c
 void mp_print_version(int always);
@@ -400,6 +479,14 @@ int mp_get_cache_percent(struct MPContext *mpctx);
 bool mp_get_cache_idle(struct MPContext *mpctx);
 void update_window_title(struct MPContext *mpctx, bool force);
 void stream_dump(struct MPContext *mpctx);
+void mp_record_frame_stat(struct MPContext *mpctx, enum frame_stat_stage stage,
+                          double pts, int64_t start_us);
+const char *mp_frame_stat_stage_name(enum frame_stat_stage stage);
+void mp_record_load_stat(struct MPContext *mpctx, double buffered_audio);
+bool mp_frame_stat_summary(struct MPContext *mpctx, enum frame_stat_stage stage,
+                           double window, struct frame_stat_summary *out);
+char *mp_perf_stats_format(void *talloc_ctx, struct MPContext *mpctx,
+                           double window);
 
 // osd.c
 void write_status_line(struct MPContext *mpctx, const char *line);
@@ -409,6 +496,7 @@ void set_osd_bar(struct MPContext *mpctx, int type, const char* name,
 void set_osd_msg(struct MPContext *mpctx, int id, int level, int time,
                  const char* fmt, ...) PRINTF_ATTRIBUTE(5,6);
 void rm_osd_msg(struct MPContext *mpctx, int id);
+double osd_get_next_deadline(struct MPContext *mpctx);
 void set_osd_function(struct MPContext *mpctx, int osd_function);
 void set_osd_subtitle(struct MPContext *mpctx, const char *text);
 
@@ -455,5 +543,7 @@ double update_video(struct MPContext *mpctx, double endpts);
 void mp_force_video_refresh(struct MPContext *mpctx);
 void update_fps(struct MPContext *mpctx);
 void video_execute_format_change(struct MPContext *mpctx);
+void park_video_decoder(struct MPContext *mpctx);
+void discard_parked_video_decoder(struct MPContext *mpctx);
 
 #endif /* MPLAYER_MP_CORE_H */
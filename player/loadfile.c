@@ -20,6 +20,12 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <pthread.h>
+
+#ifndef __MINGW32__
+#include <sys/socket.h>
+#include <netdb.h>
+#endif
 
 #include <libavutil/avutil.h>
 
@@ -30,6 +36,7 @@
 #include "osdep/terminal.h"
 #include "osdep/timer.h"
 
+#include "common/global.h"
 #include "common/msg.h"
 #include "options/path.h"
 #include "options/m_config.h"
@@ -40,6 +47,7 @@
 #include "common/common.h"
 #include "common/encode.h"
 #include "input/input.h"
+#include "misc/thread_pool.h"
 
 #include "audio/mixer.h"
 #include "audio/audio.h"
@@ -91,17 +99,23 @@ void uninit_player(struct MPContext *mpctx, unsigned int mask)
     if (mask & INITIALIZED_LIBASS) {
         mpctx->initialized_flags &= ~INITIALIZED_LIBASS;
 #if HAVE_LIBASS
-        if (mpctx->ass_renderer)
-            ass_renderer_done(mpctx->ass_renderer);
-        mpctx->ass_renderer = NULL;
-        ass_clear_fonts(mpctx->ass_library);
+        // Keep the renderer (and with it the fontconfig state, which can take
+        // seconds to set up) for the next file. Only embedded fonts force
+        // rebuilding it, since they have to be removed from the library again.
+        if (mpctx->ass_added_fonts) {
+            if (mpctx->ass_renderer)
+                ass_renderer_done(mpctx->ass_renderer);
+            mpctx->ass_renderer = NULL;
+            ass_clear_fonts(mpctx->ass_library);
+            mpctx->ass_added_fonts = false;
+        }
 #endif
     }
 
     if (mask & INITIALIZED_VCODEC) {
         mpctx->initialized_flags &= ~INITIALIZED_VCODEC;
         if (mpctx->d_video)
-            video_uninit(mpctx->d_video);
+            park_video_decoder(mpctx);
         mpctx->d_video = NULL;
         cleanup_demux_stream(mpctx, STREAM_VIDEO);
         mpctx->sync_audio_to_video = false;
@@ -120,8 +134,15 @@ void uninit_player(struct MPContext *mpctx, unsigned int mask)
         assert(!mpctx->d_video && !mpctx->d_audio && !mpctx->d_sub);
         mpctx->master_demuxer = NULL;
         for (int i = 0; i < mpctx->num_sources; i++) {
-            uninit_subs(mpctx->sources[i]);
             struct demuxer *demuxer = mpctx->sources[i];
+            // Ordered chapter source slots can share a demuxer instance
+            // (see tl_matroska.c); free each instance only once.
+            bool duplicate = false;
+            for (int j = 0; j < i; j++)
+                duplicate |= mpctx->sources[j] == demuxer;
+            if (duplicate)
+                continue;
+            uninit_subs(demuxer);
             struct stream *stream = demuxer->stream;
             free_demuxer(demuxer);
             if (stream != mpctx->stream)
@@ -325,6 +346,31 @@ static struct sh_stream *select_fallback_stream(struct demuxer *d,
     return best_stream;
 }
 
+// The stream the given track would use in the given source (same logic as
+// the track rebinding in timeline_set_part()).
+static struct sh_stream *track_stream_in_source(struct demuxer *d,
+                                                struct track *track)
+{
+    struct sh_stream *s = demuxer_stream_by_demuxer_id(d, track->type,
+                                                       track->demuxer_id);
+    if (!s)
+        s = select_fallback_stream(d, track->type, track->user_tid - 1);
+    return s;
+}
+
+// Whether the decoder for the given stream type can survive switching to
+// the new source: the track must continue with the same codec, so that
+// flushing the decoder is enough and no codec reinit is needed.
+static bool can_keep_codec(struct MPContext *mpctx, struct demuxer *source,
+                           enum stream_type type, struct sh_stream *cur)
+{
+    struct track *track = mpctx->current_track[type];
+    if (!cur || !track || !track->under_timeline || !cur->codec)
+        return false;
+    struct sh_stream *new = track_stream_in_source(source, track);
+    return new && new->codec && strcmp(new->codec, cur->codec) == 0;
+}
+
 bool timeline_set_part(struct MPContext *mpctx, int i, bool force)
 {
     struct timeline_part *p = mpctx->timeline + mpctx->timeline_part;
@@ -333,10 +379,22 @@ bool timeline_set_part(struct MPContext *mpctx, int i, bool force)
     mpctx->video_offset = n->start - n->source_start;
     if (n->source == p->source && !force)
         return false;
+
+    // A full decoder reinit stalls playback at every splice point; when the
+    // parts continue with the same codecs, keep the decoders (and their
+    // filter chains) and just flush them after the rebind below.
+    int keep = 0;
+    if (mpctx->d_video &&
+        can_keep_codec(mpctx, n->source, STREAM_VIDEO, mpctx->d_video->header))
+        keep |= INITIALIZED_VCODEC;
+    if (mpctx->d_audio &&
+        can_keep_codec(mpctx, n->source, STREAM_AUDIO, mpctx->d_audio->header))
+        keep |= INITIALIZED_ACODEC;
+
     enum stop_play_reason orig_stop_play = mpctx->stop_play;
     if (!mpctx->d_video && mpctx->stop_play == KEEP_PLAYING)
         mpctx->stop_play = AT_END_OF_FILE;  // let audio uninit drain data
-    uninit_player(mpctx, INITIALIZED_VCODEC | (mpctx->opts->fixed_vo ? 0 : INITIALIZED_VO) | (mpctx->opts->gapless_audio ? 0 : INITIALIZED_AO) | INITIALIZED_ACODEC | INITIALIZED_SUB);
+    uninit_player(mpctx, (INITIALIZED_VCODEC | (mpctx->opts->fixed_vo ? 0 : INITIALIZED_VO) | (mpctx->opts->gapless_audio ? 0 : INITIALIZED_AO) | INITIALIZED_ACODEC | INITIALIZED_SUB) & ~keep);
     mpctx->stop_play = orig_stop_play;
 
     mpctx->demuxer = n->source;
@@ -361,6 +419,17 @@ bool timeline_set_part(struct MPContext *mpctx, int i, bool force)
     }
     preselect_demux_streams(mpctx);
 
+    if (keep & INITIALIZED_VCODEC) {
+        struct sh_stream *sh = init_demux_stream(mpctx, STREAM_VIDEO);
+        mpctx->d_video->header = sh;
+        mpctx->d_video->fps = sh->video->fps;
+        video_reset_decoding(mpctx->d_video);
+    }
+    if (keep & INITIALIZED_ACODEC) {
+        mpctx->d_audio->header = init_demux_stream(mpctx, STREAM_AUDIO);
+        audio_reset_decoding(mpctx->d_audio);
+    }
+
     return true;
 }
 
@@ -710,6 +779,15 @@ static void open_subtitles_from_options(struct MPContext *mpctx)
             }
         skip:;
         }
+        // Warm the directory cache for the following playlist entry in the
+        // background, so its subtitle discovery doesn't delay the transition.
+        struct playlist_entry *next = playlist_get_next(mpctx->playlist, +1);
+        if (next && mpctx->global->thread_pool &&
+            !mp_is_url(bstr0(next->filename)))
+        {
+            mp_prefetch_text_subtitles(mpctx->global->thread_pool,
+                                       mpctx->opts, next->filename);
+        }
         talloc_free(tmp);
     }
 }
@@ -824,11 +902,20 @@ static void add_subtitle_fonts_from_sources(struct MPContext *mpctx)
     if (mpctx->opts->ass_enabled) {
         for (int j = 0; j < mpctx->num_sources; j++) {
             struct demuxer *d = mpctx->sources[j];
+            bool duplicate = false;
+            for (int i = 0; i < j; i++)
+                duplicate |= mpctx->sources[i] == d;
+            if (duplicate)
+                continue;
+            if (mpctx->opts->use_embedded_fonts)
+                demux_control(d, DEMUXER_CTRL_READ_ATTACHMENTS, NULL);
             for (int i = 0; i < d->num_attachments; i++) {
                 struct demux_attachment *att = d->attachments + i;
-                if (mpctx->opts->use_embedded_fonts && attachment_is_font(att))
+                if (mpctx->opts->use_embedded_fonts && attachment_is_font(att)) {
                     ass_add_font(mpctx->ass_library, att->name, att->data,
                                  att->data_size);
+                    mpctx->ass_added_fonts = true;
+                }
             }
         }
     }
@@ -839,11 +926,18 @@ static void init_sub_renderer(struct MPContext *mpctx)
 {
 #if HAVE_LIBASS
     assert(!(mpctx->initialized_flags & INITIALIZED_LIBASS));
-    assert(!mpctx->ass_renderer);
 
-    mpctx->ass_renderer = ass_renderer_init(mpctx->ass_library);
-    if (mpctx->ass_renderer)
-        mp_ass_configure_fonts(mpctx->ass_renderer, mpctx->opts->sub_text_style);
+    if (!mpctx->ass_renderer) {
+        mpctx->ass_renderer = ass_renderer_init(mpctx->ass_library);
+        if (mpctx->ass_renderer)
+            mp_ass_configure_fonts(mpctx->ass_renderer,
+                                   mpctx->opts->sub_text_style);
+    } else if (mpctx->ass_added_fonts) {
+        // Reusing the previous file's renderer; make the embedded fonts
+        // added for this file visible to it.
+        mp_ass_configure_fonts(mpctx->ass_renderer,
+                               mpctx->opts->sub_text_style);
+    }
     mpctx->initialized_flags |= INITIALIZED_LIBASS;
 #endif
 }
@@ -959,6 +1053,224 @@ static void load_per_file_options(m_config_t *conf,
 
 // Start playing the current playlist entry.
 // Handle initialization and deinitialization.
+// State for --prefetch-playlist. A worker thread opens stream and demuxer of
+// the expected next playlist entry ahead of time, and play_current_file()
+// swaps in the result instead of opening everything again.
+struct prefetch_ctx {
+    struct mp_log *log;
+    struct MPOpts *opts;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    bool in_progress;       // worker is running; result fields not valid yet
+    char *filename;         // entry the result (or the running job) is for
+    struct stream *stream;  // result; NULL if opening failed
+    struct demuxer *demuxer;
+};
+
+static void prefetch_destroy(void *ptr)
+{
+    struct prefetch_ctx *pf = ptr;
+    pthread_mutex_lock(&pf->lock);
+    while (pf->in_progress)
+        pthread_cond_wait(&pf->wakeup, &pf->lock);
+    pthread_mutex_unlock(&pf->lock);
+    if (pf->demuxer)
+        free_demuxer(pf->demuxer);
+    if (pf->stream)
+        free_stream(pf->stream);
+    pthread_mutex_destroy(&pf->lock);
+    pthread_cond_destroy(&pf->wakeup);
+}
+
+static void prefetch_thread(void *ptr)
+{
+    struct prefetch_ctx *pf = ptr;
+    struct MPOpts *opts = pf->opts;
+    struct stream *stream = stream_open(pf->filename, opts);
+    struct demuxer *demuxer = NULL;
+    if (stream) {
+        // Same as in play_current_file(): the cache must be enabled before
+        // the demuxer is opened on the stream.
+        stream_enable_cache_percent(&stream, opts->stream_cache_size,
+                                    opts->stream_cache_def_size,
+                                    opts->stream_cache_min_percent,
+                                    opts->stream_cache_seek_min_percent);
+        demuxer = demux_open(stream, opts->demuxer_name, NULL, opts);
+    }
+    if (!demuxer && stream) {
+        // Let the normal open path retry and report the error.
+        free_stream(stream);
+        stream = NULL;
+    }
+    mp_msg_log(pf->log, MSGL_V, "Prefetch of '%s' %s.\n", pf->filename,
+               demuxer ? "finished" : "failed");
+    pthread_mutex_lock(&pf->lock);
+    pf->stream = stream;
+    pf->demuxer = demuxer;
+    pf->in_progress = false;
+    pthread_cond_broadcast(&pf->wakeup);
+    pthread_mutex_unlock(&pf->lock);
+}
+
+// Resolve the hostname of the next URL, so that it sits in the system
+// resolver cache by the time the entry is actually opened. Keeping the
+// result would be pointless: libavformat resolves again on open, and there
+// is no way to hand it anything but what the OS-level cache provides.
+static void dns_prewarm_thread(void *ptr)
+{
+#ifndef __MINGW32__
+    struct addrinfo hints = {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(ptr, NULL, &hints, &res) == 0)
+        freeaddrinfo(res);
+#endif
+    talloc_free(ptr);
+}
+
+// Extract the host part of an URL ("proto://[user@]host[:port]/...").
+// Returns NULL if there is no hostname worth resolving.
+static char *url_hostname(void *talloc_ctx, const char *url)
+{
+    char *p = strstr(url, "://");
+    if (!p)
+        return NULL;
+    p += 3;
+    int len = strcspn(p, "/?#");
+    char *at = memchr(p, '@', len);
+    if (at) {
+        len -= at + 1 - p;
+        p = at + 1;
+    }
+    if (len && p[0] == '[')     // IPv6 address literal - nothing to resolve
+        return NULL;
+    char *colon = memchr(p, ':', len);
+    if (colon)
+        len = colon - p;
+    if (!len)
+        return NULL;
+    return talloc_strndup(talloc_ctx, p, len);
+}
+
+// Start opening the next playlist entry in the background if the current file
+// is about to end. Called from the playloop.
+void mp_prefetch_next_file(struct MPContext *mpctx)
+{
+    struct MPOpts *opts = mpctx->opts;
+    if (!mpctx->global->thread_pool)
+        return;
+    if (opts->seek_to_byte || (opts->stream_dump && opts->stream_dump[0]))
+        return;
+    // Note: no mp_next_file(), which has side effects with --loop/--shuffle.
+    struct playlist_entry *next = playlist_get_next(mpctx->playlist, +1);
+    if (!next && opts->loop_times >= 0 && !opts->shuffle)
+        next = mpctx->playlist->first;
+    if (!next || !next->filename)
+        return;
+    // Open only once the end of the current file is near, so that at most
+    // one extra file is held open at a time.
+    double len = get_time_length(mpctx);
+    double pos = get_current_time(mpctx);
+    if (len <= 0 || pos < len - 10)
+        return;
+    if (!opts->prefetch_open) {
+        // Even without --prefetch-playlist, resolving the hostname of the
+        // next network entry ahead of time is cheap and shaves the DNS
+        // round trip off the transition.
+        if (!mp_is_url(bstr0(next->filename)))
+            return;
+        if (mpctx->dns_prewarmed &&
+            strcmp(mpctx->dns_prewarmed, next->filename) == 0)
+            return;
+        char *host = url_hostname(NULL, next->filename);
+        if (!host)
+            return;
+        talloc_free(mpctx->dns_prewarmed);
+        mpctx->dns_prewarmed = talloc_strdup(mpctx, next->filename);
+        mp_thread_pool_queue(mpctx->global->thread_pool, dns_prewarm_thread,
+                             host);
+        return;
+    }
+    struct prefetch_ctx *pf = mpctx->prefetch;
+    if (!pf) {
+        pf = talloc_zero(mpctx, struct prefetch_ctx);
+        pf->log = mp_log_new(pf, mpctx->log, "prefetch");
+        pf->opts = opts;
+        pthread_mutex_init(&pf->lock, NULL);
+        pthread_cond_init(&pf->wakeup, NULL);
+        talloc_set_destructor(pf, prefetch_destroy);
+        mpctx->prefetch = pf;
+    }
+    pthread_mutex_lock(&pf->lock);
+    bool busy = pf->in_progress ||
+                (pf->filename && strcmp(pf->filename, next->filename) == 0);
+    if (!busy) {
+        // Drop a stale result for an entry that is not next anymore.
+        if (pf->demuxer)
+            free_demuxer(pf->demuxer);
+        if (pf->stream)
+            free_stream(pf->stream);
+        pf->demuxer = NULL;
+        pf->stream = NULL;
+        talloc_free(pf->filename);
+        pf->filename = talloc_strdup(pf, next->filename);
+        pf->in_progress = true;
+        mp_thread_pool_queue(mpctx->global->thread_pool, prefetch_thread, pf);
+    }
+    pthread_mutex_unlock(&pf->lock);
+}
+
+// Return the prefetched stream for filename (or NULL), with the demuxer that
+// was opened on it in *demuxer. Ownership passes to the caller.
+static struct stream *prefetch_take(struct MPContext *mpctx,
+                                    const char *filename,
+                                    struct demuxer **demuxer)
+{
+    struct prefetch_ctx *pf = mpctx->prefetch;
+    *demuxer = NULL;
+    if (!pf)
+        return NULL;
+    pthread_mutex_lock(&pf->lock);
+    if (!pf->filename || strcmp(pf->filename, filename) != 0) {
+        pthread_mutex_unlock(&pf->lock);
+        return NULL;
+    }
+    while (pf->in_progress)
+        pthread_cond_wait(&pf->wakeup, &pf->lock);
+    struct stream *stream = pf->stream;
+    *demuxer = pf->demuxer;
+    pf->stream = NULL;
+    pf->demuxer = NULL;
+    talloc_free(pf->filename);
+    pf->filename = NULL;
+    pthread_mutex_unlock(&pf->lock);
+    return stream;
+}
+
+// Materialize the demuxer's chapter list as the immutable in-core table used
+// by all chapter queries (get_current_chapter(), chapter-list, OSD), so they
+// never go back to the demuxer or stream layer. The timeline builders install
+// their own table; stream-managed timelines (DVD) are left alone, since the
+// current chapter can't be derived from the playback pts there.
+static void copy_demuxer_chapters(struct MPContext *mpctx)
+{
+    struct demuxer *demuxer = mpctx->master_demuxer;
+    if (mpctx->chapters || !demuxer || !demuxer->num_chapters)
+        return;
+    if (demuxer->stream && stream_manages_timeline(demuxer->stream))
+        return;
+    mpctx->num_chapters = demuxer->num_chapters;
+    mpctx->chapters = talloc_array(NULL, struct chapter, mpctx->num_chapters);
+    for (int n = 0; n < mpctx->num_chapters; n++) {
+        mpctx->chapters[n] = (struct chapter) {
+            .start = demuxer->chapters[n].start / 1e9,
+            .name = talloc_strdup(mpctx->chapters, demuxer->chapters[n].name),
+        };
+    }
+}
+
 static void play_current_file(struct MPContext *mpctx)
 {
     struct MPOpts *opts = mpctx->opts;
@@ -1044,32 +1356,46 @@ static void play_current_file(struct MPContext *mpctx)
         }
         stream_filename = mpctx->resolve_result->url;
     }
-    mpctx->stream = stream_open(stream_filename, opts);
+    struct demuxer *prefetch_demuxer = NULL;
+    mpctx->stream = prefetch_take(mpctx, stream_filename, &prefetch_demuxer);
+    if (mpctx->stream) {
+        MP_VERBOSE(mpctx, "Using prefetched stream and demuxer.\n");
+    } else {
+        mpctx->stream = stream_open(stream_filename, opts);
+    }
     if (!mpctx->stream) { // error...
         demux_was_interrupted(mpctx);
         goto terminate_playback;
     }
     mpctx->initialized_flags |= INITIALIZED_STREAM;
 
-    mpctx->stream->start_pos += opts->seek_to_byte;
+    if (!prefetch_demuxer) {
+        mpctx->stream->start_pos += opts->seek_to_byte;
 
-    if (opts->stream_dump && opts->stream_dump[0]) {
-        stream_dump(mpctx);
-        goto terminate_playback;
+        if (opts->stream_dump && opts->stream_dump[0]) {
+            stream_dump(mpctx);
+            goto terminate_playback;
+        }
     }
 
     // Must be called before enabling cache.
     mp_nav_init(mpctx);
 
-    // CACHE2: initial prefill: 20%  later: 5%  (should be set by -cacheopts)
-    int res = stream_enable_cache_percent(&mpctx->stream,
-                                          opts->stream_cache_size,
-                                          opts->stream_cache_def_size,
-                                          opts->stream_cache_min_percent,
-                                          opts->stream_cache_seek_min_percent);
-    if (res == 0)
-        if (demux_was_interrupted(mpctx))
-            goto terminate_playback;
+    if (opts->low_latency) {
+        // The cache process adds readahead between the source and the
+        // demuxer; for live sources the data should go straight through.
+        MP_VERBOSE(mpctx, "Not enabling the stream cache (--low-latency).\n");
+    } else if (!prefetch_demuxer) {
+        // CACHE2: initial prefill: 20%  later: 5%  (should be set by -cacheopts)
+        int res = stream_enable_cache_percent(&mpctx->stream,
+                                              opts->stream_cache_size,
+                                              opts->stream_cache_def_size,
+                                              opts->stream_cache_min_percent,
+                                              opts->stream_cache_seek_min_percent);
+        if (res == 0)
+            if (demux_was_interrupted(mpctx))
+                goto terminate_playback;
+    }
 
     stream_set_capture_file(mpctx->stream, opts->stream_capture);
 
@@ -1081,7 +1407,11 @@ goto_reopen_demuxer: ;
 
     mpctx->audio_delay = opts->audio_delay;
 
-    mpctx->demuxer = demux_open(mpctx->stream, opts->demuxer_name, NULL, opts);
+    mpctx->demuxer = prefetch_demuxer;
+    prefetch_demuxer = NULL; // only valid on the first pass
+    if (!mpctx->demuxer)
+        mpctx->demuxer = demux_open(mpctx->stream, opts->demuxer_name, NULL,
+                                    opts);
     mpctx->master_demuxer = mpctx->demuxer;
     if (!mpctx->demuxer) {
         MP_ERR(mpctx, "Failed to recognize file format.\n");
@@ -1131,6 +1461,8 @@ goto_reopen_demuxer: ;
     add_dvd_tracks(mpctx);
     add_demuxer_tracks(mpctx, mpctx->demuxer);
 
+    copy_demuxer_chapters(mpctx);
+
     mpctx->timeline_part = 0;
     if (mpctx->timeline)
         timeline_set_part(mpctx, mpctx->timeline_part, true);
@@ -1160,6 +1492,13 @@ goto_reopen_demuxer: ;
 
     preselect_demux_streams(mpctx);
 
+    // Readahead-demux packets on a thread, so the playloop does not block on
+    // the stream. Not used with timelines (the parts share their source
+    // demuxers and are switched/seeked directly) or DVD-style streams (the
+    // stream position must stay in sync with playback).
+    if (!mpctx->timeline && !stream_manages_timeline(mpctx->stream))
+        demux_start_thread(mpctx->demuxer);
+
 #if HAVE_ENCODING
     if (mpctx->encode_lavc_ctx && mpctx->current_track[STREAM_VIDEO])
         encode_lavc_expect_stream(mpctx->encode_lavc_ctx, AVMEDIA_TYPE_VIDEO);
@@ -336,6 +336,30 @@ void mp_lua_event(struct MPContext *mpctx, const char *name, const char *arg)
     }
 }
 
+static int run_property_change(lua_State *L)
+{
+    lua_getglobal(L, "mp_property_changed"); // name value fn
+    if (lua_isnil(L, -1))
+        return 0;
+    lua_insert(L, -3); // fn name value
+    lua_call(L, 2, 0);
+    return 0;
+}
+
+void mp_lua_property_change(struct MPContext *mpctx, const char *name,
+                            const char *value)
+{
+    struct lua_ctx *lctx = mpctx->lua_ctx;
+    for (int n = 0; n < lctx->num_scripts; n++) {
+        struct script_ctx *ctx = lctx->scripts[n];
+        lua_State *L = ctx->state;
+        lua_pushstring(L, name);
+        lua_pushstring(L, value);
+        if (mp_cpcall(L, run_property_change, 2) != 0)
+            report_error(L);
+    }
+}
+
 static int run_script_dispatch(lua_State *L)
 {
     int id = lua_tointeger(L, 1);
@@ -433,6 +457,103 @@ static int script_property_string(lua_State *L)
     return 0;
 }
 
+static int script_observe_property(lua_State *L)
+{
+    struct MPContext *mpctx = get_mpctx(L);
+    const char *name = luaL_checkstring(L, 1);
+    double interval = luaL_optnumber(L, 2, 0);
+    mp_observe_property(mpctx, name, interval);
+    return 0;
+}
+
+static int script_unobserve_property(lua_State *L)
+{
+    struct MPContext *mpctx = get_mpctx(L);
+    mp_unobserve_property(mpctx, luaL_checkstring(L, 1));
+    return 0;
+}
+
+static int script_resolve_property(lua_State *L)
+{
+    const struct m_option *props = mp_get_property_list();
+    const char *name = luaL_checkstring(L, 1);
+    int id = m_property_resolve(props, name);
+    if (id < 0)
+        return 0;
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int script_property_string_by_id(lua_State *L)
+{
+    const struct m_option *props = mp_get_property_list();
+    struct MPContext *mpctx = get_mpctx(L);
+    static int num_props = -1;
+    if (num_props < 0) {
+        num_props = 0;
+        while (props[num_props].name)
+            num_props++;
+    }
+    int id = luaL_checkinteger(L, 1);
+    if (id < 0 || id >= num_props)
+        return 0;
+    int type = lua_tointeger(L, lua_upvalueindex(1))
+               ? M_PROPERTY_PRINT : M_PROPERTY_GET_STRING;
+
+    char *result = NULL;
+    if (m_property_do_by_id(props, id, type, &result, mpctx) >= 0 && result) {
+        lua_pushstring(L, result);
+        talloc_free(result);
+        return 1;
+    }
+    if (type == M_PROPERTY_PRINT) {
+        lua_pushstring(L, "");
+        return 1;
+    }
+    return 0;
+}
+
+// Arg 1 is an array of property names (strings) or resolved property IDs
+// (integers, as returned by resolve_property). Returns a table mapping each
+// requested name/ID to its value, fetched with a single call into the core.
+static int script_property_multi(lua_State *L)
+{
+    const struct m_option *props = mp_get_property_list();
+    struct MPContext *mpctx = get_mpctx(L);
+    int type = lua_tointeger(L, lua_upvalueindex(1))
+               ? M_PROPERTY_PRINT : M_PROPERTY_GET_STRING;
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_newtable(L); // list res
+    for (int n = 1; ; n++) {
+        lua_rawgeti(L, 1, n); // list res key
+        if (lua_isnil(L, -1)) {
+            lua_pop(L, 1); // list res
+            break;
+        }
+        char *result = NULL;
+        int r = -1;
+        if (lua_type(L, -1) == LUA_TNUMBER) {
+            r = m_property_do_by_id(props, lua_tointeger(L, -1), type,
+                                    &result, mpctx);
+        } else {
+            const char *name = lua_tostring(L, -1);
+            if (name)
+                r = m_property_do(props, name, type, &result, mpctx);
+        }
+        if (r >= 0 && result) {
+            lua_pushstring(L, result); // list res key value
+            talloc_free(result);
+        } else if (type == M_PROPERTY_PRINT) {
+            lua_pushstring(L, ""); // list res key value
+        } else {
+            lua_pushnil(L); // list res key value
+        }
+        lua_settable(L, -3); // list res
+    }
+    return 1;
+}
+
 static int script_set_osd_ass(lua_State *L)
 {
     struct MPContext *mpctx = get_mpctx(L);
@@ -649,6 +770,9 @@ static struct fn_entry fn_list[] = {
     FN_ENTRY(send_command),
     FN_ENTRY(send_commandv),
     FN_ENTRY(property_list),
+    FN_ENTRY(observe_property),
+    FN_ENTRY(unobserve_property),
+    FN_ENTRY(resolve_property),
     FN_ENTRY(set_osd_ass),
     FN_ENTRY(get_osd_resolution),
     FN_ENTRY(get_screen_size),
@@ -680,6 +804,22 @@ static void add_functions(struct script_ctx *ctx)
     lua_pushinteger(L, 1);
     lua_pushcclosure(L, script_property_string, 1);
     lua_setfield(L, -2, "property_get_string");
+
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, script_property_string_by_id, 1);
+    lua_setfield(L, -2, "property_get_by_id");
+
+    lua_pushinteger(L, 1);
+    lua_pushcclosure(L, script_property_string_by_id, 1);
+    lua_setfield(L, -2, "property_get_string_by_id");
+
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, script_property_multi, 1);
+    lua_setfield(L, -2, "property_get_multi");
+
+    lua_pushinteger(L, 1);
+    lua_pushcclosure(L, script_property_multi, 1);
+    lua_setfield(L, -2, "property_get_string_multi");
 }
 
 void mp_lua_init(struct MPContext *mpctx)
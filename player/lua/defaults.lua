@@ -64,6 +64,37 @@ function mp_script_dispatch(id, event)
     end
 end
 
+local property_observers = {}
+local raw_observe_property = mp.observe_property
+local raw_unobserve_property = mp.unobserve_property
+
+-- Receive change notifications for a property instead of polling it.
+-- interval is the minimum number of seconds between notifications (can be
+-- nil for "every playloop iteration"). fn is called as fn(name, value),
+-- where value is the property value as a string ("" if unavailable).
+function mp.observe_property(name, interval, fn)
+    if property_observers[name] then
+        raw_unobserve_property(name)
+    end
+    property_observers[name] = fn
+    raw_observe_property(name, interval)
+end
+
+function mp.unobserve_property(name)
+    if property_observers[name] then
+        property_observers[name] = nil
+        raw_unobserve_property(name)
+    end
+end
+
+-- called by C when an observed property changed
+function mp_property_changed(name, value)
+    local cb = property_observers[name]
+    if cb then
+        cb(name, value)
+    end
+end
+
 mp.msg = {
     log = mp.log,
     fatal = function(...) return mp.log("fatal", ...) end,
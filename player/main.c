@@ -48,6 +48,7 @@
 #include "common/playlist_parser.h"
 #include "options/options.h"
 #include "input/input.h"
+#include "misc/thread_pool.h"
 
 #include "audio/decode/dec_audio.h"
 #include "audio/out/ao.h"
@@ -108,6 +109,12 @@ static MP_NORETURN void exit_player(struct MPContext *mpctx,
 {
     int rc;
     uninit_player(mpctx, INITIALIZED_ALL);
+    discard_parked_video_decoder(mpctx);
+
+    // Drop superseded records accumulated by the watch-later database, then
+    // make sure queued watch-later writes have hit the disk.
+    mp_write_watch_later_compacted();
+    mp_flush_async_writes();
 
 #if HAVE_ENCODING
     encode_lavc_finish(mpctx->encode_lavc_ctx);
@@ -135,6 +142,10 @@ static MP_NORETURN void exit_player(struct MPContext *mpctx,
     osd_free(mpctx->osd);
 
 #if HAVE_LIBASS
+    // Possibly kept alive across files by uninit_player().
+    if (mpctx->ass_renderer)
+        ass_renderer_done(mpctx->ass_renderer);
+    mpctx->ass_renderer = NULL;
     ass_library_done(mpctx->ass_library);
     mpctx->ass_library = NULL;
 #endif
@@ -196,15 +207,13 @@ static bool handle_help_options(struct MPContext *mpctx)
     struct MPOpts *opts = mpctx->opts;
     int opt_exit = 0;
     if (opts->audio_decoders && strcmp(opts->audio_decoders, "help") == 0) {
-        struct mp_decoder_list *list = audio_decoder_list();
-        mp_print_decoders(MSGT_CPLAYER, MSGL_INFO, "Audio decoders:", list);
-        talloc_free(list);
+        mp_print_decoders(MSGT_CPLAYER, MSGL_INFO, "Audio decoders:",
+                          audio_decoder_list());
         opt_exit = 1;
     }
     if (opts->video_decoders && strcmp(opts->video_decoders, "help") == 0) {
-        struct mp_decoder_list *list = video_decoder_list();
-        mp_print_decoders(MSGT_CPLAYER, MSGL_INFO, "Video decoders:", list);
-        talloc_free(list);
+        mp_print_decoders(MSGT_CPLAYER, MSGL_INFO, "Video decoders:",
+                          video_decoder_list());
         opt_exit = 1;
     }
 #if HAVE_X11
@@ -248,6 +257,12 @@ static void osdep_preinit(int *p_argc, char ***p_argv)
         enable_talloc = "1";
     if (enable_talloc && strcmp(enable_talloc, "1") == 0)
         talloc_enable_leak_report();
+    char *enable_stats = getenv("MPV_ALLOC_STATS");
+    if (*p_argc > 1 && (strcmp((*p_argv)[1], "-alloc-stats") == 0 ||
+                        strcmp((*p_argv)[1], "--alloc-stats") == 0))
+        enable_stats = "1";
+    if (enable_stats && strcmp(enable_stats, "1") == 0)
+        talloc_enable_alloc_stats();
 
 #ifdef __MINGW32__
     mp_get_converted_argv(p_argc, p_argv);
@@ -332,6 +347,7 @@ static int mpv_main(int argc, char *argv[])
 
     init_libav();
     GetCpuCaps(&gCpuCaps);
+    mpctx->global->thread_pool = mp_thread_pool_create(mpctx->global, 0);
     screenshot_init(mpctx);
     mpctx->mixer = mixer_init(mpctx, opts);
     command_init(mpctx);
@@ -18,6 +18,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include "config.h"
@@ -137,12 +138,13 @@ void update_window_title(struct MPContext *mpctx, bool force)
         mpctx->last_window_title = false;
         return;
     }
-    char *title = mp_property_expand_string(mpctx, mpctx->opts->wintitle);
+    char *title = mp_property_expand_cached(mpctx, &mpctx->wintitle_template,
+                                            mpctx->opts->wintitle);
     if (!mpctx->last_window_title || force ||
         strcmp(title, mpctx->last_window_title) != 0)
     {
         talloc_free(mpctx->last_window_title);
-        mpctx->last_window_title = talloc_steal(mpctx, title);
+        mpctx->last_window_title = talloc_strdup(mpctx, title);
 
         if (mpctx->video_out) {
             mpctx->video_out->window_title = talloc_strdup(mpctx->video_out, title);
@@ -152,8 +154,6 @@ void update_window_title(struct MPContext *mpctx, bool force)
         if (mpctx->ao) {
             ao_control(mpctx->ao, AOCONTROL_UPDATE_STREAM_TITLE, title);
         }
-    } else {
-        talloc_free(title);
     }
 }
 
@@ -207,3 +207,139 @@ void merge_playlist_files(struct playlist *pl)
     playlist_add_file(pl, edl);
     talloc_free(edl);
 }
+
+// Record that the given pipeline stage ran from start_us until now for the
+// frame with the given pts. Cheap enough to be called on every frame.
+void mp_record_frame_stat(struct MPContext *mpctx, enum frame_stat_stage stage,
+                          double pts, int64_t start_us)
+{
+    if (!mpctx->frame_stats) {
+        mpctx->frame_stats = talloc_zero_array(mpctx, struct frame_stat,
+                                               MAX_FRAME_STATS);
+    }
+    struct frame_stat *st = &mpctx->frame_stats[mpctx->frame_stats_pos];
+    mpctx->frame_stats_pos = (mpctx->frame_stats_pos + 1) % MAX_FRAME_STATS;
+    if (mpctx->num_frame_stats < MAX_FRAME_STATS)
+        mpctx->num_frame_stats += 1;
+    *st = (struct frame_stat) {
+        .stage = stage,
+        .pts = pts,
+        .start_us = start_us,
+        .duration_us = mp_time_us() - start_us,
+    };
+}
+
+const char *mp_frame_stat_stage_name(enum frame_stat_stage stage)
+{
+    switch (stage) {
+    case FSTAT_DECODE:  return "decode";
+    case FSTAT_FILTER:  return "filter";
+    case FSTAT_DRAW:    return "draw";
+    case FSTAT_FLIP:    return "flip";
+    default:            return "unknown";
+    }
+}
+
+// Sample the current buffering state (audio buffered in the AO, stream cache
+// fill). Called once per playloop iteration; rate-limited internally.
+void mp_record_load_stat(struct MPContext *mpctx, double buffered_audio)
+{
+    int64_t now = mp_time_us();
+    if (mpctx->num_load_stats && now - mpctx->last_load_stat_time < 250000)
+        return;
+    if (!mpctx->load_stats) {
+        mpctx->load_stats = talloc_zero_array(mpctx, struct load_stat,
+                                              MAX_LOAD_STATS);
+    }
+    struct load_stat *st = &mpctx->load_stats[mpctx->load_stats_pos];
+    mpctx->load_stats_pos = (mpctx->load_stats_pos + 1) % MAX_LOAD_STATS;
+    if (mpctx->num_load_stats < MAX_LOAD_STATS)
+        mpctx->num_load_stats += 1;
+    mpctx->last_load_stat_time = now;
+    *st = (struct load_stat) {
+        .time_us = now,
+        .audio_buffer = mpctx->d_audio ? buffered_audio : -1,
+        .cache_fill = mp_get_cache_percent(mpctx),
+    };
+}
+
+static int cmp_int64(const void *pa, const void *pb)
+{
+    int64_t a = *(const int64_t *)pa, b = *(const int64_t *)pb;
+    return (a > b) - (a < b);
+}
+
+// Aggregate the recorded timings of one stage over the last window seconds.
+// Returns false if no samples fall into the window.
+bool mp_frame_stat_summary(struct MPContext *mpctx, enum frame_stat_stage stage,
+                           double window, struct frame_stat_summary *out)
+{
+    *out = (struct frame_stat_summary) {0};
+    if (!mpctx->num_frame_stats)
+        return false;
+    int64_t cutoff = mp_time_us() - window * 1e6;
+    int64_t *vals = talloc_array(NULL, int64_t, mpctx->num_frame_stats);
+    int count = 0;
+    int64_t sum = 0;
+    for (int n = 0; n < mpctx->num_frame_stats; n++) {
+        struct frame_stat *st = &mpctx->frame_stats[n];
+        if (st->stage != stage || st->start_us < cutoff)
+            continue;
+        vals[count++] = st->duration_us;
+        sum += st->duration_us;
+    }
+    if (count) {
+        qsort(vals, count, sizeof(vals[0]), cmp_int64);
+        out->count = count;
+        out->avg = sum / (count * 1000.0);
+        out->p50 = vals[count / 2] / 1000.0;
+        out->p99 = vals[MPMIN(count * 99 / 100, count - 1)] / 1000.0;
+        out->max = vals[count - 1] / 1000.0;
+    }
+    talloc_free(vals);
+    return count > 0;
+}
+
+// One machine-readable line covering the last window seconds: per-stage
+// timing distributions plus audio buffer and cache fill levels.
+char *mp_perf_stats_format(void *talloc_ctx, struct MPContext *mpctx,
+                           double window)
+{
+    char *res = talloc_asprintf(talloc_ctx, "window=%.0fs", window);
+    for (int i = 0; i < FSTAT_COUNT; i++) {
+        struct frame_stat_summary sum;
+        if (!mp_frame_stat_summary(mpctx, i, window, &sum))
+            continue;
+        res = talloc_asprintf_append(res,
+                " %s:n=%d,avg=%.2f,p50=%.2f,p99=%.2f,max=%.2f",
+                mp_frame_stat_stage_name(i), sum.count, sum.avg, sum.p50,
+                sum.p99, sum.max);
+    }
+    int64_t cutoff = mp_time_us() - window * 1e6;
+    double a_sum = 0, a_min = 0, c_sum = 0, c_min = 0;
+    int a_count = 0, c_count = 0;
+    for (int n = 0; n < mpctx->num_load_stats; n++) {
+        struct load_stat *st = &mpctx->load_stats[n];
+        if (st->time_us < cutoff)
+            continue;
+        if (st->audio_buffer >= 0) {
+            a_min = a_count ? MPMIN(a_min, st->audio_buffer) : st->audio_buffer;
+            a_sum += st->audio_buffer;
+            a_count += 1;
+        }
+        if (st->cache_fill >= 0) {
+            c_min = c_count ? MPMIN(c_min, st->cache_fill) : st->cache_fill;
+            c_sum += st->cache_fill;
+            c_count += 1;
+        }
+    }
+    if (a_count) {
+        res = talloc_asprintf_append(res, " audio-buffer:n=%d,avg=%.3f,min=%.3f",
+                                     a_count, a_sum / a_count, a_min);
+    }
+    if (c_count) {
+        res = talloc_asprintf_append(res, " cache:n=%d,avg=%.1f,min=%.1f",
+                                     c_count, c_sum / c_count, c_min);
+    }
+    return res;
+}
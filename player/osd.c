@@ -41,19 +41,48 @@
 #include "core.h"
 #include "command.h"
 
-#define saddf(var, ...) (*(var) = talloc_asprintf_append((*var), __VA_ARGS__))
+// Append-buffer whose capacity is kept when it is reset, so strings that are
+// rebuilt every tick (status line, OSD text) stop causing allocator traffic.
+struct sbuf {
+    void *talloc_ctx;
+    char *text; // talloc'd under talloc_ctx, always 0-terminated
+    int len;
+};
+
+static void sbuf_reset(struct sbuf *b)
+{
+    b->len = 0;
+    MP_TARRAY_GROW(b->talloc_ctx, b->text, b->len);
+    b->text[0] = '\0';
+}
+
+static void saddf(struct sbuf *b, const char *fmt, ...) PRINTF_ATTRIBUTE(2, 3);
+static void saddf(struct sbuf *b, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0)
+        return;
+    MP_TARRAY_GROW(b->talloc_ctx, b->text, b->len + n);
+    va_start(ap, fmt);
+    vsnprintf(b->text + b->len, n + 1, fmt, ap);
+    va_end(ap);
+    b->len += n;
+}
 
 // append time in the hh:mm:ss format (plus fractions if wanted)
-static void sadd_hhmmssff(char **buf, double time, bool fractions)
+static void sadd_hhmmssff(struct sbuf *buf, double time, bool fractions)
 {
     char *s = mp_format_time(time, fractions);
-    *buf = talloc_strdup_append(*buf, s);
+    saddf(buf, "%s", s);
     talloc_free(s);
 }
 
-static void sadd_percentage(char **buf, int percent) {
+static void sadd_percentage(struct sbuf *buf, int percent) {
     if (percent >= 0)
-        *buf = talloc_asprintf_append(*buf, " (%d%%)", percent);
+        saddf(buf, " (%d%%)", percent);
 }
 
 static int get_term_width(void)
@@ -82,6 +111,22 @@ void write_status_line(struct MPContext *mpctx, const char *line)
     }
 }
 
+// Write the status line, unless it is identical to what is already on the
+// terminal. Identical lines are still refreshed once a second, in case some
+// other output has scrolled the old one away.
+static void write_changed_status_line(struct MPContext *mpctx,
+                                      const char *line, double now)
+{
+    if (mpctx->last_status_line &&
+        strcmp(line, mpctx->last_status_line) == 0 &&
+        now - mpctx->last_status_time < 1.0)
+        return;
+    write_status_line(mpctx, line);
+    talloc_free(mpctx->last_status_line);
+    mpctx->last_status_line = talloc_strdup(mpctx, line);
+    mpctx->last_status_time = now;
+}
+
 void print_status(struct MPContext *mpctx)
 {
     struct MPOpts *opts = mpctx->opts;
@@ -91,52 +136,61 @@ void print_status(struct MPContext *mpctx)
     if (opts->quiet)
         return;
 
+    // Building the line is not free either, so respect the refresh cap
+    // before doing anything.
+    double now = mp_time_sec();
+    if (opts->osd_refresh_rate > 0 &&
+        now - mpctx->last_status_time < 1.0 / opts->osd_refresh_rate)
+        return;
+
     if (opts->status_msg) {
-        char *r = mp_property_expand_string(mpctx, opts->status_msg);
-        write_status_line(mpctx, r);
-        talloc_free(r);
+        char *line = mp_property_expand_cached(mpctx,
+                &mpctx->status_msg_template, opts->status_msg);
+        write_changed_status_line(mpctx, line, now);
         return;
     }
 
-    char *line = NULL;
+    struct sbuf lbuf = {.talloc_ctx = mpctx, .text = mpctx->statusline};
+    struct sbuf *line = &lbuf;
+    sbuf_reset(line);
 
     // Playback status
     if (mpctx->paused_for_cache && !opts->pause) {
-        saddf(&line, "(Buffering) ");
+        saddf(line, "(Buffering) ");
     } else if (mpctx->paused) {
-        saddf(&line, "(Paused) ");
+        saddf(line, "(Paused) ");
     }
 
     if (mpctx->d_audio)
-        saddf(&line, "A");
+        saddf(line, "A");
     if (mpctx->d_video)
-        saddf(&line, "V");
-    saddf(&line, ": ");
+        saddf(line, "V");
+    saddf(line, ": ");
 
     // Playback position
     double cur = get_current_time(mpctx);
-    sadd_hhmmssff(&line, cur, mpctx->opts->osd_fractions);
+    sadd_hhmmssff(line, cur, mpctx->opts->osd_fractions);
 
     double len = get_time_length(mpctx);
     if (len >= 0) {
-        saddf(&line, " / ");
-        sadd_hhmmssff(&line, len, mpctx->opts->osd_fractions);
+        saddf(line, " / ");
+        sadd_hhmmssff(line, len, mpctx->opts->osd_fractions);
     }
 
-    sadd_percentage(&line, get_percent_pos(mpctx));
+    sadd_percentage(line, get_percent_pos(mpctx));
 
     // other
     if (opts->playback_speed != 1)
-        saddf(&line, " x%4.2f", opts->playback_speed);
+        saddf(line, " x%4.2f", opts->playback_speed);
 
     // A-V sync
     if (mpctx->d_audio && mpctx->d_video && mpctx->sync_audio_to_video) {
         if (mpctx->last_av_difference != MP_NOPTS_VALUE)
-            saddf(&line, " A-V:%7.3f", mpctx->last_av_difference);
+            saddf(line, " A-V:%7.3f", mpctx->last_av_difference);
         else
-            saddf(&line, " A-V: ???");
+            saddf(line, " A-V: ???");
         if (fabs(mpctx->total_avsync_change) > 0.05)
-            saddf(&line, " ct:%7.3f", mpctx->total_avsync_change);
+            saddf(line, " ct:%7.3f", mpctx->total_avsync_change);
     }
 
 #if HAVE_ENCODING
@@ -146,22 +200,22 @@ void print_status(struct MPContext *mpctx)
             position) >= 0)
     {
         // encoding stats
-        saddf(&line, " %s", lavcbuf);
+        saddf(line, " %s", lavcbuf);
     } else
 #endif
     {
         // VO stats
         if (mpctx->d_video && mpctx->drop_frame_cnt)
-            saddf(&line, " Late: %d", mpctx->drop_frame_cnt);
+            saddf(line, " Late: %d", mpctx->drop_frame_cnt);
     }
 
     int cache = mp_get_cache_percent(mpctx);
     if (cache >= 0)
-        saddf(&line, " Cache: %d%%", cache);
+        saddf(line, " Cache: %d%%", cache);
 
     // end
-    write_status_line(mpctx, line);
-    talloc_free(line);
+    write_changed_status_line(mpctx, line->text, now);
+    mpctx->statusline = line->text;
 }
 
 typedef struct mp_osd_msg mp_osd_msg_t;
@@ -301,6 +355,35 @@ static mp_osd_msg_t *get_osd_msg(struct MPContext *mpctx)
     return NULL;
 }
 
+// Earliest absolute time (as mp_time_sec()) at which the OSD contents will
+// change by themselves (message or bar expiry), or 0 if no such timer is
+// armed. The playloop uses this to sleep until the next deadline instead of
+// waking up on a fixed period.
+double osd_get_next_deadline(struct MPContext *mpctx)
+{
+    struct MPOpts *opts = mpctx->opts;
+    double deadline = 0;
+
+    if (mpctx->osd_visible)
+        deadline = mpctx->osd_visible;
+    if (mpctx->osd_function_visible) {
+        deadline = deadline ? MPMIN(deadline, mpctx->osd_function_visible)
+                            : mpctx->osd_function_visible;
+    }
+    // Expiry of the displayed message (get_osd_msg() decrements msg->time
+    // relative to osd_last_update on each OSD update).
+    for (mp_osd_msg_t *msg = mpctx->osd_msg_stack; msg; msg = msg->prev) {
+        if (msg->level <= opts->osd_level) {
+            double base = msg->started ? mpctx->osd_last_update
+                                       : mp_time_sec();
+            double t = base + msg->time;
+            deadline = deadline ? MPMIN(deadline, t) : t;
+            break;
+        }
+    }
+    return deadline;
+}
+
 // type: mp_osd_font_codepoints, ASCII, or OSD_BAR_*
 // name: fallback for terminal OSD
 void set_osd_bar(struct MPContext *mpctx, int type, const char *name,
@@ -386,14 +469,15 @@ void set_osd_subtitle(struct MPContext *mpctx, const char *text)
 }
 
 // sym == mpctx->osd_function
-static void saddf_osd_function_sym(char **buffer, int sym)
+static void saddf_osd_function_sym(struct sbuf *buffer, int sym)
 {
     char temp[10];
     osd_get_function_sym(temp, sizeof(temp), sym);
     saddf(buffer, "%s ", temp);
 }
 
-static void sadd_osd_status(char **buffer, struct MPContext *mpctx, bool full)
+static void sadd_osd_status(struct sbuf *buffer, struct MPContext *mpctx,
+                            bool full)
 {
     bool fractions = mpctx->opts->osd_fractions;
     int sym = mpctx->osd_function;
@@ -409,9 +493,9 @@ static void sadd_osd_status(char **buffer, struct MPContext *mpctx, bool full)
     saddf_osd_function_sym(buffer, sym);
     char *custom_msg = mpctx->opts->osd_status_msg;
     if (custom_msg && full) {
-        char *text = mp_property_expand_string(mpctx, custom_msg);
-        *buffer = talloc_strdup_append(*buffer, text);
-        talloc_free(text);
+        char *text = mp_property_expand_cached(mpctx,
+                &mpctx->osd_status_msg_template, custom_msg);
+        saddf(buffer, "%s", text);
     } else {
         sadd_hhmmssff(buffer, get_current_time(mpctx), fractions);
         if (full) {
@@ -487,6 +571,9 @@ void update_osd_msg(struct MPContext *mpctx)
                 write_status_line(mpctx, "");
                 MP_MSG(mpctx, MSGL_STATUS, "%s%s\n", opts->term_osd_esc,
                        mpctx->terminal_osd_text);
+                // The OSD text scrolled the status line away.
+                talloc_free(mpctx->last_status_line);
+                mpctx->last_status_line = NULL;
                 print_status(mpctx);
             }
         }
@@ -499,13 +586,21 @@ void update_osd_msg(struct MPContext *mpctx)
 
     if (mpctx->video_out && opts->term_osd != 1) {
         // fallback on the timer
-        char *text = NULL;
+        // osd_set_text() already drops unchanged text; the cap here avoids
+        // rebuilding the string (and expanding properties) at playloop rate.
+        double now = mp_time_sec();
+        if (opts->osd_refresh_rate > 0 &&
+            now - mpctx->last_osd_time < 1.0 / opts->osd_refresh_rate)
+            return;
+        mpctx->last_osd_time = now;
+
+        struct sbuf text = {0};
 
         if (osd_level >= 2)
             sadd_osd_status(&text, mpctx, osd_level == 3);
 
-        osd_set_text(osd, text);
-        talloc_free(text);
+        osd_set_text(osd, text.text);
+        talloc_free(text.text);
         return;
     }
 
@@ -44,6 +44,7 @@
 #include "stream/stream.h"
 #include "sub/osd.h"
 #include "video/filter/vf.h"
+#include "video/decode/vd.h"
 #include "video/decode/dec_video.h"
 #include "video/out/vo.h"
 
@@ -53,6 +54,11 @@
 
 #define WAKEUP_PERIOD 0.5
 
+// Maximum sleep when paused or idle and no timer is armed. Input and VO
+// window events interrupt the sleep through the input FD loop, so this only
+// bounds how long purely polled state (terminal size etc.) can go unchecked.
+#define WAKEUP_PERIOD_IDLE 8.0
+
 static const char av_desync_help_text[] =
 "\n\n"
 "           *************************************************\n"
@@ -269,7 +275,9 @@ static int mp_seek(MPContext *mpctx, struct seek_params seek,
         }
     }
     if (need_reset) {
-        reinit_video_chain(mpctx);
+        // Decoders kept alive by timeline_set_part() are already rebound.
+        if (!(mpctx->initialized_flags & INITIALIZED_VCODEC))
+            reinit_video_chain(mpctx);
         reinit_audio_chain(mpctx);
         reinit_subs(mpctx);
     }
@@ -292,7 +300,13 @@ static int mp_seek(MPContext *mpctx, struct seek_params seek,
 
     if (hr_seek)
         demuxer_amount -= hr_seek_offset;
+    // A newer queued seek command should abort this one at the next I/O
+    // boundary if it blocks on the network, instead of waiting behind it.
+    // queue_seek() coalesces the queued seeks, so only the final target
+    // is executed afterwards.
+    mp_input_set_abort_on_seek(mpctx->input, true);
     int seekresult = demux_seek(mpctx->demuxer, demuxer_amount, demuxer_style);
+    mp_input_set_abort_on_seek(mpctx->input, false);
     if (seekresult == 0) {
         if (need_reset)
             seek_reset(mpctx, !timeline_fallthrough);
@@ -669,6 +683,29 @@ static void handle_metadata_update(struct MPContext *mpctx)
     }
 }
 
+// Best-effort memory pressure handling: if the accounted memory exceeds
+// --memory-limit, drop caches that are rebuilt on demand (image pools).
+static void handle_memory_limit(struct MPContext *mpctx)
+{
+    struct MPOpts *opts = mpctx->opts;
+    if (opts->memory_limit <= 0)
+        return;
+    double now = mp_time_sec();
+    if (now < mpctx->last_memory_check + 2)
+        return;
+    mpctx->last_memory_check = now;
+    size_t total = talloc_total_size(mpctx);
+    if (total <= (size_t)opts->memory_limit * 1024 * 1024)
+        return;
+    MP_WARN(mpctx, "Memory usage (%zu KB) over --memory-limit, "
+            "dropping caches.\n", total / 1024);
+    if (mpctx->d_video) {
+        video_vd_control(mpctx->d_video, VDCTRL_TRIM_MEMORY, NULL);
+        if (mpctx->d_video->vfilter)
+            vf_trim_memory(mpctx->d_video->vfilter);
+    }
+}
+
 static void handle_pause_on_low_cache(struct MPContext *mpctx)
 {
     struct MPOpts *opts = mpctx->opts;
@@ -882,7 +919,7 @@ void handle_force_window(struct MPContext *mpctx, bool reconfig)
         // Pick whatever works
         int config_format = 0;
         for (int fmt = IMGFMT_START; fmt < IMGFMT_END; fmt++) {
-            if (vo->driver->query_format(vo, fmt)) {
+            if (vo_query_format(vo, fmt)) {
                 config_format = fmt;
                 break;
             }
@@ -920,6 +957,7 @@ static double timing_sleep(struct MPContext *mpctx, double time_frame)
 
 static double get_wakeup_period(struct MPContext *mpctx)
 {
+    struct MPOpts *opts = mpctx->opts;
     /* Even if we can immediately wake up in response to most input events,
      * there are some timers which are not registered to the event loop
      * and need to be checked periodically (like automatic mouse cursor hiding).
@@ -928,6 +966,25 @@ static double get_wakeup_period(struct MPContext *mpctx)
      */
     double sleeptime = WAKEUP_PERIOD;
 
+    if (mpctx->paused || !mpctx->demuxer) {
+        /* Nothing on the status line or OSD advances by itself while paused
+         * (or with no file loaded), so the fixed update cadence is wasted
+         * wakeups; sleep until the next timer that is actually armed. */
+        double now = mp_time_sec();
+        sleeptime = WAKEUP_PERIOD_IDLE;
+        if (mpctx->demuxer && mp_get_cache_percent(mpctx) >= 0) {
+            // Auto-(un)pausing on stream cache fill levels is polled.
+            sleeptime = MPMIN(sleeptime, WAKEUP_PERIOD);
+        }
+        double deadline = osd_get_next_deadline(mpctx);
+        if (deadline > 0)
+            sleeptime = MPCLAMP(deadline - now, 0, sleeptime);
+        if (mpctx->video_out && mpctx->mouse_cursor_visible
+            && opts->cursor_autohide_delay >= 0
+            && !(opts->cursor_autohide_fs && !opts->vo.fullscreen))
+            sleeptime = MPCLAMP(mpctx->mouse_timer - now, 0, sleeptime);
+    }
+
 #ifndef HAVE_POSIX_SELECT
     // No proper file descriptor event handling; keep waking up to poll input
     sleeptime = MPMIN(sleeptime, 0.02);
@@ -937,6 +994,12 @@ static double get_wakeup_period(struct MPContext *mpctx)
         if (mpctx->video_out->wakeup_period > 0)
             sleeptime = MPMIN(sleeptime, mpctx->video_out->wakeup_period);
 
+    if (opts->low_latency && !mpctx->paused) {
+        // With tiny device buffers, data must be moved through the chain
+        // promptly, or the sleep granularity becomes the latency floor.
+        sleeptime = MPMIN(sleeptime, 0.005);
+    }
+
     return sleeptime;
 }
 
@@ -1113,6 +1176,16 @@ void run_playloop(struct MPContext *mpctx)
         draw_osd(mpctx);
 
         mpctx->time_frame -= get_relative_time(mpctx);
+        if (!opts->untimed && !vo->untimed) {
+            // Align the display time with the VO's estimated vsync, so that
+            // frame changes don't race a vblank (which turns small timing
+            // errors into irregular frame cadence, e.g. broken 3:2 pulldown
+            // of 23.976 fps content on a 60 Hz display).
+            int64_t target_us = mpctx->last_time +
+                                MPMAX(mpctx->time_frame, -1) * 1e6;
+            int64_t vsync_us = vo_adjust_flip_time(vo, target_us);
+            mpctx->time_frame += (vsync_us - target_us) / 1e6;
+        }
         mpctx->time_frame -= vo->flip_queue_offset;
         if (mpctx->time_frame > 0.001)
             mpctx->time_frame = timing_sleep(mpctx, mpctx->time_frame);
@@ -1151,6 +1224,7 @@ void run_playloop(struct MPContext *mpctx)
         vo_flip_page(vo, pts_us | 1, duration);
 
         mpctx->last_vo_flip_duration = (mp_time_us() - t2) * 0.000001;
+        mp_record_frame_stat(mpctx, FSTAT_FLIP, mpctx->video_pts, t2);
         if (vo->driver->flip_page_timed) {
             // No need to adjust sync based on flip speed
             mpctx->last_vo_flip_duration = 0;
@@ -1191,6 +1265,8 @@ void run_playloop(struct MPContext *mpctx)
     if (mpctx->d_audio && buffered_audio == -1)
         buffered_audio = mpctx->paused ? 0 : ao_get_delay(mpctx->ao);
 
+    mp_record_load_stat(mpctx, buffered_audio);
+
     update_osd_msg(mpctx);
 
     // The cache status is part of the status line. Possibly update it.
@@ -1300,6 +1376,8 @@ void run_playloop(struct MPContext *mpctx)
 
     handle_pause_on_low_cache(mpctx);
 
+    handle_memory_limit(mpctx);
+
     handle_input_and_seek_coalesce(mpctx);
 
     handle_backstep(mpctx);
@@ -1308,6 +1386,8 @@ void run_playloop(struct MPContext *mpctx)
 
     handle_keep_open(mpctx);
 
+    mp_prefetch_next_file(mpctx);
+
     handle_force_window(mpctx, false);
 
     execute_queued_seek(mpctx);
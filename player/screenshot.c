@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "config.h"
 
@@ -31,11 +32,13 @@
 #include "bstr/bstr.h"
 #include "common/msg.h"
 #include "options/path.h"
+#include "video/img_format.h"
 #include "video/mp_image.h"
 #include "video/decode/dec_video.h"
 #include "video/filter/vf.h"
 #include "video/out/vo.h"
 #include "video/image_writer.h"
+#include "misc/thread_pool.h"
 #include "sub/osd.h"
 
 #include "video/csputils.h"
@@ -43,6 +46,11 @@
 #define MODE_FULL_WINDOW 1
 #define MODE_SUBTITLES 2
 
+// Maximum number of screenshots being converted/encoded in the background.
+// Queuing more than this blocks until the worker catches up, so each-frame
+// mode can't accumulate unbounded amounts of image data.
+#define MAX_PENDING_SCREENSHOTS 3
+
 typedef struct screenshot_ctx {
     struct MPContext *mpctx;
 
@@ -51,8 +59,23 @@ typedef struct screenshot_ctx {
     bool osd;
 
     int frameno;
+
+    // Conversion, encoding and writing run on this thread (created on
+    // first use), so taking a screenshot doesn't stall playback.
+    struct mp_thread_pool *worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    int num_pending;        // queued jobs not yet written (under lock)
 } screenshot_ctx;
 
+static void screenshot_ctx_destroy(void *p)
+{
+    screenshot_ctx *ctx = p;
+    talloc_free(ctx->worker);   // waits until all queued jobs are written
+    pthread_mutex_destroy(&ctx->lock);
+    pthread_cond_destroy(&ctx->wakeup);
+}
+
 void screenshot_init(struct MPContext *mpctx)
 {
     mpctx->screenshot_ctx = talloc(mpctx, screenshot_ctx);
@@ -60,6 +83,9 @@ void screenshot_init(struct MPContext *mpctx)
         .mpctx = mpctx,
         .frameno = 1,
     };
+    pthread_mutex_init(&mpctx->screenshot_ctx->lock, NULL);
+    pthread_cond_init(&mpctx->screenshot_ctx->wakeup, NULL);
+    talloc_set_destructor(mpctx->screenshot_ctx, screenshot_ctx_destroy);
 }
 
 #define SMSG_OK 0
@@ -292,6 +318,62 @@ static void add_subs(struct MPContext *mpctx, struct mp_image *image)
                       OSD_DRAW_SUB_ONLY, image);
 }
 
+struct screenshot_job {
+    screenshot_ctx *ctx;
+    struct mp_image *image;
+    struct image_writer_opts opts;
+    char *filename;
+};
+
+static void run_screenshot_save(void *p)
+{
+    struct screenshot_job *job = p;
+    screenshot_ctx *ctx = job->ctx;
+
+    if (!write_image(job->image, &job->opts, job->filename)) {
+        // Can't use screenshot_msg() - the OSD is owned by the playback
+        // thread. write_image() already printed the error details.
+        MP_ERR(ctx->mpctx, "Error writing screenshot!\n");
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->num_pending--;
+    pthread_cond_broadcast(&ctx->wakeup);
+    pthread_mutex_unlock(&ctx->lock);
+    talloc_free(job);
+}
+
+// Queue the image for conversion/encoding/writing on the worker thread.
+// Takes ownership of image.
+static void screenshot_save_async(screenshot_ctx *ctx, struct mp_image *image,
+                                  const struct image_writer_opts *opts,
+                                  const char *filename)
+{
+    // A single worker keeps files appearing in the order they were taken.
+    if (!ctx->worker)
+        ctx->worker = mp_thread_pool_create(ctx, 1);
+
+    struct screenshot_job *job = talloc_ptrtype(NULL, job);
+    *job = (struct screenshot_job) {
+        .ctx = ctx,
+        .image = talloc_steal(job, image),
+        .opts = *opts,
+        .filename = talloc_strdup(job, filename),
+    };
+    // The format string can point into caller-owned memory.
+    if (job->opts.format)
+        job->opts.format = talloc_strdup(job, job->opts.format);
+
+    pthread_mutex_lock(&ctx->lock);
+    while (ctx->num_pending >= MAX_PENDING_SCREENSHOTS)
+        pthread_cond_wait(&ctx->wakeup, &ctx->lock);
+    ctx->num_pending++;
+    pthread_mutex_unlock(&ctx->lock);
+
+    mp_thread_pool_queue(ctx->worker, run_screenshot_save, job);
+}
+
+// Takes ownership of image.
 static void screenshot_save(struct MPContext *mpctx, struct mp_image *image)
 {
     screenshot_ctx *ctx = mpctx->screenshot_ctx;
@@ -301,9 +383,10 @@ static void screenshot_save(struct MPContext *mpctx, struct mp_image *image)
     char *filename = gen_fname(ctx, image_writer_file_ext(opts));
     if (filename) {
         screenshot_msg(ctx, SMSG_OK, "Screenshot: '%s'", filename);
-        if (!write_image(image, opts, filename))
-            screenshot_msg(ctx, SMSG_ERR, "Error writing screenshot!");
+        screenshot_save_async(ctx, image, opts, filename);
         talloc_free(filename);
+    } else {
+        talloc_free(image);
     }
 }
 
@@ -324,6 +407,11 @@ static struct mp_image *screenshot_get(struct MPContext *mpctx, int mode)
             vo_control(mpctx->video_out, VOCTRL_SCREENSHOT, &args);
 
         image = args.out_image;
+        if (image && IMGFMT_IS_HWACCEL(image->imgfmt)) {
+            // The image writer can't read hardware surfaces; the VO should
+            // have handed out a downloaded copy (see gl_hwdec download_image).
+            mp_image_unrefp(&image);
+        }
         if (image) {
             if (mode == MODE_SUBTITLES && !args.has_osd)
                 add_subs(mpctx, image);
@@ -354,9 +442,7 @@ void screenshot_to_file(struct MPContext *mpctx, const char *filename, int mode,
         goto end;
     }
     screenshot_msg(ctx, SMSG_OK, "Screenshot: '%s'", filename);
-    if (!write_image(image, &opts, filename))
-        screenshot_msg(ctx, SMSG_ERR, "Error writing screenshot!");
-    talloc_free(image);
+    screenshot_save_async(ctx, image, &opts, filename);
 
 end:
     ctx->osd = old_osd;
@@ -388,8 +474,6 @@ void screenshot_request(struct MPContext *mpctx, int mode, bool each_frame,
     } else {
         screenshot_msg(ctx, SMSG_ERR, "Taking screenshot failed.");
     }
-
-    talloc_free(image);
 }
 
 void screenshot_flip(struct MPContext *mpctx)
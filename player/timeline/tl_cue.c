@@ -21,11 +21,14 @@
 #include <stdbool.h>
 #include <inttypes.h>
 #include <ctype.h>
+#include <pthread.h>
 
 #include "talloc.h"
 
 #include "player/core.h"
+#include "common/global.h"
 #include "common/msg.h"
+#include "misc/thread_pool.h"
 #include "demux/demux.h"
 #include "options/path.h"
 #include "bstr/bstr.h"
@@ -178,7 +181,7 @@ static void add_source(struct MPContext *mpctx, struct demuxer *d)
     MP_TARRAY_APPEND(NULL, mpctx->sources, mpctx->num_sources, d);
 }
 
-static bool try_open(struct MPContext *mpctx, char *filename)
+static struct demuxer *try_open(struct MPContext *mpctx, char *filename)
 {
     struct bstr bfilename = bstr0(filename);
     // Avoid trying to open itself or another .cue file. Best would be
@@ -186,11 +189,11 @@ static bool try_open(struct MPContext *mpctx, char *filename)
     // API doesn't allow this without opening a full demuxer.
     if (bstr_case_endswith(bfilename, bstr0(".cue"))
         || bstrcasecmp(bstr0(mpctx->demuxer->filename), bfilename) == 0)
-        return false;
+        return NULL;
 
     struct stream *s = stream_open(filename, mpctx->opts);
     if (!s)
-        return false;
+        return NULL;
     struct demuxer *d = demux_open(s, NULL, NULL, mpctx->opts);
     // Since .bin files are raw PCM data with no headers, we have to explicitly
     // open them. Also, try to avoid to open files that are most likely not .bin
@@ -202,19 +205,20 @@ static bool try_open(struct MPContext *mpctx, char *filename)
         mp_msg(MSGT_CPLAYER, MSGL_WARN, "CUE: Opening as BIN file!\n");
         d = demux_open(s, "rawaudio", NULL, mpctx->opts);
     }
-    if (d) {
-        add_source(mpctx, d);
-        return true;
-    }
+    if (d)
+        return d;
     mp_msg(MSGT_CPLAYER, MSGL_ERR, "Could not open source '%s'!\n", filename);
     free_stream(s);
-    return false;
+    return NULL;
 }
 
-static bool open_source(struct MPContext *mpctx, struct bstr filename)
+// Open the demuxer for the given file referenced by the CUE sheet. Does not
+// touch mpctx state other than reading it, so it is safe to run several of
+// these in parallel for different files.
+static struct demuxer *open_source(struct MPContext *mpctx, struct bstr filename)
 {
     void *ctx = talloc_new(NULL);
-    bool res = false;
+    struct demuxer *res = NULL;
 
     struct bstr dirname = mp_dirname(mpctx->demuxer->filename);
 
@@ -224,10 +228,9 @@ static bool open_source(struct MPContext *mpctx, struct bstr filename)
                "CUE: Invalid audio filename in .cue file!\n");
     } else {
         char *fullname = mp_path_join(ctx, dirname, base_filename);
-        if (try_open(mpctx, fullname)) {
-            res = true;
+        res = try_open(mpctx, fullname);
+        if (res)
             goto out;
-        }
     }
 
     // Try an audio file with the same name as the .cue file (but different
@@ -249,10 +252,9 @@ static bool open_source(struct MPContext *mpctx, struct bstr filename)
             mp_msg(MSGT_CPLAYER, MSGL_WARN, "CUE: No useful audio filename "
                     "in .cue file found, trying with '%s' instead!\n",
                     dename0);
-            if (try_open(mpctx, mp_path_join(ctx, dirname, dename))) {
-                res = true;
+            res = try_open(mpctx, mp_path_join(ctx, dirname, dename));
+            if (res)
                 break;
-            }
         }
     }
     closedir(d);
@@ -264,6 +266,67 @@ out:
     return res;
 }
 
+struct open_source_job {
+    struct MPContext *mpctx;
+    struct bstr filename;
+    struct demuxer *result;
+    pthread_mutex_t *lock;
+    pthread_cond_t *wakeup;
+    int *remaining;
+};
+
+static void open_source_job(void *ptr)
+{
+    struct open_source_job *job = ptr;
+    struct demuxer *d = open_source(job->mpctx, job->filename);
+    pthread_mutex_lock(job->lock);
+    job->result = d;
+    *job->remaining -= 1;
+    pthread_cond_broadcast(job->wakeup);
+    pthread_mutex_unlock(job->lock);
+}
+
+// Open all files in the given (deduplicated) list. Results are returned in
+// list order; failed entries are NULL. With one file per track - common for
+// per-track FLAC rips - opening everything serially takes seconds, so the
+// opens are spread over the worker threads when possible.
+static void open_sources(struct MPContext *mpctx, struct bstr *files,
+                         size_t file_count, struct demuxer **results)
+{
+    struct mp_thread_pool *pool = mpctx->global->thread_pool;
+    if (file_count > 1 && pool) {
+        pthread_mutex_t lock;
+        pthread_cond_t wakeup;
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&wakeup, NULL);
+        int remaining = file_count;
+        struct open_source_job *jobs =
+            talloc_array_ptrtype(NULL, jobs, file_count);
+        for (size_t i = 0; i < file_count; i++) {
+            jobs[i] = (struct open_source_job) {
+                .mpctx = mpctx,
+                .filename = files[i],
+                .lock = &lock,
+                .wakeup = &wakeup,
+                .remaining = &remaining,
+            };
+            mp_thread_pool_queue(pool, open_source_job, &jobs[i]);
+        }
+        pthread_mutex_lock(&lock);
+        while (remaining)
+            pthread_cond_wait(&wakeup, &lock);
+        pthread_mutex_unlock(&lock);
+        for (size_t i = 0; i < file_count; i++)
+            results[i] = jobs[i].result;
+        talloc_free(jobs);
+        pthread_cond_destroy(&wakeup);
+        pthread_mutex_destroy(&lock);
+    } else {
+        for (size_t i = 0; i < file_count; i++)
+            results[i] = open_source(mpctx, files[i]);
+    }
+}
+
 // return length of the source in seconds, or -1 if unknown
 static double source_get_length(struct demuxer *demuxer)
 {
@@ -356,9 +419,25 @@ void build_cue_timeline(struct MPContext *mpctx)
         }
     }
 
+    struct demuxer **file_demuxers =
+        talloc_zero_array(ctx, struct demuxer *, file_count);
+    open_sources(mpctx, files, file_count, file_demuxers);
     for (size_t i = 0; i < file_count; i++) {
-        if (!open_source(mpctx, files[i]))
+        if (!file_demuxers[i]) {
+            // Sources already added are cleaned up by the caller; free the
+            // rest, which nothing references yet.
+            for (size_t k = 0; k < file_count; k++) {
+                if (k >= i && file_demuxers[k]) {
+                    struct stream *str = file_demuxers[k]->stream;
+                    free_demuxer(file_demuxers[k]);
+                    free_stream(str);
+                }
+            }
             goto out;
+        }
+        // Keep the sources in list order, so that 1 + track->source indexes
+        // mpctx->sources correctly below.
+        add_source(mpctx, file_demuxers[i]);
     }
 
     struct timeline_part *timeline = talloc_array_ptrtype(NULL, timeline,
@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <assert.h>
 #include <dirent.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -31,7 +32,9 @@
 #include "talloc.h"
 
 #include "player/core.h"
+#include "common/global.h"
 #include "common/msg.h"
+#include "misc/thread_pool.h"
 #include "demux/demux.h"
 #include "options/path.h"
 #include "bstr/bstr.h"
@@ -162,27 +165,15 @@ static bool has_source_request(struct matroska_segment_uid *uids,
     return false;
 }
 
-// segment = get Nth segment of a multi-segment file
-static bool check_file_seg(struct MPContext *mpctx, struct demuxer ***sources,
-                           int *num_sources, struct matroska_segment_uid **uids,
-                           char *filename, int segment)
+// Try to match an opened demuxer against the missing sources. On a match,
+// the demuxer is adopted into *sources (possibly reopened with a cache) and
+// true is returned; otherwise it is freed together with its stream.
+// Must run on the main thread, since it modifies *sources and *uids.
+static bool integrate_source(struct MPContext *mpctx,
+                             struct demuxer ***sources, int *num_sources,
+                             struct matroska_segment_uid **uids,
+                             struct stream *s, struct demuxer *d, int segment)
 {
-    bool was_valid = false;
-    struct demuxer_params params = {
-        .matroska_num_wanted_uids = *num_sources,
-        .matroska_wanted_uids = *uids,
-        .matroska_wanted_segment = segment,
-        .matroska_was_valid = &was_valid,
-    };
-    struct stream *s = stream_open(filename, mpctx->opts);
-    if (!s)
-        return false;
-    struct demuxer *d = demux_open(s, "mkv", &params, mpctx->opts);
-
-    if (!d) {
-        free_stream(s);
-        return was_valid;
-    }
     if (d->type == DEMUXER_TYPE_MATROSKA) {
         struct matroska_data *m = &d->matroska_data;
 
@@ -214,17 +205,68 @@ static bool check_file_seg(struct MPContext *mpctx, struct demuxer ***sources,
                     MP_TARRAY_APPEND(NULL, *sources, *num_sources, NULL);
                 }
 
+                bool was_valid = false;
+                struct demuxer_params params = {
+                    .matroska_num_wanted_uids = *num_sources,
+                    .matroska_wanted_uids = *uids,
+                    .matroska_wanted_segment = segment,
+                    .matroska_was_valid = &was_valid,
+                };
                 if (enable_cache(mpctx, &s, &d, &params) < 0)
                     continue;
 
                 (*sources)[i] = d;
+
+                /* A single demuxer can satisfy several source slots (the
+                 * same segment requested with different edition values).
+                 * Share the instance instead of opening the file again for
+                 * each slot. uninit detects the duplicated pointers and
+                 * frees each instance only once. */
+                struct matroska_data *dm = &d->matroska_data;
+                for (int k = i + 1; k < *num_sources; k++) {
+                    struct matroska_segment_uid *uid2 = *uids + k;
+                    if ((*sources)[k])
+                        continue;
+                    if (!memcmp(uid2->segment, dm->uid.segment, 16) &&
+                        (!uid2->edition || uid2->edition == dm->uid.edition))
+                    {
+                        mp_msg(MSGT_CPLAYER, MSGL_INFO, "Source %d shares the "
+                               "demuxer of source %d.\n", k, i);
+                        (*sources)[k] = d;
+                    }
+                }
                 return true;
             }
         }
     }
     free_demuxer(d);
     free_stream(s);
-    return was_valid;
+    return false;
+}
+
+// segment = get Nth segment of a multi-segment file
+static bool check_file_seg(struct MPContext *mpctx, struct demuxer ***sources,
+                           int *num_sources, struct matroska_segment_uid **uids,
+                           char *filename, int segment)
+{
+    bool was_valid = false;
+    struct demuxer_params params = {
+        .matroska_num_wanted_uids = *num_sources,
+        .matroska_wanted_uids = *uids,
+        .matroska_wanted_segment = segment,
+        .matroska_was_valid = &was_valid,
+    };
+    struct stream *s = stream_open(filename, mpctx->opts);
+    if (!s)
+        return false;
+    struct demuxer *d = demux_open(s, "mkv", &params, mpctx->opts);
+
+    if (!d) {
+        free_stream(s);
+        return was_valid;
+    }
+    return integrate_source(mpctx, sources, num_sources, uids, s, d, segment)
+           || was_valid;
 }
 
 static void check_file(struct MPContext *mpctx, struct demuxer ***sources,
@@ -247,6 +289,126 @@ static bool missing(struct demuxer **sources, int num_sources)
     return false;
 }
 
+// Parallel variant of the directory scan: candidate files are opened and
+// header-parsed on the shared worker pool against a snapshot of the wanted
+// uids, while the main thread integrates finished candidates (it alone may
+// modify *sources and *uids). With many files on slow storage, opening them
+// is by far the dominant cost of starting ordered chapter playback.
+
+struct scan_result {
+    struct stream *s;
+    struct demuxer *d;
+    int segment;
+};
+
+struct scan_state {
+    struct MPOpts *opts;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    // --- the following fields are protected by lock
+    bool stop;              // all sources were resolved; workers should bail
+    int jobs_left;
+    struct scan_result *results;
+    int num_results;
+};
+
+struct scan_job {
+    struct scan_state *st;
+    char *filename;
+    // Private snapshot of the wanted uids at queue time. Candidates matching
+    // uids added later are picked up by the next scan pass.
+    struct matroska_segment_uid *uids;
+    int num_uids;
+};
+
+static void scan_file_job(void *arg)
+{
+    struct scan_job *job = arg;
+    struct scan_state *st = job->st;
+
+    mp_msg(MSGT_CPLAYER, MSGL_INFO, "Checking file %s\n", job->filename);
+
+    for (int segment = 0; ; segment++) {
+        pthread_mutex_lock(&st->lock);
+        bool stop = st->stop;
+        pthread_mutex_unlock(&st->lock);
+        if (stop)
+            break;
+
+        bool was_valid = false;
+        struct demuxer_params params = {
+            .matroska_num_wanted_uids = job->num_uids,
+            .matroska_wanted_uids = job->uids,
+            .matroska_wanted_segment = segment,
+            .matroska_was_valid = &was_valid,
+        };
+        struct stream *s = stream_open(job->filename, st->opts);
+        if (!s)
+            break;
+        struct demuxer *d = demux_open(s, "mkv", &params, st->opts);
+        if (d) {
+            pthread_mutex_lock(&st->lock);
+            struct scan_result r = {s, d, segment};
+            MP_TARRAY_APPEND(st, st->results, st->num_results, r);
+            pthread_cond_signal(&st->wakeup);
+            pthread_mutex_unlock(&st->lock);
+        } else {
+            free_stream(s);
+            if (!was_valid)
+                break;
+        }
+    }
+
+    pthread_mutex_lock(&st->lock);
+    st->jobs_left -= 1;
+    pthread_cond_signal(&st->wakeup);
+    pthread_mutex_unlock(&st->lock);
+}
+
+static void check_files_parallel(struct MPContext *mpctx,
+                                 struct demuxer ***sources, int *num_sources,
+                                 struct matroska_segment_uid **uids,
+                                 char **filenames, int num_filenames)
+{
+    struct mp_thread_pool *pool = mpctx->global->thread_pool;
+    struct scan_state *st = talloc_zero(NULL, struct scan_state);
+    pthread_mutex_init(&st->lock, NULL);
+    pthread_cond_init(&st->wakeup, NULL);
+    st->opts = mpctx->opts;
+    st->jobs_left = num_filenames;
+
+    for (int i = 0; i < num_filenames; i++) {
+        struct scan_job *job = talloc_zero(st, struct scan_job);
+        job->st = st;
+        job->filename = filenames[i];
+        job->num_uids = *num_sources;
+        job->uids = talloc_memdup(job, *uids, job->num_uids * sizeof(**uids));
+        mp_thread_pool_queue(pool, scan_file_job, job);
+    }
+
+    pthread_mutex_lock(&st->lock);
+    while (1) {
+        if (st->num_results) {
+            struct scan_result r = st->results[--st->num_results];
+            pthread_mutex_unlock(&st->lock);
+            integrate_source(mpctx, sources, num_sources, uids,
+                             r.s, r.d, r.segment);
+            pthread_mutex_lock(&st->lock);
+            if (!missing(*sources, *num_sources))
+                st->stop = true;
+        } else if (st->jobs_left) {
+            pthread_cond_wait(&st->wakeup, &st->lock);
+        } else {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&st->lock);
+
+    pthread_mutex_destroy(&st->lock);
+    pthread_cond_destroy(&st->wakeup);
+    talloc_free(st);
+}
+
 static int find_ordered_chapter_sources(struct MPContext *mpctx,
                                         struct demuxer ***sources,
                                         int *num_sources,
@@ -285,11 +447,19 @@ static int find_ordered_chapter_sources(struct MPContext *mpctx,
     int old_source_count;
     do {
         old_source_count = *num_sources;
-        for (int i = 0; i < num_filenames; i++) {
-            if (!missing(*sources, *num_sources))
-                break;
-            mp_msg(MSGT_CPLAYER, MSGL_INFO, "Checking file %s\n", filenames[i]);
-            check_file(mpctx, sources, num_sources, uids, filenames[i], 0);
+        if (!missing(*sources, *num_sources))
+            break;
+        if (mpctx->global->thread_pool && num_filenames > 1) {
+            check_files_parallel(mpctx, sources, num_sources, uids,
+                                 filenames, num_filenames);
+        } else {
+            for (int i = 0; i < num_filenames; i++) {
+                if (!missing(*sources, *num_sources))
+                    break;
+                mp_msg(MSGT_CPLAYER, MSGL_INFO, "Checking file %s\n",
+                       filenames[i]);
+                check_file(mpctx, sources, num_sources, uids, filenames[i], 0);
+            }
         }
     /* Loop while we have new sources to look for. */
     } while (old_source_count != *num_sources);
@@ -26,6 +26,7 @@
 #include "talloc.h"
 
 #include "common/msg.h"
+#include "osdep/timer.h"
 #include "options/options.h"
 #include "common/common.h"
 #include "common/encode.h"
@@ -57,7 +58,7 @@ static void set_allowed_vo_formats(struct vf_chain *c, struct vo *vo)
 {
     for (int fmt = IMGFMT_START; fmt < IMGFMT_END; fmt++) {
         c->allowed_output_formats[fmt - IMGFMT_START] =
-            vo->driver->query_format(vo, fmt);
+            vo_query_format(vo, fmt);
     }
 }
 
@@ -131,6 +132,72 @@ int reinit_video_filters(struct MPContext *mpctx)
     return d_video->vfilter && d_video->vfilter->initialized > 0 ? 0 : -1;
 }
 
+struct parked_video_dec {
+    struct dec_video *d_video;
+    struct bstr id; // codec configuration the decoder was opened with
+};
+
+void discard_parked_video_decoder(struct MPContext *mpctx)
+{
+    struct parked_video_dec *parked = mpctx->parked_video_dec;
+    if (!parked)
+        return;
+    mpctx->parked_video_dec = NULL;
+    video_uninit(parked->d_video);
+    talloc_free(parked);
+}
+
+// Keep a fully initialized decoder alive after its stream goes away, so the
+// next file can take it over if it uses the same codec configuration.
+// Reopening e.g. an H.264 context with frame threads costs tens of ms per
+// playlist transition, while flushing the old context is nearly free.
+void park_video_decoder(struct MPContext *mpctx)
+{
+    struct dec_video *d_video = mpctx->d_video;
+    bool reusable = d_video->vd_driver && d_video->header &&
+                    video_vd_control(d_video, VDCTRL_QUERY_REUSABLE, NULL)
+                        == CONTROL_TRUE;
+    if (!reusable) {
+        video_uninit(d_video);
+        return;
+    }
+    discard_parked_video_decoder(mpctx);
+    video_reset_decoding(d_video);
+    vf_destroy(d_video->vfilter);
+    d_video->vfilter = NULL;
+    d_video->decoder_output = (struct mp_image_params){0};
+    d_video->vf_input = (struct mp_image_params){0};
+    struct parked_video_dec *parked = talloc(NULL, struct parked_video_dec);
+    parked->d_video = d_video;
+    parked->id = video_decoder_id(parked, d_video->header);
+    // The header is owned by the demuxer, which is about to be destroyed.
+    d_video->header = NULL;
+    d_video->vo = NULL;
+    mpctx->parked_video_dec = parked;
+}
+
+// Return the parked decoder if it matches the given stream, or NULL. Either
+// way the parked slot is emptied.
+static struct dec_video *claim_parked_video_decoder(struct MPContext *mpctx,
+                                                    struct sh_stream *sh)
+{
+    struct parked_video_dec *parked = mpctx->parked_video_dec;
+    if (!parked)
+        return NULL;
+    struct dec_video *d_video = NULL;
+    struct bstr id = video_decoder_id(NULL, sh);
+    if (bstr_equals(id, parked->id)) {
+        MP_VERBOSE(mpctx, "Reusing the previous video decoder.\n");
+        d_video = parked->d_video;
+        mpctx->parked_video_dec = NULL;
+        talloc_free(parked);
+    } else {
+        discard_parked_video_decoder(mpctx);
+    }
+    talloc_free(id.start);
+    return d_video;
+}
+
 int reinit_video_chain(struct MPContext *mpctx)
 {
     struct MPOpts *opts = mpctx->opts;
@@ -162,7 +229,10 @@ int reinit_video_chain(struct MPContext *mpctx)
 
     update_window_title(mpctx, true);
 
-    struct dec_video *d_video = talloc_zero(NULL, struct dec_video);
+    struct dec_video *d_video = claim_parked_video_decoder(mpctx, sh);
+    bool reused_decoder = !!d_video;
+    if (!d_video)
+        d_video = talloc_zero(NULL, struct dec_video);
     mpctx->d_video = d_video;
     d_video->opts = mpctx->opts;
     d_video->header = sh;
@@ -178,8 +248,13 @@ int reinit_video_chain(struct MPContext *mpctx)
 
     recreate_video_filters(mpctx);
 
-    if (!video_init_best_codec(d_video, opts->video_decoders))
+    if (reused_decoder) {
+        // Flush instead of reopening; the codec configuration matches.
+        video_reset_decoding(d_video);
+        d_video->has_broken_packet_pts = -10; // needs 10 packets to reach decision
+    } else if (!video_init_best_codec(d_video, opts->video_decoders)) {
         goto err_out;
+    }
 
     bool saver_state = opts->pause || !opts->stop_screensaver;
     vo_control(mpctx->video_out, saver_state ? VOCTRL_RESTORE_SCREENSAVER
@@ -238,8 +313,11 @@ static bool filter_output_queued_frame(struct MPContext *mpctx)
     struct vo *video_out = mpctx->video_out;
 
     struct mp_image *img = vf_output_queued_frame(d_video->vfilter);
-    if (img)
+    if (img) {
+        int64_t t = mp_time_us();
         vo_queue_image(video_out, img);
+        mp_record_frame_stat(mpctx, FSTAT_DRAW, img->pts, t);
+    }
     talloc_free(img);
 
     return !!img;
@@ -332,9 +410,24 @@ static int check_framedrop(struct MPContext *mpctx, double frame_time)
             && !mpctx->restart_playback) {
             mpctx->drop_frame_cnt++;
             mpctx->dropped_frames++;
+            // Engage the decode-side skip policy only on sustained lateness,
+            // so a single slow frame doesn't cause preemptive drops.
+            if (mpctx->dropped_frames >= 3)
+                mpctx->framedrop_engaged = true;
+            mpctx->ontime_frame_cnt = 0;
             return mpctx->opts->frame_dropping;
-        } else
-            mpctx->dropped_frames = 0;
+        }
+        mpctx->dropped_frames = 0;
+        if (mpctx->framedrop_engaged) {
+            // Hysteresis: keep skipping cheap (non-reference) frames until
+            // playback has been on schedule for a while, instead of
+            // oscillating between full decode and emergency drops.
+            if (++mpctx->ontime_frame_cnt >= 30) {
+                mpctx->framedrop_engaged = false;
+            } else if (mpctx->opts->frame_dropping) {
+                return 1;
+            }
+        }
     }
     return 0;
 }
@@ -365,7 +458,20 @@ double update_video(struct MPContext *mpctx, double endpts)
         return update_video_attached_pic(mpctx);
 
     if (load_next_vo_frame(mpctx, false)) {
-        // Use currently queued VO frame
+        // Use currently queued VO frame. Keep the decoder's frame threads
+        // busy meanwhile by decoding ahead into the decoder frame queue.
+        while (!mpctx->opts->low_latency && !mpctx->hrseek_active &&
+               !d_video->waiting_decoded_mpi &&
+               d_video->num_queued_frames < VD_DECODE_AHEAD)
+        {
+            struct demux_packet *pkt = demux_read_packet(d_video->header);
+            if (!pkt)
+                break;
+            if (pkt->pts != MP_NOPTS_VALUE)
+                pkt->pts += mpctx->video_offset;
+            video_decode_ahead(d_video, pkt);
+            talloc_free(pkt);
+        }
     } else if (d_video->waiting_decoded_mpi) {
         // Draining on reconfig
         if (!load_next_vo_frame(mpctx, true))
@@ -380,13 +486,34 @@ double update_video(struct MPContext *mpctx, double endpts)
         {
             mpctx->hrseek_framedrop = false;
         }
+        // Frames decoded while converging to the seek target are never
+        // displayed; flag 4 additionally lets the decoder skip loop
+        // filtering and non-reference IDCT until the target is near.
         int framedrop_type = mpctx->hrseek_active && mpctx->hrseek_framedrop ?
-                             1 : check_framedrop(mpctx, -1);
+                             1 | 4 : check_framedrop(mpctx, -1);
+        int64_t t = mp_time_us();
         struct mp_image *decoded_frame =
             video_decode(d_video, pkt, framedrop_type);
         talloc_free(pkt);
         if (decoded_frame) {
-            filter_video(mpctx, decoded_frame, false);
+            double frame_pts = decoded_frame->pts;
+            mp_record_frame_stat(mpctx, FSTAT_DECODE, frame_pts, t);
+            // When severely behind, a decoded frame can't reach the screen
+            // before its deadline anyway, so don't spend the filter chain
+            // on it. (The decoder had to produce it regardless - it may be
+            // a reference frame.)
+            bool hopeless = framedrop_type && mpctx->opts->frame_dropping &&
+                mpctx->d_audio && !mpctx->ao->untimed &&
+                mpctx->opts->playback_speed * ao_get_delay(mpctx->ao)
+                    - mpctx->delay < -0.200;
+            if (hopeless) {
+                mpctx->drop_frame_cnt++;
+                mp_image_unrefp(&decoded_frame);
+            } else {
+                t = mp_time_us();
+                filter_video(mpctx, decoded_frame, false);
+                mp_record_frame_stat(mpctx, FSTAT_FILTER, frame_pts, t);
+            }
         } else if (!pkt) {
             if (!load_next_vo_frame(mpctx, true))
                 return -1;
@@ -87,13 +87,17 @@ int ai_oss_init(audio_in_t *ai)
     int err;
     int ioctl_param;
 
-    ai->oss.audio_fd = open(ai->oss.device, O_RDONLY | O_CLOEXEC);
+    /* Open non-blocking so a busy device fails right away instead of
+     * stalling capture startup; reads should still block normally. */
+    ai->oss.audio_fd = open(ai->oss.device, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
     if (ai->oss.audio_fd < 0)
     {
 	mp_msg(MSGT_TV, MSGL_ERR, "Unable to open '%s': %s\n",
 	       ai->oss.device, strerror(errno));
 	return -1;
     }
+    fcntl(ai->oss.audio_fd, F_SETFL,
+	  fcntl(ai->oss.audio_fd, F_GETFL) & ~O_NONBLOCK);
 
     ioctl_param = 0 ;
     mp_msg(MSGT_TV, MSGL_V, "ioctl dsp getfmt: %d\n",
@@ -33,6 +33,22 @@
 // the cache is active.
 #define CACHE_UPDATE_CONTROLS_TIME 2.0
 
+// Parameters of the adaptive readahead controller. Rates are measured over
+// windows of CACHE_RATE_WINDOW seconds, reads from the source stream are
+// sized to about CACHE_CHUNK_SECONDS of its measured throughput, and
+// readahead stops once CACHE_READAHEAD_SECONDS of data (at the measured
+// consumption rate) are buffered.
+#define CACHE_RATE_WINDOW 1.0
+#define CACHE_CHUNK_SECONDS 0.25
+#define CACHE_READAHEAD_SECONDS 10.0
+
+// Burst mode (--cache-burst): instead of topping the buffer off with many
+// small reads, fill up to the readahead target, then leave the network
+// completely idle until only CACHE_BURST_LOW_SECONDS of data (at the measured
+// consumption rate) remain. The long idle periods let cellular modems drop
+// their radio into low power states.
+#define CACHE_BURST_LOW_SECONDS 4.0
+
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,6 +56,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <assert.h>
 #include <pthread.h>
 #include <time.h>
@@ -52,10 +69,13 @@
 #include "osdep/timer.h"
 #include "osdep/threads.h"
 
+#include "compat/atomics.h"
+
 #include "common/msg.h"
 
 #include "stream.h"
 #include "common/common.h"
+#include "options/options.h"
 
 
 // Note: (struct priv*)(cache->priv)->cache == cache
@@ -71,6 +91,7 @@ struct priv {
     int64_t back_size;      // keep back_size amount of old bytes for backward seek
     int64_t fill_limit;     // we should fill buffer only if space>=fill_limit
     int64_t seek_limit;     // keep filling cache if distance is less that seek limit
+    bool burst_mode;        // fill in bursts, sleep the network in between
     struct byte_meta *bm;   // additional per-byte metadata
 
     // Owned by the main thread
@@ -79,18 +100,49 @@ struct priv {
     // Owned by the cache thread
     stream_t *stream;       // "real" stream, used to read from the source media
 
+    // Disk tier (owned by the cache thread): data evicted from the ring is
+    // appended to a temp file, and read back instead of the source stream
+    // when the client seeks into a range that is still on disk.
+    FILE *disk_file;        // backing temp file (NULL if disabled)
+    int disk_fd;            // fd of disk_file, used for actual I/O
+    int64_t disk_max_size;  // maximum number of bytes to spill
+    int64_t disk_used;      // bytes appended to the temp file so far
+    bool disk_full;         // disk_max_size reached (stops spilling)
+    struct disk_segment *disk_segments;
+    int num_disk_segments;
+
     // All the following members are shared between the threads.
-    // You must lock the mutex to access them.
+    // You must lock the mutex to access them, with the following exception:
+    // the ringbuffer position fields below are also accessed by the lock-free
+    // read fast path (cache_read_nolock()), and thus must always be accessed
+    // with cache_load64()/cache_store64(), even when the mutex is held.
 
     // Ringbuffer
     int64_t min_filepos;    // range of file that is cached in the buffer
     int64_t max_filepos;    // ... max_filepos being the last read position
     bool eof;               // true if max_filepos = EOF
     int64_t offset;         // buffer[offset] correponds to max_filepos
+    // Seqlock generation for the window fields above: odd while
+    // cache_drop_contents() rewrites them (the only non-monotonic update).
+    // The lock-free readers discard anything observed under an odd or
+    // changed generation.
+    int64_t window_gen;
 
     bool idle;              // cache thread has stopped reading
     int64_t reads;          // number of actual read attempts performed
 
+    // Adaptive readahead state. Updated by the cache thread with the mutex
+    // held; producer_rate/consumer_rate are also read by the main thread.
+    double rate_window_start;   // start time of the measurement window
+    int64_t rate_start_max;     // max_filepos at window start
+    int64_t rate_start_read;    // read_filepos at window start
+    double producer_rate;       // source throughput in bytes/sec (0 unknown)
+    double consumer_rate;       // client consumption in bytes/sec (0 unknown)
+    int64_t read_chunk;         // current size of source stream reads
+    int64_t readahead_target;   // max bytes to buffer beyond read_filepos
+    int64_t low_watermark;      // burst mode: resume filling below this
+    bool net_sleeping;          // burst mode: draining, network left idle
+
     int64_t read_filepos;   // client read position (mirrors cache->pos)
     int control;            // requested STREAM_CTRL_... or CACHE_CTRL_...
     void *control_arg;      // temporary for executing STREAM_CTRLs
@@ -114,6 +166,14 @@ struct byte_meta {
     float stream_pts;
 };
 
+// A byte range of the source stream spilled to the disk tier. The temp file
+// is append-only; spills contiguous with the last segment are merged into it,
+// so the segment list stays short even with many small evictions.
+struct disk_segment {
+    int64_t start, len;     // stream byte range [start, start + len)
+    int64_t file_pos;       // position of the data in the temp file
+};
+
 enum {
     BYTE_META_CHUNK_SIZE = 8 * 1024,
 
@@ -131,6 +191,22 @@ static int64_t mp_clipi64(int64_t val, int64_t min, int64_t max)
     return val;
 }
 
+// Atomic accessors for the ringbuffer position fields. These are needed
+// because cache_read_nolock() reads them without taking the mutex, and a
+// plain 64 bit access is not atomic on 32 bit systems. Each field has only
+// one writer, so the CAS in cache_store64() succeeds on the first try.
+static int64_t cache_load64(int64_t *p)
+{
+    return mp_atomic_add_and_fetch(p, 0);
+}
+
+static void cache_store64(int64_t *p, int64_t val)
+{
+    int64_t old = *p;
+    while (!__sync_bool_compare_and_swap(p, old, val))
+        old = *p;
+}
+
 // Used by the main thread to wakeup the cache thread, and to wait for the
 // cache thread. The cache mutex has to be locked when calling this function.
 // *retry_time should be set to 0 on the first call.
@@ -158,10 +234,118 @@ static int cache_wakeup_and_wait(struct priv *s, double *retry_time)
     return 0;
 }
 
+// Runs in the cache thread. Returns whether pos is present in the disk tier.
+static bool cache_disk_has(struct priv *s, int64_t pos)
+{
+    for (int n = 0; n < s->num_disk_segments; n++) {
+        struct disk_segment *seg = &s->disk_segments[n];
+        if (pos >= seg->start && pos < seg->start + seg->len)
+            return true;
+    }
+    return false;
+}
+
+// Runs in the cache thread. Read at most size bytes starting at stream
+// position pos from the disk tier. Returns 0 if pos is not on disk.
+static int cache_disk_read(struct priv *s, int64_t pos, unsigned char *buf,
+                           int size)
+{
+    for (int n = s->num_disk_segments - 1; n >= 0; n--) {
+        struct disk_segment *seg = &s->disk_segments[n];
+        if (pos >= seg->start && pos < seg->start + seg->len) {
+            int64_t copy = FFMIN(size, seg->start + seg->len - pos);
+            if (lseek(s->disk_fd, seg->file_pos + (pos - seg->start),
+                      SEEK_SET) < 0)
+                return 0;
+            int r = read(s->disk_fd, buf, copy);
+            return FFMAX(r, 0);
+        }
+    }
+    return 0;
+}
+
+// Advance start over the prefix of [start, end) already covered by segments.
+static int64_t cache_disk_skip_covered(struct priv *s, int64_t start,
+                                       int64_t end)
+{
+    bool progress = true;
+    while (progress && start < end) {
+        progress = false;
+        for (int n = 0; n < s->num_disk_segments; n++) {
+            struct disk_segment *seg = &s->disk_segments[n];
+            if (start >= seg->start && start < seg->start + seg->len) {
+                start = FFMIN(end, seg->start + seg->len);
+                progress = true;
+            }
+        }
+    }
+    return start;
+}
+
+// Runs in the cache thread, with the mutex held. Append the stream byte range
+// [start, end), which must still be in the ringbuffer, to the disk tier.
+// Writes to the temp file normally just hit the page cache, so doing this
+// with the mutex held is not a latency concern.
+static void cache_disk_spill(struct priv *s, int64_t start, int64_t end)
+{
+    if (!s->disk_file || s->disk_full)
+        return;
+
+    start = FFMAX(start, s->min_filepos);
+    end = FFMIN(end, s->max_filepos);
+    start = cache_disk_skip_covered(s, start, end);
+
+    while (start < end) {
+        if (s->disk_used >= s->disk_max_size) {
+            mp_msg(MSGT_CACHE, MSGL_V, "Disk cache full.\n");
+            s->disk_full = true;
+            return;
+        }
+        int64_t pos = start - s->offset;
+        if (pos < 0)
+            pos += s->buffer_size;
+        else if (pos >= s->buffer_size)
+            pos -= s->buffer_size;
+        int64_t len = FFMIN(end - start, s->buffer_size - pos); // handle wrap
+        len = FFMIN(len, s->disk_max_size - s->disk_used);
+        if (lseek(s->disk_fd, s->disk_used, SEEK_SET) < 0 ||
+            write(s->disk_fd, &s->buffer[pos], len) != len)
+        {
+            mp_msg(MSGT_CACHE, MSGL_WARN, "Disk cache write error.\n");
+            fclose(s->disk_file);
+            s->disk_file = NULL;
+            return;
+        }
+        struct disk_segment *last = s->num_disk_segments
+            ? &s->disk_segments[s->num_disk_segments - 1] : NULL;
+        if (last && last->start + last->len == start &&
+            last->file_pos + last->len == s->disk_used)
+        {
+            last->len += len;
+        } else {
+            struct disk_segment seg = {start, len, s->disk_used};
+            MP_TARRAY_APPEND(s, s->disk_segments, s->num_disk_segments, seg);
+        }
+        s->disk_used += len;
+        start = cache_disk_skip_covered(s, start + len, end);
+    }
+}
+
 // Runs in the cache thread
 static void cache_drop_contents(struct priv *s)
 {
-    s->offset = s->min_filepos = s->max_filepos = s->read_filepos;
+    cache_disk_spill(s, s->min_filepos, s->max_filepos);
+    int64_t pos = cache_load64(&s->read_filepos);
+    // The window moves backwards here, which the lock-free fast paths can
+    // not handle by ordering alone (a mix of stale and fresh values can pass
+    // their validation). Make the drop observable atomically to them by
+    // bumping the generation to an odd value first, and to an even one after
+    // all three fields are rewritten. cache_store64() is a full barrier.
+    cache_store64(&s->window_gen, s->window_gen + 1);
+    cache_store64(&s->offset, pos);
+    cache_store64(&s->min_filepos, pos);
+    cache_store64(&s->max_filepos, pos);
+    cache_store64(&s->window_gen, s->window_gen + 1);
     s->eof = false;
 }
 
@@ -198,15 +382,174 @@ static int cache_read(struct priv *s, unsigned char *buf, int size)
 
     memcpy(buf, &s->buffer[pos], newb);
 
-    s->read_filepos += newb;
+    cache_store64(&s->read_filepos, s->read_filepos + newb);
     return newb;
 }
 
+// Runs in the main thread, with the mutex not held. Lock-free fast path of
+// cache_read(): copy out data that is already buffered. This is safe without
+// the lock, because the cache thread never writes to the buffer range
+// [read_filepos, max_filepos), never raises min_filepos above the read
+// position it last observed, and the only non-monotonic window update (a
+// drop after a seek) is detected via window_gen and discarded. Returns 0 if
+// the caller should fall back to the locking slow path.
+static int cache_read_nolock(struct priv *s, unsigned char *buf, int size)
+{
+    if (size <= 0)
+        return 0;
+
+    int64_t gen = cache_load64(&s->window_gen);
+    if (gen & 1) // window drop in progress
+        return 0;
+
+    int64_t max = cache_load64(&s->max_filepos);
+    int64_t min = cache_load64(&s->min_filepos);
+    int64_t read = cache_load64(&s->read_filepos);
+
+    if (read < min || read >= max)
+        return 0;
+
+    // Matching barrier in cache_fill(): make sure we see the buffer contents
+    // the observed max_filepos covers.
+    mp_memory_barrier();
+
+    int64_t newb = max - read;
+
+    // Outside of window drops (which the generation check below discards),
+    // s->offset changes by exact multiples of buffer_size only, so the
+    // mapping to a buffer position is not affected by observing a stale value.
+    int64_t pos = (read - cache_load64(&s->offset)) % s->buffer_size;
+    if (pos < 0)
+        pos += s->buffer_size;
+
+    if (newb > s->buffer_size - pos)
+        newb = s->buffer_size - pos; // handle wrap...
+
+    newb = FFMIN(newb, size);
+
+    memcpy(buf, &s->buffer[pos], newb);
+
+    // If the cache thread dropped the window in the meantime, the values
+    // above may have been an inconsistent mix, and the copied data can be
+    // garbage - discard it and let the slow path sort it out.
+    if (cache_load64(&s->window_gen) != gen)
+        return 0;
+
+    cache_store64(&s->read_filepos, read + newb);
+    return newb;
+}
+
+// Runs in the cache thread, with the mutex held. Measure how fast the source
+// stream delivers data and how fast the client consumes it, and derive the
+// read chunk size and the readahead target from that. Fixed tuning either
+// underbuffers slow links, or makes fast sources read tens of MB that may
+// never be played.
+static void update_rates(struct priv *s)
+{
+    double now = mp_time_sec();
+    double elapsed = now - s->rate_window_start;
+    if (s->rate_window_start > 0 && elapsed < CACHE_RATE_WINDOW)
+        return;
+
+    int64_t max = s->max_filepos;
+    int64_t read = cache_load64(&s->read_filepos);
+    if (s->rate_window_start > 0) {
+        // Negative deltas (cache drop, backward seek) are not meaningful;
+        // keep the previous estimate in that case.
+        double produced = max - s->rate_start_max;
+        double consumed = read - s->rate_start_read;
+        if (produced >= 0)
+            s->producer_rate = (s->producer_rate + produced / elapsed) / 2;
+        if (consumed >= 0)
+            s->consumer_rate = (s->consumer_rate + consumed / elapsed) / 2;
+    }
+    s->rate_window_start = now;
+    s->rate_start_max = max;
+    s->rate_start_read = read;
+
+    if (s->producer_rate > 0) {
+        // Large reads on fast links amortize syscall and locking overhead;
+        // small reads keep a slow link from hogging the buffer lock.
+        s->read_chunk = mp_clipi64(s->producer_rate * CACHE_CHUNK_SECONDS,
+                                   STREAM_BUFFER_SIZE, s->buffer_size / 4);
+    }
+    s->readahead_target = s->buffer_size;
+    if (s->consumer_rate > 0) {
+        s->readahead_target =
+            mp_clipi64(s->consumer_rate * CACHE_READAHEAD_SECONDS,
+                       s->fill_limit * 4, s->buffer_size);
+    }
+    s->low_watermark = s->readahead_target / 4;
+    if (s->consumer_rate > 0) {
+        s->low_watermark =
+            mp_clipi64(s->consumer_rate * CACHE_BURST_LOW_SECONDS,
+                       s->fill_limit * 2, s->readahead_target / 2);
+    }
+}
+
+// Runs in the main thread. Lend out ringbuffer memory at the client read
+// position (see stream_read_peek()). Lock-free for the same reasons as
+// cache_read_nolock(): the cache thread never writes to the lent range
+// before the read position was moved past it, and window drops are caught
+// by the generation check.
+static int cache_read_peek(stream_t *cache, unsigned char **ptr)
+{
+    struct priv *s = cache->priv;
+
+    int64_t gen = cache_load64(&s->window_gen);
+    if (gen & 1) // window drop in progress
+        return 0;
+
+    int64_t max = cache_load64(&s->max_filepos);
+    int64_t min = cache_load64(&s->min_filepos);
+    int64_t read = cache_load64(&s->read_filepos);
+
+    if (read < min || read >= max)
+        return 0;
+
+    // Matching barrier in cache_fill(), see cache_read_nolock().
+    mp_memory_barrier();
+
+    int64_t newb = max - read;
+
+    int64_t pos = (read - cache_load64(&s->offset)) % s->buffer_size;
+    if (pos < 0)
+        pos += s->buffer_size;
+
+    if (newb > s->buffer_size - pos)
+        newb = s->buffer_size - pos; // handle wrap...
+
+    // Unlike cache_read_nolock(), this lends the buffer out, so validating
+    // after the caller copied is not an option - check before it ever sees
+    // the pointer. That is sufficient: a drop is only ever triggered by this
+    // thread moving the read position outside the window, so if the window
+    // was still consistent here, no drop can start before the following
+    // consume call.
+    if (cache_load64(&s->window_gen) != gen)
+        return 0;
+
+    *ptr = &s->buffer[pos];
+    return FFMIN(newb, INT_MAX);
+}
+
+static void cache_read_consume(stream_t *cache, int len)
+{
+    struct priv *s = cache->priv;
+
+    int64_t read = cache_load64(&s->read_filepos);
+    cache_store64(&s->read_filepos, read + len);
+    // Wakeup the cache thread if the readahead is running low (same as in
+    // cache_fill_buffer()).
+    if (cache_load64(&s->max_filepos) - (read + len) < s->buffer_size / 2)
+        pthread_cond_signal(&s->wakeup);
+}
+
 // Runs in the cache thread.
 // Returns true if reading was attempted, and the mutex was shortly unlocked.
 static bool cache_fill(struct priv *s)
 {
-    int64_t read = s->read_filepos;
+    update_rates(s);
+    int64_t read = cache_load64(&s->read_filepos);
     int len;
 
     if (read < s->min_filepos || read > s->max_filepos) {
@@ -222,7 +565,10 @@ static bool cache_fill(struct priv *s)
                    "cached range: %"PRId64"-%"PRId64".\n", read,
                    s->min_filepos, s->max_filepos);
             cache_drop_contents(s);
-            stream_seek(s->stream, read);
+            // If the disk tier covers the new position, defer repositioning
+            // the source stream until it is actually read from again.
+            if (!cache_disk_has(s, read))
+                stream_seek(s->stream, read);
         }
     }
 
@@ -240,7 +586,25 @@ static bool cache_fill(struct priv *s)
     if (pos >= s->buffer_size)
         pos -= s->buffer_size; // wrap-around
 
-    if (space < s->fill_limit) {
+    // In burst mode, stay off the network while draining down to the low
+    // watermark. Consumption wakeups still land here, but return without
+    // touching the source stream.
+    if (s->burst_mode && s->net_sleeping) {
+        if (newb > s->low_watermark) {
+            s->idle = true;
+            s->reads++;
+            return false;
+        }
+        mp_msg(MSGT_CACHE, MSGL_DBG2, "Low watermark reached, refilling.\n");
+        s->net_sleeping = false;
+    }
+
+    if (space < s->fill_limit || newb >= s->readahead_target) {
+        if (s->burst_mode && newb >= s->readahead_target) {
+            mp_msg(MSGT_CACHE, MSGL_DBG2,
+                   "High watermark reached, sleeping the network.\n");
+            s->net_sleeping = true;
+        }
         s->idle = true;
         s->reads++; // don't stuck main thread
         return false;
@@ -251,20 +615,36 @@ static bool cache_fill(struct priv *s)
         space = s->buffer_size - pos;
 
     // limit read size (or else would block and read the entire buffer in 1 call)
-    space = FFMIN(space, s->stream->read_chunk);
+    space = FFMIN(space, s->read_chunk);
 
     // back+newb+space <= buffer_size
     int64_t back2 = s->buffer_size - (space + newb); // max back size
-    if (s->min_filepos < (read - back2))
-        s->min_filepos = read - back2;
+    if (s->min_filepos < (read - back2)) {
+        // Save the evicted range for the disk tier before giving it up.
+        cache_disk_spill(s, s->min_filepos, read - back2);
+        cache_store64(&s->min_filepos, read - back2);
+    }
 
     // The read call might take a long time and block, so drop the lock.
+    // The disk tier state and max_filepos are written by this thread only,
+    // so accessing them unlocked is fine.
     pthread_mutex_unlock(&s->mutex);
-    len = stream_read_partial(s->stream, &s->buffer[pos], space);
+    bool from_disk = false;
+    len = 0;
+    if (s->disk_file)
+        len = cache_disk_read(s, s->max_filepos, &s->buffer[pos], space);
+    if (len > 0) {
+        from_disk = true;
+    } else {
+        if (s->disk_file && stream_tell(s->stream) != s->max_filepos)
+            stream_seek(s->stream, s->max_filepos);
+        len = stream_read_partial(s->stream, &s->buffer[pos], space);
+    }
     pthread_mutex_lock(&s->mutex);
 
-    double pts;
-    if (stream_control(s->stream, STREAM_CTRL_GET_CURRENT_TIME, &pts) <= 0)
+    double pts = MP_NOPTS_VALUE;
+    if (!from_disk &&
+        stream_control(s->stream, STREAM_CTRL_GET_CURRENT_TIME, &pts) <= 0)
         pts = MP_NOPTS_VALUE;
     for (int64_t b_pos = pos; b_pos < pos + len + BYTE_META_CHUNK_SIZE;
          b_pos += BYTE_META_CHUNK_SIZE)
@@ -272,9 +652,13 @@ static bool cache_fill(struct priv *s)
         s->bm[b_pos / BYTE_META_CHUNK_SIZE] = (struct byte_meta){.stream_pts = pts};
     }
 
-    s->max_filepos += len;
+    // Matching barrier in cache_read_nolock(): make the new buffer contents
+    // visible before raising max_filepos.
+    mp_memory_barrier();
+
+    cache_store64(&s->max_filepos, s->max_filepos + len);
     if (pos + len == s->buffer_size)
-        s->offset += s->buffer_size; // wrap...
+        cache_store64(&s->offset, s->offset + s->buffer_size); // wrap...
 
     s->eof = len <= 0;
     s->idle = s->eof;
@@ -321,7 +705,7 @@ static int cache_get_cached_control(stream_t *cache, int cmd, void *arg)
         *(int64_t *)arg = s->buffer_size;
         return STREAM_OK;
     case STREAM_CTRL_GET_CACHE_FILL:
-        *(int64_t *)arg = s->max_filepos - s->read_filepos;
+        *(int64_t *)arg = s->max_filepos - cache_load64(&s->read_filepos);
         return STREAM_OK;
     case STREAM_CTRL_GET_CACHE_IDLE:
         *(int *)arg = s->idle;
@@ -342,11 +726,12 @@ static int cache_get_cached_control(stream_t *cache, int cmd, void *arg)
         *(unsigned int *)arg = s->stream_num_chapters;
         return STREAM_OK;
     case STREAM_CTRL_GET_CURRENT_TIME: {
-        if (s->read_filepos >= s->min_filepos &&
-            s->read_filepos <= s->max_filepos &&
+        int64_t read = cache_load64(&s->read_filepos);
+        if (read >= s->min_filepos &&
+            read <= s->max_filepos &&
             s->min_filepos < s->max_filepos)
         {
-            int64_t fpos = FFMIN(s->read_filepos, s->max_filepos - 1);
+            int64_t fpos = FFMIN(read, s->max_filepos - 1);
             int64_t pos = fpos - s->offset;
             if (pos < 0)
                 pos += s->buffer_size;
@@ -374,9 +759,18 @@ static int cache_get_cached_control(stream_t *cache, int cmd, void *arg)
         return STREAM_UNSUPPORTED;
     }
     case STREAM_CTRL_RESUME_CACHE:
-        s->idle = s->eof = false;
+        s->idle = s->eof = s->net_sleeping = false;
         pthread_cond_signal(&s->wakeup);
         return STREAM_OK;
+    case STREAM_CTRL_GET_CACHE_SLEEPING:
+        *(int *)arg = s->net_sleeping;
+        return STREAM_OK;
+    case STREAM_CTRL_GET_CACHE_RATES:
+        *(struct stream_cache_rates *)arg = (struct stream_cache_rates) {
+            .producer = s->producer_rate,
+            .consumer = s->consumer_rate,
+        };
+        return STREAM_OK;
     }
     return STREAM_ERROR;
 }
@@ -408,7 +802,7 @@ static void cache_execute_control(struct priv *s)
                "returned error, this is not allowed!\n");
     } else if (pos_changed || (ok && control_needs_flush(s->control))) {
         mp_msg(MSGT_CACHE, MSGL_V, "Dropping cache due to control()\n");
-        s->read_filepos = stream_tell(s->stream);
+        cache_store64(&s->read_filepos, stream_tell(s->stream));
         s->control_flush = true;
         cache_drop_contents(s);
     }
@@ -420,6 +814,7 @@ static void cache_execute_control(struct priv *s)
 static void *cache_thread(void *arg)
 {
     struct priv *s = arg;
+    mpthread_set_role("io");
     pthread_mutex_lock(&s->mutex);
     update_cached_controls(s);
     double last = mp_time_sec();
@@ -451,13 +846,23 @@ static int cache_fill_buffer(struct stream *cache, char *buffer, int max_len)
     struct priv *s = cache->priv;
     assert(s->cache_thread_running);
 
-    pthread_mutex_lock(&s->mutex);
-
-    if (cache->pos != s->read_filepos)
+    if (cache->pos != cache_load64(&s->read_filepos))
         mp_msg(MSGT_CACHE, MSGL_ERR,
                "!!! read_filepos differs !!! report this bug...\n");
 
-    int t = cache_read(s, buffer, max_len);
+    int t = cache_read_nolock(s, (unsigned char *)buffer, max_len);
+    if (t > 0) {
+        // Wakeup the cache thread if the readahead is running low. Signaling
+        // without the mutex held is allowed, and skipping the wakeup entirely
+        // at most delays the refill until the idle timeout.
+        if (cache_load64(&s->max_filepos) - cache_load64(&s->read_filepos)
+            < s->buffer_size / 2)
+            pthread_cond_signal(&s->wakeup);
+        return t;
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    t = cache_read(s, (unsigned char *)buffer, max_len);
     // wakeup the cache thread, possibly make it read more data ahead
     pthread_cond_signal(&s->wakeup);
     pthread_mutex_unlock(&s->mutex);
@@ -475,7 +880,8 @@ static int cache_seek(stream_t *cache, int64_t pos)
            " (cur=%" PRId64 ") <= %" PRId64 "  \n",
            s->min_filepos, pos, s->read_filepos, s->max_filepos);
 
-    cache->pos = s->read_filepos = pos;
+    cache->pos = pos;
+    cache_store64(&s->read_filepos, pos);
     s->eof = false; // so that cache_read() will actually wait for new data
     pthread_cond_signal(&s->wakeup);
     pthread_mutex_unlock(&s->mutex);
@@ -533,6 +939,8 @@ static void cache_uninit(stream_t *cache)
     }
     pthread_mutex_destroy(&s->mutex);
     pthread_cond_destroy(&s->wakeup);
+    if (s->disk_file)
+        fclose(s->disk_file);
     free(s->buffer);
     free(s->bm);
     talloc_free(s);
@@ -573,15 +981,39 @@ int stream_cache_init(stream_t *cache, stream_t *stream, int64_t size,
         return -1;
     }
 
+    struct MPOpts *opts = cache->opts;
+    int64_t disk_size = opts ? opts->stream_cache_disk_size * (int64_t)1024 : 0;
+    if (disk_size > 0) {
+        // tmpfile() unlinks the file immediately, so nothing is left behind
+        // even if the process dies.
+        s->disk_file = tmpfile();
+        if (s->disk_file) {
+            s->disk_fd = fileno(s->disk_file);
+            s->disk_max_size = disk_size;
+            mp_msg(MSGT_CACHE, MSGL_V, "Disk cache size set to %" PRId64
+                   " KiB\n", disk_size / 1024);
+        } else {
+            mp_msg(MSGT_CACHE, MSGL_WARN,
+                   "Failed to create disk cache file.\n");
+        }
+    }
+
     pthread_mutex_init(&s->mutex, NULL);
     pthread_cond_init(&s->wakeup, NULL);
 
     cache->priv = s;
     s->cache = cache;
     s->stream = stream;
+    // Starting points for the adaptive controller (see update_rates()).
+    s->read_chunk = stream->read_chunk;
+    s->readahead_target = s->buffer_size;
+    s->low_watermark = s->buffer_size / 4;
+    s->burst_mode = opts && opts->stream_cache_burst;
 
     cache->seek = cache_seek;
     cache->fill_buffer = cache_fill_buffer;
+    cache->read_peek = cache_read_peek;
+    cache->read_consume = cache_read_consume;
     cache->control = cache_control;
     cache->close = cache_uninit;
 
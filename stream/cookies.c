@@ -27,6 +27,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <dirent.h>
 #include <inttypes.h>
 #include <limits.h>
@@ -55,6 +56,11 @@ typedef struct cookie_list_type {
 /* Pointer to the linked list of cookies */
 static struct cookie_list_type *cookie_list = NULL;
 
+/* Header string built from the list above and the file mtime it was made
+   from, so that repeated stream opens don't redo the I/O and parsing. */
+static char *cookie_header = NULL;
+static time_t cookie_file_mtime = -1;
+
 
 /* Like strdup, but stops at anything <31. */
 static char *col_dup(const char *src)
@@ -178,23 +184,47 @@ static struct cookie_list_type *load_cookies(void)
     return NULL;
 }
 
+static void free_cookie_list(struct cookie_list_type *list)
+{
+    while (list) {
+	struct cookie_list_type *next = list->next;
+	free(list->name);
+	free(list->value);
+	free(list->path);
+	free(list->domain);
+	free(list);
+	list = next;
+    }
+}
+
 // Return a cookies string as expected by lavf (libavformat/http.c). The format
 // is like a Set-Cookie header (http://curl.haxx.se/rfc/cookie_spec.html),
 // separated by newlines.
 char *cookies_lavf(void)
 {
-    if (!cookie_list)
-        cookie_list = load_cookies();
-
-    struct cookie_list_type *list = cookie_list;
-    char *res = talloc_strdup(NULL, "");
+    time_t mtime = 0;
+    if (cookies_file) {
+        struct stat st;
+        if (stat(cookies_file, &st) == 0)
+            mtime = st.st_mtime;
+    }
 
-    while (list) {
-        res = talloc_asprintf_append_buffer(res,
-                    "%s=%s; path=%s; domain=%s; %s\n", list->name, list->value,
-                    list->path, list->domain, list->secure ? "secure" : "");
-        list = list->next;
+    if (!cookie_header || mtime != cookie_file_mtime) {
+        free_cookie_list(cookie_list);
+        cookie_list = load_cookies();
+        cookie_file_mtime = mtime;
+
+        talloc_free(cookie_header);
+        cookie_header = talloc_strdup(NULL, "");
+        for (struct cookie_list_type *list = cookie_list; list;
+             list = list->next)
+        {
+            cookie_header = talloc_asprintf_append_buffer(cookie_header,
+                        "%s=%s; path=%s; domain=%s; %s\n", list->name,
+                        list->value, list->path, list->domain,
+                        list->secure ? "secure" : "");
+        }
     }
 
-    return res;
+    return talloc_strdup(NULL, cookie_header);
 }
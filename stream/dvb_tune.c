@@ -233,19 +233,18 @@ static int check_status(int fd_frontend, int tmout)
 	tm1 = tm2 = time((time_t*) NULL);
 	while(!ok)
 	{
+		// Poll in short slices and read the status on every round (not
+		// only when an event is queued - the lock event may already have
+		// been consumed by the tuning ioctls), so an acquired lock is
+		// acted on immediately instead of after the full timeout.
 		festatus = 0;
-		if(poll(pfd,1,tmout*1000) > 0)
-		{
-			if (pfd[0].revents & POLLPRI)
-			{
-				if(ioctl(fd_frontend, FE_READ_STATUS, &festatus) >= 0)
-					if(festatus & FE_HAS_LOCK)
-						locks++;
-			}
-		}
+		poll(pfd,1,100);
+		if(ioctl(fd_frontend, FE_READ_STATUS, &festatus) >= 0)
+			if(festatus & FE_HAS_LOCK)
+				locks++;
 		usleep(10000);
 		tm2 = time((time_t*) NULL);
-		if((festatus & FE_TIMEDOUT) || (locks >= 2) || (tm2 - tm1 >= tmout))
+		if((festatus & FE_TIMEDOUT) || (locks >= 1) || (tm2 - tm1 >= tmout))
 			ok = 1;
 	}
 
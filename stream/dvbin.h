@@ -16,6 +16,7 @@
 #define LOF2 (10600*1000UL)
 
 #include <inttypes.h>
+#include <time.h>
 #include <linux/dvb/dmx.h>
 #include <linux/dvb/frontend.h>
 #include <linux/dvb/version.h>
@@ -67,6 +68,8 @@ typedef struct {
 	dvb_channels_list *list;
 	char *name;
 	int devno;
+	char *conf_file;	// channel list this was parsed from (or NULL)
+	time_t conf_mtime;
 } dvb_card_config_t;
 
 typedef struct {
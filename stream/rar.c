@@ -48,6 +48,11 @@ void RarFileDelete(rar_file_t *file)
         free(file->chunk[i]);
     }
     talloc_free(file->chunk);
+    for (int i = 0; i < RAR_VOLUME_CACHE; i++) {
+        free(file->volume_cache[i].mrl);
+        if (file->volume_cache[i].s)
+            free_stream(file->volume_cache[i].s);
+    }
     free(file->name);
     free_stream(file->s);
     free(file);
@@ -401,17 +406,54 @@ done:
     return 0;
 }
 
+static stream_t *VolumeCacheGet(rar_file_t *file, const char *mrl)
+{
+    for (int i = 0; i < RAR_VOLUME_CACHE; i++) {
+        if (file->volume_cache[i].mrl &&
+            !strcmp(file->volume_cache[i].mrl, mrl)) {
+            stream_t *s = file->volume_cache[i].s;
+            free(file->volume_cache[i].mrl);
+            file->volume_cache[i].mrl = NULL;
+            file->volume_cache[i].s = NULL;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static void VolumeCachePut(rar_file_t *file, const char *mrl, stream_t *s)
+{
+    if (!s)
+        return;
+    /* Evict the oldest entry */
+    if (file->volume_cache[RAR_VOLUME_CACHE - 1].s) {
+        free(file->volume_cache[RAR_VOLUME_CACHE - 1].mrl);
+        free_stream(file->volume_cache[RAR_VOLUME_CACHE - 1].s);
+    }
+    for (int i = RAR_VOLUME_CACHE - 1; i > 0; i--)
+        file->volume_cache[i] = file->volume_cache[i - 1];
+    file->volume_cache[0].mrl = strdup(mrl);
+    file->volume_cache[0].s = s;
+}
+
 int  RarSeek(rar_file_t *file, uint64_t position)
 {
     if (position > file->real_size)
         position = file->real_size;
 
-    /* Search the chunk */
+    /* Binary search in the chunk map built by RarParse() */
     const rar_file_chunk_t *old_chunk = file->current_chunk;
-    for (int i = 0; i < file->chunk_count; i++) {
-        file->current_chunk = file->chunk[i];
-        if (position < file->current_chunk->cummulated_size + file->current_chunk->size)
-            break;
+    if (file->chunk_count > 0) {
+        int lo = 0, hi = file->chunk_count - 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (position < file->chunk[mid]->cummulated_size +
+                           file->chunk[mid]->size)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        file->current_chunk = file->chunk[lo];
     }
     file->i_pos = position;
 
@@ -419,11 +461,15 @@ int  RarSeek(rar_file_t *file, uint64_t position)
                             (position - file->current_chunk->cummulated_size);
 
     if (strcmp(old_chunk->mrl, file->current_chunk->mrl)) {
-        if (file->s)
-            free_stream(file->s);
-        file->s = stream_create(file->current_chunk->mrl,
-                                STREAM_READ | STREAM_NO_FILTERS,
-                                file->opts);
+        /* Park the old stream instead of closing it, and check whether the
+         * target volume is still open before creating a new stream. */
+        stream_t *s = VolumeCacheGet(file, file->current_chunk->mrl);
+        VolumeCachePut(file, old_chunk->mrl, file->s);
+        if (!s)
+            s = stream_create(file->current_chunk->mrl,
+                              STREAM_READ | STREAM_NO_FILTERS,
+                              file->opts);
+        file->s = s;
     }
     return file->s ? stream_seek(file->s, offset) : 0;
 }
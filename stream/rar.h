@@ -34,6 +34,8 @@ typedef struct {
     uint64_t cummulated_size;
 } rar_file_chunk_t;
 
+#define RAR_VOLUME_CACHE 2
+
 typedef struct {
     char     *name;
     uint64_t size;
@@ -48,6 +50,12 @@ typedef struct {
     uint64_t i_pos;
     stream_t *s;
     rar_file_chunk_t *current_chunk;
+    // Recently used volume streams, kept open so that seeking across
+    // volume boundaries does not reopen the volume file every time
+    struct {
+        char     *mrl;
+        stream_t *s;
+    } volume_cache[RAR_VOLUME_CACHE];
 } rar_file_t;
 
 int  RarProbe(struct stream *);
@@ -21,8 +21,58 @@
 #include "talloc.h"
 #include "common/msg.h"
 #include "options/options.h"
+#include "osdep/timer.h"
 #include "resolve.h"
 
+// Cache of recently resolved URLs. quvi_parse() needs several network round
+// trips, so replaying the same URL (e.g. looping, or going back and forth in
+// a playlist) should not redo the whole resolution each time.
+#define CACHE_SIZE 4
+#define CACHE_TTL_US (5 * 60 * 1000000LL)
+
+static struct {
+    char *url;          // input URL, NULL if slot is empty
+    char *format;       // requested quvi format
+    char *media_url;
+    char *title;
+    int64_t time;       // mp_time_us() when this was resolved
+} cache[CACHE_SIZE];
+
+static struct mp_resolve_result *cache_get(const char *url, const char *format)
+{
+    for (int n = 0; n < CACHE_SIZE; n++) {
+        if (cache[n].url && strcmp(cache[n].url, url) == 0 &&
+            strcmp(cache[n].format, format) == 0)
+        {
+            if (mp_time_us() - cache[n].time > CACHE_TTL_US)
+                break;
+            struct mp_resolve_result *result
+                = talloc_zero(NULL, struct mp_resolve_result);
+            result->url = talloc_strdup(result, cache[n].media_url);
+            result->title = talloc_strdup(result, cache[n].title);
+            return result;
+        }
+    }
+    return NULL;
+}
+
+static void cache_put(const char *url, const char *format,
+                      struct mp_resolve_result *res)
+{
+    int n = CACHE_SIZE - 1;
+    talloc_free(cache[n].url);
+    talloc_free(cache[n].format);
+    talloc_free(cache[n].media_url);
+    talloc_free(cache[n].title);
+    for (; n > 0; n--)
+        cache[n] = cache[n - 1];
+    cache[0].url = talloc_strdup(NULL, url);
+    cache[0].format = talloc_strdup(NULL, format);
+    cache[0].media_url = talloc_strdup(NULL, res->url);
+    cache[0].title = talloc_strdup(NULL, res->title);
+    cache[0].time = mp_time_us();
+}
+
 static void add_source(struct mp_resolve_result *res, const char *url,
                        const char *encid)
 {
@@ -38,6 +88,13 @@ struct mp_resolve_result *mp_resolve_quvi(const char *url, struct MPOpts *opts)
 {
     QUVIcode rc;
     bool mp_url = false;
+    const char *page_url = url;
+
+    const char *req_format = opts->quvi_format ? opts->quvi_format : "best";
+
+    struct mp_resolve_result *result = cache_get(page_url, req_format);
+    if (result)
+        goto done;
 
     quvi_t q;
     rc = quvi_init(&q);
@@ -60,8 +117,6 @@ struct mp_resolve_result *mp_resolve_quvi(const char *url, struct MPOpts *opts)
 
     mp_msg(MSGT_OPEN, MSGL_INFO, "[quvi] Checking URL...\n");
 
-    const char *req_format = opts->quvi_format ? opts->quvi_format : "best";
-
     // Can use quvi_query_formats() to get a list of formats like this:
     // "fmt05_240p|fmt18_360p|fmt34_360p|fmt35_480p|fmt43_360p|fmt44_480p"
     // (This example is youtube specific.)
@@ -78,8 +133,7 @@ struct mp_resolve_result *mp_resolve_quvi(const char *url, struct MPOpts *opts)
         return NULL;
     }
 
-    struct mp_resolve_result *result
-        = talloc_zero(NULL, struct mp_resolve_result);
+    result = talloc_zero(NULL, struct mp_resolve_result);
 
     char *val;
 
@@ -101,6 +155,11 @@ struct mp_resolve_result *mp_resolve_quvi(const char *url, struct MPOpts *opts)
         result = NULL;
     }
 
+    if (result)
+        cache_put(page_url, req_format, result);
+
+done: ;
+
     // Useful for quvi-format cycling
     add_source(result, NULL, "default");
     add_source(result, NULL, "best");
@@ -79,6 +79,7 @@ extern const stream_info_t stream_info_bluray;
 extern const stream_info_t stream_info_rar_filter;
 extern const stream_info_t stream_info_rar_entry;
 extern const stream_info_t stream_info_edl;
+extern const stream_info_t stream_info_udp;
 
 static const stream_info_t *const stream_list[] = {
 #if HAVE_VCD
@@ -86,6 +87,10 @@ static const stream_info_t *const stream_list[] = {
 #endif
 #if HAVE_CDDA
     &stream_info_cdda,
+#endif
+#if HAVE_RECVMMSG
+    // Takes udp:// and rtp:// over stream_lavf's single-packet receive loop.
+    &stream_info_udp,
 #endif
     &stream_info_ffmpeg,
     &stream_info_avdevice,
@@ -575,6 +580,58 @@ struct bstr stream_peek(stream_t *s, int len)
                   .len = FFMIN(len, s->buf_len - s->buf_pos)};
 }
 
+// Return a read-only view of the data buffered at the current read position,
+// without copying it. Returns only what is already buffered (possibly
+// nothing) - unlike stream_peek(), this never reads ahead. For cached
+// streams, the view points directly into the cache's ringbuffer. Use
+// stream_read_consume() to advance the read position past the data actually
+// used; the view becomes invalid with any other call on the stream.
+struct bstr stream_read_peek(stream_t *s)
+{
+    assert(s->buf_pos <= s->buf_len);
+    if (s->buf_pos < s->buf_len)
+        return (bstr){&s->buffer[s->buf_pos], s->buf_len - s->buf_pos};
+    if (s->read_peek) {
+        unsigned char *ptr;
+        int len = s->read_peek(s, &ptr);
+        if (len > 0)
+            return (bstr){ptr, len};
+    }
+    return (bstr){0};
+}
+
+// Advance the read position by len bytes. len must not be larger than the
+// length returned by the preceding stream_read_peek() call.
+void stream_read_consume(stream_t *s, int len)
+{
+    assert(len >= 0);
+    if (len == 0)
+        return;
+    if (s->buf_pos < s->buf_len) {
+        assert(len <= s->buf_len - s->buf_pos);
+        s->buf_pos += len;
+    } else {
+        assert(s->read_consume);
+        s->read_consume(s, len);
+        s->pos += len;
+    }
+    s->eof = 0;
+}
+
+// Return a read-only window into the stream's underlying memory mapping,
+// starting at the absolute position pos. Unlike stream_peek(), this copies
+// nothing, is not limited by the stream buffer size, and does not change the
+// read position. The window stays valid until the stream is closed. Returns
+// an empty bstr if the stream has no mapping (most streams); the caller must
+// fall back to normal reads then. The returned length can be shorter than
+// len if the file ends earlier.
+struct bstr stream_peek_mapping(stream_t *s, int64_t pos, int64_t len)
+{
+    if (!s->get_mapping || pos < 0 || len <= 0)
+        return (struct bstr){0};
+    return s->get_mapping(s, pos, len);
+}
+
 int stream_write_buffer(stream_t *s, unsigned char *buf, int len)
 {
     int rd;
@@ -593,6 +650,10 @@ static int stream_skip_read(struct stream *s, int64_t len)
     while (len > 0) {
         int x = s->buf_len - s->buf_pos;
         if (x == 0) {
+            // Skipping over unseekable streams can mean reading for a long
+            // time, so allow the user to abort it between buffer fills.
+            if (stream_check_interrupt(0))
+                return 0;
             if (!stream_fill_buffer_by(s, len))
                 return 0; // EOF
             x = s->buf_len - s->buf_pos;
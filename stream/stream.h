@@ -32,6 +32,7 @@
 enum streamtype {
     STREAMTYPE_GENERIC = 0,
     STREAMTYPE_FILE,
+    STREAMTYPE_DIR,
     STREAMTYPE_RADIO,
     STREAMTYPE_DVB,
     STREAMTYPE_DVD,
@@ -98,6 +99,21 @@ enum stream_ctrl {
     STREAM_CTRL_GET_BASE_FILENAME,
     STREAM_CTRL_GET_NAV_EVENT,          // struct mp_nav_event**
     STREAM_CTRL_NAV_CMD,                // struct mp_nav_cmd*
+    STREAM_CTRL_GET_CACHE_RATES,        // struct stream_cache_rates*
+    STREAM_CTRL_GET_UDP_STATS,          // struct stream_udp_stats*
+    STREAM_CTRL_GET_CACHE_SLEEPING,     // int*: burst mode network sleep state
+};
+
+// Throughput as measured by the stream cache (0 if not yet known).
+struct stream_cache_rates {
+    double producer;        // source stream read throughput in bytes/sec
+    double consumer;        // client (demuxer) consumption in bytes/sec
+};
+
+// Packet counters of the native UDP/RTP input.
+struct stream_udp_stats {
+    uint64_t received_packets;
+    uint64_t dropped_packets;   // kernel queue overflows + RTP sequence gaps
 };
 
 struct stream_lang_req {
@@ -129,6 +145,13 @@ typedef struct stream {
 
     // Read
     int (*fill_buffer)(struct stream *s, char *buffer, int max_len);
+    // Optional. Lend out a pointer to internal buffer memory at the current
+    // read position without copying (see stream_read_peek()). The memory must
+    // stay valid until the following read_consume() call.
+    int (*read_peek)(struct stream *s, unsigned char **ptr);
+    // Advance the read position by len bytes (at most the last read_peek
+    // result). Optional, but required if read_peek is set.
+    void (*read_consume)(struct stream *s, int len);
     // Write
     int (*write_buffer)(struct stream *s, char *buffer, int len);
     // Seek
@@ -137,6 +160,9 @@ typedef struct stream {
     // Will be later used to let streams like dvd and cdda report
     // their structure (ie tracks, chapters, etc)
     int (*control)(struct stream *s, int cmd, void *arg);
+    // Return a zero-copy window into an underlying memory mapping (optional,
+    // see stream_peek_mapping())
+    struct bstr (*get_mapping)(struct stream *s, int64_t pos, int64_t len);
     // Close
     void (*close)(struct stream *s);
 
@@ -234,6 +260,9 @@ int stream_seek(stream_t *s, int64_t pos);
 int stream_read(stream_t *s, char *mem, int total);
 int stream_read_partial(stream_t *s, char *buf, int buf_size);
 struct bstr stream_peek(stream_t *s, int len);
+struct bstr stream_peek_mapping(stream_t *s, int64_t pos, int64_t len);
+struct bstr stream_read_peek(stream_t *s);
+void stream_read_consume(stream_t *s, int len);
 void stream_drop_buffers(stream_t *s);
 
 struct MPOpts;
@@ -58,6 +58,12 @@ typedef struct {
     int end_sector;
     cd_info_t *cd_info;
 
+    // readahead for reads that bypass paranoia (see open_cdda)
+    int16_t *batch_buf;
+    int batch_sector;
+    int batch_count;
+    int batch_size;
+
     // options
     int speed;
     int paranoia_mode;
@@ -181,14 +187,33 @@ static int fill_buffer(stream_t *s, char *buffer, int max_len)
         return 0;
     }
 
-    buf = paranoia_read(p->cdp, cdparanoia_callback);
-    if (!buf)
-        return 0;
+    if (p->batch_buf) {
+        if (p->sector < p->batch_sector ||
+            p->sector >= p->batch_sector + p->batch_count)
+        {
+            long n = FFMIN(p->batch_size, p->end_sector + 1 - p->sector);
+            n = cdda_read(p->cd, p->batch_buf, p->sector, n);
+            if (n <= 0)
+                return 0;
+            p->batch_sector = p->sector;
+            p->batch_count = n;
+#if BYTE_ORDER == BIG_ENDIAN
+            for (i = 0; i < n * CDIO_CD_FRAMESIZE_RAW / 2; i++)
+                p->batch_buf[i] = le2me_16(p->batch_buf[i]);
+#endif
+        }
+        buf = p->batch_buf +
+              (p->sector - p->batch_sector) * (CDIO_CD_FRAMESIZE_RAW / 2);
+    } else {
+        buf = paranoia_read(p->cdp, cdparanoia_callback);
+        if (!buf)
+            return 0;
 
 #if BYTE_ORDER == BIG_ENDIAN
-    for (i = 0; i < CDIO_CD_FRAMESIZE_RAW / 2; i++)
-        buf[i] = le2me_16(buf[i]);
+        for (i = 0; i < CDIO_CD_FRAMESIZE_RAW / 2; i++)
+            buf[i] = le2me_16(buf[i]);
 #endif
+    }
 
     p->sector++;
     memcpy(buffer, buf, CDIO_CD_FRAMESIZE_RAW);
@@ -243,6 +268,7 @@ static void close_cdda(stream_t *s)
     paranoia_free(p->cdp);
     cdda_close(p->cd);
     cd_info_free(p->cd_info);
+    free(p->batch_buf);
     free(p);
 }
 
@@ -437,6 +463,14 @@ static int open_cdda(stream_t *st, int m)
     if (p->search_overlap > 0)
         paranoia_overlapset(priv->cdp, p->search_overlap);
 
+    if (p->paranoia_mode == 0 && p->search_overlap <= 0) {
+        // paranoia_read() transfers one sector per drive command even with
+        // all verification disabled; read whole bursts directly instead and
+        // serve single sectors from the buffer in fill_buffer().
+        priv->batch_size = av_clip(cdd->nsectors, 1, 32);
+        priv->batch_buf = malloc(priv->batch_size * CDIO_CD_FRAMESIZE_RAW);
+    }
+
     paranoia_seek(priv->cdp, priv->start_sector, SEEK_SET);
     priv->sector = priv->start_sector;
 
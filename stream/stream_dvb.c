@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 #include <ctype.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <poll.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -61,6 +62,18 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 //TODO: CAMBIARE list_ptr e da globale a per_priv
 
 
+// Probing the cards and parsing the channel lists takes long enough to
+// dominate channel zapping (which closes and reopens the stream), so the
+// parsed config is cached for the whole process and only re-read when a
+// channel list file changes on disk.
+static dvb_config_t *global_config;
+
+// What the frontend was left tuned to by the previous open; the hardware
+// keeps its tuning across fd close/open, so zapping between channels on the
+// same multiplex does not have to tune (and wait for a lock) again.
+static int last_tuned_card = -1;
+static int last_tuned_freq = -1;
+
 static dvb_priv_t stream_defaults = {
 	.cfg_prog = "",
         .cfg_card = 1,
@@ -404,6 +417,7 @@ void dvb_free_config(dvb_config_t *config)
 	for(i=0; i<config->count; i++)
 	{
 		free(config->cards[i].name);
+		free(config->cards[i].conf_file);
 		if(!config->cards[i].list)
 			continue;
 		if(config->cards[i].list->channels)
@@ -531,6 +545,8 @@ int dvb_set_channel(stream_t *stream, int card, int n)
 			return 0;
 
 	priv->last_freq = channel->freq;
+	last_tuned_card = card;
+	last_tuned_freq = channel->freq;
 	priv->is_on = 1;
 
 	//sets demux filters and restart the stream
@@ -591,7 +607,8 @@ static void dvbin_close(stream_t *stream)
 	priv->fe_fd = priv->sec_fd = priv->dvr_fd = -1;
 
 	priv->is_on = 0;
-	dvb_free_config(priv->config);
+	// the config is cached in global_config and reused by the next open
+	priv->config = NULL;
 }
 
 
@@ -681,6 +698,10 @@ static int dvb_open(stream_t *stream, int mode)
  	}
 	priv->timeout = p->cfg_timeout;
 
+	// skip retuning if the frontend is still on the right multiplex
+	if(priv->card == last_tuned_card)
+		priv->last_freq = last_tuned_freq;
+
 	tuner_type = priv->config->cards[priv->card].type;
 
 	if(tuner_type == 0)
@@ -719,7 +740,7 @@ static int dvb_open(stream_t *stream, int mode)
 }
 
 #define MAX_CARDS 4
-dvb_config_t *dvb_get_config(void)
+static dvb_config_t *dvb_parse_config(void)
 {
 	int i, fd, type, size;
 	char filename[30], *conf_file, *name;
@@ -786,10 +807,14 @@ dvb_config_t *dvb_get_config(void)
         }
 
         list = dvb_get_channels(conf_file, type);
+        char *conf_file_copy = conf_file ? strdup(conf_file) : NULL;
         talloc_free(talloc_ctx);
 
 		if(list == NULL)
+		{
+			free(conf_file_copy);
 			continue;
+		}
 
 		size = sizeof(dvb_card_config_t) * (conf->count + 1);
 		tmp = realloc(conf->cards, size);
@@ -797,6 +822,7 @@ dvb_config_t *dvb_get_config(void)
 		if(tmp == NULL)
 		{
 			fprintf(stderr, "DVB_CONFIG, can't realloc %d bytes, skipping\n", size);
+			free(conf_file_copy);
 			continue;
 		}
 		cards = tmp;
@@ -805,6 +831,7 @@ dvb_config_t *dvb_get_config(void)
 		if(name==NULL)
 		{
 			fprintf(stderr, "DVB_CONFIG, can't realloc 20 bytes, skipping\n");
+			free(conf_file_copy);
 			continue;
 		}
 
@@ -812,6 +839,13 @@ dvb_config_t *dvb_get_config(void)
 		conf->cards[conf->count].devno = i;
 		conf->cards[conf->count].list = list;
 		conf->cards[conf->count].type = type;
+		conf->cards[conf->count].conf_file = conf_file_copy;
+		conf->cards[conf->count].conf_mtime = 0;
+		{
+			struct stat st;
+			if(conf_file_copy && stat(conf_file_copy, &st) == 0)
+				conf->cards[conf->count].conf_mtime = st.st_mtime;
+		}
 		snprintf(name, 20, "DVB-%c card n. %d", type==TUNER_TER ? 'T' : (type==TUNER_CBL ? 'C' : 'S'), conf->count+1);
 		conf->cards[conf->count].name = name;
 		conf->count++;
@@ -826,6 +860,39 @@ dvb_config_t *dvb_get_config(void)
 	return conf;
 }
 
+// true if none of the channel list files changed since they were parsed
+static int dvb_config_is_fresh(dvb_config_t *conf)
+{
+	int i;
+	struct stat st;
+
+	for(i = 0; i < conf->count; i++)
+	{
+		if(conf->cards[i].conf_file == NULL)
+			continue;
+		if(stat(conf->cards[i].conf_file, &st) != 0
+			|| st.st_mtime != conf->cards[i].conf_mtime)
+			return 0;
+	}
+	return 1;
+}
+
+dvb_config_t *dvb_get_config(void)
+{
+	if(global_config != NULL)
+	{
+		if(dvb_config_is_fresh(global_config))
+			return global_config;
+		dvb_free_config(global_config);
+		global_config = NULL;
+		// channel data changed, the remembered tuning may be stale
+		last_tuned_card = last_tuned_freq = -1;
+	}
+
+	global_config = dvb_parse_config();
+	return global_config;
+}
+
 
 
 const stream_info_t stream_info_dvb = {
@@ -29,13 +29,26 @@
 
 #include "osdep/io.h"
 
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "common/msg.h"
+#include "common/common.h"
 #include "stream.h"
 #include "options/m_option.h"
 
+// How much data around a seek target is requested with MADV_WILLNEED.
+#define MMAP_SEEK_WINDOW (16 * 1024 * 1024)
+
 struct priv {
     int fd;
     bool close;
+#if HAVE_SYS_MMAN_H
+    unsigned char *map;     // mmap base pointer (NULL if mmap is not used)
+    int64_t map_size;
+    int64_t map_pos;        // current read position within the mapping
+#endif
 };
 
 static int fill_buffer(stream_t *s, char *buffer, int max_len)
@@ -66,6 +79,50 @@ static int seek(stream_t *s, int64_t newpos)
     return lseek(p->fd, newpos, SEEK_SET) != (off_t)-1;
 }
 
+#if HAVE_SYS_MMAN_H
+
+static int fill_buffer_mmap(stream_t *s, char *buffer, int max_len)
+{
+    struct priv *p = s->priv;
+    int64_t left = p->map_size - p->map_pos;
+    int r = MPMIN(left, max_len);
+    if (r <= 0)
+        return -1;
+    memcpy(buffer, p->map + p->map_pos, r);
+    p->map_pos += r;
+    return r;
+}
+
+static int seek_mmap(stream_t *s, int64_t newpos)
+{
+    struct priv *p = s->priv;
+    if (newpos < 0 || newpos > p->map_size)
+        return 0;
+    // Sequential kernel readahead (set at open) covers linear playback; on a
+    // jump, explicitly request the window around the target so the demuxer
+    // does not stall on major page faults right after the seek.
+    if (newpos != p->map_pos) {
+        long pagesize = sysconf(_SC_PAGESIZE);
+        int64_t start = newpos - newpos % pagesize;
+        int64_t len = MPMIN(p->map_size - start, MMAP_SEEK_WINDOW);
+        if (len > 0)
+            madvise(p->map + start, len, MADV_WILLNEED);
+    }
+    p->map_pos = newpos;
+    return 1;
+}
+
+static struct bstr get_mapping(stream_t *s, int64_t pos, int64_t len)
+{
+    struct priv *p = s->priv;
+    if (pos >= p->map_size)
+        return (struct bstr){0};
+    return (struct bstr){.start = p->map + pos,
+                         .len = MPMIN(len, p->map_size - pos)};
+}
+
+#endif
+
 static int control(stream_t *s, int cmd, void *arg)
 {
     struct priv *p = s->priv;
@@ -87,6 +144,10 @@ static int control(stream_t *s, int cmd, void *arg)
 static void s_close(stream_t *s)
 {
     struct priv *p = s->priv;
+#if HAVE_SYS_MMAN_H
+    if (p->map)
+        munmap(p->map, p->map_size);
+#endif
     if (p->close && p->fd >= 0)
         close(p->fd);
 }
@@ -151,10 +212,12 @@ static int open_f(stream_t *stream, int mode)
 #ifndef __MINGW32__
         struct stat st;
         if (fstat(fd, &st) == 0 && S_ISDIR(st.st_mode)) {
-            mp_msg(MSGT_OPEN, MSGL_ERR, "File is a directory: '%s'\n",
-                    filename);
+            // Let directories through - the playlist demuxer expands them
+            // into their sorted contents.
             close(fd);
-            return STREAM_ERROR;
+            stream->type = STREAMTYPE_DIR;
+            stream->demuxer = "playlist";
+            return STREAM_OK;
         }
 #endif
         priv->fd = fd;
@@ -183,6 +246,28 @@ static int open_f(stream_t *stream, int mode)
     stream->read_chunk = 64 * 1024;
     stream->close = s_close;
 
+#if HAVE_SYS_MMAN_H
+    // Use mmap for regular local files: saves the read() syscall and buffer
+    // copy on the hot path, and allows handing out zero-copy windows with
+    // stream_peek_mapping().
+    struct stat st;
+    if (mode == STREAM_READ && priv->close && len > 0 &&
+        (uint64_t)len <= SIZE_MAX / 2 &&
+        fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        void *map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            priv->map = map;
+            priv->map_size = len;
+            madvise(map, len, MADV_SEQUENTIAL);
+            stream->fill_buffer = fill_buffer_mmap;
+            stream->seek = seek_mmap;
+            stream->get_mapping = get_mapping;
+            mp_msg(MSGT_OPEN, MSGL_V, "[file] Using memory mapped I/O\n");
+        }
+    }
+#endif
+
     return STREAM_OK;
 }
 
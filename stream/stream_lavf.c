@@ -31,12 +31,25 @@
 #include "bstr/bstr.h"
 #include "talloc.h"
 
+// Maximum distance for which a forward seek is done by reading and
+// discarding the data in between. For network streams this tends to be
+// much cheaper than aborting the connection and issuing a new request.
+#define SMALL_SEEK_MAX (256 * 1024)
+
+struct stream_lavf_priv {
+    AVIOContext *avio;
+    // Connection reuse statistics, printed on close.
+    int64_t drained_bytes;
+    int num_short_seeks;
+};
+
 static int open_f(stream_t *stream, int mode);
 static char **read_icy(stream_t *stream);
 
 static int fill_buffer(stream_t *s, char *buffer, int max_len)
 {
-    AVIOContext *avio = s->priv;
+    struct stream_lavf_priv *p = s->priv;
+    AVIOContext *avio = p ? p->avio : NULL;
     if (!avio)
         return -1;
     int r = avio_read(avio, buffer, max_len);
@@ -45,7 +58,8 @@ static int fill_buffer(stream_t *s, char *buffer, int max_len)
 
 static int write_buffer(stream_t *s, char *buffer, int len)
 {
-    AVIOContext *avio = s->priv;
+    struct stream_lavf_priv *p = s->priv;
+    AVIOContext *avio = p ? p->avio : NULL;
     if (!avio)
         return -1;
     avio_write(avio, buffer, len);
@@ -57,9 +71,30 @@ static int write_buffer(stream_t *s, char *buffer, int len)
 
 static int seek(stream_t *s, int64_t newpos)
 {
-    AVIOContext *avio = s->priv;
+    struct stream_lavf_priv *p = s->priv;
+    AVIOContext *avio = p ? p->avio : NULL;
     if (!avio)
         return -1;
+    int64_t pos = avio_tell(avio);
+    if (s->streaming && !avio->write_flag && pos >= 0 && newpos > pos &&
+        newpos - pos <= SMALL_SEEK_MAX)
+    {
+        while (pos < newpos) {
+            char buf[4096];
+            int len = sizeof(buf);
+            if (len > newpos - pos)
+                len = newpos - pos;
+            int r = avio_read(avio, buf, len);
+            if (r <= 0)
+                break;
+            pos += r;
+            p->drained_bytes += r;
+        }
+        if (pos == newpos) {
+            p->num_short_seeks++;
+            return 1;
+        }
+    }
     if (avio_seek(avio, newpos, SEEK_SET) < 0) {
         return 0;
     }
@@ -68,19 +103,28 @@ static int seek(stream_t *s, int64_t newpos)
 
 static void close_f(stream_t *stream)
 {
-    AVIOContext *avio = stream->priv;
+    struct stream_lavf_priv *p = stream->priv;
+    if (!p)
+        return;
+    if (p->num_short_seeks) {
+        mp_msg(MSGT_OPEN, MSGL_V, "[ffmpeg] %d forward seeks absorbed by "
+               "draining %lld bytes\n", p->num_short_seeks,
+               (long long)p->drained_bytes);
+    }
     /* NOTE: As of 2011 write streams must be manually flushed before close.
      * Currently write_buffer() always flushes them after writing.
      * avio_close() could return an error, but we have no way to return that
      * with the current stream API.
      */
-    if (avio)
-        avio_close(avio);
+    if (p->avio)
+        avio_close(p->avio);
+    p->avio = NULL;
 }
 
 static int control(stream_t *s, int cmd, void *arg)
 {
-    AVIOContext *avio = s->priv;
+    struct stream_lavf_priv *p = s->priv;
+    AVIOContext *avio = p ? p->avio : NULL;
     if (!avio && cmd != STREAM_CTRL_RECONNECT)
         return -1;
     int64_t size, ts;
@@ -227,7 +271,9 @@ static int open_f(stream_t *stream, int mode)
         stream->demuxer = "lavf";
         stream->lavf_type = "flv";
     }
-    stream->priv = avio;
+    struct stream_lavf_priv *priv = talloc_zero(stream, struct stream_lavf_priv);
+    priv->avio = avio;
+    stream->priv = priv;
     int64_t size = avio_size(avio);
     if (size >= 0)
         stream->end_pos = size;
@@ -260,7 +306,8 @@ static void append_meta(char ***info, int *num_info, bstr name, bstr val)
 
 static char **read_icy(stream_t *s)
 {
-    AVIOContext *avio = s->priv;
+    struct stream_lavf_priv *p = s->priv;
+    AVIOContext *avio = p->avio;
 
     if (!mp_avio_has_opts(avio))
         return NULL;
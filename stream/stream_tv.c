@@ -72,6 +72,7 @@ tv_param_t stream_tv_defaults = {
     0,             //scan_autostart
     50,            //scan_threshold
     0.5,           //scan_period
+    6,             //hw_buffers
 };
 
 #define OPT_BASE_STRUCT tv_param_t
@@ -66,6 +66,7 @@ typedef struct tv_param_s {
     int scan;
     int scan_threshold;
     float scan_period;
+    int hw_buffers;     ///< number of capture buffers to request (v4l2 only)
     /**
       Terminate stream with video renderer instead of Null renderer
       Will help if video freezes but audio does not.
@@ -90,11 +90,16 @@ struct map {
 
 #define BUFFER_COUNT 6
 
+/// capture buffers that must stay queued so the driver can keep capturing
+#define MIN_QUEUED_BUFFERS 2
+
 /** video ringbuffer entry */
 typedef struct {
-    unsigned char               *data;     ///< frame contents
+    unsigned char               *data;     ///< frame contents (copy fallback)
     long long                   timestamp; ///< frame timestamp
     int                         framesize; ///< actual frame size
+    int                         vbuf;      ///< mmap'd capture buffer held by
+                                           ///  this entry, -1 if data was copied
 } video_buffer_entry;
 
 /* private data */
@@ -116,6 +121,8 @@ typedef struct priv {
     /* audio video interleaving ;-) */
     volatile int                streamon;
     pthread_t                   audio_grabber_thread;
+    pthread_t                   audio_init_thread;
+    int                         audio_init_started;
     pthread_mutex_t             skew_mutex;
 
     /* 2nd level video buffers */
@@ -128,6 +135,7 @@ typedef struct priv {
     volatile int                video_head;
     volatile int                video_tail;
     volatile int                video_cnt;
+    int                         vbuf_held; ///< capture buffers referenced by ring entries
     pthread_t                   video_grabber_thread;
     pthread_mutex_t             video_buffer_mutex;
 
@@ -399,7 +407,7 @@ static void setup_audio_buffer_sizes(priv_t *priv)
            priv->audio_buffer_size, priv->audio_in.blocksize, priv->aud_skew_cnt);
 }
 
-static void init_audio(priv_t *priv)
+static void do_init_audio(priv_t *priv)
 {
     if (priv->audio_initialized) return;
 
@@ -438,6 +446,36 @@ static void init_audio(priv_t *priv)
     }
 }
 
+static void *audio_init_thread_fn(void *ptr)
+{
+    do_init_audio(ptr);
+    return NULL;
+}
+
+// Negotiate the audio device in the background. The audio setup is
+// independent of the video ioctl setup that follows in init() and in tv.c,
+// and takes just as long on some capture hardware, so overlap the two.
+static void start_init_audio(priv_t *priv)
+{
+    if (priv->audio_initialized || priv->audio_init_started ||
+        priv->tv_param->noaudio)
+        return;
+    if (pthread_create(&priv->audio_init_thread, NULL, audio_init_thread_fn,
+                       priv) == 0)
+        priv->audio_init_started = 1;
+}
+
+// All users of the audio state funnel through here; wait for (or do) the
+// device negotiation.
+static void init_audio(priv_t *priv)
+{
+    if (priv->audio_init_started) {
+        pthread_join(priv->audio_init_thread, NULL);
+        priv->audio_init_started = 0;
+    }
+    do_init_audio(priv);
+}
+
 #if 0
 /*
 ** the number of milliseconds elapsed between time0 and time1
@@ -962,6 +1000,10 @@ static int uninit(priv_t *priv)
     int i, frames, dropped = 0;
 
     priv->shutdown = 1;
+    if (priv->audio_init_started) {
+        pthread_join(priv->audio_init_thread, NULL);
+        priv->audio_init_started = 0;
+    }
     if(priv->video_grabber_thread)
         pthread_join(priv->video_grabber_thread, NULL);
     pthread_mutex_destroy(&priv->video_buffer_mutex);
@@ -1091,6 +1133,10 @@ static int init(priv_t *priv)
             return 0;
         }
     }
+    // The tuner state needed for channel selection is known now; start
+    // audio device negotiation while the remaining video setup runs.
+    start_init_audio(priv);
+
     mp_msg(MSGT_TV, MSGL_INFO, "Selected device: %s\n", priv->capability.card);
     if (priv->capability.capabilities & V4L2_CAP_TUNER) {
         mp_msg(MSGT_TV, MSGL_INFO, " Tuner cap:%s%s%s\n",
@@ -1326,16 +1372,21 @@ static int start(priv_t *priv)
         return 0;
     }
     memset(priv->video_ringbuffer,0,priv->video_buffer_size_max * sizeof(video_buffer_entry));
+    for (i = 0; i < priv->video_buffer_size_max; i++)
+        priv->video_ringbuffer[i].vbuf = -1;
 
     pthread_mutex_init(&priv->video_buffer_mutex, NULL);
 
     priv->video_head = 0;
     priv->video_tail = 0;
     priv->video_cnt = 0;
+    priv->vbuf_held = 0;
 
     /* request buffers */
     if (priv->immediate_mode) {
         request.count = 2;
+    } else if (priv->tv_param->hw_buffers >= 2) {
+        request.count = priv->tv_param->hw_buffers;
     } else {
         request.count = BUFFER_COUNT;
     }
@@ -1568,6 +1619,7 @@ static void *video_grabber(void *data)
         }
         pthread_mutex_unlock(&priv->video_buffer_mutex);
 
+        int requeue = 1;
         if (priv->video_cnt == priv->video_buffer_size_current) {
             if (!priv->immediate_mode) {
                 mp_msg(MSGT_TV, MSGL_ERR, "\nvideo buffer full - dropping frame\n");
@@ -1594,11 +1646,28 @@ static void *video_grabber(void *data)
                     pthread_mutex_unlock(&priv->audio_mutex);
                 }
             }
-            copy_frame(priv, priv->video_ringbuffer+priv->video_tail, priv->map[buf.index].addr,buf.bytesused);
+            /* Pass the mmap'd capture buffer itself through the ring and
+               defer the requeue to the consumer, as long as enough buffers
+               stay queued for the driver; otherwise fall back to copying.
+               automute needs a writable copy for the blank frame. */
+            pthread_mutex_lock(&priv->video_buffer_mutex);
+            int defer = priv->tv_param->automute <= 0 &&
+                        priv->mapcount - priv->vbuf_held - 1 >= MIN_QUEUED_BUFFERS;
+            if (defer)
+                priv->vbuf_held++;
+            pthread_mutex_unlock(&priv->video_buffer_mutex);
+            if (defer) {
+                priv->video_ringbuffer[priv->video_tail].vbuf = buf.index;
+                priv->video_ringbuffer[priv->video_tail].framesize = buf.bytesused;
+                requeue = 0;
+            } else {
+                copy_frame(priv, priv->video_ringbuffer+priv->video_tail, priv->map[buf.index].addr,buf.bytesused);
+                priv->video_ringbuffer[priv->video_tail].vbuf = -1;
+            }
             priv->video_tail = (priv->video_tail+1)%priv->video_buffer_size_current;
             priv->video_cnt++;
         }
-        if (v4l2_ioctl(priv->video_fd, VIDIOC_QBUF, &buf) < 0) {
+        if (requeue && v4l2_ioctl(priv->video_fd, VIDIOC_QBUF, &buf) < 0) {
             mp_msg(MSGT_TV, MSGL_ERR, "%s: ioctl queue buffer failed: %s\n",
                    info.short_name, strerror(errno));
             return 0;
@@ -1624,8 +1693,18 @@ static double grab_video_frame(priv_t *priv, char *buffer, int len)
     }
 
     pthread_mutex_lock(&priv->video_buffer_mutex);
-    interval = (double)priv->video_ringbuffer[priv->video_head].timestamp*1e-6;
-    memcpy(buffer, priv->video_ringbuffer[priv->video_head].data, len);
+    video_buffer_entry *entry = priv->video_ringbuffer + priv->video_head;
+    interval = (double)entry->timestamp*1e-6;
+    memcpy(buffer, entry->vbuf >= 0 ? priv->map[entry->vbuf].addr : entry->data, len);
+    if (entry->vbuf >= 0) {
+        /* the frame is consumed - hand the capture buffer back to the driver */
+        if (v4l2_ioctl(priv->video_fd, VIDIOC_QBUF, &(priv->map[entry->vbuf].buf)) < 0) {
+            mp_msg(MSGT_TV, MSGL_ERR, "%s: ioctl queue buffer failed: %s\n",
+                   info.short_name, strerror(errno));
+        }
+        priv->vbuf_held--;
+        entry->vbuf = -1;
+    }
     priv->video_cnt--;
     priv->video_head = (priv->video_head+1)%priv->video_buffer_size_current;
     pthread_mutex_unlock(&priv->video_buffer_mutex);
@@ -41,11 +41,25 @@ static int sun_vcd_read(mp_vcd_priv_t*, int*);
 #include <linux/cdrom.h>
 #endif
 
+#ifdef __linux__
+#include <scsi/sg.h>
+#endif
+
+// sectors fetched per SCSI READ CD command; CDROMREADRAW transfers only
+// one sector per ioctl, so sequential reads batch through this buffer
+#define VCD_READAHEAD 16
+
 struct mp_vcd_priv_st {
   int fd;
   struct cdrom_tocentry entry;
   char buf[VCD_SECTOR_SIZE];
   struct cdrom_tochdr tochdr;
+#if defined(__linux__) && defined(SG_IO)
+  int sg_state;            // -1: untried, 1: READ CD works, 0: unusable
+  unsigned int ra_sector;  // first sector in ra_buf
+  int ra_count;            // valid sectors in ra_buf
+  char ra_buf[VCD_SECTOR_SIZE * VCD_READAHEAD];
+#endif
 };
 
 static inline void vcd_set_msf(mp_vcd_priv_t* vcd, unsigned int sect){
@@ -144,14 +158,72 @@ static mp_vcd_priv_t* vcd_read_toc(int fd){
   vcd = malloc(sizeof(mp_vcd_priv_t));
   vcd->fd = fd;
   vcd->tochdr = tochdr;
+#if defined(__linux__) && defined(SG_IO)
+  vcd->sg_state = -1;
+  vcd->ra_sector = 0;
+  vcd->ra_count = 0;
+#endif
   return vcd;
 }
 
+#if defined(__linux__) && defined(SG_IO)
+static int vcd_sg_read(mp_vcd_priv_t* vcd, unsigned int lba, int sectors)
+{
+  unsigned char cmd[12];
+  struct sg_io_hdr sghdr;
+
+  memset(cmd, 0, sizeof(cmd));
+  cmd[0] = 0xBE;               // READ CD
+  cmd[1] = 5 << 2;             // mode2 / form2
+  AV_WB32(&cmd[2], lba);
+  AV_WB24(&cmd[6], sectors);
+  cmd[9] = 0xF8;               // full raw sector, same layout as CDROMREADRAW
+
+  memset(&sghdr, 0, sizeof(sghdr));
+  sghdr.interface_id = 'S';
+  sghdr.timeout = 20000;
+  sghdr.dxfer_direction = SG_DXFER_FROM_DEV;
+  sghdr.dxfer_len = sectors * VCD_SECTOR_SIZE;
+  sghdr.dxferp = vcd->ra_buf;
+  sghdr.cmd_len = sizeof(cmd);
+  sghdr.cmdp = cmd;
+
+  if (ioctl(vcd->fd, SG_IO, &sghdr) == -1 || sghdr.status)
+    return 0;
+  return sectors - sghdr.resid / VCD_SECTOR_SIZE;
+}
+#endif
+
 static int vcd_read(mp_vcd_priv_t* vcd,char *mem){
 #ifndef sun
+#if defined(__linux__) && defined(SG_IO)
+  unsigned int sect = vcd_get_msf(vcd);
+  if (vcd->sg_state &&
+      (sect < vcd->ra_sector || sect >= vcd->ra_sector + vcd->ra_count)) {
+    int n = vcd_sg_read(vcd, sect, VCD_READAHEAD);
+    if (n <= 0 && vcd->sg_state > 0)
+      n = vcd_sg_read(vcd, sect, 1); // the batch may reach past the lead-out
+    if (n > 0) {
+      vcd->ra_sector = sect;
+      vcd->ra_count  = n;
+      vcd->sg_state  = 1;
+    } else if (vcd->sg_state > 0) {
+      return 0; // EOF?
+    } else {
+      vcd->sg_state = 0; // READ CD not supported, use per-sector ioctls
+      vcd->ra_count = 0;
+    }
+  }
+  if (vcd->sg_state)
+    memcpy(mem, vcd->ra_buf + (sect - vcd->ra_sector) * VCD_SECTOR_SIZE +
+                VCD_SECTOR_OFFS, VCD_SECTOR_DATA);
+  else
+#endif
+  {
   memcpy(vcd->buf,&vcd->entry.cdte_addr.msf,sizeof(struct cdrom_msf));
   if(ioctl(vcd->fd,CDROMREADRAW,vcd->buf)==-1) return 0; // EOF?
   memcpy(mem,&vcd->buf[VCD_SECTOR_OFFS],VCD_SECTOR_DATA);
+  }
 #else
   {
     int offset;
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "config.h"
 #include "demux/demux.h"
@@ -64,6 +65,26 @@ struct dec_sub {
 
     struct sd *sd[MAX_NUM_SD];
     int num_sd;
+
+    // Speculative rendering of the next video frame's subtitles on a worker
+    // thread. All fields below (and all sd calls) are protected by lock; the
+    // mutex is recursive because some entry points call each other.
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    pthread_t prefetch_thread;
+    bool prefetch_thread_valid;
+    bool prefetch_exit;
+    bool prefetch_busy;         // thread is inside the renderer right now
+    bool prefetch_requested;
+    struct mp_osd_res prefetch_dim;
+    double prefetch_pts;
+    bool prefetch_valid;        // prefetched contains a servable result
+    struct sub_bitmaps prefetched;
+    void *prefetched_alloc;
+    // Copy handed out by the last sub_get_bitmaps() call; stays valid until
+    // the next one, so the caller is never affected by a concurrent render.
+    struct sub_bitmaps served;
+    void *served_alloc;
 };
 
 struct packet_list {
@@ -71,13 +92,128 @@ struct packet_list {
     int num_packets;
 };
 
+static struct sd *sub_get_last_sd(struct dec_sub *sub);
+
 struct dec_sub *sub_create(struct MPOpts *opts)
 {
     struct dec_sub *sub = talloc_zero(NULL, struct dec_sub);
     sub->opts = opts;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&sub->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&sub->wakeup, NULL);
+
+    sub->prefetched_alloc = talloc_new(sub);
+    sub->served_alloc = talloc_new(sub);
     return sub;
 }
 
+// Lock out the prefetch thread. While locked, no sd calls can happen on the
+// other thread, so the sub decoders can be accessed freely.
+static void sub_lock(struct dec_sub *sub)
+{
+    pthread_mutex_lock(&sub->lock);
+    while (sub->prefetch_busy)
+        pthread_cond_wait(&sub->wakeup, &sub->lock);
+}
+
+static void sub_unlock(struct dec_sub *sub)
+{
+    pthread_mutex_unlock(&sub->lock);
+}
+
+// Make a deep copy, so the result is independent from the decoder's (or
+// libass') internal buffers, which are invalidated on the next render.
+static void copy_sub_bitmaps(void *ta_ctx, struct sub_bitmaps *src,
+                             struct sub_bitmaps *dst)
+{
+    *dst = *src;
+    dst->parts = NULL;
+    if (!src->num_parts)
+        return;
+    dst->parts = talloc_memdup(ta_ctx, src->parts,
+                               src->num_parts * sizeof(dst->parts[0]));
+    for (int n = 0; n < dst->num_parts; n++) {
+        struct sub_bitmap *b = &dst->parts[n];
+        if (src->format == SUBBITMAP_INDEXED) {
+            struct osd_bmp_indexed *bmp =
+                talloc_memdup(ta_ctx, b->bitmap, sizeof(*bmp));
+            bmp->bitmap = talloc_memdup(ta_ctx, bmp->bitmap,
+                                        b->h * b->stride);
+            b->bitmap = bmp;
+        } else {
+            b->bitmap = talloc_memdup(ta_ctx, b->bitmap, b->h * b->stride);
+        }
+    }
+}
+
+static bool res_equals(struct mp_osd_res a, struct mp_osd_res b)
+{
+    return a.w == b.w && a.h == b.h && a.ml == b.ml && a.mt == b.mt
+        && a.mr == b.mr && a.mb == b.mb
+        && a.display_par == b.display_par;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    struct dec_sub *sub = arg;
+
+    pthread_mutex_lock(&sub->lock);
+    while (!sub->prefetch_exit) {
+        if (!sub->prefetch_requested) {
+            pthread_cond_wait(&sub->wakeup, &sub->lock);
+            continue;
+        }
+        sub->prefetch_requested = false;
+        sub->prefetch_busy = true;
+        struct mp_osd_res dim = sub->prefetch_dim;
+        double pts = sub->prefetch_pts;
+        pthread_mutex_unlock(&sub->lock);
+
+        // While prefetch_busy is set, the decoder state can't change.
+        struct sub_bitmaps res = {0};
+        struct sd *sd = sub_get_last_sd(sub);
+        if (sd && sd->driver->get_bitmaps)
+            sd->driver->get_bitmaps(sd, dim, pts, &res);
+
+        pthread_mutex_lock(&sub->lock);
+        talloc_free_children(sub->prefetched_alloc);
+        copy_sub_bitmaps(sub->prefetched_alloc, &res, &sub->prefetched);
+        sub->prefetch_dim = dim;
+        sub->prefetch_pts = pts;
+        sub->prefetch_valid = true;
+        sub->prefetch_busy = false;
+        pthread_cond_broadcast(&sub->wakeup);
+    }
+    pthread_mutex_unlock(&sub->lock);
+    return NULL;
+}
+
+// Discard prefetched output and cancel pending requests. Call this whenever
+// decoder state changes in a way that could affect rendered output (the
+// thread itself is blocked out by sub_lock() at this point already).
+static void prefetch_invalidate(struct dec_sub *sub)
+{
+    sub->prefetch_requested = false;
+    sub->prefetch_valid = false;
+}
+
+static void prefetch_stop_thread(struct dec_sub *sub)
+{
+    if (!sub->prefetch_thread_valid)
+        return;
+    pthread_mutex_lock(&sub->lock);
+    sub->prefetch_exit = true;
+    pthread_cond_broadcast(&sub->wakeup);
+    pthread_mutex_unlock(&sub->lock);
+    pthread_join(sub->prefetch_thread, NULL);
+    sub->prefetch_thread_valid = false;
+    sub->prefetch_exit = false;
+}
+
 static void sub_uninit(struct dec_sub *sub)
 {
     sub_reset(sub);
@@ -93,7 +229,10 @@ void sub_destroy(struct dec_sub *sub)
 {
     if (!sub)
         return;
+    prefetch_stop_thread(sub);
     sub_uninit(sub);
+    pthread_cond_destroy(&sub->wakeup);
+    pthread_mutex_destroy(&sub->lock);
     talloc_free(sub);
 }
 
@@ -161,7 +300,8 @@ static int sub_init_decoder(struct dec_sub *sub, struct sd *sd)
     return 0;
 }
 
-void sub_init_from_sh(struct dec_sub *sub, struct sh_stream *sh)
+static void sub_init_from_sh_unlocked(struct dec_sub *sub,
+                                      struct sh_stream *sh)
 {
     assert(!sub->num_sd);
     assert(sh && sh->sub);
@@ -202,6 +342,14 @@ void sub_init_from_sh(struct dec_sub *sub, struct sh_stream *sh)
            sh->codec ? sh->codec : "<unknown>");
 }
 
+void sub_init_from_sh(struct dec_sub *sub, struct sh_stream *sh)
+{
+    sub_lock(sub);
+    prefetch_invalidate(sub);
+    sub_init_from_sh_unlocked(sub, sh);
+    sub_unlock(sub);
+}
+
 static struct demux_packet *get_decoded_packet(struct sd *sd)
 {
     return sd->driver->get_converted ? sd->driver->get_converted(sd) : NULL;
@@ -257,7 +405,11 @@ static void decode_chain_recode(struct dec_sub *sub, struct sd **sd, int num_sd,
 
 void sub_decode(struct dec_sub *sub, struct demux_packet *packet)
 {
+    sub_lock(sub);
+    // New events can affect already prefetched output.
+    prefetch_invalidate(sub);
     decode_chain_recode(sub, sub->sd, sub->num_sd, packet);
+    sub_unlock(sub);
 }
 
 static const char *guess_sub_cp(struct packet_list *subs, const char *usercp)
@@ -267,7 +419,7 @@ static const char *guess_sub_cp(struct packet_list *subs, const char *usercp)
 
     // Concat all subs into a buffer. We can't probably do much better without
     // having the original data (which we don't, not anymore).
-    int max_size = 2 * 1024 * 1024;
+    int max_size = MP_CHARSET_GUESS_MAX;
     const char *sep = "\n\n"; // In utf-16: U+0A0A GURMUKHI LETTER UU
     int sep_len = strlen(sep);
     int num_pkt = 0;
@@ -370,6 +522,9 @@ bool sub_read_all_packets(struct dec_sub *sub, struct sh_stream *sh)
     if (!sub_accept_packets_in_advance(sub) || sh->sub->track || sub->num_sd < 1)
         return false;
 
+    sub_lock(sub);
+    prefetch_invalidate(sub);
+
     struct packet_list *subs = talloc_zero(NULL, struct packet_list);
 
     // In some cases, we want to put the packets through a decoder first.
@@ -441,6 +596,7 @@ bool sub_read_all_packets(struct dec_sub *sub, struct sh_stream *sh)
     add_sub_list(sub, preprocess, subs);
 
     talloc_free(subs);
+    sub_unlock(sub);
     return true;
 }
 
@@ -455,13 +611,49 @@ void sub_get_bitmaps(struct dec_sub *sub, struct mp_osd_res dim, double pts,
                      struct sub_bitmaps *res)
 {
     struct MPOpts *opts = sub->opts;
+
+    sub_lock(sub);
     struct sd *sd = sub_get_last_sd(sub);
 
     *res = (struct sub_bitmaps) {0};
-    if (sd && opts->sub_visibility) {
-        if (sd->driver->get_bitmaps)
-            sd->driver->get_bitmaps(sd, dim, pts, res);
+    if (sd && opts->sub_visibility && sd->driver->get_bitmaps) {
+        // Accept the speculatively rendered result if it's for (almost)
+        // exactly this pts - the prediction error for CFR video is far below
+        // the ASS timestamp granularity of 1ms.
+        if (sub->prefetch_valid && res_equals(sub->prefetch_dim, dim) &&
+            fabs(sub->prefetch_pts - pts) < 0.0005)
+        {
+            void *tmp_alloc = sub->served_alloc;
+            struct sub_bitmaps tmp = sub->served;
+            sub->served_alloc = sub->prefetched_alloc;
+            sub->served = sub->prefetched;
+            sub->prefetched_alloc = tmp_alloc;
+            sub->prefetched = tmp;
+        } else {
+            struct sub_bitmaps rendered = {0};
+            sd->driver->get_bitmaps(sd, dim, pts, &rendered);
+            talloc_free_children(sub->served_alloc);
+            copy_sub_bitmaps(sub->served_alloc, &rendered, &sub->served);
+        }
+        *res = sub->served;
+        sub->prefetch_valid = false;
+
+        // Kick off rendering for the (predicted) next frame.
+        if (sub->video_fps > 0 && pts != MP_NOPTS_VALUE) {
+            if (!sub->prefetch_thread_valid) {
+                sub->prefetch_thread_valid =
+                    pthread_create(&sub->prefetch_thread, NULL,
+                                   prefetch_thread, sub) == 0;
+            }
+            if (sub->prefetch_thread_valid) {
+                sub->prefetch_dim = dim;
+                sub->prefetch_pts = pts + 1.0 / sub->video_fps;
+                sub->prefetch_requested = true;
+                pthread_cond_broadcast(&sub->wakeup);
+            }
+        }
     }
+    sub_unlock(sub);
 }
 
 bool sub_has_get_text(struct dec_sub *sub)
@@ -473,33 +665,42 @@ bool sub_has_get_text(struct dec_sub *sub)
 char *sub_get_text(struct dec_sub *sub, double pts)
 {
     struct MPOpts *opts = sub->opts;
-    struct sd *sd = sub_get_last_sd(sub);
     char *text = NULL;
+    sub_lock(sub);
+    struct sd *sd = sub_get_last_sd(sub);
     if (sd && opts->sub_visibility) {
         if (sd->driver->get_text)
             text = sd->driver->get_text(sd, pts);
     }
+    sub_unlock(sub);
     return text;
 }
 
 void sub_reset(struct dec_sub *sub)
 {
+    sub_lock(sub);
+    prefetch_invalidate(sub);
     for (int n = 0; n < sub->num_sd; n++) {
         if (sub->sd[n]->driver->reset)
             sub->sd[n]->driver->reset(sub->sd[n]);
     }
+    sub_unlock(sub);
 }
 
 int sub_control(struct dec_sub *sub, enum sd_ctrl cmd, void *arg)
 {
+    int r = CONTROL_UNKNOWN;
+    sub_lock(sub);
+    prefetch_invalidate(sub);
     for (int n = 0; n < sub->num_sd; n++) {
         if (sub->sd[n]->driver->control) {
-            int r = sub->sd[n]->driver->control(sub->sd[n], cmd, arg);
+            r = sub->sd[n]->driver->control(sub->sd[n], cmd, arg);
             if (r != CONTROL_UNKNOWN)
-                return r;
+                break;
         }
     }
-    return CONTROL_UNKNOWN;
+    sub_unlock(sub);
+    return r;
 }
 
 #define MAX_PACKETS 10
@@ -1,8 +1,10 @@
 #include <dirent.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 #include "osdep/io.h"
 
@@ -10,6 +12,7 @@
 #include "options/options.h"
 #include "options/path.h"
 #include "common/common.h"
+#include "misc/thread_pool.h"
 #include "sub/find_subfiles.h"
 
 static const char *sub_exts[] = {"utf", "utf8", "utf-8", "idx", "sub", "srt",
@@ -59,6 +62,96 @@ static int compare_sub_priority(const void *a, const void *b)
     return strcoll(s1->fname, s2->fname);
 }
 
+// Process-wide cache of directory listings, so that loading one playlist
+// file after another does not re-read the same (possibly remote and slow)
+// directories over and over. Entries are invalidated by directory mtime.
+
+#define DIR_CACHE_MAX_ENTRIES 16
+
+struct dir_cache_entry {
+    char *path;
+    time_t mtime;           // directory mtime at scan time
+    char **names;
+    int num_names;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    void *ctx;              // talloc context for the entries
+    struct dir_cache_entry **entries;
+    int num_entries;
+} dir_cache = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static char **copy_listing(void *talloc_ctx, struct dir_cache_entry *e,
+                           int *num_names)
+{
+    char **names = talloc_array(talloc_ctx, char *, e->num_names);
+    for (int n = 0; n < e->num_names; n++)
+        names[n] = talloc_strdup(names, e->names[n]);
+    *num_names = e->num_names;
+    return names;
+}
+
+// Return the file names in the given directory, served from the cache if its
+// mtime didn't change. The result is a copy owned by talloc_ctx, since the
+// cached data can be dropped by another thread at any time. Returns NULL if
+// the directory can't be read.
+static char **get_dir_listing(void *talloc_ctx, const char *path0,
+                              int *num_names)
+{
+    struct stat st;
+    if (stat(path0, &st) != 0)
+        return NULL;
+
+    pthread_mutex_lock(&dir_cache.lock);
+    for (int n = 0; n < dir_cache.num_entries; n++) {
+        struct dir_cache_entry *e = dir_cache.entries[n];
+        if (strcmp(e->path, path0) == 0) {
+            if (e->mtime == st.st_mtime) {
+                char **names = copy_listing(talloc_ctx, e, num_names);
+                pthread_mutex_unlock(&dir_cache.lock);
+                return names;
+            }
+            talloc_free(e);
+            MP_TARRAY_REMOVE_AT(dir_cache.entries, dir_cache.num_entries, n);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&dir_cache.lock);
+
+    // Scan with the lock dropped - remote directories can take seconds, and
+    // concurrent scans of different directories should not serialize.
+    DIR *d = opendir(path0);
+    if (!d)
+        return NULL;
+    struct dir_cache_entry *e = talloc_zero(NULL, struct dir_cache_entry);
+    e->path = talloc_strdup(e, path0);
+    e->mtime = st.st_mtime;
+    struct dirent *de;
+    while ((de = readdir(d)))
+        MP_TARRAY_APPEND(e, e->names, e->num_names,
+                         talloc_strdup(e, de->d_name));
+    closedir(d);
+
+    char **names = copy_listing(talloc_ctx, e, num_names);
+
+    pthread_mutex_lock(&dir_cache.lock);
+    if (!dir_cache.ctx)
+        dir_cache.ctx = talloc_new(NULL);
+    // A concurrent scan of the same directory at worst inserts a duplicate
+    // entry, which simply ages out.
+    if (dir_cache.num_entries >= DIR_CACHE_MAX_ENTRIES) {
+        talloc_free(dir_cache.entries[0]);
+        MP_TARRAY_REMOVE_AT(dir_cache.entries, dir_cache.num_entries, 0);
+    }
+    talloc_steal(dir_cache.ctx, e);
+    MP_TARRAY_APPEND(dir_cache.ctx, dir_cache.entries,
+                     dir_cache.num_entries, e);
+    pthread_mutex_unlock(&dir_cache.lock);
+
+    return names;
+}
+
 static struct bstr guess_lang_from_filename(struct bstr name)
 {
     if (name.len < 2)
@@ -109,13 +202,13 @@ static void append_dir_subtitles(struct MPOpts *opts,
     // 2 = any sub file containing movie name
     // 3 = sub file containing movie name and the lang extension
     char *path0 = bstrdup0(tmpmem, path);
-    DIR *d = opendir(path0);
-    if (!d)
+    int num_names = 0;
+    char **names = get_dir_listing(tmpmem, path0, &num_names);
+    if (!names)
         goto out;
     mp_msg(MSGT_SUBREADER, MSGL_V, "Load subtitles in %.*s\n", BSTR_P(path));
-    struct dirent *de;
-    while ((de = readdir(d))) {
-        struct bstr dename = bstr0(de->d_name);
+    for (int i = 0; i < num_names; i++) {
+        struct bstr dename = bstr0(names[i]);
         void *tmpmem2 = talloc_new(tmpmem);
 
         // retrieve various parts of the filename
@@ -159,7 +252,7 @@ static void append_dir_subtitles(struct MPOpts *opts,
         }
 
         mp_msg(MSGT_SUBREADER, MSGL_DBG2, "Potential sub file: "
-               "\"%s\"  Priority: %d\n", de->d_name, prio);
+               "\"%s\"  Priority: %d\n", names[i], prio);
         if (prio) {
             prio += prio;
             char *subpath = mp_path_join(*slist, path, dename);
@@ -181,7 +274,6 @@ static void append_dir_subtitles(struct MPOpts *opts,
     next_sub:
         talloc_free(tmpmem2);
     }
-    closedir(d);
 
  out:
     talloc_free(tmpmem);
@@ -252,3 +344,29 @@ struct subfn *find_text_subtitles(struct MPOpts *opts, const char *fname)
 
     return slist;
 }
+
+struct prefetch_args {
+    struct MPOpts *opts;
+    char *fname;
+};
+
+static void prefetch_job(void *p)
+{
+    struct prefetch_args *args = p;
+    // Run a throwaway search; all we want is its side effect of putting the
+    // directory listings into the cache.
+    talloc_free(find_text_subtitles(args->opts, args->fname));
+    talloc_free(args);
+}
+
+// Scan fname's subtitle search path into the directory cache in the
+// background, so that a later find_text_subtitles() call for it (e.g. on the
+// playlist transition to fname) doesn't stall playback start.
+void mp_prefetch_text_subtitles(struct mp_thread_pool *pool,
+                                struct MPOpts *opts, const char *fname)
+{
+    struct prefetch_args *args = talloc_zero(NULL, struct prefetch_args);
+    args->opts = opts;
+    args->fname = talloc_strdup(args, fname);
+    mp_thread_pool_queue(pool, prefetch_job, args);
+}
@@ -20,6 +20,7 @@
 #define MPLAYER_FIND_SUBFILES_H
 
 struct MPOpts;
+struct mp_thread_pool;
 
 struct subfn {
     int priority;
@@ -28,5 +29,7 @@ struct subfn {
 };
 
 struct subfn *find_text_subtitles(struct MPOpts *opts, const char *fname);
+void mp_prefetch_text_subtitles(struct mp_thread_pool *pool,
+                                struct MPOpts *opts, const char *fname);
 
 #endif /* MPLAYER_FINDFILES_H */
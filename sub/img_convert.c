@@ -35,6 +35,9 @@ struct osd_conv_cache {
     struct sub_bitmap part[MP_SUB_BB_LIST_MAX];
     struct sub_bitmap *parts;
     void *scratch;
+    // reused result buffers (osd_conv_idx_to_rgba())
+    struct mp_image **images;
+    int num_images;
 };
 
 struct osd_conv_cache *osd_conv_cache_new(void)
@@ -42,6 +45,28 @@ struct osd_conv_cache *osd_conv_cache_new(void)
     return talloc_zero(NULL, struct osd_conv_cache);
 }
 
+// Return a cached BGRA image of the given size. Part sizes are stable for the
+// whole lifetime of a subtitle event, so this usually reuses the buffer of
+// the previous frame instead of allocating a new one.
+static struct mp_image *get_cache_image(struct osd_conv_cache *c, int n,
+                                        int w, int h)
+{
+    if (n >= c->num_images) {
+        c->images = talloc_realloc(c, c->images, struct mp_image *, n + 1);
+        for (int i = c->num_images; i <= n; i++)
+            c->images[i] = NULL;
+        c->num_images = n + 1;
+    }
+    struct mp_image *image = c->images[n];
+    if (!image || image->w != w || image->h != h) {
+        talloc_free(image);
+        image = mp_image_alloc(IMGFMT_BGRA, w, h);
+        talloc_steal(c->images, image);
+        c->images[n] = image;
+    }
+    return image;
+}
+
 static void rgba_to_premultiplied_rgba(uint32_t *colors, size_t count)
 {
     for (int n = 0; n < count; n++) {
@@ -64,8 +89,11 @@ bool osd_conv_idx_to_rgba(struct osd_conv_cache *c, struct sub_bitmaps *imgs)
         return false;
 
     imgs->format = SUBBITMAP_RGBA;
-    talloc_free(c->parts);
-    imgs->parts = c->parts = talloc_array(c, struct sub_bitmap, src.num_parts);
+    if (talloc_get_size(c->parts) != src.num_parts * sizeof(c->parts[0])) {
+        talloc_free(c->parts);
+        c->parts = talloc_array(c, struct sub_bitmap, src.num_parts);
+    }
+    imgs->parts = c->parts;
 
     for (int n = 0; n < src.num_parts; n++) {
         struct sub_bitmap *d = &imgs->parts[n];
@@ -75,16 +103,27 @@ bool osd_conv_idx_to_rgba(struct osd_conv_cache *c, struct sub_bitmaps *imgs)
         rgba_to_premultiplied_rgba(sb.palette, 256);
 
         *d = *s;
-        struct mp_image *image = mp_image_alloc(IMGFMT_BGRA, s->w, s->h);
-        talloc_steal(c->parts, image);
+        struct mp_image *image = get_cache_image(c, n, s->w, s->h);
         d->stride = image->stride[0];
         d->bitmap = image->planes[0];
 
         for (int y = 0; y < s->h; y++) {
             uint8_t *inbmp = sb.bitmap + y * s->stride;
             uint32_t *outbmp = (uint32_t*)((uint8_t*)d->bitmap + y * d->stride);
-            for (int x = 0; x < s->w; x++)
-                *outbmp++ = sb.palette[*inbmp++];
+            // DVD/PGS bitmaps are dominated by long runs of the same index
+            // (transparent background, solid fills). Expanding them run-wise
+            // turns the per-pixel table lookup into constant fills, which the
+            // compiler can vectorize.
+            int x = 0;
+            while (x < s->w) {
+                uint8_t v = inbmp[x];
+                int end = x + 1;
+                while (end < s->w && inbmp[end] == v)
+                    end++;
+                uint32_t pix = sb.palette[v];
+                for (; x < end; x++)
+                    outbmp[x] = pix;
+            }
         }
     }
     return true;
@@ -259,6 +259,8 @@ struct draw_on_image_closure {
     struct mp_image *dest;
     struct mp_image_pool *pool;
     bool changed;
+    struct mp_rect drawn;       // bounding box of all drawn regions
+    bool have_drawn;
 };
 
 static void draw_on_image(void *ctx, struct sub_bitmaps *imgs)
@@ -273,6 +275,21 @@ static void draw_on_image(void *ctx, struct sub_bitmaps *imgs)
     mp_draw_sub_bitmaps(&osd->draw_cache, closure->dest, imgs);
     talloc_steal(osd, osd->draw_cache);
     closure->changed = true;
+
+    struct mp_rect rc_list[MP_SUB_BB_LIST_MAX];
+    int num_rc = mp_get_sub_bb_list(imgs, rc_list, MP_SUB_BB_LIST_MAX);
+    for (int n = 0; n < num_rc; n++) {
+        struct mp_rect rc = rc_list[n];
+        struct mp_rect bounds = {0, 0, closure->dest->w, closure->dest->h};
+        if (!mp_rect_intersection(&rc, &bounds))
+            continue;
+        if (closure->have_drawn) {
+            mp_rect_union(&closure->drawn, &rc);
+        } else {
+            closure->drawn = rc;
+            closure->have_drawn = true;
+        }
+    }
 }
 
 // Calls mp_image_make_writeable() on the dest image if something is drawn.
@@ -286,6 +303,23 @@ bool osd_draw_on_image(struct osd_state *osd, struct mp_osd_res res,
     return closure.changed;
 }
 
+// Like osd_draw_on_image(), but additionally return the bounding box of the
+// regions of dest the OSD was blended into. *out_drawn is set to a 0-sized
+// rect if nothing was drawn. This is intended for incremental redrawing:
+// outside of the returned rect, dest still contains the unmodified video
+// frame, so a VO only has to restore and re-blend this region on the next
+// redraw of the same frame.
+bool osd_draw_on_image_bb(struct osd_state *osd, struct mp_osd_res res,
+                          double video_pts, int draw_flags,
+                          struct mp_image *dest, struct mp_rect *out_drawn)
+{
+    struct draw_on_image_closure closure = {osd, dest};
+    osd_draw(osd, res, video_pts, draw_flags, mp_draw_sub_formats,
+             &draw_on_image, &closure);
+    *out_drawn = closure.have_drawn ? closure.drawn : (struct mp_rect){0};
+    return closure.changed;
+}
+
 // Like osd_draw_on_image(), but if dest needs to be copied to make it
 // writeable, allocate images from the given pool. (This is a minor
 // optimization to reduce "real" image sized memory allocations.)
@@ -115,13 +115,18 @@ struct osd_object {
     struct mp_osd_res vo_res;
 
     // Internally used by osd_libass.c
+    struct bstr last_state; // see obj_check_changed()
+    struct bstr progbar_state; // inputs of the cached static progbar events
     struct sub_bitmap *parts_cache;
     struct ass_track *osd_track;
-    struct ass_renderer *osd_render;
-    struct ass_library *osd_ass_library;
 };
 
 struct osd_state {
+    // Renderer shared by all OSD parts, so identical fonts are rasterized
+    // and cached only once.
+    struct ass_renderer *osd_render;
+    struct ass_library *osd_ass_library;
+
     struct osd_object *objs[MAX_OSD_PARTS];
 
     double video_offset;
@@ -223,6 +228,11 @@ struct mp_image;
 bool osd_draw_on_image(struct osd_state *osd, struct mp_osd_res res,
                        double video_pts, int draw_flags, struct mp_image *dest);
 
+struct mp_rect;
+bool osd_draw_on_image_bb(struct osd_state *osd, struct mp_osd_res res,
+                          double video_pts, int draw_flags,
+                          struct mp_image *dest, struct mp_rect *out_drawn);
+
 struct mp_image_pool;
 void osd_draw_on_image_p(struct osd_state *osd, struct mp_osd_res res,
                          double video_pts, int draw_flags,
@@ -43,21 +43,21 @@ void osd_init_backend(struct osd_state *osd)
 {
 }
 
-static void create_ass_renderer(struct osd_state *osd, struct osd_object *obj)
+static void create_ass_renderer(struct osd_state *osd)
 {
-    if (obj->osd_render)
+    if (osd->osd_render)
         return;
 
-    obj->osd_ass_library = mp_ass_init(osd->opts);
-    ass_add_font(obj->osd_ass_library, "mpv-osd-symbols", (void *)osd_font_pfb,
+    osd->osd_ass_library = mp_ass_init(osd->opts);
+    ass_add_font(osd->osd_ass_library, "mpv-osd-symbols", (void *)osd_font_pfb,
                  sizeof(osd_font_pfb) - 1);
 
-    obj->osd_render = ass_renderer_init(obj->osd_ass_library);
-    if (!obj->osd_render)
+    osd->osd_render = ass_renderer_init(osd->osd_ass_library);
+    if (!osd->osd_render)
         abort();
 
-    mp_ass_configure_fonts(obj->osd_render, osd->opts->osd_style);
-    ass_set_aspect_ratio(obj->osd_render, 1.0, 1.0);
+    mp_ass_configure_fonts(osd->osd_render, osd->opts->osd_style);
+    ass_set_aspect_ratio(osd->osd_render, 1.0, 1.0);
 }
 
 void osd_destroy_backend(struct osd_state *osd)
@@ -67,23 +67,23 @@ void osd_destroy_backend(struct osd_state *osd)
         if (obj->osd_track)
             ass_free_track(obj->osd_track);
         obj->osd_track = NULL;
-        if (obj->osd_render)
-            ass_renderer_done(obj->osd_render);
-        obj->osd_render = NULL;
-        if (obj->osd_ass_library)
-            ass_library_done(obj->osd_ass_library);
-        obj->osd_ass_library = NULL;
     }
+    if (osd->osd_render)
+        ass_renderer_done(osd->osd_render);
+    osd->osd_render = NULL;
+    if (osd->osd_ass_library)
+        ass_library_done(osd->osd_ass_library);
+    osd->osd_ass_library = NULL;
 }
 
 static void create_ass_track(struct osd_state *osd, struct osd_object *obj,
                              int res_x, int res_y)
 {
-    create_ass_renderer(osd, obj);
+    create_ass_renderer(osd);
 
     ASS_Track *track = obj->osd_track;
     if (!track)
-        track = ass_new_track(obj->osd_ass_library);
+        track = ass_new_track(osd->osd_ass_library);
 
     int old_res_x = track->PlayResX;
     int old_res_y = track->PlayResY;
@@ -101,7 +101,7 @@ static void create_ass_track(struct osd_state *osd, struct osd_object *obj,
     // Force libass to clear its internal cache - it doesn't check for
     // PlayRes changes itself.
     if (old_res_x != track->PlayResX || old_res_y != track->PlayResY)
-        ass_set_frame_size(obj->osd_render, 1, 1);
+        ass_set_frame_size(osd->osd_render, 1, 1);
 
     if (track->n_styles < 2) {
         int sid = ass_alloc_style(track);
@@ -277,6 +277,17 @@ static void ass_draw_reset(struct ass_draw *d)
     d->text = NULL;
 }
 
+static void state_append(void *ta_ctx, bstr *s, const void *data, size_t size)
+{
+    bstr_xappend(ta_ctx, s, (bstr){(unsigned char *)data, size});
+}
+
+static void state_append_str(void *ta_ctx, bstr *s, const char *str)
+{
+    // Include the terminating 0, so concatenated strings can't be confused.
+    state_append(ta_ctx, s, str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
 static void get_osd_bar_box(struct osd_state *osd, struct osd_object *obj,
                             float *o_x, float *o_y, float *o_w, float *o_h,
                             float *o_border)
@@ -313,10 +324,63 @@ static void update_progbar(struct osd_state *osd, struct osd_object *obj)
     float px, py, width, height, border;
     get_osd_bar_box(osd, obj, &px, &py, &width, &height, &border);
 
-    clear_obj(obj);
+    if (osd->progbar_type < 0) {
+        clear_obj(obj);
+        talloc_free(obj->progbar_state.start);
+        obj->progbar_state = (bstr){0};
+        return;
+    }
+
+    float pos = osd->progbar_value * width - border / 2;
+
+    struct ass_draw *d = &(struct ass_draw) { .scale = 4 };
+    // filled area
+    d->text = talloc_asprintf_append(d->text, "{\\bord0\\pos(%f,%f)}", px, py);
+    ass_draw_start(d);
+    ass_draw_rect_cw(d, 0, 0, pos, height);
+    ass_draw_stop(d);
+    char *fill = d->text;
+    d->text = NULL;
+
+    // position marker
+    d->text = talloc_asprintf_append(d->text, "{\\bord%f\\pos(%f,%f)}",
+                                     border / 2, px, py);
+    ass_draw_start(d);
+    ass_draw_move_to(d, pos + border / 2, 0);
+    ass_draw_line_to(d, pos + border / 2, height);
+    ass_draw_stop(d);
+    char *marker = d->text;
+    d->text = NULL;
+
+    // The remaining events (the symbol, and the box with one dent per
+    // chapter mark) don't depend on the position. Regenerating their vector
+    // strings dominates the update, so keep them across position changes
+    // and replace only the two events built above in place.
+    bstr state = {0};
+    state_append(NULL, &state, &osd->progbar_type, sizeof(osd->progbar_type));
+    state_append(NULL, &state, osd->progbar_stops,
+                 osd->progbar_num_stops * sizeof(osd->progbar_stops[0]));
+    float geometry[5] = {px, py, width, height, border};
+    state_append(NULL, &state, geometry, sizeof(geometry));
 
-    if (osd->progbar_type < 0)
+    ASS_Track *track = obj->osd_track;
+    if (obj->progbar_state.start && bstr_equals(state, obj->progbar_state) &&
+        track->n_events == 4)
+    {
+        talloc_free(state.start);
+        free(track->events[1].Text);
+        track->events[1].Text = strdup(fill);
+        free(track->events[2].Text);
+        track->events[2].Text = strdup(marker);
+        talloc_free(fill);
+        talloc_free(marker);
         return;
+    }
+    talloc_free(obj->progbar_state.start);
+    talloc_steal(obj, state.start);
+    obj->progbar_state = state;
+
+    clear_obj(obj);
 
     float sx = px - border * 2 - height / 4; // includes additional spacing
     float sy = py + height / 2;
@@ -333,28 +397,14 @@ static void update_progbar(struct osd_state *osd, struct osd_object *obj)
         text = talloc_strdup_append_buffer(text, "{\\r}");
     }
 
-    add_osd_ass_event(obj->osd_track, text);
+    add_osd_ass_event(track, text);
     talloc_free(text);
 
-    struct ass_draw *d = &(struct ass_draw) { .scale = 4 };
-    // filled area
-    d->text = talloc_asprintf_append(d->text, "{\\bord0\\pos(%f,%f)}", px, py);
-    ass_draw_start(d);
-    float pos = osd->progbar_value * width - border / 2;
-    ass_draw_rect_cw(d, 0, 0, pos, height);
-    ass_draw_stop(d);
-    add_osd_ass_event(obj->osd_track, d->text);
-    ass_draw_reset(d);
+    add_osd_ass_event(track, fill);
+    talloc_free(fill);
 
-    // position marker
-    d->text = talloc_asprintf_append(d->text, "{\\bord%f\\pos(%f,%f)}",
-                                     border / 2, px, py);
-    ass_draw_start(d);
-    ass_draw_move_to(d, pos + border / 2, 0);
-    ass_draw_line_to(d, pos + border / 2, height);
-    ass_draw_stop(d);
-    add_osd_ass_event(obj->osd_track, d->text);
-    ass_draw_reset(d);
+    add_osd_ass_event(track, marker);
+    talloc_free(marker);
 
     d->text = talloc_asprintf_append(d->text, "{\\pos(%f,%f)}", px, py);
     ass_draw_start(d);
@@ -412,9 +462,9 @@ static void update_sub(struct osd_state *osd, struct osd_object *obj)
     if (!osd->sub_text || !osd->sub_text[0])
         return;
 
-    create_ass_renderer(osd, obj);
+    create_ass_renderer(osd);
     if (!obj->osd_track)
-        obj->osd_track = mp_ass_default_track(obj->osd_ass_library, osd->opts);
+        obj->osd_track = mp_ass_default_track(osd->osd_ass_library, osd->opts);
 
     struct osd_style_opts font = *opts->sub_text_style;
     font.font_size *= opts->sub_scale;
@@ -423,7 +473,7 @@ static void update_sub(struct osd_state *osd, struct osd_object *obj)
     mp_ass_set_style(style, obj->osd_track->PlayResY, &font);
 
 #if LIBASS_VERSION >= 0x01010000
-    ass_set_line_position(obj->osd_render, 100 - opts->sub_pos);
+    ass_set_line_position(osd->osd_render, 100 - opts->sub_pos);
 #endif
 
     char *escaped_text = mangle_ass(osd->sub_text);
@@ -431,6 +481,70 @@ static void update_sub(struct osd_state *osd, struct osd_object *obj)
     talloc_free(escaped_text);
 }
 
+// Serialize everything update_object() output depends on for the given object.
+// Option structs are compared as raw bytes; changing an option always writes
+// new values (and reallocates contained strings), so a byte-identical state
+// means the resulting ASS track would be identical too.
+static bstr get_object_state(struct osd_state *osd, struct osd_object *obj)
+{
+    struct MPOpts *opts = osd->opts;
+    bstr s = {0};
+    state_append(NULL, &s, &obj->vo_res, sizeof(obj->vo_res));
+    switch (obj->type) {
+    case OSDTYPE_OSD:
+        state_append_str(NULL, &s, osd->osd_text);
+        state_append(NULL, &s, opts->osd_style, sizeof(*opts->osd_style));
+        state_append(NULL, &s, &opts->osd_scale, sizeof(opts->osd_scale));
+        state_append(NULL, &s, &opts->osd_scale_by_window,
+                     sizeof(opts->osd_scale_by_window));
+        break;
+    case OSDTYPE_SUBTEXT:
+        state_append_str(NULL, &s, osd->sub_text);
+        state_append(NULL, &s, opts->sub_text_style,
+                     sizeof(*opts->sub_text_style));
+        state_append(NULL, &s, &opts->sub_scale, sizeof(opts->sub_scale));
+        state_append(NULL, &s, &opts->sub_pos, sizeof(opts->sub_pos));
+        break;
+    case OSDTYPE_PROGBAR:
+        state_append(NULL, &s, &osd->progbar_type, sizeof(osd->progbar_type));
+        state_append(NULL, &s, &osd->progbar_value, sizeof(osd->progbar_value));
+        state_append(NULL, &s, osd->progbar_stops,
+                     osd->progbar_num_stops * sizeof(osd->progbar_stops[0]));
+        state_append(NULL, &s, opts->osd_style, sizeof(*opts->osd_style));
+        state_append(NULL, &s, &opts->osd_bar_align_x,
+                     sizeof(opts->osd_bar_align_x));
+        state_append(NULL, &s, &opts->osd_bar_align_y,
+                     sizeof(opts->osd_bar_align_y));
+        state_append(NULL, &s, &opts->osd_bar_w, sizeof(opts->osd_bar_w));
+        state_append(NULL, &s, &opts->osd_bar_h, sizeof(opts->osd_bar_h));
+        break;
+    case OSDTYPE_EXTERNAL:
+        state_append_str(NULL, &s, osd->external);
+        state_append(NULL, &s, &osd->external_res_x,
+                     sizeof(osd->external_res_x));
+        state_append(NULL, &s, &osd->external_res_y,
+                     sizeof(osd->external_res_y));
+        break;
+    }
+    return s;
+}
+
+// Return true if the object's state changed since the last update_object()
+// call (and remember the new state), false if rebuilding the ASS track would
+// reproduce exactly what is there already.
+static bool obj_check_changed(struct osd_state *osd, struct osd_object *obj)
+{
+    bstr state = get_object_state(osd, obj);
+    if (obj->last_state.start && bstr_equals(state, obj->last_state)) {
+        talloc_free(state.start);
+        return false;
+    }
+    talloc_free(obj->last_state.start);
+    talloc_steal(obj, state.start);
+    obj->last_state = state;
+    return true;
+}
+
 static void update_object(struct osd_state *osd, struct osd_object *obj)
 {
     switch (obj->type) {
@@ -452,16 +566,24 @@ static void update_object(struct osd_state *osd, struct osd_object *obj)
 void osd_object_get_bitmaps(struct osd_state *osd, struct osd_object *obj,
                             struct sub_bitmaps *out_imgs)
 {
-    if (obj->force_redraw)
-        update_object(osd, obj);
+    if (obj->force_redraw) {
+        // Rebuilding the track and re-laying it out is relatively expensive,
+        // and redraw requests are often no-ops (e.g. an OSD message whose
+        // text didn't change, or a seek bar at the same position) - skip them.
+        if (obj_check_changed(osd, obj)) {
+            update_object(osd, obj);
+        } else {
+            obj->force_redraw = false;
+        }
+    }
 
     *out_imgs = (struct sub_bitmaps) {0};
     if (!obj->osd_track)
         return;
 
-    ass_set_frame_size(obj->osd_render, obj->vo_res.w, obj->vo_res.h);
-    ass_set_aspect_ratio(obj->osd_render, obj->vo_res.display_par, 1.0);
-    mp_ass_render_frame(obj->osd_render, obj->osd_track, 0,
+    ass_set_frame_size(osd->osd_render, obj->vo_res.w, obj->vo_res.h);
+    ass_set_aspect_ratio(osd->osd_render, obj->vo_res.display_par, 1.0);
+    mp_ass_render_frame(osd->osd_render, obj->osd_track, 0,
                         &obj->parts_cache, out_imgs);
     talloc_steal(obj, obj->parts_cache);
 }
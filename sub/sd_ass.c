@@ -42,6 +42,16 @@ struct sd_ass_priv {
     char last_text[500];
     struct mp_image_params video_params;
     struct mp_image_params last_params;
+    // Start-time sorted view of the track's events, used by get_text() on
+    // large tracks. Rebuilt whenever the event count changes.
+    struct ev_start *ev_index;
+    int ev_index_count;
+    long long ev_max_duration;
+};
+
+struct ev_start {
+    long long start;
+    int idx;
 };
 
 static void mangle_colors(struct sd *sd, struct sub_bitmaps *parts);
@@ -228,6 +238,49 @@ static bool is_whitespace_only(char *s, int len)
     return true;
 }
 
+static void append_event_text(struct buf *b, ASS_Event *event)
+{
+    if (!event->Text)
+        return;
+    int start = b->len;
+    ass_to_plaintext(b, event->Text);
+    if (is_whitespace_only(&b->start[start], b->len - start)) {
+        b->len = start;
+    } else {
+        append(b, '\n');
+    }
+}
+
+static int cmp_ev_start(const void *pa, const void *pb)
+{
+    const struct ev_start *a = pa, *b = pb;
+    if (a->start != b->start)
+        return a->start < b->start ? -1 : 1;
+    return a->idx - b->idx;
+}
+
+// Below this number of events, a plain linear scan is cheap enough.
+#define EV_INDEX_MIN 1000
+
+static void update_ev_index(struct sd *sd)
+{
+    struct sd_ass_priv *ctx = sd->priv;
+    ASS_Track *track = ctx->ass_track;
+    if (track->n_events == ctx->ev_index_count)
+        return;
+    ctx->ev_index = talloc_realloc(ctx, ctx->ev_index, struct ev_start,
+                                   track->n_events);
+    ctx->ev_max_duration = 0;
+    for (int i = 0; i < track->n_events; i++) {
+        ctx->ev_index[i] = (struct ev_start){track->events[i].Start, i};
+        ctx->ev_max_duration = MPMAX(ctx->ev_max_duration,
+                                     track->events[i].Duration);
+    }
+    qsort(ctx->ev_index, track->n_events, sizeof(*ctx->ev_index),
+          cmp_ev_start);
+    ctx->ev_index_count = track->n_events;
+}
+
 static char *get_text(struct sd *sd, double pts)
 {
     struct sd_ass_priv *ctx = sd->priv;
@@ -239,18 +292,43 @@ static char *get_text(struct sd *sd, double pts)
 
     struct buf b = {ctx->last_text, sizeof(ctx->last_text) - 1};
 
-    for (int i = 0; i < track->n_events; ++i) {
-        ASS_Event *event = track->events + i;
-        if (ipts >= event->Start && ipts < event->Start + event->Duration) {
-            if (event->Text) {
-                int start = b.len;
-                ass_to_plaintext(&b, event->Text);
-                if (is_whitespace_only(&b.start[start], b.len - start)) {
-                    b.len = start;
-                } else {
-                    append(&b, '\n');
-                }
-            }
+    if (track->n_events >= EV_INDEX_MIN) {
+        update_ev_index(sd);
+        // Find the first event that can still overlap ipts; everything from
+        // there up to the first event starting past ipts needs a look.
+        int lo = 0, hi = ctx->ev_index_count;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (ctx->ev_index[mid].start + ctx->ev_max_duration > ipts)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        int *matches = NULL;
+        int num_matches = 0;
+        for (int n = lo; n < ctx->ev_index_count; n++) {
+            if (ctx->ev_index[n].start > ipts)
+                break;
+            ASS_Event *event = track->events + ctx->ev_index[n].idx;
+            if (ipts >= event->Start && ipts < event->Start + event->Duration)
+                MP_TARRAY_APPEND(NULL, matches, num_matches,
+                                 ctx->ev_index[n].idx);
+        }
+        // Emit in event list order, like the linear scan below.
+        for (int n = 1; n < num_matches; n++) {
+            int v = matches[n], m = n;
+            for (; m > 0 && matches[m - 1] > v; m--)
+                matches[m] = matches[m - 1];
+            matches[m] = v;
+        }
+        for (int n = 0; n < num_matches; n++)
+            append_event_text(&b, track->events + matches[n]);
+        talloc_free(matches);
+    } else {
+        for (int i = 0; i < track->n_events; ++i) {
+            ASS_Event *event = track->events + i;
+            if (ipts >= event->Start && ipts < event->Start + event->Duration)
+                append_event_text(&b, event);
         }
     }
 
@@ -225,10 +225,11 @@ static void crop_image(struct sub_bitmap *part)
             cur++;
         int start_visible = cur;
         int last_visible = -1;
-        while (cur < part->w) {
-            if (!invisible[pixels[cur]])
-                last_visible = cur;
-            cur++;
+        if (start_visible < part->w) {
+            // Scan from the right; DVD sub rows are mostly transparent.
+            last_visible = part->w - 1;
+            while (invisible[pixels[last_visible]])
+                last_visible--;
         }
         x0 = FFMIN(x0, start_visible);
         x1 = FFMAX(x1, last_visible);
@@ -14,6 +14,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #define TA_NO_WRAPPERS
@@ -55,7 +57,14 @@ union aligned_header {
 #define PTR_TO_HEADER(ptr) (&((union aligned_header *)(ptr) - 1)->ta)
 #define PTR_FROM_HEADER(h) ((void *)((union aligned_header *)(h) + 1))
 
-#define MAX_ALLOC (((size_t)-1) - sizeof(union aligned_header))
+/* The top bits of ta_header.size flag arena contexts (created with
+ * ta_arena_new()) and allocations whose memory was served from an arena
+ * slab. The low bits hold the user allocation size as before. */
+#define TA_FLAG_ARENA    ((size_t)1 << (sizeof(size_t) * 8 - 1))
+#define TA_FLAG_IN_ARENA ((size_t)1 << (sizeof(size_t) * 8 - 2))
+#define TA_SIZE_MASK     (~(TA_FLAG_ARENA | TA_FLAG_IN_ARENA))
+
+#define MAX_ALLOC (TA_SIZE_MASK - sizeof(union aligned_header))
 
 // Needed for non-leaf allocations, or extended features such as destructors.
 struct ta_ext_header {
@@ -71,6 +80,71 @@ static void ta_dbg_add(struct ta_header *h);
 static void ta_dbg_check_header(struct ta_header *h);
 static void ta_dbg_remove(struct ta_header *h);
 
+// User data of an arena context; the slabs the children live in.
+struct ta_arena {
+    struct ta_arena_slab *slab; // most recently added slab
+};
+
+struct ta_arena_slab {
+    struct ta_arena_slab *prev;
+    size_t used;
+    size_t size;
+    // slab memory follows (MIN_ALIGN aligned)
+};
+
+#define ARENA_SLAB_SIZE (64 * 1024)
+#define ARENA_SLAB_HDR ((sizeof(struct ta_arena_slab) + MIN_ALIGN - 1) \
+                        & ~(size_t)(MIN_ALIGN - 1))
+
+// Bump-allocate bytes from the arena's slabs. Returns NULL on OOM.
+static void *arena_bump(struct ta_arena *arena, size_t bytes)
+{
+    bytes = (bytes + MIN_ALIGN - 1) & ~(size_t)(MIN_ALIGN - 1);
+    struct ta_arena_slab *slab = arena->slab;
+    if (!slab || slab->size - slab->used < bytes) {
+        size_t slab_size = bytes > ARENA_SLAB_SIZE ? bytes : ARENA_SLAB_SIZE;
+        slab = malloc(ARENA_SLAB_HDR + slab_size);
+        if (!slab)
+            return NULL;
+        *slab = (struct ta_arena_slab) {
+            .prev = arena->slab,
+            .size = slab_size,
+        };
+        arena->slab = slab;
+    }
+    void *ptr = (char *)slab + ARENA_SLAB_HDR + slab->used;
+    slab->used += bytes;
+    return ptr;
+}
+
+// Make the slab memory reusable, keeping the most recent slab allocated.
+// All children must have been freed (their headers live in the slabs).
+static void arena_reset(struct ta_arena *arena)
+{
+    struct ta_arena_slab *slab = arena->slab;
+    if (!slab)
+        return;
+    struct ta_arena_slab *prev = slab->prev;
+    slab->used = 0;
+    slab->prev = NULL;
+    while (prev) {
+        struct ta_arena_slab *next = prev->prev;
+        free(prev);
+        prev = next;
+    }
+}
+
+static void arena_destroy(struct ta_arena *arena)
+{
+    struct ta_arena_slab *slab = arena->slab;
+    while (slab) {
+        struct ta_arena_slab *prev = slab->prev;
+        free(slab);
+        slab = prev;
+    }
+    arena->slab = NULL;
+}
+
 static struct ta_header *get_header(void *ptr)
 {
     struct ta_header *h = ptr ? PTR_TO_HEADER(ptr) : NULL;
@@ -140,10 +214,20 @@ void *ta_alloc_size(void *ta_parent, size_t size)
 {
     if (size >= MAX_ALLOC)
         return NULL;
-    struct ta_header *h = malloc(sizeof(union aligned_header) + size);
-    if (!h)
-        return NULL;
-    *h = (struct ta_header) {.size = size};
+    struct ta_header *h;
+    struct ta_header *parent_h = get_header(ta_parent);
+    if (parent_h && (parent_h->size & TA_FLAG_ARENA)) {
+        h = arena_bump(PTR_FROM_HEADER(parent_h),
+                       sizeof(union aligned_header) + size);
+        if (!h)
+            return NULL;
+        *h = (struct ta_header) {.size = size | TA_FLAG_IN_ARENA};
+    } else {
+        h = malloc(sizeof(union aligned_header) + size);
+        if (!h)
+            return NULL;
+        *h = (struct ta_header) {.size = size};
+    }
     ta_dbg_add(h);
     void *ptr = PTR_FROM_HEADER(h);
     if (!ta_set_parent(ptr, ta_parent)) {
@@ -160,10 +244,21 @@ void *ta_zalloc_size(void *ta_parent, size_t size)
 {
     if (size >= MAX_ALLOC)
         return NULL;
-    struct ta_header *h = calloc(1, sizeof(union aligned_header) + size);
-    if (!h)
-        return NULL;
-    *h = (struct ta_header) {.size = size};
+    struct ta_header *h;
+    struct ta_header *parent_h = get_header(ta_parent);
+    if (parent_h && (parent_h->size & TA_FLAG_ARENA)) {
+        h = arena_bump(PTR_FROM_HEADER(parent_h),
+                       sizeof(union aligned_header) + size);
+        if (!h)
+            return NULL;
+        *h = (struct ta_header) {.size = size | TA_FLAG_IN_ARENA};
+        memset(PTR_FROM_HEADER(h), 0, size);
+    } else {
+        h = calloc(1, sizeof(union aligned_header) + size);
+        if (!h)
+            return NULL;
+        *h = (struct ta_header) {.size = size};
+    }
     ta_dbg_add(h);
     void *ptr = PTR_FROM_HEADER(h);
     if (!ta_set_parent(ptr, ta_parent)) {
@@ -173,6 +268,25 @@ void *ta_zalloc_size(void *ta_parent, size_t size)
     return ptr;
 }
 
+/* Create an empty arena context. Children allocated with it as parent are
+ * bump-allocated from large slabs instead of being malloc'd individually,
+ * which makes it a cheap parent for many small, short-lived allocations
+ * (e.g. a per-frame scratch scope). The usual semantics are unchanged:
+ * children can have destructors and children of their own, and can be freed
+ * individually, although their memory is only reclaimed as a whole, when
+ * the arena itself is freed, or all its children are freed with
+ * ta_free_children(). Growing a child with ta_realloc... moves it to an
+ * ordinary malloc'd block.
+ * Returns NULL on OOM.
+ */
+void *ta_arena_new(void *ta_parent)
+{
+    struct ta_arena *arena = ta_zalloc_size(ta_parent, sizeof(*arena));
+    if (arena)
+        PTR_TO_HEADER(arena)->size |= TA_FLAG_ARENA;
+    return arena;
+}
+
 /* Reallocate the allocation given by ptr and return a new pointer. Much like
  * realloc(), the returned pointer can be different, and on OOM, NULL is
  * returned.
@@ -197,14 +311,44 @@ void *ta_realloc_size(void *ta_parent, void *ptr, size_t size)
         return ta_alloc_size(ta_parent, size);
     struct ta_header *h = get_header(ptr);
     struct ta_header *old_h = h;
-    if (h->size == size)
+    if ((h->size & TA_SIZE_MASK) == size)
         return ptr;
+    if (h->size & TA_FLAG_IN_ARENA) {
+        // Slab memory can't be realloc'd. Shrinking can be done in place;
+        // growing moves the allocation to an ordinary malloc'd block (the
+        // old slab memory is reclaimed when the arena is freed or reset).
+        if (size < (h->size & TA_SIZE_MASK)) {
+            h->size = size | TA_FLAG_IN_ARENA;
+            return ptr;
+        }
+        struct ta_header *new_h = malloc(sizeof(union aligned_header) + size);
+        if (!new_h)
+            return NULL;
+        ta_dbg_remove(h);
+        memcpy(new_h, h, sizeof(union aligned_header) +
+                         (h->size & TA_SIZE_MASK));
+        ta_dbg_add(new_h);
+        h = new_h;
+        h->size = size;
+        if (h->next) {
+            // Relink siblings
+            h->next->prev = h;
+            h->prev->next = h;
+        }
+        if (h->ext) {
+            // Relink children
+            h->ext->header = h;
+            h->ext->children.next->prev = &h->ext->children;
+            h->ext->children.prev->next = &h->ext->children;
+        }
+        return PTR_FROM_HEADER(h);
+    }
     ta_dbg_remove(h);
     h = realloc(h, sizeof(union aligned_header) + size);
     ta_dbg_add(h ? h : old_h);
     if (!h)
         return NULL;
-    h->size = size;
+    h->size = size | (h->size & ~TA_SIZE_MASK);
     if (h != old_h) {
         if (h->next) {
             // Relink siblings
@@ -228,7 +372,27 @@ void *ta_realloc_size(void *ta_parent, void *ptr, size_t size)
 size_t ta_get_size(void *ptr)
 {
     struct ta_header *h = get_header(ptr);
-    return h ? h->size : 0;
+    return h ? h->size & TA_SIZE_MASK : 0;
+}
+
+/* Sum of the sizes of ptr's allocation and all of its direct and indirect
+ * children. Walks the whole hierarchy, so this is meant for on-demand
+ * statistics, not for hot paths. malloc and arena slab overhead is not
+ * included.
+ */
+size_t ta_calc_total_size(void *ptr)
+{
+    struct ta_header *h = get_header(ptr);
+    if (!h)
+        return 0;
+    size_t size = h->size & TA_SIZE_MASK;
+    struct ta_ext_header *eh = h->ext;
+    if (eh) {
+        for (struct ta_header *c = eh->children.next; c != &eh->children;
+             c = c->next)
+            size += ta_calc_total_size(PTR_FROM_HEADER(c));
+    }
+    return size;
 }
 
 /* Free all allocations that (recursively) have ptr as parent allocation, but
@@ -238,10 +402,12 @@ void ta_free_children(void *ptr)
 {
     struct ta_header *h = get_header(ptr);
     struct ta_ext_header *eh = h ? h->ext : NULL;
-    if (!eh)
-        return;
-    while (eh->children.next != &eh->children)
-        ta_free(PTR_FROM_HEADER(eh->children.next));
+    if (eh) {
+        while (eh->children.next != &eh->children)
+            ta_free(PTR_FROM_HEADER(eh->children.next));
+    }
+    if (h && (h->size & TA_FLAG_ARENA))
+        arena_reset(PTR_FROM_HEADER(h));
 }
 
 /* Free the given allocation, and all of its direct and indirect children.
@@ -261,7 +427,10 @@ void ta_free(void *ptr)
     }
     ta_dbg_remove(h);
     free(h->ext);
-    free(h);
+    if (h->size & TA_FLAG_ARENA)
+        arena_destroy(PTR_FROM_HEADER(h));
+    if (!(h->size & TA_FLAG_IN_ARENA))
+        free(h); // otherwise arena slab memory; freed with the arena
 }
 
 /* Set a destructor that is to be called when the given allocation is freed.
@@ -348,7 +517,7 @@ static size_t get_children_size(struct ta_header *h)
     if (h->ext) {
         struct ta_header *s;
         for (s = h->ext->children.next; s != &h->ext->children; s = s->next)
-            size += s->size + get_children_size(s);
+            size += (s->size & TA_SIZE_MASK) + get_children_size(s);
     }
     return size;
 }
@@ -372,16 +541,17 @@ static void print_leak_report(void)
                     snprintf(name, sizeof(name), "%s", cur->name);
                 if (cur->name == &allocation_is_string) {
                     snprintf(name, sizeof(name), "'%.*s'",
-                             (int)cur->size, (char *)PTR_FROM_HEADER(cur));
+                             (int)(cur->size & TA_SIZE_MASK),
+                             (char *)PTR_FROM_HEADER(cur));
                 }
                 for (int n = 0; n < sizeof(name); n++) {
                     if (name[n] && name[n] < 0x20)
                         name[n] = '.';
                 }
                 fprintf(stderr, "  %-20p %10zu %10zu  %s\n",
-                        cur, cur->size, c_size, name);
+                        cur, cur->size & TA_SIZE_MASK, c_size, name);
             }
-            size += cur->size;
+            size += cur->size & TA_SIZE_MASK;
             num_blocks += 1;
             // Unlink, and don't confuse valgrind by leaving live pointers.
             cur->leak_next->leak_prev = cur->leak_prev;
@@ -405,6 +575,87 @@ void ta_enable_leak_report(void)
     pthread_mutex_unlock(&ta_dbg_mutex);
 }
 
+/* Allocation-site statistics. Sites are keyed by the pointer of the location
+ * string literal set via TA_LOC, so recording is a probe into a fixed table
+ * and does no allocations of its own - cheap enough to stay enabled in
+ * production builds. Counters are cumulative and reset on every dump, so two
+ * dumps bracket the allocations made in between (e.g. one frame).
+ */
+#define ALLOC_STATS_SITES 1024
+
+struct alloc_stat_site {
+    const char *loc;
+    uint64_t num_allocs;
+    uint64_t num_bytes;
+};
+
+static bool enable_alloc_stats;
+static struct alloc_stat_site alloc_stat_sites[ALLOC_STATS_SITES];
+static uint64_t alloc_stats_dropped;
+
+// Called with ta_dbg_mutex held.
+static void alloc_stats_record(const char *loc, size_t size)
+{
+    uintptr_t hash = ((uintptr_t)loc >> 4) * 2654435761u;
+    for (size_t i = 0; i < ALLOC_STATS_SITES; i++) {
+        struct alloc_stat_site *site =
+            &alloc_stat_sites[(hash + i) % ALLOC_STATS_SITES];
+        if (site->loc && site->loc != loc)
+            continue;
+        site->loc = loc;
+        site->num_allocs++;
+        site->num_bytes += size;
+        return;
+    }
+    alloc_stats_dropped++; // table full; should not happen in practice
+}
+
+void ta_enable_alloc_stats(void)
+{
+    pthread_mutex_lock(&ta_dbg_mutex);
+    enable_alloc_stats = true;
+    pthread_mutex_unlock(&ta_dbg_mutex);
+}
+
+static int alloc_stat_cmp(const void *pa, const void *pb)
+{
+    const struct alloc_stat_site *a = pa, *b = pb;
+    if (a->num_bytes != b->num_bytes)
+        return a->num_bytes < b->num_bytes ? 1 : -1;
+    return 0;
+}
+
+void ta_print_alloc_stats(void)
+{
+    if (!enable_alloc_stats) {
+        fprintf(stderr, "Allocation stats not enabled "
+                "(use --alloc-stats or MPV_ALLOC_STATS=1).\n");
+        return;
+    }
+    static struct alloc_stat_site sorted[ALLOC_STATS_SITES];
+    pthread_mutex_lock(&ta_dbg_mutex);
+    memcpy(sorted, alloc_stat_sites, sizeof(sorted));
+    memset(alloc_stat_sites, 0, sizeof(alloc_stat_sites));
+    uint64_t dropped = alloc_stats_dropped;
+    alloc_stats_dropped = 0;
+    pthread_mutex_unlock(&ta_dbg_mutex);
+    qsort(sorted, ALLOC_STATS_SITES, sizeof(sorted[0]), alloc_stat_cmp);
+    uint64_t total_allocs = 0, total_bytes = 0;
+    fprintf(stderr, "Allocations by site since last dump:\n");
+    fprintf(stderr, "  %10s %12s  %s\n", "Count", "Bytes", "Site");
+    for (size_t i = 0; i < ALLOC_STATS_SITES; i++) {
+        struct alloc_stat_site *site = &sorted[i];
+        if (!site->loc || !site->num_allocs)
+            continue;
+        fprintf(stderr, "  %10"PRIu64" %12"PRIu64"  %s\n",
+                site->num_allocs, site->num_bytes, site->loc);
+        total_allocs += site->num_allocs;
+        total_bytes += site->num_bytes;
+    }
+    fprintf(stderr, "%"PRIu64" bytes in %"PRIu64" allocations"
+            " (%"PRIu64" dropped).\n", total_bytes, total_allocs, dropped);
+}
+
 /* Set a (static) string that will be printed if the memory allocation in ptr
  * shows up on the leak report. The string must stay valid until ptr is freed.
  * Calling it on ptr==NULL does nothing.
@@ -414,8 +665,17 @@ void ta_enable_leak_report(void)
 void *ta_dbg_set_loc(void *ptr, const char *loc)
 {
     struct ta_header *h = get_header(ptr);
-    if (h)
+    if (h) {
         h->name = loc;
+        // With NDEBUG, TA_LOC is "" and all sites are indistinguishable.
+        if (enable_alloc_stats && loc && loc != &allocation_is_string &&
+            loc[0])
+        {
+            pthread_mutex_lock(&ta_dbg_mutex);
+            alloc_stats_record(loc, h->size & TA_SIZE_MASK);
+            pthread_mutex_unlock(&ta_dbg_mutex);
+        }
+    }
     return ptr;
 }
 
@@ -434,6 +694,8 @@ static void ta_dbg_check_header(struct ta_header *h){}
 static void ta_dbg_remove(struct ta_header *h){}
 
 void ta_enable_leak_report(void){}
+void ta_enable_alloc_stats(void){}
+void ta_print_alloc_stats(void){}
 void *ta_dbg_set_loc(void *ptr, const char *loc){return ptr;}
 void *ta_dbg_mark_as_string(void *ptr){return ptr;}
 
@@ -46,6 +46,7 @@ void *ta_alloc_size(void *ta_parent, size_t size);
 void *ta_zalloc_size(void *ta_parent, size_t size);
 void *ta_realloc_size(void *ta_parent, void *ptr, size_t size);
 size_t ta_get_size(void *ptr);
+size_t ta_calc_total_size(void *ptr);
 void ta_free(void *ptr);
 void ta_free_children(void *ptr);
 bool ta_set_destructor(void *ptr, void (*destructor)(void *));
@@ -55,6 +56,7 @@ void *ta_find_parent(void *ptr);
 // Utility functions
 size_t ta_calc_array_size(size_t element_size, size_t count);
 void *ta_new_context(void *ta_parent);
+void *ta_arena_new(void *ta_parent);
 void *ta_steal_(void *ta_parent, void *ptr);
 void *ta_memdup(void *ta_parent, void *ptr, size_t size);
 char *ta_strdup(void *ta_parent, const char *str);
@@ -103,6 +105,7 @@ bool ta_vasprintf_append_buffer(char **str, const char *fmt, va_list ap) TA_PRF(
 #define ta_xset_destructor(...)         ta_oom_b(ta_set_destructor(__VA_ARGS__))
 #define ta_xset_parent(...)             ta_oom_b(ta_set_parent(__VA_ARGS__))
 #define ta_xnew_context(...)            ta_oom_p(ta_new_context(__VA_ARGS__))
+#define ta_xarena_new(...)              ta_oom_p(ta_arena_new(__VA_ARGS__))
 #define ta_xstrdup_append(...)          ta_oom_b(ta_strdup_append(__VA_ARGS__))
 #define ta_xstrdup_append_buffer(...)   ta_oom_b(ta_strdup_append_buffer(__VA_ARGS__))
 #define ta_xstrndup_append(...)         ta_oom_b(ta_strndup_append(__VA_ARGS__))
@@ -148,6 +151,8 @@ void *ta_oom_p(void *p);
 #define ta_oom_g(ptr) (TA_TYPEOF(ptr))ta_oom_p(ptr)
 
 void ta_enable_leak_report(void);
+void ta_enable_alloc_stats(void);
+void ta_print_alloc_stats(void);
 void *ta_dbg_set_loc(void *ptr, const char *name);
 void *ta_dbg_mark_as_string(void *ptr);
 
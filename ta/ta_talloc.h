@@ -33,12 +33,16 @@
 #define talloc_steal                    ta_xsteal
 #define talloc_realloc_size             ta_xrealloc_size
 #define talloc_new                      ta_xnew_context
+#define talloc_arena_new                ta_xarena_new
 #define talloc_set_destructor           ta_xset_destructor
 #define talloc_parent                   ta_find_parent
 #define talloc_enable_leak_report       ta_enable_leak_report
+#define talloc_enable_alloc_stats       ta_enable_alloc_stats
+#define talloc_print_alloc_stats        ta_print_alloc_stats
 #define talloc_size                     ta_xalloc_size
 #define talloc_zero_size                ta_xzalloc_size
 #define talloc_get_size                 ta_get_size
+#define talloc_total_size               ta_calc_total_size
 #define talloc_free_children            ta_free_children
 #define talloc_free                     ta_free
 #define talloc_memdup                   ta_xmemdup
@@ -28,8 +28,11 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 #include <libavutil/common.h>
 #include <libavcodec/avcodec.h>
 
@@ -135,13 +138,7 @@ void mp_get_chroma_location(enum mp_chroma_location loc, int *x, int *y)
         *x = -1;
 }
 
-/**
- * \brief little helper function to create a lookup table for gamma
- * \param map buffer to create map into
- * \param size size of buffer
- * \param gamma gamma value
- */
-void mp_gen_gamma_map(uint8_t *map, int size, float gamma)
+static void gen_gamma_map(uint8_t *map, int size, float gamma)
 {
     if (gamma == 1.0) {
         for (int i = 0; i < size; i++)
@@ -160,6 +157,61 @@ void mp_gen_gamma_map(uint8_t *map, int size, float gamma)
     }
 }
 
+// Cache for gen_gamma_map() results. VOs regenerate their LUTs on every
+// equalizer change, which calls pow() per entry; keep enough entries for the
+// three channel maps of a VO plus some slack.
+#define GAMMA_CACHE_SIZE 6
+
+static pthread_mutex_t gamma_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct gamma_cache_entry {
+    uint8_t *map;
+    int size;
+    float gamma;
+} gamma_cache[GAMMA_CACHE_SIZE];
+static int gamma_cache_pos;
+
+/**
+ * \brief little helper function to create a lookup table for gamma
+ * \param map buffer to create map into
+ * \param size size of buffer
+ * \param gamma gamma value
+ */
+void mp_gen_gamma_map(uint8_t *map, int size, float gamma)
+{
+    if (gamma == 1.0) {
+        // Linear ramp; not worth a cache slot.
+        gen_gamma_map(map, size, gamma);
+        return;
+    }
+
+    pthread_mutex_lock(&gamma_cache_lock);
+    for (int i = 0; i < GAMMA_CACHE_SIZE; i++) {
+        struct gamma_cache_entry *e = &gamma_cache[i];
+        if (e->map && e->size == size && e->gamma == gamma) {
+            memcpy(map, e->map, size);
+            pthread_mutex_unlock(&gamma_cache_lock);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&gamma_cache_lock);
+
+    gen_gamma_map(map, size, gamma);
+
+    pthread_mutex_lock(&gamma_cache_lock);
+    struct gamma_cache_entry *e = &gamma_cache[gamma_cache_pos];
+    gamma_cache_pos = (gamma_cache_pos + 1) % GAMMA_CACHE_SIZE;
+    if (e->size != size) {
+        free(e->map);
+        e->map = malloc(size);
+    }
+    if (e->map) {
+        memcpy(e->map, map, size);
+        e->size = size;
+        e->gamma = gamma;
+    }
+    pthread_mutex_unlock(&gamma_cache_lock);
+}
+
 /* Fill in the Y, U, V vectors of a yuv2rgb conversion matrix
  * based on the given luma weights of the R, G and B components (lr, lg, lb).
  * lr+lg+lb is assumed to equal 1.
@@ -193,13 +245,7 @@ static void luma_coeffs(float m[3][4], float lr, float lg, float lb)
     // Constant coefficients (m[x][3]) not set here
 }
 
-/**
- * \brief get the coefficients of the yuv -> rgb conversion matrix
- * \param params struct specifying the properties of the conversion like
- *  brightness, ...
- * \param m array to store coefficients into
- */
-void mp_get_yuv2rgb_coeffs(struct mp_csp_params *params, float m[3][4])
+static void get_yuv2rgb_coeffs(struct mp_csp_params *params, float m[3][4])
 {
     int format = params->colorspace.format;
     if (format <= MP_CSP_AUTO || format >= MP_CSP_COUNT)
@@ -312,6 +358,67 @@ void mp_get_yuv2rgb_coeffs(struct mp_csp_params *params, float m[3][4])
     }
 }
 
+// Compare only the fields get_yuv2rgb_coeffs() actually reads, so the cache
+// is unaffected by padding or by future unrelated fields.
+static bool csp_params_equal(const struct mp_csp_params *a,
+                             const struct mp_csp_params *b)
+{
+    return a->colorspace.format == b->colorspace.format &&
+           a->colorspace.levels_in == b->colorspace.levels_in &&
+           a->colorspace.levels_out == b->colorspace.levels_out &&
+           a->brightness == b->brightness &&
+           a->contrast == b->contrast &&
+           a->hue == b->hue &&
+           a->saturation == b->saturation &&
+           a->texture_bits == b->texture_bits &&
+           a->input_bits == b->input_bits &&
+           a->int_bits_in == b->int_bits_in &&
+           a->int_bits_out == b->int_bits_out;
+}
+
+// Subtitle rendering and the VOs re-derive the matrix on every reconfigure
+// and equalizer change, usually with identical parameters. A few slots cover
+// the handful of variants active at the same time (video, OSD, vsfilter).
+#define CSP_CACHE_SIZE 4
+
+static pthread_mutex_t csp_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct csp_cache_entry {
+    bool valid;
+    struct mp_csp_params params;
+    float m[3][4];
+} csp_cache[CSP_CACHE_SIZE];
+static int csp_cache_pos;
+
+/**
+ * \brief get the coefficients of the yuv -> rgb conversion matrix
+ * \param params struct specifying the properties of the conversion like
+ *  brightness, ...
+ * \param m array to store coefficients into
+ */
+void mp_get_yuv2rgb_coeffs(struct mp_csp_params *params, float m[3][4])
+{
+    pthread_mutex_lock(&csp_cache_lock);
+    for (int i = 0; i < CSP_CACHE_SIZE; i++) {
+        struct csp_cache_entry *e = &csp_cache[i];
+        if (e->valid && csp_params_equal(&e->params, params)) {
+            memcpy(m, e->m, sizeof(e->m));
+            pthread_mutex_unlock(&csp_cache_lock);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&csp_cache_lock);
+
+    get_yuv2rgb_coeffs(params, m);
+
+    pthread_mutex_lock(&csp_cache_lock);
+    struct csp_cache_entry *e = &csp_cache[csp_cache_pos];
+    csp_cache_pos = (csp_cache_pos + 1) % CSP_CACHE_SIZE;
+    e->valid = true;
+    e->params = *params;
+    memcpy(e->m, m, sizeof(e->m));
+    pthread_mutex_unlock(&csp_cache_lock);
+}
+
 //! size of gamma map use to avoid slow exp function in gen_yuv2rgb_map
 #define GMAP_SIZE (1024)
 /**
@@ -22,9 +22,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
+#include <libavcodec/avcodec.h>
+
 #include "common/msg.h"
+#include "bstr/bstr.h"
 
 #include "osdep/timer.h"
 
@@ -62,7 +66,13 @@ void video_reset_decoding(struct dec_video *d_video)
     if (d_video->vfilter && d_video->vfilter->initialized == 1)
         vf_seek_reset(d_video->vfilter);
     mp_image_unrefp(&d_video->waiting_decoded_mpi);
+    for (int n = 0; n < d_video->num_queued_frames; n++)
+        mp_image_unrefp(&d_video->frame_queue[n]);
+    d_video->num_queued_frames = 0;
     d_video->num_buffered_pts = 0;
+    d_video->buffered_pts_head = 0;
+    d_video->buffered_pts_is_heap = false;
+    d_video->frames_in_decoder = 0;
     d_video->last_pts = MP_NOPTS_VALUE;
     d_video->last_packet_pdts = MP_NOPTS_VALUE;
     d_video->decoded_pts = MP_NOPTS_VALUE;
@@ -80,6 +90,14 @@ int video_vd_control(struct dec_video *d_video, int cmd, void *arg)
     return CONTROL_UNKNOWN;
 }
 
+// Number of frames currently buffered inside the decoder. This is the exact
+// count of packets fed in without a frame out yet, not the worst-case delay
+// VDCTRL_QUERY_UNSEEN_FRAMES reports.
+int video_get_decoder_delay(struct dec_video *d_video)
+{
+    return d_video->frames_in_decoder;
+}
+
 int video_set_colors(struct dec_video *d_video, const char *item, int value)
 {
     vf_equalizer_t data;
@@ -115,9 +133,42 @@ int video_get_colors(struct dec_video *d_video, const char *item, int *value)
     return 0;
 }
 
+static void append_id_bytes(void *talloc_ctx, struct bstr *id,
+                            const void *data, size_t len)
+{
+    id->start = talloc_realloc_size(talloc_ctx, id->start, id->len + len);
+    memcpy(id->start + id->len, data, len);
+    id->len += len;
+}
+
+struct bstr video_decoder_id(void *talloc_ctx, struct sh_stream *sh)
+{
+    // Everything the decoder init path reads from the stream header has to
+    // go in here; two streams with equal IDs can share a decoder instance.
+    struct bstr id = {0};
+    append_id_bytes(talloc_ctx, &id, sh->codec, strlen(sh->codec) + 1);
+    append_id_bytes(talloc_ctx, &id, &sh->format, sizeof(sh->format));
+    append_id_bytes(talloc_ctx, &id, &sh->video->disp_w, sizeof(int));
+    append_id_bytes(talloc_ctx, &id, &sh->video->disp_h, sizeof(int));
+    if (sh->video->bih)
+        append_id_bytes(talloc_ctx, &id, sh->video->bih, sh->video->bih->biSize);
+    if (sh->lav_headers) {
+        struct AVCodecContext *lav = sh->lav_headers;
+        append_id_bytes(talloc_ctx, &id, &lav->codec_tag, sizeof(lav->codec_tag));
+        append_id_bytes(talloc_ctx, &id, &lav->bits_per_coded_sample,
+                        sizeof(lav->bits_per_coded_sample));
+        if (lav->extradata_size)
+            append_id_bytes(talloc_ctx, &id, lav->extradata, lav->extradata_size);
+    }
+    return id;
+}
+
 void video_uninit(struct dec_video *d_video)
 {
     mp_image_unrefp(&d_video->waiting_decoded_mpi);
+    for (int n = 0; n < d_video->num_queued_frames; n++)
+        mp_image_unrefp(&d_video->frame_queue[n]);
+    d_video->num_queued_frames = 0;
     if (d_video->vd_driver) {
         mp_msg(MSGT_DECVIDEO, MSGL_V, "Uninit video.\n");
         d_video->vd_driver->uninit(d_video);
@@ -138,19 +189,22 @@ static int init_video_codec(struct dec_video *d_video, const char *decoder)
 
 struct mp_decoder_list *video_decoder_list(void)
 {
-    struct mp_decoder_list *list = talloc_zero(NULL, struct mp_decoder_list);
-    for (int i = 0; mpcodecs_vd_drivers[i] != NULL; i++)
-        mpcodecs_vd_drivers[i]->add_decoders(list);
-    return list;
+    // Built on first use and kept for the process lifetime: the set of
+    // decoders can't change at runtime, and rebuilding it for every track
+    // costs hundreds of small allocations. Callers must not free it.
+    static struct mp_decoder_list *cached;
+    if (!cached) {
+        cached = talloc_zero(NULL, struct mp_decoder_list);
+        for (int i = 0; mpcodecs_vd_drivers[i] != NULL; i++)
+            mpcodecs_vd_drivers[i]->add_decoders(cached);
+    }
+    return cached;
 }
 
 static struct mp_decoder_list *mp_select_video_decoders(const char *codec,
                                                         char *selection)
 {
-    struct mp_decoder_list *list = video_decoder_list();
-    struct mp_decoder_list *new = mp_select_decoders(list, codec, selection);
-    talloc_free(list);
-    return new;
+    return mp_select_decoders(video_decoder_list(), codec, selection);
 }
 
 static const struct vd_functions *find_driver(const char *name)
@@ -207,26 +261,94 @@ bool video_init_best_codec(struct dec_video *d_video, char* video_decoders)
     return !!d_video->vd_driver;
 }
 
+static void pts_heap_sift_down(struct dec_video *d_video, int i)
+{
+    double *heap = d_video->buffered_pts;
+    while (1) {
+        int smallest = i;
+        for (int c = i * 2 + 1; c <= i * 2 + 2; c++) {
+            if (c < d_video->num_buffered_pts && heap[c] < heap[smallest])
+                smallest = c;
+        }
+        if (smallest == i)
+            break;
+        double tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Out-of-order timestamps (VFR or broken input): linearize the monotonic
+// ring and continue as a min-heap until the next decoding reset. The ring
+// contents are ascending, so the linearized array already satisfies the
+// heap property.
+static void pts_switch_to_heap(struct dec_video *d_video)
+{
+    const int size = MP_ARRAY_SIZE(d_video->buffered_pts);
+    double tmp[MP_ARRAY_SIZE(d_video->buffered_pts)];
+    for (int i = 0; i < d_video->num_buffered_pts; i++)
+        tmp[i] = d_video->buffered_pts[(d_video->buffered_pts_head + i) % size];
+    memcpy(d_video->buffered_pts, tmp,
+           d_video->num_buffered_pts * sizeof(double));
+    d_video->buffered_pts_head = 0;
+    d_video->buffered_pts_is_heap = true;
+}
+
+static void add_sorted_pts(struct dec_video *d_video, double pts)
+{
+    const int size = MP_ARRAY_SIZE(d_video->buffered_pts);
+    if (!d_video->buffered_pts_is_heap) {
+        int tail = d_video->buffered_pts_head + d_video->num_buffered_pts - 1;
+        if (d_video->num_buffered_pts == 0 ||
+            pts >= d_video->buffered_pts[tail % size])
+        {
+            d_video->buffered_pts[(tail + 1) % size] = pts;
+            d_video->num_buffered_pts++;
+            return;
+        }
+        pts_switch_to_heap(d_video);
+    }
+    int i = d_video->num_buffered_pts++;
+    while (i > 0 && d_video->buffered_pts[(i - 1) / 2] > pts) {
+        d_video->buffered_pts[i] = d_video->buffered_pts[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    d_video->buffered_pts[i] = pts;
+}
+
+// Remove and return the smallest buffered timestamp. Must not be called with
+// an empty buffer.
+static double pop_sorted_pts(struct dec_video *d_video)
+{
+    const int size = MP_ARRAY_SIZE(d_video->buffered_pts);
+    double min;
+    if (!d_video->buffered_pts_is_heap) {
+        min = d_video->buffered_pts[d_video->buffered_pts_head];
+        d_video->buffered_pts_head = (d_video->buffered_pts_head + 1) % size;
+        d_video->num_buffered_pts--;
+    } else {
+        min = d_video->buffered_pts[0];
+        d_video->num_buffered_pts--;
+        d_video->buffered_pts[0] =
+            d_video->buffered_pts[d_video->num_buffered_pts];
+        pts_heap_sift_down(d_video, 0);
+    }
+    return min;
+}
+
 static void add_pts_to_sort(struct dec_video *d_video, double pts)
 {
     if (pts != MP_NOPTS_VALUE) {
-        int delay = -1;
-        video_vd_control(d_video, VDCTRL_QUERY_UNSEEN_FRAMES, &delay);
-        if (delay >= 0 && delay < d_video->num_buffered_pts)
-            d_video->num_buffered_pts = delay;
+        // If the decoder swallowed frames internally, their buffered
+        // timestamps are stale - drop the smallest values along with them.
+        while (d_video->num_buffered_pts > d_video->frames_in_decoder)
+            pop_sorted_pts(d_video);
         if (d_video->num_buffered_pts ==
             sizeof(d_video->buffered_pts) / sizeof(double))
             mp_msg(MSGT_DECVIDEO, MSGL_ERR, "Too many buffered pts\n");
-        else {
-            int i, j;
-            for (i = 0; i < d_video->num_buffered_pts; i++)
-                if (d_video->buffered_pts[i] < pts)
-                    break;
-            for (j = d_video->num_buffered_pts; j > i; j--)
-                d_video->buffered_pts[j] = d_video->buffered_pts[j - 1];
-            d_video->buffered_pts[i] = pts;
-            d_video->num_buffered_pts++;
-        }
+        else
+            add_sorted_pts(d_video, pts);
     }
 }
 
@@ -241,8 +363,7 @@ static double retrieve_sorted_pts(struct dec_video *d_video, double codec_pts)
 
     double sorted_pts;
     if (d_video->num_buffered_pts) {
-        d_video->num_buffered_pts--;
-        sorted_pts = d_video->buffered_pts[d_video->num_buffered_pts];
+        sorted_pts = pop_sorted_pts(d_video);
     } else {
         mp_msg(MSGT_CPLAYER, MSGL_ERR,
                 "No pts value from demuxer to use for frame!\n");
@@ -285,9 +406,9 @@ static double retrieve_sorted_pts(struct dec_video *d_video, double codec_pts)
     return d_video->pts_assoc_mode == 1 ? codec_pts : sorted_pts;
 }
 
-struct mp_image *video_decode(struct dec_video *d_video,
-                              struct demux_packet *packet,
-                              int drop_frame)
+static struct mp_image *decode_frame(struct dec_video *d_video,
+                                     struct demux_packet *packet,
+                                     int drop_frame)
 {
     struct MPOpts *opts = d_video->opts;
     bool sort_pts =
@@ -310,6 +431,20 @@ struct mp_image *video_decode(struct dec_video *d_video,
 
     //------------------------ frame decoded. --------------------
 
+    // Packets in minus frames out gives the decoder's current buffering. The
+    // decoder can swallow a packet without ever producing a frame for it
+    // (dropped or skipped frames), so clamp against its worst-case capacity.
+    if (packet)
+        d_video->frames_in_decoder++;
+    if (mpi)
+        d_video->frames_in_decoder--;
+    int max_delay = -1;
+    video_vd_control(d_video, VDCTRL_QUERY_UNSEEN_FRAMES, &max_delay);
+    if (max_delay >= 0 && d_video->frames_in_decoder > max_delay)
+        d_video->frames_in_decoder = max_delay;
+    if (d_video->frames_in_decoder < 0)
+        d_video->frames_in_decoder = 0;
+
     if (!mpi || drop_frame) {
         talloc_free(mpi);
         return NULL;            // error / skipped frame
@@ -373,6 +508,47 @@ struct mp_image *video_decode(struct dec_video *d_video,
     return mpi;
 }
 
+static void queue_frame(struct dec_video *d_video, struct mp_image *mpi)
+{
+    assert(d_video->num_queued_frames < VD_MAX_QUEUED_FRAMES);
+    d_video->frame_queue[d_video->num_queued_frames++] = mpi;
+}
+
+static struct mp_image *dequeue_frame(struct dec_video *d_video)
+{
+    if (!d_video->num_queued_frames)
+        return NULL;
+    struct mp_image *mpi = d_video->frame_queue[0];
+    d_video->num_queued_frames--;
+    memmove(&d_video->frame_queue[0], &d_video->frame_queue[1],
+            d_video->num_queued_frames * sizeof(d_video->frame_queue[0]));
+    return mpi;
+}
+
+struct mp_image *video_decode(struct dec_video *d_video,
+                              struct demux_packet *packet,
+                              int drop_frame)
+{
+    struct mp_image *mpi = decode_frame(d_video, packet, drop_frame);
+    if (mpi)
+        queue_frame(d_video, mpi);
+    return dequeue_frame(d_video);
+}
+
+// Feed a packet to the decoder, and add any resulting frame to the frame
+// queue instead of returning it. With frame-threaded decoding, this is used
+// to keep the codec's threads supplied with input while the VO still holds
+// earlier output. The caller must not decode ahead when num_queued_frames
+// has reached VD_DECODE_AHEAD.
+void video_decode_ahead(struct dec_video *d_video,
+                        struct demux_packet *packet)
+{
+    assert(d_video->num_queued_frames < VD_DECODE_AHEAD);
+    struct mp_image *mpi = decode_frame(d_video, packet, 0);
+    if (mpi)
+        queue_frame(d_video, mpi);
+}
+
 int video_reconfig_filters(struct dec_video *d_video,
                            const struct mp_image_params *params)
 {
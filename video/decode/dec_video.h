@@ -21,6 +21,7 @@
 
 #include <stdbool.h>
 
+#include "bstr/bstr.h"
 #include "demux/stheader.h"
 #include "video/hwdec.h"
 #include "video/mp_image.h"
@@ -28,6 +29,12 @@
 struct mp_decoder_list;
 struct vo;
 
+// Total capacity of the decoded frame queue.
+#define VD_MAX_QUEUED_FRAMES 4
+// Decode ahead at most this many frames. Kept below the queue capacity so
+// that video_decode() always has room for the frame it decodes itself.
+#define VD_DECODE_AHEAD 2
+
 struct dec_video {
     struct MPOpts *opts;
     struct vf_chain *vfilter;  // video filter chain
@@ -44,6 +51,12 @@ struct dec_video {
     // Used temporarily during format changes
     struct mp_image *waiting_decoded_mpi;
 
+    // FIFO of decoded frames not yet returned to the playloop. Decoding
+    // ahead into this queue keeps the decoder's frame threads busy while
+    // the VO still holds earlier output.
+    struct mp_image *frame_queue[VD_MAX_QUEUED_FRAMES];
+    int num_queued_frames;
+
     void *priv; // for free use by vd_driver
 
     // Last PTS from decoder (set with each vd_driver->decode() call)
@@ -55,14 +68,23 @@ struct dec_video {
     int num_codec_dts_problems;
 
     // PTS sorting (obscure, non-default)
+    // Monotonic ring of buffered timestamps; switches to a min-heap once
+    // out-of-order (VFR) input shows up. See add_pts_to_sort().
     double buffered_pts[32];
     int num_buffered_pts;
+    int buffered_pts_head;      // ring read position (unused in heap mode)
+    bool buffered_pts_is_heap;
     double sorted_pts;
     int num_sorted_pts_problems;
     double unsorted_pts;
     int num_unsorted_pts_problems;
     int pts_assoc_mode;
 
+    // Packets fed to the decoder minus frames it has returned, i.e. how many
+    // frames are buffered inside the decoder right now. Kept exact by
+    // clamping against the decoder's worst-case buffering capacity.
+    int frames_in_decoder;
+
     // PTS or DTS of packet last read
     double last_packet_pdts;
 
@@ -86,15 +108,21 @@ struct mp_decoder_list *video_decoder_list(void);
 bool video_init_best_codec(struct dec_video *d_video, char* video_decoders);
 void video_uninit(struct dec_video *d_video);
 
+// Opaque binary ID of the codec configuration a decoder would be opened with.
+struct bstr video_decoder_id(void *talloc_ctx, struct sh_stream *sh);
+
 struct demux_packet;
 struct mp_image *video_decode(struct dec_video *d_video,
                               struct demux_packet *packet,
                               int drop_frame);
+void video_decode_ahead(struct dec_video *d_video,
+                        struct demux_packet *packet);
 
 int video_get_colors(struct dec_video *d_video, const char *item, int *value);
 int video_set_colors(struct dec_video *d_video, const char *item, int value);
 void video_reset_decoding(struct dec_video *d_video);
 int video_vd_control(struct dec_video *d_video, int cmd, void *arg);
+int video_get_decoder_delay(struct dec_video *d_video);
 
 int video_reconfig_filters(struct dec_video *d_video,
                            const struct mp_image_params *params);
@@ -45,6 +45,8 @@ enum vd_ctrl {
     VDCTRL_RESET = 1, // reset decode state after seeking
     VDCTRL_QUERY_UNSEEN_FRAMES, // current decoder lag
     VDCTRL_FORCE_HWDEC_FALLBACK, // force software decoding fallback
+    VDCTRL_TRIM_MEMORY, // drop cached buffers that are recreated on demand
+    VDCTRL_QUERY_REUSABLE, // whether the instance can outlive its stream
 };
 
 #endif /* MPLAYER_VD_H */
@@ -415,6 +415,13 @@ static void init_avctx(struct dec_video *vd, const char *decoder,
         }
 #endif
         mp_set_avcodec_threads(avctx, lavc_param->threads);
+        if (vd->opts->low_latency) {
+            // Frame threads add thread_count-1 frames of decode delay, and
+            // LOW_DELAY makes the codec output frames as soon as possible
+            // instead of buffering up to has_b_frames of reordering.
+            avctx->thread_count = 1;
+            avctx->flags |= CODEC_FLAG_LOW_DELAY;
+        }
     }
 
     avctx->flags |= lavc_param->bitexact;
@@ -436,6 +443,8 @@ static void init_avctx(struct dec_video *vd, const char *decoder,
 
     // Do this after the above avopt handling in case it changes values
     ctx->skip_frame = avctx->skip_frame;
+    ctx->skip_loop_filter = avctx->skip_loop_filter;
+    ctx->skip_idct = avctx->skip_idct;
 
     avctx->codec_tag = sh->format;
     avctx->coded_width  = sh->video->disp_w;
@@ -728,6 +737,18 @@ static int decode(struct dec_video *vd, struct demux_packet *packet,
     else
         avctx->skip_frame = ctx->skip_frame;
 
+    if (flags & 4) {
+        // Hurry-up mode for frames which are never displayed (e.g. while
+        // converging to a precise seek target). Skipping the IDCT on
+        // reference frames would corrupt the prediction chain up to the
+        // target frame, so only non-reference frames lose it.
+        avctx->skip_loop_filter = AVDISCARD_ALL;
+        avctx->skip_idct = AVDISCARD_NONREF;
+    } else {
+        avctx->skip_loop_filter = ctx->skip_loop_filter;
+        avctx->skip_idct = ctx->skip_idct;
+    }
+
     mp_set_av_packet(&pkt, packet, NULL);
 
     ret = avcodec_decode_video2(avctx, ctx->pic, &got_picture, &pkt);
@@ -807,6 +828,13 @@ static int control(struct dec_video *vd, int cmd, void *arg)
         return CONTROL_TRUE;
     case VDCTRL_FORCE_HWDEC_FALLBACK:
         return force_fallback(vd);
+    case VDCTRL_TRIM_MEMORY:
+        mp_image_pool_clear(ctx->non_dr1_pool);
+        return CONTROL_TRUE;
+    case VDCTRL_QUERY_REUSABLE:
+        // hwdec contexts hold references into the VO, which may be destroyed
+        // together with the stream - only software contexts can be kept.
+        return ctx->hwdec ? CONTROL_FALSE : CONTROL_TRUE;
     }
     return CONTROL_UNKNOWN;
 }
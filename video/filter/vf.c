@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <libavutil/common.h>
 #include <libavutil/mem.h>
@@ -35,6 +36,8 @@
 #include "video/img_format.h"
 #include "video/mp_image.h"
 #include "video/mp_image_pool.h"
+#include "osdep/numcores.h"
+
 #include "vf.h"
 
 #include "video/memcpy_pic.h"
@@ -131,6 +134,8 @@ static bool get_desc(struct m_obj_desc *dst, int index)
     return true;
 }
 
+static void pipeline_drain(struct vf_pipeline *pl);
+
 // For the vf option
 const struct m_obj_list vf_obj_list = {
     .get_desc = get_desc,
@@ -139,8 +144,20 @@ const struct m_obj_list vf_obj_list = {
 
 // Try the cmd on each filter (starting with the first), and stop at the first
 // filter which does not return CONTROL_UNKNOWN for it.
+// Drop cached image buffers; they are reallocated on demand, so this only
+// costs some allocation churn on the next frames.
+void vf_trim_memory(struct vf_chain *c)
+{
+    if (c->pipeline)
+        pipeline_drain(c->pipeline);
+    for (struct vf_instance *cur = c->first; cur; cur = cur->next)
+        mp_image_pool_clear(cur->out_pool);
+}
+
 int vf_control_any(struct vf_chain *c, int cmd, void *arg)
 {
+    if (c->pipeline)
+        pipeline_drain(c->pipeline);
     for (struct vf_instance *cur = c->first; cur; cur = cur->next) {
         if (cur->control) {
             int r = cur->control(cur, cmd, arg);
@@ -283,6 +300,7 @@ struct vf_instance *vf_append_filter(struct vf_chain *c, const char *name,
             pprev = &(*pprev)->next;
         vf->next = *pprev ? *pprev : NULL;
         *pprev = vf;
+        c->initialized = 0; // changed chain needs renegotiation
     }
     return vf;
 }
@@ -335,14 +353,186 @@ static int vf_do_filter(struct vf_instance *vf, struct mp_image *img)
     }
 }
 
+// Pipelined chain execution: each filter instance gets a worker thread with
+// a bounded input queue, so consecutive frames can occupy different chain
+// stages concurrently. Every instance is still run by exactly one thread, so
+// filter-internal state needs no locking; output order is preserved because
+// each stage is a FIFO. All queues and flags are protected by one lock.
+
+// Number of frames that can wait in each pipeline stage's input queue.
+#define VF_PIPELINE_QUEUE_SIZE 2
+
+struct vf_stage {
+    struct vf_pipeline *pl;
+    struct vf_instance *vf;
+    int index;
+    pthread_t thread;
+    struct mp_image **queued;   // input frames not yet filtered
+    int num_queued;
+    bool busy;                  // currently inside the filter callback
+};
+
+struct vf_pipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;      // to stages: new input, or terminate
+    pthread_cond_t progress;    // to feeders: queue space, output, or idle
+    bool terminate;
+    int error;                  // first error returned by any filter
+    struct vf_stage **stages;
+    int num_stages;
+    struct mp_image **out_queued; // output of the last stage
+    int num_out_queued;
+};
+
+// Hand a frame to the given stage, or to the chain output queue if st is
+// NULL. Waits until the receiving queue has space. Called with pl->lock held.
+static void pipeline_send_locked(struct vf_pipeline *pl, struct vf_stage *st,
+                                 struct mp_image *img)
+{
+    if (st) {
+        while (st->num_queued >= VF_PIPELINE_QUEUE_SIZE && !pl->terminate)
+            pthread_cond_wait(&pl->progress, &pl->lock);
+        if (pl->terminate) {
+            talloc_free(img);
+            return;
+        }
+        MP_TARRAY_APPEND(st, st->queued, st->num_queued, img);
+        pthread_cond_broadcast(&pl->wakeup);
+    } else {
+        MP_TARRAY_APPEND(pl, pl->out_queued, pl->num_out_queued, img);
+        pthread_cond_broadcast(&pl->progress);
+    }
+}
+
+static bool pipeline_busy(struct vf_pipeline *pl)
+{
+    for (int n = 0; n < pl->num_stages; n++) {
+        if (pl->stages[n]->busy || pl->stages[n]->num_queued)
+            return true;
+    }
+    return false;
+}
+
+static void *pipeline_stage_thread(void *p)
+{
+    struct vf_stage *st = p;
+    struct vf_pipeline *pl = st->pl;
+
+    pthread_mutex_lock(&pl->lock);
+    while (1) {
+        if (st->num_queued) {
+            struct mp_image *img = st->queued[0];
+            MP_TARRAY_REMOVE_AT(st->queued, st->num_queued, 0);
+            st->busy = true;
+            pthread_cond_broadcast(&pl->progress);
+            pthread_mutex_unlock(&pl->lock);
+            int r = vf_do_filter(st->vf, img);
+            pthread_mutex_lock(&pl->lock);
+            if (r < 0 && pl->error >= 0)
+                pl->error = r;
+            struct vf_stage *next = st->index + 1 < pl->num_stages
+                                    ? pl->stages[st->index + 1] : NULL;
+            while (st->vf->num_out_queued)
+                pipeline_send_locked(pl, next, vf_dequeue_output_frame(st->vf));
+            st->busy = false;
+            pthread_cond_broadcast(&pl->progress);
+        } else if (pl->terminate) {
+            break;
+        } else {
+            pthread_cond_wait(&pl->wakeup, &pl->lock);
+        }
+    }
+    pthread_mutex_unlock(&pl->lock);
+    return NULL;
+}
+
+// Wait until no frame is being filtered or waiting in a stage input queue.
+// Frames already produced stay in the chain output queue.
+static void pipeline_drain(struct vf_pipeline *pl)
+{
+    pthread_mutex_lock(&pl->lock);
+    while (pipeline_busy(pl))
+        pthread_cond_wait(&pl->progress, &pl->lock);
+    pthread_mutex_unlock(&pl->lock);
+}
+
+static void pipeline_destroy(struct vf_chain *c)
+{
+    struct vf_pipeline *pl = c->pipeline;
+    if (!pl)
+        return;
+    pthread_mutex_lock(&pl->lock);
+    pl->terminate = true;
+    pthread_cond_broadcast(&pl->wakeup);
+    pthread_cond_broadcast(&pl->progress);
+    pthread_mutex_unlock(&pl->lock);
+    for (int n = 0; n < pl->num_stages; n++)
+        pthread_join(pl->stages[n]->thread, NULL);
+    for (int n = 0; n < pl->num_stages; n++) {
+        struct vf_stage *st = pl->stages[n];
+        for (int i = 0; i < st->num_queued; i++)
+            talloc_free(st->queued[i]);
+    }
+    for (int n = 0; n < pl->num_out_queued; n++)
+        talloc_free(pl->out_queued[n]);
+    pthread_mutex_destroy(&pl->lock);
+    pthread_cond_destroy(&pl->wakeup);
+    pthread_cond_destroy(&pl->progress);
+    talloc_free(pl);
+    c->pipeline = NULL;
+}
+
+static void pipeline_create(struct vf_chain *c)
+{
+    assert(!c->pipeline);
+    if (!c->opts->vf_pipeline || c->initialized < 1)
+        return;
+    int num_filters = 0;
+    for (struct vf_instance *vf = c->first; vf; vf = vf->next)
+        num_filters += vf->filter || vf->filter_ext ? 1 : 0;
+    if (num_filters < 2 || default_thread_count() < 2)
+        return;
+    struct vf_pipeline *pl = talloc_zero(NULL, struct vf_pipeline);
+    pthread_mutex_init(&pl->lock, NULL);
+    pthread_cond_init(&pl->wakeup, NULL);
+    pthread_cond_init(&pl->progress, NULL);
+    pl->error = 0;
+    for (struct vf_instance *vf = c->first; vf; vf = vf->next) {
+        struct vf_stage *st = talloc_zero(pl, struct vf_stage);
+        st->pl = pl;
+        st->vf = vf;
+        st->index = pl->num_stages;
+        MP_TARRAY_APPEND(pl, pl->stages, pl->num_stages, st);
+    }
+    c->pipeline = pl;
+    for (int n = 0; n < pl->num_stages; n++) {
+        struct vf_stage *st = pl->stages[n];
+        if (pthread_create(&st->thread, NULL, pipeline_stage_thread, st)) {
+            // Join only the threads that were started, then filter serially.
+            pl->num_stages = n;
+            pipeline_destroy(c);
+            return;
+        }
+    }
+}
+
 // Input a frame into the filter chain. Ownership of img is transferred.
 // Return >= 0 on success, < 0 on failure (even if output frames were produced)
+// With pipelined execution, errors are reported delayed, with the next call.
 int vf_filter_frame(struct vf_chain *c, struct mp_image *img)
 {
     if (c->initialized < 1) {
         talloc_free(img);
         return -1;
     }
+    if (c->pipeline) {
+        struct vf_pipeline *pl = c->pipeline;
+        pthread_mutex_lock(&pl->lock);
+        int r = pl->error;
+        pipeline_send_locked(pl, pl->stages[0], img);
+        pthread_mutex_unlock(&pl->lock);
+        return r;
+    }
     return vf_do_filter(c->first, img);
 }
 
@@ -351,6 +541,22 @@ struct mp_image *vf_output_queued_frame(struct vf_chain *c)
 {
     if (c->initialized < 1)
         return NULL;
+    if (c->pipeline) {
+        struct vf_pipeline *pl = c->pipeline;
+        struct mp_image *res = NULL;
+        pthread_mutex_lock(&pl->lock);
+        // While the last stage finishes the oldest frame, newer frames are
+        // being filtered upstream; waiting here only costs one stage's
+        // latency, and guarantees no frame is lost at end of stream.
+        while (!pl->num_out_queued && pipeline_busy(pl))
+            pthread_cond_wait(&pl->progress, &pl->lock);
+        if (pl->num_out_queued) {
+            res = pl->out_queued[0];
+            MP_TARRAY_REMOVE_AT(pl->out_queued, pl->num_out_queued, 0);
+        }
+        pthread_mutex_unlock(&pl->lock);
+        return res;
+    }
     while (1) {
         struct vf_instance *last = NULL;
         for (struct vf_instance * cur = c->first; cur; cur = cur->next) {
@@ -375,6 +581,15 @@ static void vf_forget_frames(struct vf_instance *vf)
 
 void vf_seek_reset(struct vf_chain *c)
 {
+    if (c->pipeline) {
+        struct vf_pipeline *pl = c->pipeline;
+        pipeline_drain(pl);
+        pthread_mutex_lock(&pl->lock);
+        for (int n = 0; n < pl->num_out_queued; n++)
+            talloc_free(pl->out_queued[n]);
+        pl->num_out_queued = 0;
+        pthread_mutex_unlock(&pl->lock);
+    }
     for (struct vf_instance *cur = c->first; cur; cur = cur->next) {
         if (cur->control)
             cur->control(cur, VFCTRL_SEEK_RESET, NULL);
@@ -491,6 +706,12 @@ static int vf_reconfig_wrapper(struct vf_instance *vf,
 
 int vf_reconfig(struct vf_chain *c, const struct mp_image_params *params)
 {
+    // A chain that successfully negotiated for the same input format is
+    // still valid - skip re-querying and reconfiguring every filter.
+    if (c->initialized == 1 && mp_image_params_equals(params, &c->first->fmt_in))
+        return 0;
+
+    pipeline_destroy(c);
     struct mp_image_params cur = *params;
     int r = 0;
     c->first->fmt_in = *params;
@@ -510,6 +731,7 @@ int vf_reconfig(struct vf_chain *c, const struct mp_image_params *params)
         mp_msg(MSGT_VFILTER, MSGL_ERR, "Image formats incompatible.\n");
     mp_msg(MSGT_VFILTER, loglevel, "Video filter chain:\n");
     vf_print_filter_chain(c, loglevel);
+    pipeline_create(c);
     return r;
 }
 
@@ -574,6 +796,7 @@ void vf_destroy(struct vf_chain *c)
 {
     if (!c)
         return;
+    pipeline_destroy(c);
     while (c->first) {
         vf_instance_t *vf = c->first;
         c->first = vf->next;
@@ -97,6 +97,9 @@ struct vf_chain {
 
     struct vf_instance *first, *last;
 
+    // Pipelined execution across the chain (NULL if filtering serially).
+    struct vf_pipeline *pipeline;
+
     struct mp_image_params output_params;
     uint8_t allowed_output_formats[IMGFMT_END - IMGFMT_START];
 
@@ -126,6 +129,7 @@ struct vf_chain *vf_new(struct MPOpts *opts);
 void vf_destroy(struct vf_chain *c);
 int vf_reconfig(struct vf_chain *c, const struct mp_image_params *params);
 int vf_control_any(struct vf_chain *c, int cmd, void *arg);
+void vf_trim_memory(struct vf_chain *c);
 int vf_filter_frame(struct vf_chain *c, struct mp_image *img);
 struct mp_image *vf_output_queued_frame(struct vf_chain *c);
 void vf_seek_reset(struct vf_chain *c);
@@ -102,10 +102,21 @@ static int name_to_imgfmt(const char *name)
     return mp_imgfmt_from_name(bstr0(name), false);
 }
 
-static void set_imgprop(struct vf_dlopen_picdata *out, const mp_image_t *mpi)
+static void *ref_frame(void *frame)
+{
+    return mp_image_new_ref(frame);
+}
+
+static void unref_frame(void *frame)
+{
+    talloc_free(frame);
+}
+
+static void set_imgprop(struct vf_dlopen_picdata *out, mp_image_t *mpi)
 {
     int i;
     out->planes = mpi->num_planes;
+    out->frame = mpi;
     for (i = 0; i < mpi->num_planes; ++i) {
         out->plane[i] = mpi->planes[i];
         out->planestride[i] = mpi->stride[i];
@@ -223,6 +234,36 @@ static int norm_qscale(int qscale, int type)
     return qscale;
 }
 
+// Allocate fresh output images, run cb (put_image or drain_image), and queue
+// the images it produced. attr is the input frame the output attributes are
+// copied from. Returns the number of frames the callback yielded.
+static int emit_output(struct vf_instance *vf, struct mp_image *attr,
+                       int (*cb)(struct vf_dlopen_context *ctx))
+{
+    struct mp_image *out[FILTER_MAX_OUTCNT] = {0};
+
+    for (int n = 0; n < vf->priv->out_cnt; n++) {
+        out[n] = vf_alloc_out_image(vf);
+        mp_image_copy_attributes(out[n], attr);
+        set_imgprop(&vf->priv->filter.outpic[n], out[n]);
+    }
+
+    // more than one out pic
+    int ret = cb(&vf->priv->filter);
+    if (ret < 0)
+        ret = 0;
+    assert(ret <= vf->priv->out_cnt);
+
+    for (int n = 0; n < ret; n++) {
+        out[n]->pts = vf->priv->filter.outpic[n].pts;
+        vf_add_output_frame(vf, out[n]);
+    }
+    for (int n = ret; n < FILTER_MAX_OUTCNT; n++) {
+        talloc_free(out[n]);
+    }
+    return ret;
+}
+
 static int filter(struct vf_instance *vf, struct mp_image *mpi)
 {
     int i, k;
@@ -250,26 +291,14 @@ static int filter(struct vf_instance *vf, struct mp_image *mpi)
     }
     vf->priv->filter.inpic.pts = mpi->pts;
 
-    struct mp_image *out[FILTER_MAX_OUTCNT] = {0};
-
-    for (int n = 0; n < vf->priv->out_cnt; n++) {
-        out[n] = vf_alloc_out_image(vf);
-        mp_image_copy_attributes(out[n], mpi);
-        set_imgprop(&vf->priv->filter.outpic[n], out[n]);
-    }
+    emit_output(vf, mpi, vf->priv->filter.put_image);
 
-    // more than one out pic
-    int ret = vf->priv->filter.put_image(&vf->priv->filter);
-    if (ret < 0)
-        ret = 0;
-    assert(ret <= vf->priv->out_cnt);
-
-    for (int n = 0; n < ret; n++) {
-        out[n]->pts = vf->priv->filter.outpic[n].pts;
-        vf_add_output_frame(vf, out[n]);
-    }
-    for (int n = ret; n < FILTER_MAX_OUTCNT; n++) {
-        talloc_free(out[n]);
+    // A filter that pipelines internally (buffering refs to input frames,
+    // with put_image returning 0) delivers the finished results of earlier
+    // frames here.
+    if (vf->priv->filter.drain_image) {
+        while (emit_output(vf, mpi, vf->priv->filter.drain_image) > 0) {
+        }
     }
 
     talloc_free(mpi);
@@ -331,6 +360,8 @@ static int vf_open(vf_instance_t *vf)
     memset(&vf->priv->filter, 0, sizeof(vf->priv->filter));
     vf->priv->filter.major_version = VF_DLOPEN_MAJOR_VERSION;
     vf->priv->filter.minor_version = VF_DLOPEN_MINOR_VERSION;
+    vf->priv->filter.ref_frame = ref_frame;
+    vf->priv->filter.unref_frame = unref_frame;
 
     // count arguments
     for (vf->priv->cfg_argc = sizeof(vf->priv->cfg_argv) / sizeof(vf->priv->cfg_argv[0]);
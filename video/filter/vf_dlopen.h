@@ -5,7 +5,7 @@
 // when doing a backwards compatible change, bump minor version
 // when doing an incompatible change, bump major version and zero minor version
 #define VF_DLOPEN_MAJOR_VERSION 1
-#define VF_DLOPEN_MINOR_VERSION 0
+#define VF_DLOPEN_MINOR_VERSION 1
 
 #if VF_DLOPEN_MINOR_VERSION > 0
 # define VF_DLOPEN_CHECK_VERSION(ctx) \
@@ -42,6 +42,9 @@ struct vf_dlopen_picdata {
     unsigned int planexshift[4];
     unsigned int planeyshift[4];
     double pts;
+    void *frame;
+    // (since 1.1) opaque host handle for the frame backing the planes; pass
+    // it to ref_frame() to keep the pixel data alive without copying it
 };
 
 struct vf_dlopen_context {
@@ -61,8 +64,23 @@ struct vf_dlopen_context {
     int (*put_image)(struct vf_dlopen_context *ctx);  // returns number of images written, or negative on error
     // before this is called, inpic_* and outpic_* are filled
 
+    int (*drain_image)(struct vf_dlopen_context *ctx);  // same return as put_image
+    // (since 1.1) optional; called repeatedly after put_image as long as it
+    // returns a positive count, with fresh outpic_* but no new inpic. Lets a
+    // filter that pipelines internally accept several input frames (put_image
+    // returning 0) and deliver the finished results of earlier frames later,
+    // instead of having to produce each result synchronously.
+
     void (*uninit)(struct vf_dlopen_context *ctx);
 
+    // (since 1.1) set by the host before config is called.
+    // ref_frame returns a new handle to the same pixel data; the plane
+    // pointers of the corresponding picdata stay valid until the handle is
+    // passed to unref_frame. This allows keeping input frames (e.g. across
+    // put_image calls while pipelining) without copying them.
+    void *(*ref_frame)(void *frame);
+    void (*unref_frame)(void *frame);
+
     unsigned int in_width;
     unsigned int in_height;
     unsigned int in_d_width;
@@ -29,14 +29,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <libavutil/common.h>
 
 #include "config.h"
 #include "common/cpudetect.h"
+#include "osdep/numcores.h"
 #include "video/img_format.h"
 #include "video/mp_image.h"
 #include "vf.h"
@@ -47,13 +50,17 @@
 
 #include "vf_lavfi.h"
 
+// Upper bound on worker threads; each needs its own scratch buffer.
+#define MAX_GRADFUN_SLICES 8
+
 struct vf_priv_s {
     float cfg_thresh;
     int cfg_radius;
     float cfg_size;
     int thresh;
     int radius;
-    uint16_t *buf;
+    int num_slices;
+    uint16_t *buf[MAX_GRADFUN_SLICES];
     void (*filter_line)(uint8_t *dst, uint8_t *src, uint16_t *dc,
                         int width, int thresh, const uint16_t *dithers);
     void (*blur_line)(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
@@ -247,16 +254,43 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
-static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
-                         int width, int height, int dstride, int sstride, int r)
+struct gradfun_slice {
+    struct vf_priv_s *ctx;
+    uint8_t *dst, *src;
+    int width, height, dstride, sstride, r;
+    int y0, y1;     // output row range (even boundaries)
+    uint16_t *sbuf; // scratch for this slice
+};
+
+// Produce output rows [y0,y1) of a plane. Slices other than the topmost warm
+// up on the 2*r rows above their band, so the sliding blur window has the
+// same contents as in a single full-plane pass; the output is bit-identical
+// to serial filtering.
+static void filter_plane_slice(struct gradfun_slice *s)
 {
+    struct vf_priv_s *ctx = s->ctx;
+    int width = s->width;
+    int dstride = s->dstride, sstride = s->sstride;
+    int r = s->r;
+    int ys = FFMAX(s->y0 - 2*r, 0);
+    uint8_t *dst = s->dst + ys*dstride;
+    uint8_t *src = s->src + ys*sstride;
+    int height = FFMIN(s->y1 + 2*r, s->height) - ys;
+    int out0 = s->y0 - ys, out1 = s->y1 - ys;
     int bstride = ((width+15)&~15)/2;
     int y;
     uint32_t dc_factor = (1<<21)/(r*r);
-    uint16_t *dc = ctx->buf+16;
-    uint16_t *buf = ctx->buf+bstride+32;
+    uint16_t *dc = s->sbuf+16;
+    uint16_t *buf = s->sbuf+bstride+32;
     int thresh = ctx->thresh;
 
+#define FILTER_LINE(y) \
+    do { \
+        if ((y) >= out0 && (y) < out1) \
+            ctx->filter_line(dst+(y)*dstride, src+(y)*sstride, dc-r/2, \
+                             width, thresh, dither[((y)+ys)&7]); \
+    } while (0)
+
     memset(dc, 0, (bstride+16)*sizeof(*buf));
     for (y=0; y<r; y++)
         ctx->blur_line(dc, buf+y*bstride, buf+(y-1)*bstride, src+2*y*sstride, sstride, width/2);
@@ -280,13 +314,55 @@ static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
         }
         if (y == r) {
             for (y=0; y<r; y++)
-                ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+                FILTER_LINE(y);
         }
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+        FILTER_LINE(y);
         if (++y >= height) break;
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+        FILTER_LINE(y);
         if (++y >= height) break;
     }
+
+#undef FILTER_LINE
+}
+
+static void *filter_plane_slice_thread(void *arg)
+{
+    filter_plane_slice(arg);
+    return NULL;
+}
+
+static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
+                         int width, int height, int dstride, int sstride, int r)
+{
+    struct gradfun_slice slices[MAX_GRADFUN_SLICES];
+    pthread_t threads[MAX_GRADFUN_SLICES];
+    bool threaded[MAX_GRADFUN_SLICES];
+    // Slices shorter than their warm-up region are not worth a thread.
+    int num_slices = av_clip(height / (4*r), 1, ctx->num_slices);
+    int n;
+
+    for (n = 0; n < num_slices; n++) {
+        slices[n] = (struct gradfun_slice) {
+            .ctx = ctx, .dst = dst, .src = src,
+            .width = width, .height = height,
+            .dstride = dstride, .sstride = sstride, .r = r,
+            .y0 = (height * n / num_slices) & ~1,
+            .y1 = n == num_slices - 1
+                  ? height : (height * (n + 1) / num_slices) & ~1,
+            .sbuf = ctx->buf[n],
+        };
+    }
+    for (n = 1; n < num_slices; n++) {
+        threaded[n] = !pthread_create(&threads[n], NULL,
+                                      filter_plane_slice_thread, &slices[n]);
+        if (!threaded[n])
+            filter_plane_slice(&slices[n]);
+    }
+    filter_plane_slice(&slices[0]);
+    for (n = 1; n < num_slices; n++) {
+        if (threaded[n])
+            pthread_join(threads[n], NULL);
+    }
 }
 
 static struct mp_image *filter(struct vf_instance *vf, struct mp_image *mpi)
@@ -339,21 +415,30 @@ static int config(struct vf_instance *vf,
                   int width, int height, int d_width, int d_height,
                   unsigned int flags, unsigned int outfmt)
 {
-    free(vf->priv->buf);
     vf->priv->radius = vf->priv->cfg_radius;
     if (vf->priv->cfg_size > -1) {
         vf->priv->radius = (vf->priv->cfg_size / 100.0f)
                            * sqrtf(width * width + height * height);
     }
     vf->priv->radius = av_clip((vf->priv->radius+1)&~1, 4, 32);
-    vf->priv->buf = av_mallocz((((width+15)&~15)*(vf->priv->radius+1)/2+32)*sizeof(uint16_t));
+    vf->priv->num_slices = av_clip(default_thread_count(), 1,
+                                   MAX_GRADFUN_SLICES);
+    for (int i = 0; i < MAX_GRADFUN_SLICES; i++) {
+        av_free(vf->priv->buf[i]);
+        vf->priv->buf[i] = NULL;
+        if (i < vf->priv->num_slices) {
+            vf->priv->buf[i] = av_mallocz((((width+15)&~15)
+                               *(vf->priv->radius+1)/2+32)*sizeof(uint16_t));
+        }
+    }
     return vf_next_config(vf,width,height,d_width,d_height,flags,outfmt);
 }
 
 static void uninit(struct vf_instance *vf)
 {
     if (!vf->priv) return;
-    av_free(vf->priv->buf);
+    for (int i = 0; i < MAX_GRADFUN_SLICES; i++)
+        av_free(vf->priv->buf[i]);
 }
 
 static void lavfi_recreate(struct vf_instance *vf)
@@ -20,11 +20,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "common/msg.h"
+#include "osdep/numcores.h"
 #include "options/m_option.h"
 #include "video/img_format.h"
 #include "video/mp_image.h"
@@ -38,9 +41,12 @@
 
 //===========================================================================//
 
+// Upper bound on workers for the row-sliced temporal-only path.
+#define MAX_DENOISE_SLICES 8
+
 struct vf_priv_s {
         int Coefs[4][512*16];
-        unsigned int *Line;
+        unsigned int *Line[3];
 	unsigned short *Frame[3];
         double strength[4];
         struct vf_lw_opts *lw_opts;
@@ -51,12 +57,16 @@ struct vf_priv_s {
 
 static void uninit(struct vf_instance *vf)
 {
-	free(vf->priv->Line);
+	free(vf->priv->Line[0]);
+	free(vf->priv->Line[1]);
+	free(vf->priv->Line[2]);
 	free(vf->priv->Frame[0]);
 	free(vf->priv->Frame[1]);
 	free(vf->priv->Frame[2]);
 
-	vf->priv->Line     = NULL;
+	vf->priv->Line[0]  = NULL;
+	vf->priv->Line[1]  = NULL;
+	vf->priv->Line[2]  = NULL;
 	vf->priv->Frame[0] = NULL;
 	vf->priv->Frame[1] = NULL;
 	vf->priv->Frame[2] = NULL;
@@ -67,7 +77,10 @@ static int config(struct vf_instance *vf,
 	unsigned int flags, unsigned int outfmt){
 
 	uninit(vf);
-        vf->priv->Line = malloc(width*sizeof(unsigned int));
+        // One line buffer per plane, so the planes can run concurrently.
+        vf->priv->Line[0] = malloc(width*sizeof(unsigned int));
+        vf->priv->Line[1] = malloc(width*sizeof(unsigned int));
+        vf->priv->Line[2] = malloc(width*sizeof(unsigned int));
 
 	return vf_next_config(vf,width,height,d_width,d_height,flags,outfmt);
 }
@@ -101,6 +114,66 @@ static void deNoiseTemporal(
     }
 }
 
+// The temporal low-pass carries only per-pixel state (FrameAnt), so rows
+// are independent and can be split into bands across worker threads.
+struct temporal_slice {
+    unsigned char *frame, *frame_dest;
+    unsigned short *frame_ant;
+    int w, h, sstride, dstride;
+    int *temporal;
+};
+
+static void *deNoiseTemporalThread(void *arg)
+{
+    struct temporal_slice *s = arg;
+    deNoiseTemporal(s->frame, s->frame_dest, s->frame_ant,
+                    s->w, s->h, s->sstride, s->dstride, s->temporal);
+    return NULL;
+}
+
+static void deNoiseTemporalSliced(
+                    unsigned char *Frame,
+                    unsigned char *FrameDest,
+                    unsigned short *FrameAnt,
+                    int W, int H, int sStride, int dStride,
+                    int *Temporal)
+{
+    struct temporal_slice slices[MAX_DENOISE_SLICES];
+    pthread_t threads[MAX_DENOISE_SLICES];
+    bool threaded[MAX_DENOISE_SLICES];
+    int num_slices = default_thread_count();
+    int n;
+
+    if (num_slices > MAX_DENOISE_SLICES)
+        num_slices = MAX_DENOISE_SLICES;
+    if (num_slices < 1 || H < 4 * num_slices)
+        num_slices = 1;
+
+    for (n = 0; n < num_slices; n++) {
+        int y0 = H * n / num_slices;
+        int y1 = H * (n + 1) / num_slices;
+        slices[n] = (struct temporal_slice) {
+            .frame = Frame + (long)y0 * sStride,
+            .frame_dest = FrameDest + (long)y0 * dStride,
+            .frame_ant = FrameAnt + (long)y0 * W,
+            .w = W, .h = y1 - y0,
+            .sstride = sStride, .dstride = dStride,
+            .temporal = Temporal,
+        };
+    }
+    for (n = 1; n < num_slices; n++) {
+        threaded[n] = !pthread_create(&threads[n], NULL,
+                                      deNoiseTemporalThread, &slices[n]);
+        if (!threaded[n])
+            deNoiseTemporalThread(&slices[n]);
+    }
+    deNoiseTemporalThread(&slices[0]);
+    for (n = 1; n < num_slices; n++) {
+        if (threaded[n])
+            pthread_join(threads[n], NULL);
+    }
+}
+
 static void deNoiseSpacial(
                     unsigned char *Frame,        // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
@@ -162,8 +235,8 @@ static void deNoise(unsigned char *Frame,        // mpi->planes[x]
     }
 
     if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
+        deNoiseTemporalSliced(Frame, FrameDest, FrameAnt,
+                              W, H, sStride, dStride, Temporal);
         return;
     }
     if(!Temporal[0]){
@@ -209,33 +282,65 @@ static void deNoise(unsigned char *Frame,        // mpi->planes[x]
 }
 
 
+// The three planes carry fully separate state, so they are denoised on
+// concurrent threads (each with its own line buffer).
+struct denoise_job {
+    unsigned char *frame, *frame_dest;
+    unsigned int *line_ant;
+    unsigned short **frame_ant_ptr;
+    int w, h, sstride, dstride;
+    int *horizontal, *vertical, *temporal;
+};
+
+static void *denoise_thread(void *arg)
+{
+    struct denoise_job *j = arg;
+    deNoise(j->frame, j->frame_dest, j->line_ant, j->frame_ant_ptr,
+            j->w, j->h, j->sstride, j->dstride,
+            j->horizontal, j->vertical, j->temporal);
+    return NULL;
+}
+
 static struct mp_image *filter(struct vf_instance *vf, struct mp_image *mpi)
 {
 	int cw= mpi->w >> mpi->chroma_x_shift;
 	int ch= mpi->h >> mpi->chroma_y_shift;
         int W = mpi->w, H = mpi->h;
+        struct denoise_job jobs[3];
+        pthread_t threads[3];
+        bool threaded[3];
+        int n;
 
         struct mp_image *dmpi = vf_alloc_out_image(vf);
         mp_image_copy_attributes(dmpi, mpi);
 
-        deNoise(mpi->planes[0], dmpi->planes[0],
-		vf->priv->Line, &vf->priv->Frame[0], W, H,
-                mpi->stride[0], dmpi->stride[0],
-                vf->priv->Coefs[0],
-                vf->priv->Coefs[0],
-                vf->priv->Coefs[1]);
-        deNoise(mpi->planes[1], dmpi->planes[1],
-		vf->priv->Line, &vf->priv->Frame[1], cw, ch,
-                mpi->stride[1], dmpi->stride[1],
-                vf->priv->Coefs[2],
-                vf->priv->Coefs[2],
-                vf->priv->Coefs[3]);
-        deNoise(mpi->planes[2], dmpi->planes[2],
-		vf->priv->Line, &vf->priv->Frame[2], cw, ch,
-                mpi->stride[2], dmpi->stride[2],
-                vf->priv->Coefs[2],
-                vf->priv->Coefs[2],
-                vf->priv->Coefs[3]);
+        for (n = 0; n < 3; n++) {
+            int luma = n == 0;
+            jobs[n] = (struct denoise_job) {
+                .frame = mpi->planes[n],
+                .frame_dest = dmpi->planes[n],
+                .line_ant = vf->priv->Line[n],
+                .frame_ant_ptr = &vf->priv->Frame[n],
+                .w = luma ? W : cw,
+                .h = luma ? H : ch,
+                .sstride = mpi->stride[n],
+                .dstride = dmpi->stride[n],
+                .horizontal = vf->priv->Coefs[luma ? 0 : 2],
+                .vertical = vf->priv->Coefs[luma ? 0 : 2],
+                .temporal = vf->priv->Coefs[luma ? 1 : 3],
+            };
+        }
+        for (n = 1; n < 3; n++) {
+            threaded[n] = !pthread_create(&threads[n], NULL, denoise_thread,
+                                          &jobs[n]);
+            if (!threaded[n])
+                denoise_thread(&jobs[n]);
+        }
+        denoise_thread(&jobs[0]);
+        for (n = 1; n < 3; n++) {
+            if (threaded[n])
+                pthread_join(threads[n], NULL);
+        }
 
         talloc_free(mpi);
         return dmpi;
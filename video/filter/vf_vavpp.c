@@ -152,11 +152,11 @@ static struct mp_image *render(struct vf_priv_s *p, struct va_surface *in,
         param->filter_flags = flags;
         param->filters = p->pipe.filters;
         param->num_filters = p->pipe.num_filters;
-        vaUnmapBuffer(p->display, buffer);
         param->forward_references = p->pipe.forward.surfaces;
         param->backward_references = p->pipe.backward.surfaces;
         param->num_forward_references = p->pipe.forward.num_required;
         param->num_backward_references = p->pipe.backward.num_required;
+        vaUnmapBuffer(p->display, buffer);
         status = vaRenderPicture(p->display, p->context, &buffer, 1);
         if (!is_success(status, "vaRenderPicture()"))
             break;
@@ -20,13 +20,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "config.h"
 #include "common/cpudetect.h"
 #include "options/options.h"
+#include "osdep/numcores.h"
 
 #include "common/msg.h"
 #include "video/img_format.h"
@@ -358,32 +361,86 @@ static void filter_line_c(struct vf_priv_s *p, uint8_t *dst, uint8_t *prev, uint
     }
 }
 
-static void filter(struct vf_priv_s *p, uint8_t *dst[3], int dst_stride[3], int width, int height, int parity, int tff){
+// Rows are independent (filter_line only reads the padded ref planes), so
+// the frame can be sliced across threads. Below this height it's not worth
+// the thread startup overhead.
+#define MAX_DEINT_SLICES 8
+#define MIN_DEINT_HEIGHT 480
+
+struct deint_slice {
+    struct vf_priv_s *p;
+    uint8_t **dst;
+    int *dst_stride;
+    int width, height, parity, tff;
+    int slice, num_slices;
+};
+
+static void filter_slice(struct deint_slice *s){
+    struct vf_priv_s *p = s->p;
     int y, i;
 
     for(i=0; i<3; i++){
         int is_chroma= !!i;
-        int w= width >>is_chroma;
-        int h= height>>is_chroma;
+        int w= s->width >>is_chroma;
+        int h= s->height>>is_chroma;
         int refs= p->stride[i];
+        int y0= h *  s->slice    / s->num_slices;
+        int y1= h * (s->slice+1) / s->num_slices;
 
-        for(y=0; y<h; y++){
-            if((y ^ parity) & 1){
+        for(y=y0; y<y1; y++){
+            if((y ^ s->parity) & 1){
                 uint8_t *prev= &p->ref[0][i][y*refs];
                 uint8_t *cur = &p->ref[1][i][y*refs];
                 uint8_t *next= &p->ref[2][i][y*refs];
-                uint8_t *dst2= &dst[i][y*dst_stride[i]];
-                filter_line(p, dst2, prev, cur, next, w, refs, parity ^ tff);
+                uint8_t *dst2= &s->dst[i][y*s->dst_stride[i]];
+                filter_line(p, dst2, prev, cur, next, w, refs,
+                            s->parity ^ s->tff);
             }else{
-                memcpy(&dst[i][y*dst_stride[i]], &p->ref[1][i][y*refs], w);
+                memcpy(&s->dst[i][y*s->dst_stride[i]], &p->ref[1][i][y*refs], w);
             }
         }
     }
 #if HAVE_MMX
+    // MMX state is per thread, so each slice has to clear its own.
     if(gCpuCaps.hasMMX2) __asm__ volatile("emms \n\t" : : : "memory");
 #endif
 }
 
+static void *filter_slice_thread(void *arg){
+    filter_slice(arg);
+    return NULL;
+}
+
+static void filter(struct vf_priv_s *p, uint8_t *dst[3], int dst_stride[3], int width, int height, int parity, int tff){
+    struct deint_slice slices[MAX_DEINT_SLICES];
+    pthread_t threads[MAX_DEINT_SLICES];
+    bool threaded[MAX_DEINT_SLICES];
+    int num_slices= FFMAX(FFMIN(default_thread_count(), MAX_DEINT_SLICES), 1);
+    int n;
+
+    if(height < MIN_DEINT_HEIGHT)
+        num_slices= 1;
+
+    for(n=0; n<num_slices; n++){
+        slices[n]= (struct deint_slice) {
+            .p= p, .dst= dst, .dst_stride= dst_stride,
+            .width= width, .height= height, .parity= parity, .tff= tff,
+            .slice= n, .num_slices= num_slices,
+        };
+    }
+    for(n=1; n<num_slices; n++){
+        threaded[n]= !pthread_create(&threads[n], NULL, filter_slice_thread,
+                                     &slices[n]);
+        if(!threaded[n])
+            filter_slice(&slices[n]);
+    }
+    filter_slice(&slices[0]);
+    for(n=1; n<num_slices; n++){
+        if(threaded[n])
+            pthread_join(threads[n], NULL);
+    }
+}
+
 static int config(struct vf_instance *vf,
         int width, int height, int d_width, int d_height,
 	unsigned int flags, unsigned int outfmt){
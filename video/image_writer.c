@@ -32,6 +32,7 @@
 #endif
 
 #include "osdep/io.h"
+#include "osdep/numcores.h"
 
 #include "image_writer.h"
 #include "talloc.h"
@@ -66,6 +67,7 @@ const struct m_sub_options image_writer_conf = {
         OPT_FLAG("jpeg-baseline", jpeg_baseline, 0),
         OPT_INTRANGE("png-compression", png_compression, 0, 0, 9),
         OPT_INTRANGE("png-filter", png_filter, 0, 0, 5),
+        OPT_FLAG("png-fast", png_fast, 0),
         OPT_STRING("format", format, 0),
         {0},
     },
@@ -106,9 +108,19 @@ static int write_lavc(struct image_writer_ctx *ctx, mp_image_t *image, FILE *fp)
     avctx->width = image->w;
     avctx->height = image->h;
     avctx->pix_fmt = imgfmt2pixfmt(image->imgfmt);
+    // Use all cores for encoders that support slice or frame threading
+    // (ignored by the others).
+    avctx->thread_count = default_thread_count();
+    avctx->thread_type = FF_THREAD_SLICE | FF_THREAD_FRAME;
     if (ctx->writer->lavc_codec == AV_CODEC_ID_PNG) {
         avctx->compression_level = ctx->opts->png_compression;
         avctx->prediction_method = ctx->opts->png_filter;
+        if (ctx->opts->png_fast) {
+            // Fast preset: cheapest zlib level, no filtering. Overrides the
+            // png-compression/png-filter options.
+            avctx->compression_level = 1;
+            avctx->prediction_method = 0;
+        }
     }
 
     if (avcodec_open2(avctx, codec, NULL) < 0) {
@@ -22,6 +22,7 @@ struct image_writer_opts {
     char *format;
     int png_compression;
     int png_filter;
+    int png_fast;
     int jpeg_quality;
     int jpeg_optimize;
     int jpeg_smooth;
@@ -0,0 +1,98 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with mpv; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "common/cpudetect.h"
+#include "memcpy_pic.h"
+
+#if HAVE_SSE2 && defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// Copy one line, using non-temporal stores for the aligned bulk. The
+// misaligned head and the tail go through the cache as usual. The caller
+// is responsible for the final _mm_sfence().
+static void copy_line_nt(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    size_t head = -(uintptr_t)dst & 15;
+    if (head > len)
+        head = len;
+    if (head) {
+        memcpy(dst, src, head);
+        dst += head;
+        src += head;
+        len -= head;
+    }
+    while (len >= 64) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(src + 0));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)(dst + 0), v0);
+        _mm_stream_si128((__m128i *)(dst + 16), v1);
+        _mm_stream_si128((__m128i *)(dst + 32), v2);
+        _mm_stream_si128((__m128i *)(dst + 48), v3);
+        dst += 64;
+        src += 64;
+        len -= 64;
+    }
+    while (len >= 16) {
+        _mm_stream_si128((__m128i *)dst,
+                         _mm_loadu_si128((const __m128i *)src));
+        dst += 16;
+        src += 16;
+        len -= 16;
+    }
+    if (len)
+        memcpy(dst, src, len);
+}
+
+#endif
+
+void mp_memcpy_pic_nt(void *dst, const void *src, int bytesPerLine, int height,
+                      int dstStride, int srcStride)
+{
+#if HAVE_SSE2 && defined(__SSE2__)
+    if (gCpuCaps.hasSSE2) {
+        if (bytesPerLine == dstStride && dstStride == srcStride) {
+            if (srcStride < 0) {
+                src = (uint8_t *)src + (height - 1) * srcStride;
+                dst = (uint8_t *)dst + (height - 1) * dstStride;
+                srcStride = -srcStride;
+            }
+            copy_line_nt(dst, src, (size_t)srcStride * height);
+        } else {
+            for (int i = 0; i < height; i++) {
+                copy_line_nt(dst, src, bytesPerLine);
+                src = (uint8_t *)src + srcStride;
+                dst = (uint8_t *)dst + dstStride;
+            }
+        }
+        // Make the streamed stores visible before anyone reads the image.
+        _mm_sfence();
+        return;
+    }
+#endif
+    for (int i = 0; i < height; i++) {
+        memcpy(dst, src, bytesPerLine);
+        src = (uint8_t *)src + srcStride;
+        dst = (uint8_t *)dst + dstStride;
+    }
+}
@@ -26,10 +26,24 @@
 #define my_memcpy_pic memcpy_pic
 #define memcpy_pic2(d, s, b, h, ds, ss, unused) memcpy_pic(d, s, b, h, ds, ss)
 
+// memcpy_pic.c - like memcpy_pic(), but uses non-temporal stores for the
+// bulk of the copy if the CPU supports them.
+void mp_memcpy_pic_nt(void *dst, const void *src, int bytesPerLine, int height,
+                      int dstStride, int srcStride);
+
 static inline void memcpy_pic(void *dst, const void *src,
                               int bytesPerLine, int height,
                               int dstStride, int srcStride)
 {
+    // A copied frame is typically consumed asynchronously (by the GPU, or
+    // a hardware decoder surface mapping), not read back right away. For
+    // copies that wouldn't fit in L2 anyway, bypass the cache instead of
+    // evicting the player's working set.
+    if ((size_t)bytesPerLine * height >= 256 * 1024) {
+        mp_memcpy_pic_nt(dst, src, bytesPerLine, height, dstStride, srcStride);
+        return;
+    }
+
     if (bytesPerLine == dstStride && dstStride == srcStride) {
         if (srcStride < 0) {
             src = (uint8_t*)src + (height - 1) * srcStride;
@@ -66,9 +80,17 @@ static inline void memset16_pic(void *dst, int fill, int unitsPerLine,
     if (fill == 0) {
         memset_pic(dst, 0, unitsPerLine * 2, height, stride);
     } else {
+        // Used for non-zero black levels (chroma planes, 10 bit luma).
+        // Replicate the value to 8 bytes and let the compiler turn the
+        // wide stores into SIMD; a border fill is purely store bound.
+        uint64_t fill4 = (uint16_t)fill * UINT64_C(0x0001000100010001);
         for (int i = 0; i < height; i++) {
             uint16_t *line = dst;
             uint16_t *end = line + unitsPerLine;
+            while (line < end && ((uintptr_t)line & 7))
+                *line++ = fill;
+            for (; line + 4 <= end; line += 4)
+                memcpy(line, &fill4, 8);
             while (line < end)
                 *line++ = fill;
             dst = (uint8_t *)dst + stride;
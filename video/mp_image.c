@@ -130,23 +130,31 @@ static void mp_image_alloc_planes(struct mp_image *mpi)
         int alloc_h = MP_ALIGN_UP(mpi->h, 32) >> mpi->fmt.ys[n];
         int line_bytes = (mpi->plane_w[n] * mpi->fmt.bpp[n] + 7) / 8;
         mpi->stride[n] = FFALIGN(line_bytes, SWS_MIN_BYTE_ALIGN);
+        /* With power-of-two widths, consecutive lines (and whole planes)
+         * land in the same cache sets, which measurably slows down copy
+         * and filter loops. Break the pattern with one extra cache line. */
+        if (mpi->stride[n] > 0 && mpi->stride[n] % 1024 == 0)
+            mpi->stride[n] += 64;
         plane_size[n] = mpi->stride[n] * alloc_h;
     }
     if (mpi->fmt.flags & MP_IMGFLAG_PAL)
         plane_size[1] = MP_PALETTE_SIZE;
 
+    // Each plane starts on its own cache line (relative to the start of the
+    // allocation; the absolute alignment is up to av_malloc()).
+    size_t plane_offset[MP_MAX_PLANES];
     size_t sum = 0;
-    for (int n = 0; n < MP_MAX_PLANES; n++)
-        sum += plane_size[n];
+    for (int n = 0; n < MP_MAX_PLANES; n++) {
+        plane_offset[n] = sum;
+        sum += MP_ALIGN_UP(plane_size[n], 64);
+    }
 
     uint8_t *data = av_malloc(FFMAX(sum, 1));
     if (!data)
         abort(); //out of memory
 
-    for (int n = 0; n < MP_MAX_PLANES; n++) {
-        mpi->planes[n] = plane_size[n] ? data : NULL;
-        data += plane_size[n];
-    }
+    for (int n = 0; n < MP_MAX_PLANES; n++)
+        mpi->planes[n] = plane_size[n] ? data + plane_offset[n] : NULL;
 }
 
 void mp_image_setfmt(struct mp_image *mpi, unsigned int out_fmt)
@@ -126,6 +126,23 @@ struct mp_image *mp_image_pool_get(struct mp_image_pool *pool, unsigned int fmt,
     pool_unlock();
 
     if (!new) {
+        // Evict unreferenced images that can't be reused anyway. E.g. on a
+        // decoder reinit with a new size, they would otherwise stick around
+        // (doubling frame memory) until the pool overflows.
+        for (int n = pool->num_images - 1; n >= 0; n--) {
+            struct mp_image *img = pool->images[n];
+            if (img->imgfmt != fmt || img->w != w || img->h != h) {
+                struct image_flags *it = img->priv;
+                bool referenced;
+                pool_lock();
+                it->pool_alive = false;
+                referenced = it->referenced;
+                pool_unlock();
+                if (!referenced)
+                    talloc_free(img);
+                MP_TARRAY_REMOVE_AT(pool->images, pool->num_images, n);
+            }
+        }
         if (pool->num_images >= pool->max_count)
             mp_image_pool_clear(pool);
         new = mp_image_alloc(fmt, w, h);
@@ -165,7 +165,22 @@ int packer_pack(struct bitmap_packer *packer)
             packer->used_height = FFMIN(y, packer->h);
             assert(packer->w == 0 || IS_POWER_OF_2(packer->w));
             assert(packer->h == 0 || IS_POWER_OF_2(packer->h));
-            return packer->w != w_orig || packer->h != h_orig;
+            bool resized = packer->w != w_orig || packer->h != h_orig;
+            packer->layout_changed =
+                resized || packer->count != packer->prev_count;
+            for (int i = 0; i < packer->count; i++) {
+                bool d = resized || i >= packer->prev_count ||
+                         packer->prev_in[i].x != in[i].x ||
+                         packer->prev_in[i].y != in[i].y ||
+                         packer->prev_result[i].x != packer->result[i].x ||
+                         packer->prev_result[i].y != packer->result[i].y;
+                packer->dirty[i] = d;
+                packer->layout_changed |= d;
+                packer->prev_in[i] = in[i];
+                packer->prev_result[i] = packer->result[i];
+            }
+            packer->prev_count = packer->count;
+            return resized;
         }
         if (packer->w <= packer->h && packer->w != packer->w_max)
             packer->w = FFMIN(packer->w * 2, packer->w_max);
@@ -174,6 +189,7 @@ int packer_pack(struct bitmap_packer *packer)
         else {
             packer->w = w_orig;
             packer->h = h_orig;
+            packer->prev_count = 0;
             return -1;
         }
     }
@@ -190,6 +206,11 @@ void packer_set_size(struct bitmap_packer *packer, int size)
     packer->in = talloc_realloc(packer, packer->in, struct pos, packer->asize);
     packer->result = talloc_array_ptrtype(packer, packer->result,
                                           packer->asize);
+    packer->dirty = talloc_realloc(packer, packer->dirty, bool, packer->asize);
+    packer->prev_in = talloc_realloc(packer, packer->prev_in, struct pos,
+                                     packer->asize);
+    packer->prev_result = talloc_realloc(packer, packer->prev_result,
+                                         struct pos, packer->asize);
     packer->scratch = talloc_array_ptrtype(packer, packer->scratch,
                                            packer->asize + 16);
 }
@@ -1,6 +1,8 @@
 #ifndef MPLAYER_PACK_RECTANGLES_H
 #define MPLAYER_PACK_RECTANGLES_H
 
+#include <stdbool.h>
+
 struct pos {
     int x;
     int y;
@@ -17,9 +19,19 @@ struct bitmap_packer {
     struct pos *result;
     int used_width;
     int used_height;
+    // Set by packer_pack(): dirty[i] is true if rectangle i was assigned a
+    // different slot (position or size) than in the previous packing, or if
+    // the output surface was resized. layout_changed is true if any entry is
+    // dirty or the rectangle count changed. Callers can use this to update
+    // only the changed regions of a packed surface.
+    bool *dirty;
+    bool layout_changed;
 
     // internal
     int *scratch;
+    struct pos *prev_in;
+    struct pos *prev_result;
+    int prev_count;
     int asize;
 };
 
@@ -115,6 +115,7 @@ static const struct feature features[] = {
     {MPGL_CAP_SRGB_FB,          "sRGB framebuffers"},
     {MPGL_CAP_FLOAT_TEX,        "Float textures"},
     {MPGL_CAP_TEX_RG,           "RG textures"},
+    {MPGL_CAP_TIMER_QUERY,      "Timer queries"},
     {MPGL_CAP_NO_SW,            "NO_SW"},
     {0},
 };
@@ -190,6 +191,7 @@ struct gl_functions gl_functions[] = {
         .provides = MPGL_CAP_GL,
         .functions = (struct gl_function[]) {
             DEF_FN_HARD(Viewport),
+            DEF_FN_HARD(Scissor),
             DEF_FN_HARD(Clear),
             DEF_FN_HARD(GenTextures),
             DEF_FN_HARD(DeleteTextures),
@@ -352,6 +354,31 @@ struct gl_functions gl_functions[] = {
         .provides = MPGL_CAP_TEX_RG,
         .functions = (struct gl_function[]) {{0}},
     },
+    // GPU timer queries, extension in GL 2.x/3.x, core in GL 3.3.
+    {
+        .ver_core = MPGL_VER(3, 3),
+        .extension = "GL_ARB_timer_query",
+        .provides = MPGL_CAP_TIMER_QUERY,
+        .functions = (struct gl_function[]) {
+            DEF_FN(GenQueries),
+            DEF_FN(DeleteQueries),
+            DEF_FN(BeginQuery),
+            DEF_FN(EndQuery),
+            DEF_FN(GetQueryObjectuiv),
+            {0}
+        },
+    },
+    // Program binaries, extension in GL 3.x, core in GL 4.1.
+    {
+        .ver_core = MPGL_VER(4, 1),
+        .extension = "GL_ARB_get_program_binary",
+        .functions = (struct gl_function[]) {
+            DEF_FN(GetProgramBinary),
+            DEF_FN(ProgramBinary),
+            DEF_FN(ProgramParameteri),
+            {0}
+        },
+    },
     // Swap control, always an OS specific extension
     {
         .extension = "_swap_control",
@@ -768,6 +795,143 @@ void glDownloadTex(GL *gl, GLenum target, GLenum format, GLenum type,
     gl->GetTexImage(target, 0, format, type, dataptr);
 }
 
+struct pool_tex {
+    GLenum target;
+    GLint internal_format;
+    GLenum format;
+    GLenum type;
+    int w, h;
+    GLuint texture;
+    bool in_use;
+};
+
+struct gl_tex_pool {
+    GL *gl;
+    struct pool_tex *textures;
+    int num_textures;
+    GLuint *fbos;               // unused framebuffer objects
+    int num_fbos;
+};
+
+// Maximum number of idle textures kept for reuse. Exceeding entries are
+// deleted oldest-first; this bounds VRAM waste when the working set shrinks
+// (e.g. after switching to a video with smaller dimensions).
+#define TEX_POOL_MAX_IDLE 16
+
+struct gl_tex_pool *gl_tex_pool_create(GL *gl)
+{
+    struct gl_tex_pool *pool = talloc_zero(NULL, struct gl_tex_pool);
+    pool->gl = gl;
+    return pool;
+}
+
+// Delete all pooled GL objects and free the pool. The GL context must still
+// be current; all textures handed out by the pool must have been returned.
+void gl_tex_pool_free(struct gl_tex_pool *pool)
+{
+    if (!pool)
+        return;
+    GL *gl = pool->gl;
+    for (int n = 0; n < pool->num_textures; n++) {
+        assert(!pool->textures[n].in_use);
+        gl->DeleteTextures(1, &pool->textures[n].texture);
+    }
+    for (int n = 0; n < pool->num_fbos; n++)
+        gl->DeleteFramebuffers(1, &pool->fbos[n]);
+    talloc_free(pool);
+}
+
+// Return a texture with storage already allocated via glTexImage2D. An idle
+// pool entry is reused if it matches the requested size and format exactly;
+// otherwise a new texture is created (bound to target during creation, then
+// unbound). Texture parameters are not reset - callers must set the ones
+// they rely on, as reused textures keep the previous user's parameters.
+GLuint gl_tex_pool_get_tex(struct gl_tex_pool *pool, GLenum target,
+                           GLint internal_format, GLenum format, GLenum type,
+                           int w, int h)
+{
+    GL *gl = pool->gl;
+
+    for (int n = 0; n < pool->num_textures; n++) {
+        struct pool_tex *e = &pool->textures[n];
+        if (!e->in_use && e->target == target && e->w == w && e->h == h &&
+            e->internal_format == internal_format && e->format == format &&
+            e->type == type)
+        {
+            e->in_use = true;
+            return e->texture;
+        }
+    }
+
+    struct pool_tex e = {
+        .target = target,
+        .internal_format = internal_format,
+        .format = format,
+        .type = type,
+        .w = w,
+        .h = h,
+        .in_use = true,
+    };
+    gl->GenTextures(1, &e.texture);
+    gl->BindTexture(target, e.texture);
+    gl->TexImage2D(target, 0, internal_format, w, h, 0, format, type, NULL);
+    gl->BindTexture(target, 0);
+
+    pool->textures = talloc_realloc(pool, pool->textures, struct pool_tex,
+                                    pool->num_textures + 1);
+    pool->textures[pool->num_textures++] = e;
+    return e.texture;
+}
+
+// Return a texture to the pool for later reuse. texture==0 is ignored.
+void gl_tex_pool_put_tex(struct gl_tex_pool *pool, GLuint texture)
+{
+    if (!texture)
+        return;
+    GL *gl = pool->gl;
+    int idle = 0;
+    int entry = -1;
+    for (int n = 0; n < pool->num_textures; n++) {
+        if (pool->textures[n].texture == texture) {
+            assert(pool->textures[n].in_use);
+            pool->textures[n].in_use = false;
+            entry = n;
+        }
+        if (!pool->textures[n].in_use)
+            idle++;
+    }
+    assert(entry >= 0);
+    for (int n = 0; idle > TEX_POOL_MAX_IDLE && n < pool->num_textures;) {
+        if (!pool->textures[n].in_use) {
+            gl->DeleteTextures(1, &pool->textures[n].texture);
+            pool->textures[n] = pool->textures[--pool->num_textures];
+            idle--;
+        } else {
+            n++;
+        }
+    }
+}
+
+// FBOs carry no storage of their own, so they are recycled from a plain
+// free list (attachments are rebound by the caller anyway).
+GLuint gl_tex_pool_get_fbo(struct gl_tex_pool *pool)
+{
+    GL *gl = pool->gl;
+    if (pool->num_fbos > 0)
+        return pool->fbos[--pool->num_fbos];
+    GLuint fbo = 0;
+    gl->GenFramebuffers(1, &fbo);
+    return fbo;
+}
+
+void gl_tex_pool_put_fbo(struct gl_tex_pool *pool, GLuint fbo)
+{
+    if (!fbo)
+        return;
+    pool->fbos = talloc_realloc(pool, pool->fbos, GLuint, pool->num_fbos + 1);
+    pool->fbos[pool->num_fbos++] = fbo;
+}
+
 void glEnable3DLeft(GL *gl, int type)
 {
     GLint buffer;
@@ -858,17 +1022,47 @@ mp_image_t *glGetWindowScreenshot(GL *gl)
 {
     GLint vp[4]; //x, y, w, h
     gl->GetIntegerv(GL_VIEWPORT, vp);
-    mp_image_t *image = mp_image_alloc(IMGFMT_RGB24, vp[2], vp[3]);
     gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-    gl->PixelStorei(GL_PACK_ALIGNMENT, 1);
     gl->PixelStorei(GL_PACK_ROW_LENGTH, 0);
     gl->ReadBuffer(GL_FRONT);
-    //flip image while reading (and also avoid stride-related trouble)
+    if (gl->MapBuffer) {
+        // Read through a PBO in the framebuffer's native component order,
+        // so the driver can DMA the data instead of converting it on the CPU.
+        mp_image_t *image = mp_image_alloc(IMGFMT_BGRA, vp[2], vp[3]);
+        GLuint pbo = 0;
+        gl->GenBuffers(1, &pbo);
+        gl->BindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        gl->BufferData(GL_PIXEL_PACK_BUFFER, 4 * vp[2] * vp[3], NULL,
+                       GL_STREAM_READ);
+        gl->PixelStorei(GL_PACK_ALIGNMENT, 4);
+        gl->ReadPixels(vp[0], vp[1], vp[2], vp[3], GL_BGRA, GL_UNSIGNED_BYTE,
+                       NULL);
+        char *data = gl->MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (data) {
+            // flip the image while copying it out of the buffer
+            for (int y = 0; y < vp[3]; y++) {
+                memcpy(image->planes[0] + y * image->stride[0],
+                       data + (vp[3] - y - 1) * 4 * vp[2], 4 * vp[2]);
+            }
+            gl->UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        gl->BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        gl->DeleteBuffers(1, &pbo);
+        if (data)
+            return image;
+        talloc_free(image);
+    }
+    // Legacy fallback: read everything with a single call (a call per line
+    // forces a full pipeline sync for every line), then flip while copying.
+    mp_image_t *image = mp_image_alloc(IMGFMT_RGB24, vp[2], vp[3]);
+    char *data = talloc_size(NULL, 3 * vp[2] * vp[3]);
+    gl->PixelStorei(GL_PACK_ALIGNMENT, 1);
+    gl->ReadPixels(vp[0], vp[1], vp[2], vp[3], GL_RGB, GL_UNSIGNED_BYTE, data);
     for (int y = 0; y < vp[3]; y++) {
-        gl->ReadPixels(vp[0], vp[1] + vp[3] - y - 1, vp[2], 1,
-                       GL_RGB, GL_UNSIGNED_BYTE,
-                       image->planes[0] + y * image->stride[0]);
+        memcpy(image->planes[0] + y * image->stride[0],
+               data + (vp[3] - y - 1) * 3 * vp[2], 3 * vp[2]);
     }
+    talloc_free(data);
     return image;
 }
 
@@ -1037,11 +1231,16 @@ void mp_log_source(struct mp_log *log, int lev, const char *src)
     }
 }
 
+extern const struct gl_hwdec_driver gl_hwdec_vaegl;
 extern const struct gl_hwdec_driver gl_hwdec_vaglx;
 extern const struct gl_hwdec_driver gl_hwdec_vda;
 extern const struct gl_hwdec_driver gl_hwdec_vdpau;
 
 const struct gl_hwdec_driver *mpgl_hwdec_drivers[] = {
+    // The EGL driver is zero-copy; try it before the copying GLX driver.
+#if HAVE_VAAPI_EGL
+    &gl_hwdec_vaegl,
+#endif
 #if HAVE_VAAPI_GLX
     &gl_hwdec_vaglx,
 #endif
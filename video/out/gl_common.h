@@ -67,6 +67,18 @@ void glDownloadTex(GL *gl, GLenum target, GLenum format, GLenum type,
 void glCheckError(GL *gl, struct mp_log *log, const char *info);
 mp_image_t *glGetWindowScreenshot(GL *gl);
 
+// Pool of reusable textures and FBOs, so reconfiguration and OSD changes can
+// recycle existing GPU allocations instead of deleting and recreating them.
+struct gl_tex_pool;
+struct gl_tex_pool *gl_tex_pool_create(GL *gl);
+void gl_tex_pool_free(struct gl_tex_pool *pool);
+GLuint gl_tex_pool_get_tex(struct gl_tex_pool *pool, GLenum target,
+                           GLint internal_format, GLenum format, GLenum type,
+                           int w, int h);
+void gl_tex_pool_put_tex(struct gl_tex_pool *pool, GLuint texture);
+GLuint gl_tex_pool_get_fbo(struct gl_tex_pool *pool);
+void gl_tex_pool_put_fbo(struct gl_tex_pool *pool, GLuint fbo);
+
 #define GL_3D_RED_CYAN        1
 #define GL_3D_GREEN_MAGENTA   2
 #define GL_3D_QUADBUFFER      3
@@ -89,6 +101,7 @@ enum {
     MPGL_CAP_TEX_RG             = (1 << 10),    // GL_ARB_texture_rg / GL 3.x
     MPGL_CAP_VDPAU              = (1 << 11),    // GL_NV_vdpau_interop
     MPGL_CAP_APPLE_RGB_422      = (1 << 12),    // GL_APPLE_rgb_422
+    MPGL_CAP_TIMER_QUERY        = (1 << 13),    // GL_ARB_timer_query / GL 3.3
     MPGL_CAP_NO_SW              = (1 << 30),    // used to block sw. renderers
 };
 
@@ -110,6 +123,10 @@ typedef struct MPGLContext {
     int requested_gl_version;
 
     void (*swapGlBuffers)(struct MPGLContext *);
+    // Optional. Get the age of the current back buffer: the number of swaps
+    // since its contents were last the front buffer, or 0 if the contents are
+    // undefined/unknown (EGL_EXT_buffer_age semantics).
+    int (*getBufferAge)(struct MPGLContext *);
     int (*vo_init)(struct vo *vo);
     void (*vo_uninit)(struct vo *vo);
     int (*vo_control)(struct vo *vo, int *events, int request, void *arg);
@@ -229,6 +246,7 @@ struct GL {
     void (GLAPIENTRY *Begin)(GLenum);
     void (GLAPIENTRY *End)(void);
     void (GLAPIENTRY *Viewport)(GLint, GLint, GLsizei, GLsizei);
+    void (GLAPIENTRY *Scissor)(GLint, GLint, GLsizei, GLsizei);
     void (GLAPIENTRY *MatrixMode)(GLenum);
     void (GLAPIENTRY *LoadIdentity)(void);
     void (GLAPIENTRY *Translated)(double, double, double);
@@ -343,6 +361,10 @@ struct GL {
     void (GLAPIENTRY *GetShaderiv)(GLuint, GLenum, GLint *);
     void (GLAPIENTRY *GetProgramInfoLog)(GLuint, GLsizei, GLsizei *, GLchar *);
     void (GLAPIENTRY *GetProgramiv)(GLenum, GLenum, GLint *);
+    void (GLAPIENTRY *GetProgramBinary)(GLuint, GLsizei, GLsizei *, GLenum *,
+                                        void *);
+    void (GLAPIENTRY *ProgramBinary)(GLuint, GLenum, const void *, GLsizei);
+    void (GLAPIENTRY *ProgramParameteri)(GLuint, GLenum, GLint);
     const GLubyte* (GLAPIENTRY *GetStringi)(GLenum, GLuint);
     void (GLAPIENTRY *BindAttribLocation)(GLuint, GLuint, const GLchar *);
     void (GLAPIENTRY *BindFramebuffer)(GLenum, GLuint);
@@ -351,6 +373,11 @@ struct GL {
     GLenum (GLAPIENTRY *CheckFramebufferStatus)(GLenum);
     void (GLAPIENTRY *FramebufferTexture2D)(GLenum, GLenum, GLenum, GLuint,
                                             GLint);
+    void (GLAPIENTRY *GenQueries)(GLsizei, GLuint *);
+    void (GLAPIENTRY *DeleteQueries)(GLsizei, const GLuint *);
+    void (GLAPIENTRY *BeginQuery)(GLenum, GLuint);
+    void (GLAPIENTRY *EndQuery)(GLenum);
+    void (GLAPIENTRY *GetQueryObjectuiv)(GLuint, GLenum, GLuint *);
 
     void (GLAPIENTRY *Uniform1f)(GLint, GLfloat);
     void (GLAPIENTRY *Uniform2f)(GLint, GLfloat, GLfloat);
@@ -0,0 +1,262 @@
+/*
+ * This file is part of mpv.
+ *
+ * mpv is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * mpv is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with mpv.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <va/va_drm.h>
+#include <va/va_drmcommon.h>
+
+#include "gl_common.h"
+#include "video/vaapi.h"
+#include "video/img_format.h"
+#include "video/hwdec.h"
+
+// Plane formats for EGL_LINUX_DRM_FOURCC_EXT (from drm_fourcc.h, which is
+// not a dependency of the EGL headers).
+#ifndef DRM_FORMAT_R8
+#define DRM_FORMAT_R8   0x20203852  // 'R8  '
+#endif
+#ifndef DRM_FORMAT_GR88
+#define DRM_FORMAT_GR88 0x38385247  // 'GR88'
+#endif
+
+/* True zero-copy path: the VA surface's backing dmabuf is imported as
+ * EGLImages (one per NV12 plane), which the GL textures sample directly.
+ * No surface data is ever copied, unlike the GLX path, which runs a full
+ * surface-to-RGB copy per frame with vaCopySurfaceGLX().
+ *
+ * Requires an EGL based GL context, EGL_EXT_image_dma_buf_import, and
+ * libva with vaAcquireBufferHandle() (>= 0.36).
+ */
+
+struct priv {
+    struct mp_vaapi_ctx *ctx;
+    VADisplay display;
+    int drm_fd;
+
+    GLuint gl_textures[2];
+    EGLImageKHR images[2];
+    VAImage current_image;
+    bool buffer_acquired;
+
+    EGLDisplay egl_display;
+    PFNEGLCREATEIMAGEKHRPROC CreateImageKHR;
+    PFNEGLDESTROYIMAGEKHRPROC DestroyImageKHR;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC EGLImageTargetTexture2DOES;
+};
+
+static void unmap_image(struct gl_hwdec *hw)
+{
+    struct priv *p = hw->priv;
+
+    for (int n = 0; n < 2; n++) {
+        if (p->images[n])
+            p->DestroyImageKHR(p->egl_display, p->images[n]);
+        p->images[n] = 0;
+    }
+    if (p->buffer_acquired) {
+        vaReleaseBufferHandle(p->display, p->current_image.buf);
+        p->buffer_acquired = false;
+    }
+    if (p->current_image.image_id != VA_INVALID_ID) {
+        vaDestroyImage(p->display, p->current_image.image_id);
+        p->current_image.image_id = VA_INVALID_ID;
+    }
+}
+
+static void destroy_textures(struct gl_hwdec *hw)
+{
+    struct priv *p = hw->priv;
+    GL *gl = hw->mpgl->gl;
+
+    gl->DeleteTextures(2, p->gl_textures);
+    p->gl_textures[0] = p->gl_textures[1] = 0;
+}
+
+static void destroy(struct gl_hwdec *hw)
+{
+    struct priv *p = hw->priv;
+    unmap_image(hw);
+    destroy_textures(hw);
+    va_destroy(p->ctx);
+    if (p->drm_fd >= 0)
+        close(p->drm_fd);
+}
+
+static bool has_egl_extension(EGLDisplay display, const char *name)
+{
+    const char *exts = eglQueryString(display, EGL_EXTENSIONS);
+    return exts && strstr(exts, name);
+}
+
+static int create(struct gl_hwdec *hw)
+{
+    if (hw->info->vaapi_ctx)
+        return -1;
+    if (eglGetCurrentContext() == EGL_NO_CONTEXT)
+        return -1;
+
+    struct priv *p = talloc_zero(hw, struct priv);
+    hw->priv = p;
+    p->current_image.image_id = VA_INVALID_ID;
+    p->drm_fd = -1;
+
+    p->egl_display = eglGetCurrentDisplay();
+    if (p->egl_display == EGL_NO_DISPLAY)
+        return -1;
+    if (!has_egl_extension(p->egl_display, "EGL_EXT_image_dma_buf_import"))
+        return -1;
+
+    p->CreateImageKHR = (PFNEGLCREATEIMAGEKHRPROC)
+        eglGetProcAddress("eglCreateImageKHR");
+    p->DestroyImageKHR = (PFNEGLDESTROYIMAGEKHRPROC)
+        eglGetProcAddress("eglDestroyImageKHR");
+    p->EGLImageTargetTexture2DOES = (PFNGLEGLIMAGETARGETTEXTURE2DOESPROC)
+        eglGetProcAddress("glEGLImageTargetTexture2DOES");
+    if (!p->CreateImageKHR || !p->DestroyImageKHR ||
+        !p->EGLImageTargetTexture2DOES)
+        return -1;
+
+    p->drm_fd = open("/dev/dri/renderD128", O_RDWR);
+    if (p->drm_fd < 0)
+        return -1;
+    p->display = vaGetDisplayDRM(p->drm_fd);
+    if (!p->display) {
+        close(p->drm_fd);
+        p->drm_fd = -1;
+        return -1;
+    }
+    p->ctx = va_initialize(p->display);
+    if (!p->ctx) {
+        vaTerminate(p->display);
+        close(p->drm_fd);
+        p->drm_fd = -1;
+        return -1;
+    }
+    hw->info->vaapi_ctx = p->ctx;
+    hw->converted_imgfmt = IMGFMT_NV12;
+    return 0;
+}
+
+static int reinit(struct gl_hwdec *hw, const struct mp_image_params *params)
+{
+    struct priv *p = hw->priv;
+    GL *gl = hw->mpgl->gl;
+
+    unmap_image(hw);
+    destroy_textures(hw);
+
+    gl->GenTextures(2, p->gl_textures);
+    for (int n = 0; n < 2; n++) {
+        gl->BindTexture(GL_TEXTURE_2D, p->gl_textures[n]);
+        gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // Texture storage is provided by the imported EGLImage on map.
+    }
+    gl->BindTexture(GL_TEXTURE_2D, 0);
+    return 0;
+}
+
+static int map_image(struct gl_hwdec *hw, struct mp_image *hw_image,
+                     GLuint *out_textures)
+{
+    struct priv *p = hw->priv;
+    GL *gl = hw->mpgl->gl;
+    VAStatus status;
+
+    unmap_image(hw);
+
+    status = vaDeriveImage(p->display, va_surface_id_in_mp_image(hw_image),
+                           &p->current_image);
+    if (!check_va_status(status, "vaDeriveImage()"))
+        return -1;
+    if (p->current_image.format.fourcc != VA_FOURCC_NV12)
+        goto error;
+
+    VABufferInfo buffer_info = {
+        .mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME,
+    };
+    status = vaAcquireBufferHandle(p->display, p->current_image.buf,
+                                   &buffer_info);
+    if (!check_va_status(status, "vaAcquireBufferHandle()"))
+        goto error;
+    p->buffer_acquired = true;
+
+    for (int n = 0; n < 2; n++) {
+        int w = p->current_image.width;
+        int h = p->current_image.height;
+        // NV12: plane 0 is full-size luma, plane 1 half-size interleaved CbCr.
+        EGLint attribs[] = {
+            EGL_LINUX_DRM_FOURCC_EXT, n ? DRM_FORMAT_GR88 : DRM_FORMAT_R8,
+            EGL_WIDTH, n ? w / 2 : w,
+            EGL_HEIGHT, n ? h / 2 : h,
+            EGL_DMA_BUF_PLANE0_FD_EXT, buffer_info.handle,
+            EGL_DMA_BUF_PLANE0_OFFSET_EXT, p->current_image.offsets[n],
+            EGL_DMA_BUF_PLANE0_PITCH_EXT, p->current_image.pitches[n],
+            EGL_NONE
+        };
+        p->images[n] = p->CreateImageKHR(p->egl_display, EGL_NO_CONTEXT,
+                                         EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+        if (!p->images[n])
+            goto error;
+        gl->BindTexture(GL_TEXTURE_2D, p->gl_textures[n]);
+        p->EGLImageTargetTexture2DOES(GL_TEXTURE_2D, p->images[n]);
+        out_textures[n] = p->gl_textures[n];
+    }
+    gl->BindTexture(GL_TEXTURE_2D, 0);
+    return 0;
+
+error:
+    unmap_image(hw);
+    MP_FATAL(hw, "mapping VAAPI EGL image failed\n");
+    return -1;
+}
+
+// Used for screenshots: maps the VAImage of the decoded surface instead of
+// reading back the EGL texture.
+static struct mp_image *download_image(struct gl_hwdec *hw,
+                                       struct mp_image *hw_image)
+{
+    struct priv *p = hw->priv;
+    struct va_surface *surface = va_surface_in_mp_image(hw_image);
+    if (!surface)
+        return NULL;
+    struct mp_image *img =
+        va_surface_download(surface, p->ctx->image_formats, NULL);
+    if (img)
+        mp_image_copy_attributes(img, hw_image);
+    return img;
+}
+
+const struct gl_hwdec_driver gl_hwdec_vaegl = {
+    .api_name = "vaapi",
+    .imgfmt = IMGFMT_VAAPI,
+    .create = create,
+    .reinit = reinit,
+    .map_image = map_image,
+    .unmap_image = unmap_image,
+    .download_image = download_image,
+    .destroy = destroy,
+};
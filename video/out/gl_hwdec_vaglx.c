@@ -124,6 +124,22 @@ static void unmap_image(struct gl_hwdec *hw)
 {
 }
 
+// Used for screenshots: maps the VAImage of the decoded surface instead of
+// going through the GLX texture copy.
+static struct mp_image *download_image(struct gl_hwdec *hw,
+                                       struct mp_image *hw_image)
+{
+    struct priv *p = hw->priv;
+    struct va_surface *surface = va_surface_in_mp_image(hw_image);
+    if (!surface)
+        return NULL;
+    struct mp_image *img =
+        va_surface_download(surface, p->ctx->image_formats, NULL);
+    if (img)
+        mp_image_copy_attributes(img, hw_image);
+    return img;
+}
+
 const struct gl_hwdec_driver gl_hwdec_vaglx = {
     .api_name = "vaapi",
     .imgfmt = IMGFMT_VAAPI,
@@ -131,5 +147,6 @@ const struct gl_hwdec_driver gl_hwdec_vaglx = {
     .reinit = reinit,
     .map_image = map_image,
     .unmap_image = unmap_image,
+    .download_image = download_image,
     .destroy = destroy,
 };
@@ -246,6 +246,19 @@ static void unmap_image(struct gl_hwdec *hw)
     gl->VDPAUUnmapSurfacesNV(1, &p->vdpgl_surface);
 }
 
+// Used for screenshots: reads the decoded surface back, rather than
+// re-rendering through the mixer or re-decoding in software.
+static struct mp_image *download_image(struct gl_hwdec *hw,
+                                       struct mp_image *hw_image)
+{
+    struct priv *p = hw->priv;
+
+    if (handle_preemption(hw) < 0)
+        return NULL;
+
+    return mp_vdpau_download_video_surface(p->ctx, hw_image);
+}
+
 const struct gl_hwdec_driver gl_hwdec_vdpau = {
     .api_name = "vdpau",
     .imgfmt = IMGFMT_VDPAU,
@@ -253,5 +266,6 @@ const struct gl_hwdec_driver gl_hwdec_vdpau = {
     .reinit = reinit,
     .map_image = map_image,
     .unmap_image = unmap_image,
+    .download_image = download_image,
     .destroy = destroy,
 };
@@ -22,6 +22,8 @@
 
 #include <string.h>
 
+#include <libavutil/adler32.h>
+
 #include "talloc.h"
 
 #include "config.h"
@@ -101,7 +103,7 @@ static struct bstr load_file(void *talloc_ctx, const char *filename)
     return res;
 }
 
-#define LUT3D_CACHE_HEADER "mpv 3dlut cache 1.0\n"
+#define LUT3D_CACHE_HEADER "mpv 3dlut cache 1.1\n"
 
 struct lut3d *mp_load_icc(struct mp_icc_opts *opts, struct mp_log *log)
 {
@@ -120,8 +122,14 @@ struct lut3d *mp_load_icc(struct mp_icc_opts *opts, struct mp_log *log)
     if (!iccdata.len)
         goto error_exit;
 
-    char *cache_info = talloc_asprintf(tmp, "intent=%d, size=%dx%dx%d\n",
-                                       opts->intent, s_r, s_g, s_b);
+    // Key the cache on a checksum of the profile contents instead of
+    // embedding them, so the cache file stays small. A collision is no worse
+    // than a corrupted cache file.
+    unsigned long checksum =
+        av_adler32_update(1, (const uint8_t *)iccdata.start, iccdata.len);
+    char *cache_info =
+        talloc_asprintf(tmp, "intent=%d, size=%dx%dx%d, profile=%zu:%08lx\n",
+                        opts->intent, s_r, s_g, s_b, iccdata.len, checksum);
 
     // check cache
     if (opts->cache) {
@@ -130,7 +138,6 @@ struct lut3d *mp_load_icc(struct mp_icc_opts *opts, struct mp_log *log)
         struct bstr cachedata = load_file(tmp, opts->cache);
         if (bstr_eatstart(&cachedata, bstr0(LUT3D_CACHE_HEADER))
             && bstr_eatstart(&cachedata, bstr0(cache_info))
-            && bstr_eatstart(&cachedata, iccdata)
             && cachedata.len == talloc_get_size(output))
         {
             memcpy(output, cachedata.start, cachedata.len);
@@ -185,13 +192,21 @@ struct lut3d *mp_load_icc(struct mp_icc_opts *opts, struct mp_log *log)
     cmsDeleteTransform(trafo);
 
     if (opts->cache) {
-        FILE *out = fopen(opts->cache, "wb");
+        // Write to a temporary file and rename it into place, so an
+        // interrupted write can't leave a truncated cache behind.
+        char *fname = mp_get_user_path(tmp, opts->cache);
+        char *tmpname = talloc_asprintf(tmp, "%s.tmp", fname);
+        bool ok = false;
+        FILE *out = fopen(tmpname, "wb");
         if (out) {
             fprintf(out, "%s%s", LUT3D_CACHE_HEADER, cache_info);
-            fwrite(iccdata.start, iccdata.len, 1, out);
             fwrite(output, talloc_get_size(output), 1, out);
-            fclose(out);
+            ok = !ferror(out);
+            if (fclose(out) != 0)
+                ok = false;
         }
+        if (!ok || rename(tmpname, fname) != 0)
+            mp_msg_log(log, MSGL_WARN, "Writing 3D LUT cache failed.\n");
     }
 
 done: ;
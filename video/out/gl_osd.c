@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <libavutil/common.h>
+#include <libavutil/adler32.h>
 
 #include "bitmap_packer.h"
 
@@ -47,7 +48,8 @@ static const struct osd_fmt_entry osd_to_gl_legacy_formats[SUBBITMAP_COUNT] = {
     [SUBBITMAP_RGBA] =   {GL_RGBA,  GL_BGRA,  GL_UNSIGNED_BYTE},
 };
 
-struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, bool legacy)
+struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, bool legacy,
+                               struct gl_tex_pool *tex_pool)
 {
     GLint max_texture_size;
     gl->GetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
@@ -57,9 +59,14 @@ struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, bool legacy)
         .log = log,
         .gl = gl,
         .fmt_table = legacy ? osd_to_gl_legacy_formats : osd_to_gl3_formats,
+        .tex_pool = tex_pool,
+        .owns_tex_pool = !tex_pool,
         .scratch = talloc_zero_size(ctx, 1),
     };
 
+    if (ctx->owns_tex_pool)
+        ctx->tex_pool = gl_tex_pool_create(gl);
+
     for (int n = 0; n < MAX_OSD_PARTS; n++) {
         struct mpgl_osd_part *p = talloc_ptrtype(ctx, p);
         *p = (struct mpgl_osd_part) {
@@ -83,10 +90,12 @@ void mpgl_osd_destroy(struct mpgl_osd *ctx)
 
     for (int n = 0; n < MAX_OSD_PARTS; n++) {
         struct mpgl_osd_part *p = ctx->parts[n];
-        gl->DeleteTextures(1, &p->texture);
+        gl_tex_pool_put_tex(ctx->tex_pool, p->texture);
         if (gl->DeleteBuffers)
             gl->DeleteBuffers(1, &p->buffer);
     }
+    if (ctx->owns_tex_pool)
+        gl_tex_pool_free(ctx->tex_pool);
     talloc_free(ctx);
 }
 
@@ -131,24 +140,48 @@ static bool upload_pbo(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
     return success;
 }
 
+static uint32_t part_checksum(struct sub_bitmap *s, int pix_stride)
+{
+    unsigned long sum = 1;
+    for (int y = 0; y < s->h; y++) {
+        sum = av_adler32_update(sum, (uint8_t *)s->bitmap + y * s->stride,
+                                s->w * pix_stride);
+    }
+    return sum;
+}
+
 static void upload_tex(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
                        struct sub_bitmaps *imgs)
 {
     struct osd_fmt_entry fmt = ctx->fmt_table[imgs->format];
-    if (osd->packer->padding) {
+    int pix_stride = glFmt2bpp(fmt.format, fmt.type);
+    // If the atlas layout is unchanged, only regions whose bitmap contents
+    // actually changed need to be re-uploaded. If it did change, everything
+    // is re-uploaded (also because clearing the padding wipes old contents).
+    bool all = osd->packer->layout_changed ||
+               osd->packer->count > osd->num_part_checksums;
+    if (osd->packer->padding && all) {
         struct pos bb[2];
         packer_get_bb(osd->packer, bb);
         glClearTex(ctx->gl, GL_TEXTURE_2D, fmt.format, fmt.type,
                    bb[0].x, bb[0].y, bb[1].x - bb[0].y, bb[1].y - bb[0].y,
                    0, &ctx->scratch);
     }
+    osd->part_checksums = talloc_realloc(osd, osd->part_checksums, uint32_t,
+                                         osd->packer->count);
     for (int n = 0; n < osd->packer->count; n++) {
         struct sub_bitmap *s = &imgs->parts[n];
         struct pos p = osd->packer->result[n];
 
+        uint32_t sum = part_checksum(s, pix_stride);
+        if (!all && !osd->packer->dirty[n] && sum == osd->part_checksums[n])
+            continue;
+        osd->part_checksums[n] = sum;
+
         glUploadTex(ctx->gl, GL_TEXTURE_2D, fmt.format, fmt.type,
                     s->bitmap, s->stride, p.x, p.y, s->w, s->h, 0);
     }
+    osd->num_part_checksums = osd->packer->count;
 }
 
 static bool upload_osd(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
@@ -168,20 +201,19 @@ static bool upload_osd(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
     struct osd_fmt_entry fmt = ctx->fmt_table[imgs->format];
     assert(fmt.type != 0);
 
-    if (!osd->texture)
-        gl->GenTextures(1, &osd->texture);
-
-    gl->BindTexture(GL_TEXTURE_2D, osd->texture);
-
-    if (osd->packer->w > osd->w || osd->packer->h > osd->h
+    if (!osd->texture || osd->packer->w > osd->w || osd->packer->h > osd->h
         || osd->format != imgs->format)
     {
+        gl_tex_pool_put_tex(ctx->tex_pool, osd->texture);
+
         osd->format = imgs->format;
         osd->w = FFMAX(32, osd->packer->w);
         osd->h = FFMAX(32, osd->packer->h);
 
-        gl->TexImage2D(GL_TEXTURE_2D, 0, fmt.internal_format, osd->w, osd->h,
-                       0, fmt.format, fmt.type, NULL);
+        osd->texture = gl_tex_pool_get_tex(ctx->tex_pool, GL_TEXTURE_2D,
+                                           fmt.internal_format, fmt.format,
+                                           fmt.type, osd->w, osd->h);
+        gl->BindTexture(GL_TEXTURE_2D, osd->texture);
 
         gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         gl->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -191,13 +223,21 @@ static bool upload_osd(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
         if (gl->DeleteBuffers)
             gl->DeleteBuffers(1, &osd->buffer);
         osd->buffer = 0;
+        osd->num_part_checksums = 0;
+    } else {
+        gl->BindTexture(GL_TEXTURE_2D, osd->texture);
     }
 
     bool uploaded = false;
     if (ctx->use_pbo)
         uploaded = upload_pbo(ctx, osd, imgs);
-    if (!uploaded)
+    if (uploaded) {
+        // The PBO path always uploads the whole bounding box, so the
+        // checksums can't be trusted for partial uploads anymore.
+        osd->num_part_checksums = 0;
+    } else {
         upload_tex(ctx, osd, imgs);
+    }
 
     gl->BindTexture(GL_TEXTURE_2D, 0);
 
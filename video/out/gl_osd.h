@@ -16,7 +16,14 @@ struct mpgl_osd_part {
     GLuint buffer;
     int num_vertices;
     void *vertices;
+    // Bounding box of the rendered sub-bitmaps in window coordinates (valid
+    // as long as the cached vertices are).
+    struct mp_rect bb;
     struct bitmap_packer *packer;
+    // Per sub-bitmap content checksums from the previous upload, used to
+    // skip glTexSubImage2D for atlas regions that did not change.
+    uint32_t *part_checksums;
+    int num_part_checksums;
 };
 
 struct mpgl_osd {
@@ -27,10 +34,15 @@ struct mpgl_osd {
     struct mpgl_osd_part *parts[MAX_OSD_PARTS];
     const struct osd_fmt_entry *fmt_table;
     bool formats[SUBBITMAP_COUNT];
+    // Textures are recycled through this pool; either shared with the caller
+    // (gl_video), or private if the caller passed NULL.
+    struct gl_tex_pool *tex_pool;
+    bool owns_tex_pool;
     void *scratch;
 };
 
-struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, bool legacy);
+struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, bool legacy,
+                               struct gl_tex_pool *tex_pool);
 void mpgl_osd_destroy(struct mpgl_osd *ctx);
 
 void mpgl_osd_set_gl_state(struct mpgl_osd *ctx, struct mpgl_osd_part *p);
@@ -23,10 +23,13 @@
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include <assert.h>
 
 #include <libavutil/common.h>
+#include <libavutil/md5.h>
 
 #include "gl_video.h"
 
@@ -35,6 +38,7 @@
 #include "gl_osd.h"
 #include "filter_kernels.h"
 #include "aspect.h"
+#include "options/path.h"
 #include "video/memcpy_pic.h"
 #include "bitmap_packer.h"
 #include "dither.h"
@@ -99,6 +103,15 @@ struct vertex {
 // (GL_QUAD is deprecated, strips can't be used with OSD image lists)
 #define VERTICES_PER_QUAD 6
 
+// Depth of the PBO upload ring. With a single buffer, mapping it again for
+// the next frame stalls until the GPU has finished reading the previous
+// upload; rotating through a few buffers makes the copy fully asynchronous.
+#define NUM_PBO_BUFFERS 3
+
+// Number of past frames for which damage is remembered; buffer ages larger
+// than this force a full repaint.
+#define MAX_DAMAGE_HISTORY 4
+
 struct texplane {
     int w, h;
     int tex_w, tex_h;
@@ -106,8 +119,9 @@ struct texplane {
     GLenum gl_format;
     GLenum gl_type;
     GLuint gl_texture;
-    int gl_buffer;
-    int buffer_size;
+    int gl_buffer[NUM_PBO_BUFFERS];
+    int buffer_size[NUM_PBO_BUFFERS];
+    int buffer_index;
     void *buffer_ptr;
 };
 
@@ -129,6 +143,18 @@ struct scaler {
     struct filter_kernel kernel_storage;
 };
 
+// Cached scaler weight LUTs, so that switching scalers mid-playback (or
+// toggling between two of them for comparison) doesn't recompute the kernel.
+#define MAX_LUT_CACHE 8
+
+struct lut_cache_entry {
+    const char *kernel_name;
+    int size;
+    double inv_scale;
+    float params[2];
+    float *weights;     // LOOKUP_TEXTURE_SIZE * size items
+};
+
 struct fbotex {
     GLuint fbo;
     GLuint texture;
@@ -136,6 +162,26 @@ struct fbotex {
     int vp_x, vp_y, vp_w, vp_h; // viewport of fbo / used part of the texture
 };
 
+// GPU-timed render passes (GL_ARB_timer_query)
+enum {
+    GPU_TIMER_UPLOAD,   // source image upload (texture/PBO transfers)
+    GPU_TIMER_RENDER,   // color conversion and scaling passes
+    GPU_TIMER_OSD,      // OSD and subtitle rendering
+    NUM_GPU_TIMERS,
+};
+
+// Ring of in-flight queries per pass, so reading results never has to wait
+// for the GPU to finish the frame just issued.
+#define NUM_GPU_TIMER_QUERIES 4
+
+struct gpu_timer {
+    GLuint queries[NUM_GPU_TIMER_QUERIES];
+    bool pending[NUM_GPU_TIMER_QUERIES];
+    int index;
+    bool running;
+    double avg_ms;      // moving average of the pass time
+};
+
 struct gl_video {
     GL *gl;
 
@@ -151,10 +197,14 @@ struct gl_video {
     GLuint vao;
 
     GLuint osd_programs[SUBBITMAP_COUNT];
-    GLuint indirect_program, scale_sep_program, final_program;
+    GLuint indirect_program, unsharp_program, scale_sep_program, final_program;
 
     struct mpgl_osd *osd;
 
+    // Recycles texture/FBO allocations across reconfigs and OSD changes
+    // (shared with the OSD renderer).
+    struct gl_tex_pool *tex_pool;
+
     GLuint lut_3d_texture;
     bool use_lut_3d;
 
@@ -185,11 +235,16 @@ struct gl_video {
     bool have_image;
 
     struct fbotex indirect_fbo;         // RGB target
+    struct fbotex unsharp_fbo;          // optional unsharp hook pass
     struct fbotex scale_sep_fbo;        // first pass when doing 2 pass scaling
 
     // state for luma (0) and chroma (1) scalers
     struct scaler scalers[2];
 
+    struct lut_cache_entry lut_cache[MAX_LUT_CACHE];
+    int num_lut_cache;
+    int lut_cache_pos;  // next slot to replace when the cache is full
+
     struct mp_csp_details colorspace;
     struct mp_csp_equalizer video_eq;
     struct mp_image_params image_params;
@@ -201,6 +256,21 @@ struct gl_video {
 
     int frames_rendered;
 
+    bool use_timer_queries;
+    struct gpu_timer gpu_timers[NUM_GPU_TIMERS];
+
+    // Damage tracking for buffer-age based partial redraws. The serial is
+    // bumped whenever the rendered video content can change (new frame,
+    // equalizer, options, ...), so that a back buffer still holding an older
+    // video frame can be recognized as requiring a full repaint.
+    int video_serial;
+    struct mp_rect osd_damage;  // OSD bounding box of the current frame
+    struct frame_damage {
+        int video_serial;
+        struct mp_rect osd;
+    } damage_history[MAX_DAMAGE_HISTORY]; // [0] = most recently swapped frame
+    int num_damage_history;
+
     // Cached because computing it can take relatively long
     int last_dither_matrix_size;
     float *last_dither_matrix;
@@ -308,6 +378,7 @@ const struct m_sub_options gl_video_conf = {
         OPT_FLAG("srgb", srgb, 0),
         OPT_FLAG("npot", npot, 0),
         OPT_FLAG("pbo", pbo, 0),
+        OPT_FLAG("shader-cache", shader_cache, 0),
         OPT_CHOICE("stereo", stereo_mode, 0,
                    ({"no", 0},
                     {"red-cyan",        GL_3D_RED_CYAN},
@@ -319,6 +390,7 @@ const struct m_sub_options gl_video_conf = {
         OPT_FLOAT("lparam2", scaler_params[1], 0),
         OPT_FLAG("scaler-resizes-only", scaler_resizes_only, 0),
         OPT_FLAG("fancy-downscaling", fancy_downscaling, 0),
+        OPT_FLOATRANGE("unsharp", unsharp, 0, -5.0, 5.0),
         OPT_FLAG("indirect", indirect, 0),
         OPT_FLAG("scale-sep", scale_sep, 0),
         OPT_CHOICE("fbo-format", fbo_format, 0,
@@ -358,6 +430,7 @@ const struct m_sub_options gl_video_conf = {
 static void uninit_rendering(struct gl_video *p);
 static void delete_shaders(struct gl_video *p);
 static void check_gl_features(struct gl_video *p);
+static void invalidate_video(struct gl_video *p);
 static bool init_format(int fmt, struct gl_video *init);
 
 
@@ -479,12 +552,11 @@ static bool fbotex_init(struct gl_video *p, struct fbotex *fbo, int w, int h,
     if (!(gl->mpgl_caps & MPGL_CAP_FB))
         return false;
 
-    gl->GenFramebuffers(1, &fbo->fbo);
-    gl->GenTextures(1, &fbo->texture);
+    fbo->fbo = gl_tex_pool_get_fbo(p->tex_pool);
+    fbo->texture = gl_tex_pool_get_tex(p->tex_pool, p->gl_target, iformat,
+                                       GL_RGB, GL_UNSIGNED_BYTE,
+                                       fbo->tex_w, fbo->tex_h);
     gl->BindTexture(p->gl_target, fbo->texture);
-    gl->TexImage2D(p->gl_target, 0, iformat,
-                   fbo->tex_w, fbo->tex_h, 0,
-                   GL_RGB, GL_UNSIGNED_BYTE, NULL);
     default_tex_params(gl, p->gl_target, GL_LINEAR);
     gl->BindFramebuffer(GL_FRAMEBUFFER, fbo->fbo);
     gl->FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
@@ -507,8 +579,8 @@ static void fbotex_uninit(struct gl_video *p, struct fbotex *fbo)
     GL *gl = p->gl;
 
     if (gl->mpgl_caps & MPGL_CAP_FB) {
-        gl->DeleteFramebuffers(1, &fbo->fbo);
-        gl->DeleteTextures(1, &fbo->texture);
+        gl_tex_pool_put_fbo(p->tex_pool, fbo->fbo);
+        gl_tex_pool_put_tex(p->tex_pool, fbo->texture);
         *fbo = (struct fbotex) {0};
     }
 }
@@ -635,6 +707,8 @@ static void update_uniforms(struct gl_video *p, GLuint program)
                   p->dither_center);
 
     float sparam1 = p->opts.scaler_params[0];
+    if (program == p->unsharp_program)
+        sparam1 = p->opts.unsharp;
     gl->Uniform1f(gl->GetUniformLocation(program, "filter_param1"),
                   isnan(sparam1) ? 0.5f : sparam1);
 
@@ -648,6 +722,7 @@ static void update_all_uniforms(struct gl_video *p)
     for (int n = 0; n < SUBBITMAP_COUNT; n++)
         update_uniforms(p, p->osd_programs[n]);
     update_uniforms(p, p->indirect_program);
+    update_uniforms(p, p->unsharp_program);
     update_uniforms(p, p->scale_sep_program);
     update_uniforms(p, p->final_program);
 }
@@ -745,11 +820,160 @@ static void bind_attrib_locs(GL *gl, GLuint program)
 
 #define PRELUDE_END "// -- prelude end\n"
 
+#define SHADER_CACHE_DIR "gl_shader_cache"
+
+static bool shader_cache_usable(struct gl_video *p)
+{
+    GL *gl = p->gl;
+    return p->opts.shader_cache && gl->GetProgramBinary && gl->ProgramBinary;
+}
+
+// The cache key covers the full shader sources (which encode all relevant
+// feature bits) and the GL implementation, so driver updates and option
+// changes never load a stale or incompatible binary.
+static char *shader_cache_filename(struct gl_video *p, void *talloc_ctx,
+                                   const char *header, const char *vertex,
+                                   const char *frag)
+{
+    GL *gl = p->gl;
+    void *tmp = talloc_new(NULL);
+    char *key = talloc_asprintf(tmp, "%s|%s|%s|%s|%s|%s",
+                                (char *)gl->GetString(GL_VENDOR),
+                                (char *)gl->GetString(GL_RENDERER),
+                                (char *)gl->GetString(GL_VERSION),
+                                header, vertex, frag);
+    uint8_t md5[16];
+    av_md5_sum(md5, (uint8_t *)key, strlen(key));
+    char *filename = talloc_strdup(talloc_ctx, SHADER_CACHE_DIR "/");
+    for (int i = 0; i < 16; i++)
+        filename = talloc_asprintf_append(filename, "%02x", md5[i]);
+    filename = talloc_asprintf_append(filename, ".bin");
+    talloc_free(tmp);
+    return filename;
+}
+
+// A cache file is a native endian uint32_t binary format, followed by the
+// program binary as returned by glGetProgramBinary().
+static GLuint load_cached_program(struct gl_video *p, const char *filename)
+{
+    GL *gl = p->gl;
+    GLuint prog = 0;
+    char *path = mp_find_user_config_file(filename);
+    if (!path)
+        return 0;
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        if (size > 4) {
+            char *data = talloc_size(NULL, size);
+            if (fread(data, size, 1, f) == 1) {
+                uint32_t format;
+                memcpy(&format, data, 4);
+                prog = gl->CreateProgram();
+                gl->ProgramBinary(prog, format, data + 4, size - 4);
+                GLint status = 0;
+                gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+                if (!status) {
+                    // Driver update or similar - recompile and re-cache.
+                    gl->DeleteProgram(prog);
+                    prog = 0;
+                }
+            }
+            talloc_free(data);
+        }
+        fclose(f);
+    }
+    talloc_free(path);
+    return prog;
+}
+
+static void save_cached_program(struct gl_video *p, GLuint prog,
+                                const char *filename)
+{
+    GL *gl = p->gl;
+    GLint size = 0;
+    gl->GetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+        return;
+    char *data = talloc_size(NULL, size);
+    GLsizei out_size = 0;
+    GLenum gl_format = 0;
+    gl->GetProgramBinary(prog, size, &out_size, &gl_format, data);
+    if (out_size > 0) {
+        mp_mk_config_dir(SHADER_CACHE_DIR);
+        char *path = mp_find_user_config_file(filename);
+        FILE *f = path ? fopen(path, "wb") : NULL;
+        if (f) {
+            uint32_t format = gl_format;
+            bool ok = fwrite(&format, 4, 1, f) == 1 &&
+                      fwrite(data, out_size, 1, f) == 1;
+            ok = fclose(f) == 0 && ok;
+            if (!ok)
+                unlink(path);
+        }
+        talloc_free(path);
+    }
+    talloc_free(data);
+}
+
+#define DITHER_CACHE_DIR "gl_dither_cache"
+
+// The fruit dither matrix is fully determined by its size, but generating it
+// is expensive (the search is roughly O(n^2 log n) in the number of matrix
+// entries, i.e. seconds at 256x256). Cache the result on disk keyed by size.
+static bool load_cached_dither_matrix(struct gl_video *p, int size, float *m)
+{
+    bool ok = false;
+    void *tmp = talloc_new(NULL);
+    char *filename = talloc_asprintf(tmp, DITHER_CACHE_DIR "/fruit_%d.bin",
+                                     size);
+    char *path = talloc_steal(tmp, mp_find_user_config_file(filename));
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (f) {
+        ok = fread(m, sizeof(float) * size * size, 1, f) == 1 &&
+             getc(f) == EOF;
+        fclose(f);
+    }
+    talloc_free(tmp);
+    return ok;
+}
+
+static void save_cached_dither_matrix(struct gl_video *p, int size, float *m)
+{
+    void *tmp = talloc_new(NULL);
+    char *filename = talloc_asprintf(tmp, DITHER_CACHE_DIR "/fruit_%d.bin",
+                                     size);
+    mp_mk_config_dir(DITHER_CACHE_DIR);
+    char *path = talloc_steal(tmp, mp_find_user_config_file(filename));
+    FILE *f = path ? fopen(path, "wb") : NULL;
+    if (f) {
+        bool ok = fwrite(m, sizeof(float) * size * size, 1, f) == 1;
+        ok = fclose(f) == 0 && ok;
+        if (!ok)
+            unlink(path);
+    }
+    talloc_free(tmp);
+}
+
 static GLuint create_program(struct gl_video *p, const char *name,
                              const char *header, const char *vertex,
                              const char *frag)
 {
     GL *gl = p->gl;
+    void *tmp = talloc_new(NULL);
+    char *cache_file = NULL;
+    if (shader_cache_usable(p)) {
+        cache_file = shader_cache_filename(p, tmp, header, vertex, frag);
+        GLuint cached = load_cached_program(p, cache_file);
+        if (cached) {
+            MP_VERBOSE(p, "loaded cached binary for shader program '%s'\n",
+                       name);
+            talloc_free(tmp);
+            return cached;
+        }
+    }
     MP_VERBOSE(p, "compiling shader program '%s', header:\n", name);
     const char *real_header = strstr(header, PRELUDE_END);
     real_header = real_header ? real_header + strlen(PRELUDE_END) : header;
@@ -758,7 +982,12 @@ static GLuint create_program(struct gl_video *p, const char *name,
     prog_create_shader(p, prog, GL_VERTEX_SHADER, header, vertex);
     prog_create_shader(p, prog, GL_FRAGMENT_SHADER, header, frag);
     bind_attrib_locs(gl, prog);
+    if (cache_file && gl->ProgramParameteri)
+        gl->ProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
     link_shader(p, prog);
+    if (cache_file)
+        save_cached_program(p, prog, cache_file);
+    talloc_free(tmp);
     return prog;
 }
 
@@ -928,6 +1157,11 @@ static void compile_shaders(struct gl_video *p)
     if (header_sep && p->plane_count > 1)
         use_indirect = true;
 
+    // The unsharp hook pass samples a neighborhood of the current pixel, which
+    // requires a single already-converted RGB texture as input.
+    if (p->opts.unsharp != 0)
+        use_indirect = true;
+
     if (input_is_subsampled(p)) {
         shader_setup_scaler(&header_conv, &p->scalers[1], -1);
     } else {
@@ -951,6 +1185,15 @@ static void compile_shaders(struct gl_video *p)
         header_final = t_concat(tmp, header_final, header_conv);
     }
 
+    if (p->opts.unsharp != 0) {
+        char *header_unsharp = talloc_strdup(tmp, "");
+        shader_def_opt(&header_unsharp, "FIXED_SCALE", true);
+        shader_def(&header_unsharp, "SAMPLE_L", "sample_sharpen5");
+        header_unsharp = t_concat(tmp, header, header_unsharp);
+        p->unsharp_program =
+            create_program(p, "unsharp", header_unsharp, vertex_shader, s_video);
+    }
+
     if (header_sep) {
         header_sep = t_concat(tmp, header, header_sep);
         p->scale_sep_program =
@@ -979,6 +1222,7 @@ static void delete_shaders(struct gl_video *p)
     for (int n = 0; n < SUBBITMAP_COUNT; n++)
         delete_program(gl, &p->osd_programs[n]);
     delete_program(gl, &p->indirect_program);
+    delete_program(gl, &p->unsharp_program);
     delete_program(gl, &p->scale_sep_program);
     delete_program(gl, &p->final_program);
 }
@@ -1002,6 +1246,40 @@ static bool update_scale_factor(struct gl_video *p, struct filter_kernel *kernel
     return mp_init_filter(kernel, filter_sizes, FFMAX(1.0, 1.0 / scale));
 }
 
+// Return the weight LUT for the given (initialized) kernel, computing it only
+// if no cached scaler configuration matches. The returned array stays valid
+// until the entry is evicted; the caller must not free it.
+static const float *get_scaler_lut(struct gl_video *p,
+                                   struct filter_kernel *kernel)
+{
+    for (int n = 0; n < p->num_lut_cache; n++) {
+        struct lut_cache_entry *e = &p->lut_cache[n];
+        if (strcmp(e->kernel_name, kernel->name) == 0 &&
+            e->size == kernel->size &&
+            e->inv_scale == kernel->inv_scale &&
+            e->params[0] == kernel->params[0] &&
+            e->params[1] == kernel->params[1])
+            return e->weights;
+    }
+
+    struct lut_cache_entry *e;
+    if (p->num_lut_cache < MAX_LUT_CACHE) {
+        e = &p->lut_cache[p->num_lut_cache++];
+    } else {
+        e = &p->lut_cache[p->lut_cache_pos];
+        p->lut_cache_pos = (p->lut_cache_pos + 1) % MAX_LUT_CACHE;
+        talloc_free(e->weights);
+    }
+    e->kernel_name = kernel->name; // static string from mp_filter_kernels[]
+    e->size = kernel->size;
+    e->inv_scale = kernel->inv_scale;
+    e->params[0] = kernel->params[0];
+    e->params[1] = kernel->params[1];
+    e->weights = talloc_array(p, float, LOOKUP_TEXTURE_SIZE * kernel->size);
+    mp_compute_lut(kernel, LOOKUP_TEXTURE_SIZE, e->weights);
+    return e->weights;
+}
+
 static void init_scaler(struct gl_video *p, struct scaler *scaler)
 {
     GL *gl = p->gl;
@@ -1043,8 +1321,7 @@ static void init_scaler(struct gl_video *p, struct scaler *scaler)
     gl->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
     gl->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
-    float *weights = talloc_array(NULL, float, LOOKUP_TEXTURE_SIZE * size);
-    mp_compute_lut(scaler->kernel, LOOKUP_TEXTURE_SIZE, weights);
+    const float *weights = get_scaler_lut(p, scaler->kernel);
     if (use_2d) {
         gl->TexImage2D(GL_TEXTURE_2D, 0, fmt->internal_format, fmt->pixels,
                        LOOKUP_TEXTURE_SIZE, 0, fmt->format, GL_FLOAT,
@@ -1054,7 +1331,6 @@ static void init_scaler(struct gl_video *p, struct scaler *scaler)
                        LOOKUP_TEXTURE_SIZE, 0, fmt->format, GL_FLOAT,
                        weights);
     }
-    talloc_free(weights);
 
     gl->TexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     gl->TexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -1093,7 +1369,14 @@ static void init_dither(struct gl_video *p)
         if (p->last_dither_matrix_size != size) {
             p->last_dither_matrix = talloc_realloc(p, p->last_dither_matrix,
                                                    float, size * size);
-            mp_make_fruit_dither_matrix(p->last_dither_matrix, sizeb);
+            bool cached = p->opts.shader_cache &&
+                load_cached_dither_matrix(p, size, p->last_dither_matrix);
+            if (!cached) {
+                mp_make_fruit_dither_matrix(p->last_dither_matrix, sizeb);
+                if (p->opts.shader_cache)
+                    save_cached_dither_matrix(p, size,
+                                              p->last_dither_matrix);
+            }
             p->last_dither_matrix_size = size;
         }
 
@@ -1137,7 +1420,7 @@ static void recreate_osd(struct gl_video *p)
 {
     if (p->osd)
         mpgl_osd_destroy(p->osd);
-    p->osd = mpgl_osd_init(p->gl, p->log, false);
+    p->osd = mpgl_osd_init(p->gl, p->log, false, p->tex_pool);
     p->osd->use_pbo = p->opts.pbo;
 }
 
@@ -1183,6 +1466,10 @@ static void reinit_rendering(struct gl_video *p)
         fbotex_init(p, &p->indirect_fbo, p->image_w, p->image_h,
                     p->opts.fbo_format);
 
+    if (p->unsharp_program && !p->unsharp_fbo.fbo)
+        fbotex_init(p, &p->unsharp_fbo, p->image_w, p->image_h,
+                    p->opts.fbo_format);
+
     recreate_osd(p);
 }
 
@@ -1227,6 +1514,7 @@ void gl_video_set_lut3d(struct gl_video *p, struct lut3d *lut3d)
     gl->ActiveTexture(GL_TEXTURE0);
 
     p->use_lut_3d = true;
+    invalidate_video(p);
     check_gl_features(p);
 
     debug_check_gl(p, "after 3d lut creation");
@@ -1329,14 +1617,14 @@ static void init_video(struct gl_video *p, const struct mp_image_params *params)
             texture_size(p, plane->w, plane->h,
                             &plane->tex_w, &plane->tex_h);
 
+            plane->gl_texture =
+                gl_tex_pool_get_tex(p->tex_pool, p->gl_target,
+                                    plane->gl_internal_format,
+                                    plane->gl_format, plane->gl_type,
+                                    plane->tex_w, plane->tex_h);
+
             gl->ActiveTexture(GL_TEXTURE0 + n);
-            gl->GenTextures(1, &plane->gl_texture);
             gl->BindTexture(p->gl_target, plane->gl_texture);
-
-            gl->TexImage2D(p->gl_target, 0, plane->gl_internal_format,
-                           plane->tex_w, plane->tex_h, 0,
-                           plane->gl_format, plane->gl_type, NULL);
-
             default_tex_params(gl, p->gl_target, GL_LINEAR);
         }
 
@@ -1369,16 +1657,20 @@ static void uninit_video(struct gl_video *p)
     for (int n = 0; n < 3; n++) {
         struct texplane *plane = &vimg->planes[n];
 
-        gl->DeleteTextures(1, &plane->gl_texture);
+        gl_tex_pool_put_tex(p->tex_pool, plane->gl_texture);
         plane->gl_texture = 0;
-        gl->DeleteBuffers(1, &plane->gl_buffer);
-        plane->gl_buffer = 0;
+        gl->DeleteBuffers(NUM_PBO_BUFFERS, &plane->gl_buffer[0]);
+        for (int i = 0; i < NUM_PBO_BUFFERS; i++) {
+            plane->gl_buffer[i] = 0;
+            plane->buffer_size[i] = 0;
+        }
+        plane->buffer_index = 0;
         plane->buffer_ptr = NULL;
-        plane->buffer_size = 0;
     }
     mp_image_unrefp(&vimg->hwimage);
 
     fbotex_uninit(p, &p->indirect_fbo);
+    fbotex_uninit(p, &p->unsharp_fbo);
     fbotex_uninit(p, &p->scale_sep_fbo);
 }
 
@@ -1438,6 +1730,67 @@ static void handle_pass(struct gl_video *p, struct fbotex *chain,
     *chain = *fbo;
 }
 
+// Mark the rendered video content as changed for damage tracking; a back
+// buffer from before this call then can't be patched up with a partial redraw.
+static void invalidate_video(struct gl_video *p)
+{
+    p->video_serial++;
+}
+
+// Union of two possibly empty (x1 <= x0 or y1 <= y0) rectangles.
+static void damage_union(struct mp_rect *rc, const struct mp_rect *rc2)
+{
+    if (rc2->x1 <= rc2->x0 || rc2->y1 <= rc2->y0)
+        return;
+    if (rc->x1 <= rc->x0 || rc->y1 <= rc->y0) {
+        *rc = *rc2;
+    } else {
+        mp_rect_union(rc, rc2);
+    }
+}
+
+// Begin GPU timing of a render pass. If the oldest query of the ring is still
+// in flight, timing is skipped for this frame rather than stalling on the
+// result.
+static void gpu_timer_start(struct gl_video *p, int timer)
+{
+    GL *gl = p->gl;
+    struct gpu_timer *t = &p->gpu_timers[timer];
+
+    if (!p->use_timer_queries)
+        return;
+
+    if (t->pending[t->index]) {
+        GLuint available = 0;
+        gl->GetQueryObjectuiv(t->queries[t->index], GL_QUERY_RESULT_AVAILABLE,
+                              &available);
+        if (!available)
+            return;
+        GLuint ns = 0;
+        gl->GetQueryObjectuiv(t->queries[t->index], GL_QUERY_RESULT, &ns);
+        t->pending[t->index] = false;
+        // Average over recent frames to smooth out single-frame spikes.
+        t->avg_ms = t->avg_ms * 0.9 + (ns / 1e6) * 0.1;
+    }
+
+    gl->BeginQuery(GL_TIME_ELAPSED, t->queries[t->index]);
+    t->running = true;
+}
+
+static void gpu_timer_stop(struct gl_video *p, int timer)
+{
+    GL *gl = p->gl;
+    struct gpu_timer *t = &p->gpu_timers[timer];
+
+    if (!t->running)
+        return;
+
+    gl->EndQuery(GL_TIME_ELAPSED);
+    t->pending[t->index] = true;
+    t->index = (t->index + 1) % NUM_GPU_TIMER_QUERIES;
+    t->running = false;
+}
+
 void gl_video_render_frame(struct gl_video *p)
 {
     GL *gl = p->gl;
@@ -1460,8 +1813,10 @@ void gl_video_render_frame(struct gl_video *p)
         return;
     }
 
+    gpu_timer_start(p, GPU_TIMER_RENDER);
+
     // Order of processing:
-    //  [indirect -> [scale_sep ->]] final
+    //  [indirect -> [unsharp ->] [scale_sep ->]] final
 
     GLuint imgtex[4] = {0};
     set_image_textures(p, vimg, imgtex);
@@ -1475,6 +1830,7 @@ void gl_video_render_frame(struct gl_video *p)
     };
 
     handle_pass(p, &chain, &p->indirect_fbo, p->indirect_program);
+    handle_pass(p, &chain, &p->unsharp_fbo, p->unsharp_program);
 
     // Clip to visible height so that separate scaling scales the visible part
     // only (and the target FBO texture can have a bounded size).
@@ -1534,6 +1890,8 @@ void gl_video_render_frame(struct gl_video *p)
 
     unset_image_textures(p);
 
+    gpu_timer_stop(p, GPU_TIMER_RENDER);
+
     p->frames_rendered++;
 
     debug_check_gl(p, "after video rendering");
@@ -1603,6 +1961,9 @@ void gl_video_resize(struct gl_video *p, struct mp_rect *window,
     p->vp_w = window->x1 - window->x0;
     p->vp_h = window->y1 - window->y0;
 
+    // All recorded damage is in outdated window coordinates.
+    p->num_damage_history = 0;
+
     p->gl->Viewport(p->vp_x, p->vp_y, p->vp_w, p->vp_h);
 
     check_resize(p);
@@ -1625,12 +1986,13 @@ static bool get_image(struct gl_video *p, struct mp_image *mpi)
         struct texplane *plane = &vimg->planes[n];
         mpi->stride[n] = mpi->plane_w[n] * p->image_desc.bytes[n];
         int needed_size = mpi->plane_h[n] * mpi->stride[n];
-        if (!plane->gl_buffer)
-            gl->GenBuffers(1, &plane->gl_buffer);
-        gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, plane->gl_buffer);
-        if (needed_size > plane->buffer_size) {
-            plane->buffer_size = needed_size;
-            gl->BufferData(GL_PIXEL_UNPACK_BUFFER, plane->buffer_size,
+        int i = plane->buffer_index;
+        if (!plane->gl_buffer[i])
+            gl->GenBuffers(1, &plane->gl_buffer[i]);
+        gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, plane->gl_buffer[i]);
+        if (needed_size > plane->buffer_size[i]) {
+            plane->buffer_size[i] = needed_size;
+            gl->BufferData(GL_PIXEL_UNPACK_BUFFER, plane->buffer_size[i],
                            NULL, GL_DYNAMIC_DRAW);
         }
         if (!plane->buffer_ptr)
@@ -1646,6 +2008,8 @@ void gl_video_upload_image(struct gl_video *p, struct mp_image *mpi)
 {
     GL *gl = p->gl;
 
+    invalidate_video(p);
+
     struct video_image *vimg = &p->image;
 
     if (p->hwdec_active) {
@@ -1656,6 +2020,8 @@ void gl_video_upload_image(struct gl_video *p, struct mp_image *mpi)
 
     assert(mpi->num_planes == p->plane_count);
 
+    gpu_timer_start(p, GPU_TIMER_UPLOAD);
+
     mp_image_t mpi2 = *mpi;
     bool pbo = false;
     if (!vimg->planes[0].buffer_ptr && get_image(p, &mpi2)) {
@@ -1672,11 +2038,15 @@ void gl_video_upload_image(struct gl_video *p, struct mp_image *mpi)
         struct texplane *plane = &vimg->planes[n];
         void *plane_ptr = mpi->planes[n];
         if (pbo) {
-            gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, plane->gl_buffer);
+            gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER,
+                           plane->gl_buffer[plane->buffer_index]);
             if (!gl->UnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
                 MP_FATAL(p, "Video PBO upload failed. "
                          "Remove the 'pbo' suboption.\n");
             plane->buffer_ptr = NULL;
+            // Read from this buffer asynchronously; map the next one for
+            // the following frame so the copy doesn't wait for the GPU.
+            plane->buffer_index = (plane->buffer_index + 1) % NUM_PBO_BUFFERS;
             plane_ptr = NULL; // PBO offset 0
         }
         gl->ActiveTexture(GL_TEXTURE0 + n);
@@ -1687,6 +2057,8 @@ void gl_video_upload_image(struct gl_video *p, struct mp_image *mpi)
     gl->ActiveTexture(GL_TEXTURE0);
     gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
+    gpu_timer_stop(p, GPU_TIMER_UPLOAD);
+
     p->have_image = true;
 }
 
@@ -1728,11 +2100,12 @@ struct mp_image *gl_video_download_image(struct gl_video *p)
     return image;
 }
 
-static void draw_osd_cb(void *ctx, struct mpgl_osd_part *osd,
-                        struct sub_bitmaps *imgs)
+// Generate the vertices (and the bounding box) of an OSD part if needed, and
+// account its screen area to the current frame's OSD damage.
+static void gen_osd_cb(void *ctx, struct mpgl_osd_part *osd,
+                       struct sub_bitmaps *imgs)
 {
     struct gl_video *p = ctx;
-    GL *gl = p->gl;
 
     assert(osd->format != SUBBITMAP_EMPTY);
 
@@ -1741,6 +2114,7 @@ static void draw_osd_cb(void *ctx, struct mpgl_osd_part *osd,
                                        osd->packer->count * VERTICES_PER_QUAD);
 
         struct vertex *va = osd->vertices;
+        osd->bb = (struct mp_rect){0, 0, 0, 0};
 
         for (int n = 0; n < osd->packer->count; n++) {
             struct sub_bitmap *b = &imgs->parts[n];
@@ -1757,9 +2131,23 @@ static void draw_osd_cb(void *ctx, struct mpgl_osd_part *osd,
                     pos.x, pos.y, pos.x + b->w, pos.y + b->h,
                     osd->w, osd->h, color, GL_TEXTURE_2D, false);
             osd->num_vertices += VERTICES_PER_QUAD;
+
+            struct mp_rect rc = {b->x, b->y, b->x + b->dw, b->y + b->dh};
+            damage_union(&osd->bb, &rc);
         }
     }
 
+    damage_union(&p->osd_damage, &osd->bb);
+}
+
+static void draw_osd_cb(void *ctx, struct mpgl_osd_part *osd,
+                        struct sub_bitmaps *imgs)
+{
+    struct gl_video *p = ctx;
+    GL *gl = p->gl;
+
+    gen_osd_cb(ctx, osd, imgs);
+
     debug_check_gl(p, "before drawing osd");
 
     gl->UseProgram(p->osd_programs[osd->format]);
@@ -1776,14 +2164,76 @@ void gl_video_draw_osd(struct gl_video *p, struct osd_state *osd)
     GL *gl = p->gl;
     assert(p->osd);
 
+    gpu_timer_start(p, GPU_TIMER_OSD);
+
+    p->osd_damage = (struct mp_rect){0, 0, 0, 0};
     mpgl_osd_draw_cb(p->osd, osd, p->osd_rect, draw_osd_cb, p);
 
+    gpu_timer_stop(p, GPU_TIMER_OSD);
+
     // The playloop calls this last before waiting some time until it decides
     // to call flip_page(). Tell OpenGL to start execution of the GPU commands
     // while we sleep (this happens asynchronously).
     gl->Flush();
 }
 
+// Repaint only the parts of the back buffer that differ from the current
+// frame, under the assumption that the buffer contains the frame from
+// buffer_age swaps ago (EGL_EXT_buffer_age semantics; age 0 = unknown).
+// The damaged region is the OSD of that old frame plus the current OSD.
+// Returns false if a partial redraw isn't possible; the caller must then do a
+// full gl_video_render_frame() + gl_video_draw_osd() pass.
+bool gl_video_redraw_partial(struct gl_video *p, struct osd_state *osd,
+                             int buffer_age)
+{
+    GL *gl = p->gl;
+    int n = buffer_age - 1;
+
+    if (n < 0 || n >= p->num_damage_history || !p->have_image)
+        return false;
+    if (p->damage_history[n].video_serial != p->video_serial)
+        return false;
+    // Temporal dithering modifies the whole frame on every redraw.
+    if (p->opts.temporal_dither)
+        return false;
+
+    // Generate (and upload) the new OSD first, so that its screen area is
+    // known before any drawing happens.
+    p->osd_damage = (struct mp_rect){0, 0, 0, 0};
+    mpgl_osd_draw_cb(p->osd, osd, p->osd_rect, gen_osd_cb, p);
+
+    struct mp_rect rc = p->osd_damage;
+    damage_union(&rc, &p->damage_history[n].osd);
+    struct mp_rect vp = {p->vp_x, p->vp_y, p->vp_x + p->vp_w,
+                         p->vp_y + p->vp_h};
+    if (mp_rect_intersection(&rc, &vp)) {
+        // GL window coordinates are bottom-up.
+        gl->Enable(GL_SCISSOR_TEST);
+        gl->Scissor(rc.x0, p->vp_y + p->vp_h - rc.y1,
+                    rc.x1 - rc.x0, rc.y1 - rc.y0);
+        gl_video_render_frame(p);
+        mpgl_osd_redraw_cb(p->osd, draw_osd_cb, p);
+        gl->Disable(GL_SCISSOR_TEST);
+    }
+
+    gl->Flush();
+    return true;
+}
+
+// Must be called on every buffer swap; records what the swapped-out frame
+// looked like for later partial redraws.
+void gl_video_swapped(struct gl_video *p)
+{
+    memmove(&p->damage_history[1], &p->damage_history[0],
+            sizeof(p->damage_history[0]) * (MAX_DAMAGE_HISTORY - 1));
+    p->damage_history[0] = (struct frame_damage) {
+        .video_serial = p->video_serial,
+        .osd = p->osd_damage,
+    };
+    if (p->num_damage_history < MAX_DAMAGE_HISTORY)
+        p->num_damage_history++;
+}
+
 static bool test_fbo(struct gl_video *p, GLenum format)
 {
     static const float vals[] = {
@@ -1948,6 +2398,12 @@ static int init_gl(struct gl_video *p)
 
     gl->ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+    p->use_timer_queries = !!(gl->mpgl_caps & MPGL_CAP_TIMER_QUERY);
+    if (p->use_timer_queries) {
+        for (int n = 0; n < NUM_GPU_TIMERS; n++)
+            gl->GenQueries(NUM_GPU_TIMER_QUERIES, p->gpu_timers[n].queries);
+    }
+
     debug_check_gl(p, "after init_gl");
 
     return 1;
@@ -1964,8 +2420,16 @@ void gl_video_uninit(struct gl_video *p)
     gl->DeleteBuffers(1, &p->vertex_buffer);
     gl->DeleteTextures(1, &p->lut_3d_texture);
 
+    if (p->use_timer_queries) {
+        for (int n = 0; n < NUM_GPU_TIMERS; n++)
+            gl->DeleteQueries(NUM_GPU_TIMER_QUERIES, p->gpu_timers[n].queries);
+    }
+
     mpgl_osd_destroy(p->osd);
 
+    // Last user is gone; this deletes all recycled textures and FBOs.
+    gl_tex_pool_free(p->tex_pool);
+
     talloc_free(p);
 }
 
@@ -2118,14 +2582,80 @@ bool gl_video_check_format(struct gl_video *p, int mp_format)
     return init_format(mp_format, &tmp);
 }
 
+// Try to apply a pure size change without recreating any GL objects, by
+// reusing the (possibly larger) textures already allocated and rendering
+// only the used sub-rectangle. Returns false if a full reinit is required.
+// Since textures are never shrunk, a stream that switches between a few
+// resolutions (bitrate-adaptive sources) pays the reinit cost only the
+// first time it reaches each new maximum.
+static bool resize_video_in_place(struct gl_video *p,
+                                  const struct mp_image_params *params)
+{
+    if (p->hwdec_active || !p->image_format)
+        return false;
+
+    struct mp_image_params tmp = p->image_params;
+    tmp.w = params->w;
+    tmp.h = params->h;
+    tmp.d_w = params->d_w;
+    tmp.d_h = params->d_h;
+    if (!mp_image_params_equals(&tmp, params))
+        return false;           // more than the size changed
+
+    int full_w = MP_ALIGN_UP(params->w, 1 << p->image_desc.chroma_xs);
+    int full_h = MP_ALIGN_UP(params->h, 1 << p->image_desc.chroma_ys);
+
+    for (int n = 0; n < p->plane_count; n++) {
+        struct texplane *plane = &p->image.planes[n];
+        if (full_w >> p->image_desc.xs[n] > plane->tex_w ||
+            full_h >> p->image_desc.ys[n] > plane->tex_h)
+            return false;       // doesn't fit the allocated textures
+    }
+    if ((p->indirect_fbo.fbo && (params->w > p->indirect_fbo.tex_w ||
+                                 params->h > p->indirect_fbo.tex_h)) ||
+        (p->unsharp_fbo.fbo && (params->w > p->unsharp_fbo.tex_w ||
+                                params->h > p->unsharp_fbo.tex_h)))
+        return false;
+
+    MP_VERBOSE(p, "Resizing video in place: %dx%d -> %dx%d\n",
+               p->image_w, p->image_h, params->w, params->h);
+
+    p->image_w = params->w;
+    p->image_h = params->h;
+    p->image_dw = params->d_w;
+    p->image_dh = params->d_h;
+    p->image_params = *params;
+
+    for (int n = 0; n < p->plane_count; n++) {
+        struct texplane *plane = &p->image.planes[n];
+        plane->w = full_w >> p->image_desc.xs[n];
+        plane->h = full_h >> p->image_desc.ys[n];
+    }
+    if (p->indirect_fbo.fbo) {
+        p->indirect_fbo.vp_w = params->w;
+        p->indirect_fbo.vp_h = params->h;
+    }
+    if (p->unsharp_fbo.fbo) {
+        p->unsharp_fbo.vp_w = params->w;
+        p->unsharp_fbo.vp_h = params->h;
+    }
+
+    // Scale factors and texture coordinates changed with the image size.
+    check_resize(p);
+    return true;
+}
+
 void gl_video_config(struct gl_video *p, struct mp_image_params *params)
 {
+    invalidate_video(p);
     p->have_image = false;
     mp_image_unrefp(&p->image.hwimage);
 
     if (!mp_image_params_equals(&p->image_params, params)) {
-        uninit_video(p);
-        init_video(p, params);
+        if (!resize_video_in_place(p, params)) {
+            uninit_video(p);
+            init_video(p, params);
+        }
     }
 }
 
@@ -2133,6 +2663,7 @@ void gl_video_set_output_depth(struct gl_video *p, int r, int g, int b)
 {
     MP_VERBOSE(p, "Display depth: R=%d, G=%d, B=%d\n", r, g, b);
     p->depth_g = g;
+    invalidate_video(p);
 }
 
 struct gl_video *gl_video_init(GL *gl, struct mp_log *log)
@@ -2150,6 +2681,7 @@ struct gl_video *gl_video_init(GL *gl, struct mp_log *log)
         },
         .scratch = talloc_zero_array(p, char *, 1),
     };
+    p->tex_pool = gl_tex_pool_create(gl);
     init_gl(p);
     recreate_osd(p);
     return p;
@@ -2192,6 +2724,7 @@ void gl_video_set_options(struct gl_video *p, struct gl_video_opts *opts)
 
     check_gl_features(p);
     reinit_rendering(p);
+    invalidate_video(p);
 }
 
 bool gl_video_get_csp_override(struct gl_video *p, struct mp_csp_details *csp)
@@ -2209,6 +2742,7 @@ bool gl_video_set_equalizer(struct gl_video *p, const char *name, int val)
             compile_shaders(p);
         }
         update_all_uniforms(p);
+        invalidate_video(p);
         return true;
     }
     return false;
@@ -2219,6 +2753,18 @@ bool gl_video_get_equalizer(struct gl_video *p, const char *name, int *val)
     return mp_csp_equalizer_get(&p->video_eq, name, val) >= 0;
 }
 
+// Average GPU time in ms spent on recent render passes; times[0] = upload,
+// times[1] = render, times[2] = OSD. Returns false if GL_ARB_timer_query
+// is unavailable.
+bool gl_video_get_gpu_times(struct gl_video *p, double times[3])
+{
+    if (!p->use_timer_queries)
+        return false;
+    for (int n = 0; n < NUM_GPU_TIMERS; n++)
+        times[n] = p->gpu_timers[n].avg_ms;
+    return true;
+}
+
 static int validate_scaler_opt(const m_option_t *opt, struct bstr name,
                                struct bstr param)
 {
@@ -2251,5 +2797,6 @@ void gl_video_resize_redraw(struct gl_video *p, int w, int h)
 void gl_video_set_hwdec(struct gl_video *p, struct gl_hwdec *hwdec)
 {
     p->hwdec = hwdec;
+    invalidate_video(p);
     mp_image_unrefp(&p->image.hwimage);
 }
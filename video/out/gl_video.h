@@ -36,8 +36,10 @@ struct gl_video_opts {
     int scale_sep;
     int fancy_downscaling;
     int scaler_resizes_only;
+    float unsharp;
     int npot;
     int pbo;
+    int shader_cache;
     int dither_depth;
     int dither_algo;
     int dither_size;
@@ -64,6 +66,9 @@ void gl_video_set_lut3d(struct gl_video *p, struct lut3d *lut3d);
 void gl_video_draw_osd(struct gl_video *p, struct osd_state *osd);
 void gl_video_upload_image(struct gl_video *p, struct mp_image *img);
 void gl_video_render_frame(struct gl_video *p);
+bool gl_video_redraw_partial(struct gl_video *p, struct osd_state *osd,
+                             int buffer_age);
+void gl_video_swapped(struct gl_video *p);
 struct mp_image *gl_video_download_image(struct gl_video *p);
 void gl_video_resize(struct gl_video *p, struct mp_rect *window,
                      struct mp_rect *src, struct mp_rect *dst,
@@ -71,6 +76,7 @@ void gl_video_resize(struct gl_video *p, struct mp_rect *window,
 bool gl_video_get_csp_override(struct gl_video *p, struct mp_csp_details *csp);
 bool gl_video_set_equalizer(struct gl_video *p, const char *name, int val);
 bool gl_video_get_equalizer(struct gl_video *p, const char *name, int *val);
+bool gl_video_get_gpu_times(struct gl_video *p, double times[3]);
 
 void gl_video_set_debug(struct gl_video *p, bool enable);
 void gl_video_resize_redraw(struct gl_video *p, int w, int h);
@@ -16,6 +16,8 @@
  * with mpv.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include <wayland-egl.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -23,11 +25,17 @@
 #include "wayland_common.h"
 #include "gl_common.h"
 
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
 struct egl_context {
     EGLSurface egl_surface;
 
     struct wl_egl_window *egl_window;
 
+    bool have_buffer_age;   // EGL_EXT_buffer_age supported
+
     struct {
         EGLDisplay dpy;
         EGLContext ctx;
@@ -139,6 +147,8 @@ static bool egl_create_context(struct vo_wayland_state *wl,
 
     eglstr = eglQueryString(egl_ctx->egl.dpy, EGL_EXTENSIONS);
 
+    egl_ctx->have_buffer_age = !!strstr(eglstr, "EGL_EXT_buffer_age");
+
     mpgl_load_functions(gl, (void*(*)(const GLubyte*))eglGetProcAddress, eglstr,
                         wl->log);
     if (!gl->BindProgram)
@@ -230,12 +240,27 @@ static void swapGlBuffers_wayland(MPGLContext *ctx)
         egl_resize(wl, egl_ctx);
 }
 
+static int getBufferAge_wayland(MPGLContext *ctx)
+{
+    struct egl_context * egl_ctx = ctx->priv;
+
+    if (!egl_ctx->have_buffer_age || !egl_ctx->egl_surface)
+        return 0;
+
+    EGLint age = 0;
+    if (eglQuerySurface(egl_ctx->egl.dpy, egl_ctx->egl_surface,
+                        EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        return 0;
+    return age;
+}
+
 void mpgl_set_backend_wayland(MPGLContext *ctx)
 {
     ctx->priv = talloc_zero(ctx, struct egl_context);
     ctx->config_window = config_window_wayland;
     ctx->releaseGlContext = releaseGlContext_wayland;
     ctx->swapGlBuffers = swapGlBuffers_wayland;
+    ctx->getBufferAge = getBufferAge_wayland;
     ctx->vo_control = vo_wayland_control;
     ctx->vo_init = vo_wayland_init;
     ctx->vo_uninit = vo_wayland_uninit;
@@ -25,6 +25,8 @@
 #include <stdbool.h>
 
 #include <unistd.h>
+#include <pthread.h>
+#include <math.h>
 
 #include <libavutil/common.h>
 
@@ -32,12 +34,14 @@
 
 #include "config.h"
 #include "osdep/timer.h"
+#include "osdep/threads.h"
 #include "options/options.h"
 #include "bstr/bstr.h"
 #include "vo.h"
 #include "aspect.h"
 #include "input/input.h"
 #include "options/m_config.h"
+#include "options/path.h"
 #include "common/msg.h"
 #include "common/global.h"
 #include "video/mp_image.h"
@@ -142,6 +146,228 @@ const struct m_obj_list vo_obj_list = {
     .allow_trailer = true,
 };
 
+/* The VO thread owns all vo_driver calls. This keeps window system and GL
+ * contexts on a single thread (most of them are not thread-safe, or bind
+ * state to the creating thread), while still letting the playloop overlap
+ * decoding with a blocking page flip.
+ *
+ * Calls are marshalled synchronously: the playloop blocks until the driver
+ * callback has run on the VO thread. The one exception is the page flip for
+ * drivers with flip_page_timed, which is queued asynchronously - these
+ * drivers block until presentation time, and waiting for that on the
+ * playloop thread would stall decoding. Any following driver call waits for
+ * a still pending flip first, so the driver never sees concurrent calls.
+ */
+struct vo_thread {
+    pthread_t thread;
+    bool active;
+    bool terminate;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;      // to VO thread: new call or flip queued
+    pthread_cond_t done;        // to callers: call or flip finished
+    // Pending synchronous driver call (NULL if none).
+    void (*fn)(struct vo *vo, void *arg);
+    void *fn_arg;
+    // Pending asynchronous page flip.
+    bool flip_pending;
+    int64_t flip_pts_us;
+    int flip_duration;
+    // Pending asynchronous frame draw (owned reference, NULL if none).
+    struct mp_image *draw_mpi;
+};
+
+/* Estimate the display refresh interval and phase from the completion times
+ * of page flips. With vsync enabled, the flip call returns (or unblocks)
+ * shortly after a vblank, so the completion times are noisy samples of the
+ * vblank clock, always a whole number of refresh intervals apart. The
+ * interval is refined with an exponential moving average; since on e.g.
+ * 24 fps content over 60 Hz no two flips are a single refresh apart, the
+ * initial estimate is found with Euclid's algorithm on the residuals.
+ */
+
+#define VSYNC_MIN_INTERVAL 4000     // us; below this (250 Hz) assume noise
+#define VSYNC_MAX_INTERVAL 200000   // us; flips further apart don't update
+#define VSYNC_LOCK_SAMPLES 50       // consecutive fits before it's trusted
+
+struct vo_vsync_est {
+    pthread_mutex_t lock;
+    int64_t last_flip_us;   // completion time of the most recent flip
+    double interval_us;     // current refresh interval estimate
+    int num_samples;        // consecutive samples matching the estimate
+};
+
+static void vsync_est_feed(struct vo *vo)
+{
+    struct vo_vsync_est *est = vo->vsync;
+    int64_t now = mp_time_us();
+    pthread_mutex_lock(&est->lock);
+    double d = now - est->last_flip_us;
+    if (est->last_flip_us > 0 &&
+        d >= VSYNC_MIN_INTERVAL && d <= VSYNC_MAX_INTERVAL)
+    {
+        if (est->interval_us >= VSYNC_MIN_INTERVAL) {
+            double n = floor(d / est->interval_us + 0.5);
+            double err = d - n * est->interval_us;
+            if (n >= 1 && fabs(err) < est->interval_us / 4) {
+                // A whole number of estimated intervals - refine.
+                est->interval_us += (d / n - est->interval_us) / 16;
+                if (est->num_samples < 1000)
+                    est->num_samples++;
+            } else if (fabs(err) >= VSYNC_MIN_INTERVAL) {
+                // Euclid step: if flips are multiples of the true interval
+                // apart, so is the residual, and it's smaller.
+                est->interval_us = fabs(err);
+                est->num_samples = 0;
+            } else {
+                est->num_samples = 0;
+            }
+        } else {
+            est->interval_us = d;
+            est->num_samples = 0;
+        }
+    }
+    est->last_flip_us = now;
+    pthread_mutex_unlock(&est->lock);
+}
+
+static void vsync_est_reset(struct vo *vo)
+{
+    struct vo_vsync_est *est = vo->vsync;
+    pthread_mutex_lock(&est->lock);
+    est->last_flip_us = 0;
+    est->interval_us = 0;
+    est->num_samples = 0;
+    pthread_mutex_unlock(&est->lock);
+}
+
+int64_t vo_adjust_flip_time(struct vo *vo, int64_t pts_us)
+{
+    struct vo_vsync_est *est = vo->vsync;
+    int64_t res = pts_us;
+    pthread_mutex_lock(&est->lock);
+    if (est->num_samples >= VSYNC_LOCK_SAMPLES && est->last_flip_us > 0 &&
+        pts_us > est->last_flip_us)
+    {
+        double n = floor((pts_us - est->last_flip_us) / est->interval_us + 0.5);
+        if (n >= 1)
+            res = est->last_flip_us + n * est->interval_us;
+    }
+    pthread_mutex_unlock(&est->lock);
+    return res;
+}
+
+struct run_flip_page_args {
+    int64_t pts_us;
+    int duration;
+};
+
+static void run_flip_page(struct vo *vo, void *ptr)
+{
+    struct run_flip_page_args *args = ptr;
+    if (vo->driver->flip_page_timed)
+        vo->driver->flip_page_timed(vo, args->pts_us, args->duration);
+    else
+        vo->driver->flip_page(vo);
+    vsync_est_feed(vo);
+}
+
+static void *vo_thread_loop(void *arg)
+{
+    struct vo *vo = arg;
+    struct vo_thread *t = vo->thread;
+    mpthread_set_role("vo");
+    pthread_mutex_lock(&t->lock);
+    while (1) {
+        if (t->fn) {
+            void (*fn)(struct vo *vo, void *arg) = t->fn;
+            void *fn_arg = t->fn_arg;
+            pthread_mutex_unlock(&t->lock);
+            fn(vo, fn_arg);
+            pthread_mutex_lock(&t->lock);
+            t->fn = NULL;
+            pthread_cond_broadcast(&t->done);
+        } else if (t->draw_mpi) {
+            struct mp_image *mpi = t->draw_mpi;
+            pthread_mutex_unlock(&t->lock);
+            vo->driver->draw_image(vo, mpi);
+            talloc_free(mpi);
+            pthread_mutex_lock(&t->lock);
+            t->draw_mpi = NULL;
+            pthread_cond_broadcast(&t->done);
+        } else if (t->flip_pending) {
+            struct run_flip_page_args args = {t->flip_pts_us, t->flip_duration};
+            pthread_mutex_unlock(&t->lock);
+            run_flip_page(vo, &args);
+            pthread_mutex_lock(&t->lock);
+            t->flip_pending = false;
+            pthread_cond_broadcast(&t->done);
+        } else if (t->terminate) {
+            break;
+        } else {
+            pthread_cond_wait(&t->wakeup, &t->lock);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+static void vo_thread_start(struct vo *vo)
+{
+    struct vo_thread *t = talloc_zero(vo, struct vo_thread);
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->wakeup, NULL);
+    pthread_cond_init(&t->done, NULL);
+    vo->thread = t;
+    if (pthread_create(&t->thread, NULL, vo_thread_loop, vo)) {
+        MP_WARN(&vo->vo_log, "Could not create VO thread.\n");
+        return;
+    }
+    t->active = true;
+}
+
+static void vo_thread_stop(struct vo *vo)
+{
+    struct vo_thread *t = vo->thread;
+    if (!t || !t->active)
+        return;
+    pthread_mutex_lock(&t->lock);
+    t->terminate = true;
+    pthread_cond_broadcast(&t->wakeup);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+    t->active = false;
+    pthread_mutex_destroy(&t->lock);
+    pthread_cond_destroy(&t->wakeup);
+    pthread_cond_destroy(&t->done);
+}
+
+// Run fn(vo, arg) on the VO thread and wait until it has returned. Calls
+// directly if the thread is not running, or when already on the VO thread
+// (drivers calling e.g. vo_control() from within their callbacks).
+static void vo_run(struct vo *vo, void (*fn)(struct vo *vo, void *arg),
+                   void *arg)
+{
+    struct vo_thread *t = vo->thread;
+    if (!t || !t->active || pthread_equal(t->thread, pthread_self())) {
+        fn(vo, arg);
+        return;
+    }
+    pthread_mutex_lock(&t->lock);
+    while (t->fn || t->draw_mpi || t->flip_pending)
+        pthread_cond_wait(&t->done, &t->lock);
+    t->fn = fn;
+    t->fn_arg = arg;
+    pthread_cond_broadcast(&t->wakeup);
+    while (t->fn)
+        pthread_cond_wait(&t->done, &t->lock);
+    pthread_mutex_unlock(&t->lock);
+}
+
+static void run_preinit(struct vo *vo, void *ptr)
+{
+    *(int *)ptr = vo->driver->preinit(vo);
+}
+
 static struct vo *vo_create(struct mpv_global *global,
                             struct input_ctx *input_ctx,
                             struct encode_lavc_context *encode_lavc_ctx,
@@ -167,7 +393,10 @@ static struct vo *vo_create(struct mpv_global *global,
         .aspdat = { .monitor_par = 1 },
         .next_pts = MP_NOPTS_VALUE,
         .next_pts2 = MP_NOPTS_VALUE,
+        .vsync = talloc_zero(NULL, struct vo_vsync_est),
     };
+    talloc_steal(vo, vo->vsync);
+    pthread_mutex_init(&vo->vsync->lock, NULL);
     if (vo->driver->encode != !!vo->encode_lavc_ctx)
         goto error;
     struct m_config *config = m_config_from_obj_desc(vo, &desc);
@@ -176,17 +405,60 @@ static struct vo *vo_create(struct mpv_global *global,
     if (m_config_set_obj_params(config, args) < 0)
         goto error;
     vo->priv = config->optstruct;
-    if (vo->driver->preinit(vo))
+    // Encoding is untimed and runs in lockstep with the frontend anyway.
+    if (!vo->driver->encode)
+        vo_thread_start(vo);
+    int ret = -1;
+    vo_run(vo, run_preinit, &ret);
+    if (ret)
         goto error;
     return vo;
 error:
+    vo_thread_stop(vo);
     talloc_free(vo);
     return NULL;
 }
 
+struct run_control_args {
+    uint32_t request;
+    void *data;
+    int ret;
+};
+
+static void run_control(struct vo *vo, void *ptr)
+{
+    struct run_control_args *args = ptr;
+    args->ret = vo->driver->control(vo, args->request, args->data);
+}
+
 int vo_control(struct vo *vo, uint32_t request, void *data)
 {
-    return vo->driver->control(vo, request, data);
+    struct run_control_args args = {request, data, VO_FALSE};
+    vo_run(vo, run_control, &args);
+    return args.ret;
+}
+
+struct run_query_format_args {
+    uint32_t format;
+    int ret;
+};
+
+static void run_query_format(struct vo *vo, void *ptr)
+{
+    struct run_query_format_args *args = ptr;
+    args->ret = vo->driver->query_format(vo, args->format);
+}
+
+int vo_query_format(struct vo *vo, uint32_t format)
+{
+    struct run_query_format_args args = {format, 0};
+    vo_run(vo, run_query_format, &args);
+    return args.ret;
+}
+
+static void run_draw_image(struct vo *vo, void *ptr)
+{
+    vo->driver->draw_image(vo, ptr);
 }
 
 void vo_queue_image(struct vo *vo, struct mp_image *mpi)
@@ -194,7 +466,20 @@ void vo_queue_image(struct vo *vo, struct mp_image *mpi)
     if (!vo->config_ok)
         return;
     if (vo->driver->buffer_frames) {
-        vo->driver->draw_image(vo, mpi);
+        struct vo_thread *t = vo->thread;
+        if (t && t->active) {
+            /* Queue the draw and return; the copy into the video surface
+             * runs on the VO thread, and the playloop can decode the next
+             * frame meanwhile. Later calls into the driver wait for it. */
+            pthread_mutex_lock(&t->lock);
+            while (t->fn || t->draw_mpi || t->flip_pending)
+                pthread_cond_wait(&t->done, &t->lock);
+            t->draw_mpi = mp_image_new_ref(mpi);
+            pthread_cond_broadcast(&t->wakeup);
+            pthread_mutex_unlock(&t->lock);
+        } else {
+            vo_run(vo, run_draw_image, mpi);
+        }
         return;
     }
     vo->frame_loaded = true;
@@ -223,6 +508,11 @@ bool vo_get_want_redraw(struct vo *vo)
     return vo->want_redraw;
 }
 
+static void run_get_buffered_frame(struct vo *vo, void *ptr)
+{
+    vo->driver->get_buffered_frame(vo, *(bool *)ptr);
+}
+
 int vo_get_buffered_frame(struct vo *vo, bool eof)
 {
     if (!vo->config_ok)
@@ -231,7 +521,7 @@ int vo_get_buffered_frame(struct vo *vo, bool eof)
         return 0;
     if (!vo->driver->buffer_frames)
         return -1;
-    vo->driver->get_buffered_frame(vo, eof);
+    vo_run(vo, run_get_buffered_frame, &eof);
     return vo->frame_loaded ? 0 : -1;
 }
 
@@ -250,15 +540,20 @@ void vo_new_frame_imminent(struct vo *vo)
         assert(vo->frame_loaded);
         assert(vo->waiting_mpi);
         assert(vo->waiting_mpi->pts == vo->next_pts);
-        vo->driver->draw_image(vo, vo->waiting_mpi);
+        vo_run(vo, run_draw_image, vo->waiting_mpi);
         mp_image_unrefp(&vo->waiting_mpi);
     }
 }
 
+static void run_draw_osd(struct vo *vo, void *ptr)
+{
+    vo->driver->draw_osd(vo, ptr);
+}
+
 void vo_draw_osd(struct vo *vo, struct osd_state *osd)
 {
     if (vo->config_ok && vo->driver->draw_osd)
-        vo->driver->draw_osd(vo, osd);
+        vo_run(vo, run_draw_osd, osd);
 }
 
 void vo_flip_page(struct vo *vo, unsigned int pts_us, int duration)
@@ -272,11 +567,24 @@ void vo_flip_page(struct vo *vo, unsigned int pts_us, int duration)
     }
     vo->want_redraw = false;
     vo->redrawing = false;
-    if (vo->driver->flip_page_timed)
-        vo->driver->flip_page_timed(vo, pts_us, duration);
-    else
-        vo->driver->flip_page(vo);
     vo->hasframe = true;
+    struct vo_thread *t = vo->thread;
+    if (t && t->active && vo->driver->flip_page_timed) {
+        // Queue the flip and return; the driver blocks until presentation
+        // time, and the playloop can decode the next frame meanwhile. The
+        // playloop ignores the flip call duration for these drivers.
+        pthread_mutex_lock(&t->lock);
+        while (t->fn || t->draw_mpi || t->flip_pending)
+            pthread_cond_wait(&t->done, &t->lock);
+        t->flip_pending = true;
+        t->flip_pts_us = pts_us;
+        t->flip_duration = duration;
+        pthread_cond_broadcast(&t->wakeup);
+        pthread_mutex_unlock(&t->lock);
+    } else {
+        struct run_flip_page_args args = {pts_us, duration};
+        vo_run(vo, run_flip_page, &args);
+    }
 }
 
 void vo_check_events(struct vo *vo)
@@ -300,12 +608,19 @@ void vo_seek_reset(struct vo *vo)
     mp_image_unrefp(&vo->waiting_mpi);
 }
 
+static void run_uninit(struct vo *vo, void *ptr)
+{
+    vo->driver->uninit(vo);
+}
+
 void vo_destroy(struct vo *vo)
 {
     if (vo->registered_fd != -1)
         mp_input_rm_key_fd(vo->input_ctx, vo->registered_fd);
     mp_image_unrefp(&vo->waiting_mpi);
-    vo->driver->uninit(vo);
+    vo_run(vo, run_uninit, NULL);
+    vo_thread_stop(vo);
+    pthread_mutex_destroy(&vo->vsync->lock);
     talloc_free(vo);
 }
 
@@ -328,13 +643,29 @@ struct vo *init_best_video_out(struct mpv_global *global,
         return NULL;
     }
 autoprobe:
+    // Try the VO that probed successfully last run first. Probing the VOs
+    // before it in the list just failed then (often slowly, e.g. waiting
+    // for an X connection timeout), and will most likely fail again.
+    {
+        char *cached = mp_read_cached_choice(NULL, "vo");
+        if (cached) {
+            struct vo *vo = vo_create(global, input_ctx, encode_lavc_ctx,
+                                      cached, NULL);
+            talloc_free(cached);
+            if (vo)
+                return vo;
+        }
+    }
     // now try the rest...
     for (int i = 0; video_out_drivers[i]; i++) {
         struct vo *vo = vo_create(global, input_ctx, encode_lavc_ctx,
                                   (char *)video_out_drivers[i]->name, NULL);
-        if (vo)
+        if (vo) {
+            mp_write_cached_choice("vo", video_out_drivers[i]->name);
             return vo;
+        }
     }
+    mp_write_cached_choice("vo", NULL);
     return NULL;
 }
 
@@ -400,6 +731,27 @@ static int event_fd_callback(void *ctx, int fd)
     return MP_INPUT_NOTHING;
 }
 
+struct run_reconfig_args {
+    struct mp_image_params *params;
+    int flags;
+    int d_width, d_height;
+    int ret;
+};
+
+static void run_reconfig(struct vo *vo, void *ptr)
+{
+    struct run_reconfig_args *args = ptr;
+    if (vo->driver->reconfig) {
+        args->ret = vo->driver->reconfig(vo, args->params, args->flags);
+    } else {
+        // Old config() takes window size, while reconfig() takes aspect (!)
+        int r = vo->driver->config(vo, args->params->w, args->params->h,
+                                   args->d_width, args->d_height, args->flags,
+                                   args->params->imgfmt);
+        args->ret = r ? -1 : 0;
+    }
+}
+
 int vo_reconfig(struct vo *vo, struct mp_image_params *params, int flags)
 {
     int d_width = params->d_w;
@@ -419,15 +771,14 @@ int vo_reconfig(struct vo *vo, struct mp_image_params *params, int flags)
 
     struct mp_image_params p2 = *params;
 
-    int ret;
-    if (vo->driver->reconfig) {
-        ret = vo->driver->reconfig(vo, &p2, flags);
-    } else {
-        // Old config() takes window size, while reconfig() takes aspect (!)
-        ret = vo->driver->config(vo, p2.w, p2.h, d_width, d_height, flags,
-                                 p2.imgfmt);
-        ret = ret ? -1 : 0;
-    }
+    struct run_reconfig_args args = {
+        .params = &p2,
+        .flags = flags,
+        .d_width = d_width,
+        .d_height = d_height,
+    };
+    vo_run(vo, run_reconfig, &args);
+    int ret = args.ret;
     vo->config_ok = (ret >= 0);
     vo->config_count += vo->config_ok;
     if (vo->config_ok)
@@ -441,6 +792,8 @@ int vo_reconfig(struct vo *vo, struct mp_image_params *params, int flags)
     vo->waiting_mpi = NULL;
     vo->redrawing = false;
     vo->hasframe = false;
+    // A mode change may have changed the refresh rate.
+    vsync_est_reset(vo);
     if (vo->config_ok) {
         // Legacy
         struct mp_csp_details csp;
@@ -57,6 +57,14 @@ enum mp_voctrl {
     VOCTRL_SKIPFRAME,
     VOCTRL_REDRAW_FRAME,
 
+    /* Number of frames queued ahead of display, and the queue capacity.
+     * Only for VOs that queue flips to a display-side presentation queue. */
+    VOCTRL_GET_PRES_QUEUE_DEPTH,        // int[2] (queued/capacity)
+
+    /* Average GPU time of recent render passes in ms.
+     * Only for VOs that can time their GPU work. */
+    VOCTRL_GET_GPU_PASS_TIMES,          // double[3] (upload/render/osd)
+
     VOCTRL_ONTOP,
     VOCTRL_BORDER,
     VOCTRL_UPDATE_WINDOW_TITLE,         // char*
@@ -245,6 +253,8 @@ struct vo {
     double flip_queue_offset; // queue flip events at most this much in advance
 
     const struct vo_driver *driver;
+    struct vo_thread *thread; // all driver calls are run on this thread
+    struct vo_vsync_est *vsync; // estimated display refresh timing
     void *priv;
     struct mp_vo_opts *opts;
     struct vo_x11_state *x11;
@@ -284,6 +294,7 @@ struct vo *init_best_video_out(struct mpv_global *global,
 int vo_reconfig(struct vo *vo, struct mp_image_params *p, int flags);
 
 int vo_control(struct vo *vo, uint32_t request, void *data);
+int vo_query_format(struct vo *vo, uint32_t format);
 void vo_queue_image(struct vo *vo, struct mp_image *mpi);
 int vo_redraw_frame(struct vo *vo);
 bool vo_get_want_redraw(struct vo *vo);
@@ -292,6 +303,11 @@ void vo_skip_frame(struct vo *vo);
 void vo_new_frame_imminent(struct vo *vo);
 void vo_draw_osd(struct vo *vo, struct osd_state *osd);
 void vo_flip_page(struct vo *vo, unsigned int pts_us, int duration);
+// Move pts_us to the nearest predicted display vsync, if the VO has a stable
+// estimate of the display refresh from past flip times. The adjustment is
+// bounded by half a refresh interval, so it can't drift against the audio
+// clock. Returns pts_us unchanged if no usable estimate exists.
+int64_t vo_adjust_flip_time(struct vo *vo, int64_t pts_us);
 void vo_check_events(struct vo *vo);
 void vo_seek_reset(struct vo *vo);
 void vo_destroy(struct vo *vo);
@@ -87,6 +87,10 @@ struct d3dtex {
     IDirect3DTexture9 *device;
 };
 
+// Number of texture sets to rotate through on upload, so that writing a new
+// frame doesn't have to wait for the GPU to finish reading the previous one.
+#define NUM_FRAME_TEX 3
+
 struct texplane {
     int bytes_per_pixel;
     int bits_per_pixel;
@@ -94,7 +98,7 @@ struct texplane {
     // e.g. get the plane's width in pixels with (priv->src_width >> shift_x)
     int shift_x, shift_y;
     D3DFORMAT d3d_format;
-    struct d3dtex texture;
+    struct d3dtex texture[NUM_FRAME_TEX];
     // temporary locking during uploading the frame (e.g. for draw_slice)
     D3DLOCKED_RECT locked_rect;
     // value used to clear the image with memset (YUV chroma planes do not use
@@ -148,6 +152,8 @@ typedef struct d3d_priv {
 
     int plane_count;
     struct texplane planes[3];
+    int cur_frame_tex;          /**< index of the texture set (of NUM_FRAME_TEX)
+                                currently holding the displayed frame */
 
     IDirect3DPixelShader9 *pixel_shader;
     const BYTE *pixel_shader_data;
@@ -176,6 +182,8 @@ typedef struct d3d_priv {
                                     0 = textures do not have to be square */
     int device_texture_sys;         /**< 1 = device can texture from system memory
                                     0 = device requires shadow */
+    int device_caps_dyn_tex;        /**< 1 = device supports D3DUSAGE_DYNAMIC
+                                    textures, 0 = plain textures only */
     int max_texture_width;          /**< from the device capabilities */
     int max_texture_height;         /**< from the device capabilities */
 
@@ -355,8 +363,12 @@ static bool d3dtex_allocate(d3d_priv *priv, struct d3dtex *tex, D3DFORMAT fmt,
     case 2: memtype = D3DPOOL_DEFAULT; break;
     }
 
+    // The managed pool doesn't allow dynamic usage.
+    DWORD usage = priv->device_caps_dyn_tex && memtype != D3DPOOL_MANAGED
+                  ? D3DUSAGE_DYNAMIC : 0;
+
     if (FAILED(IDirect3DDevice9_CreateTexture(priv->d3d_device, tw, th, 1,
-        D3DUSAGE_DYNAMIC, fmt, memtype, &tex->system, NULL)))
+        usage, fmt, memtype, &tex->system, NULL)))
     {
         MP_ERR(priv, "Allocating %dx%d texture in system RAM failed.\n", w, h);
         goto error_exit;
@@ -364,7 +376,7 @@ static bool d3dtex_allocate(d3d_priv *priv, struct d3dtex *tex, D3DFORMAT fmt,
 
     if (!priv->device_texture_sys && !priv->opt_texture_memory) {
         if (FAILED(IDirect3DDevice9_CreateTexture(priv->d3d_device, tw, th, 1,
-            D3DUSAGE_DYNAMIC, fmt, D3DPOOL_DEFAULT, &tex->device, NULL)))
+            usage, fmt, D3DPOOL_DEFAULT, &tex->device, NULL)))
         {
             MP_ERR(priv, "Allocating %dx%d texture in video RAM failed.\n", w, h);
             goto error_exit;
@@ -410,7 +422,8 @@ static void d3d_unlock_video_objects(d3d_priv *priv)
     for (int n = 0; n < priv->plane_count; n++) {
         struct texplane *plane = &priv->planes[n];
         if (plane->locked_rect.pBits) {
-            if (FAILED(IDirect3DTexture9_UnlockRect(plane->texture.system, 0)))
+            struct d3dtex *tex = &plane->texture[priv->cur_frame_tex];
+            if (FAILED(IDirect3DTexture9_UnlockRect(tex->system, 0)))
                 any_failed = true;
         }
         plane->locked_rect.pBits = NULL;
@@ -431,7 +444,8 @@ static void d3d_destroy_video_objects(d3d_priv *priv)
     priv->d3d_surface = NULL;
 
     for (int n = 0; n < priv->plane_count; n++) {
-        d3dtex_release(priv, &priv->planes[n].texture);
+        for (int i = 0; i < NUM_FRAME_TEX; i++)
+            d3dtex_release(priv, &priv->planes[n].texture[i]);
     }
 
     if (priv->pixel_shader)
@@ -472,24 +486,26 @@ static bool d3d_configure_video_objects(d3d_priv *priv)
         for (n = 0; n < priv->plane_count; n++) {
             struct texplane *plane = &priv->planes[n];
 
-            if (!plane->texture.system) {
-                if (!d3dtex_allocate(priv,
-                                     &plane->texture,
-                                     plane->d3d_format,
-                                     priv->src_width >> plane->shift_x,
-                                     priv->src_height >> plane->shift_y))
-                {
-                    MP_ERR(priv, "Allocating plane %d"
-                           " failed.\n", n);
-                    return false;
+            if (!plane->texture[0].system) {
+                for (int i = 0; i < NUM_FRAME_TEX; i++) {
+                    if (!d3dtex_allocate(priv,
+                                         &plane->texture[i],
+                                         plane->d3d_format,
+                                         priv->src_width >> plane->shift_x,
+                                         priv->src_height >> plane->shift_y))
+                    {
+                        MP_ERR(priv, "Allocating plane %d"
+                               " failed.\n", n);
+                        return false;
+                    }
                 }
 
                 MP_VERBOSE(priv, "Allocated plane %d:"
                        " %d bit, shift=%d/%d size=%d/%d (%d/%d).\n", n,
                        plane->bits_per_pixel,
                        plane->shift_x, plane->shift_y,
-                       plane->texture.w, plane->texture.h,
-                       plane->texture.tex_w, plane->texture.tex_h);
+                       plane->texture[0].w, plane->texture[0].h,
+                       plane->texture[0].tex_w, plane->texture[0].tex_h);
 
                 need_clear = true;
             }
@@ -524,14 +540,25 @@ static bool d3d_configure_video_objects(d3d_priv *priv)
     return true;
 }
 
-static bool d3d_lock_video_textures(d3d_priv *priv)
+// Lock flags to use for rewriting a whole frame texture. If the texture is
+// dynamic, let the driver discard the old contents instead of synchronizing
+// with possibly still pending GPU reads.
+static DWORD d3d_frame_tex_lockflags(d3d_priv *priv)
+{
+    return priv->device_caps_dyn_tex && priv->opt_texture_memory != 1
+           ? D3DLOCK_DISCARD : 0;
+}
+
+static bool d3d_lock_video_textures(d3d_priv *priv, DWORD flags)
 {
     for (int n = 0; n < priv->plane_count; n++) {
         struct texplane *plane = &priv->planes[n];
+        struct d3dtex *tex = &plane->texture[priv->cur_frame_tex];
 
         if (!plane->locked_rect.pBits) {
-            if (FAILED(IDirect3DTexture9_LockRect(plane->texture.system, 0,
-                                                  &plane->locked_rect, NULL, 0)))
+            if (FAILED(IDirect3DTexture9_LockRect(tex->system, 0,
+                                                  &plane->locked_rect, NULL,
+                                                  flags)))
             {
                 MP_VERBOSE(priv, "Texture lock failure.\n");
                 d3d_unlock_video_objects(priv);
@@ -545,16 +572,22 @@ static bool d3d_lock_video_textures(d3d_priv *priv)
 
 static void d3d_clear_video_textures(d3d_priv *priv)
 {
-    if (!d3d_lock_video_textures(priv))
-        return;
+    for (int i = 0; i < NUM_FRAME_TEX; i++) {
+        priv->cur_frame_tex = i;
 
-    for (int n = 0; n < priv->plane_count; n++) {
-        struct texplane *plane = &priv->planes[n];
-        memset(plane->locked_rect.pBits, plane->clearval,
-               plane->locked_rect.Pitch * plane->texture.tex_h);
+        if (!d3d_lock_video_textures(priv, 0))
+            return;
+
+        for (int n = 0; n < priv->plane_count; n++) {
+            struct texplane *plane = &priv->planes[n];
+            memset(plane->locked_rect.pBits, plane->clearval,
+                   plane->locked_rect.Pitch * plane->texture[i].tex_h);
+        }
+
+        d3d_unlock_video_objects(priv);
     }
 
-    d3d_unlock_video_objects(priv);
+    priv->cur_frame_tex = 0;
 }
 
 // Recreate and initialize D3D objects if necessary. The amount of work that
@@ -646,6 +679,7 @@ static bool init_d3d(d3d_priv *priv)
                         !(texture_caps & D3DPTEXTURECAPS_NONPOW2CONDITIONAL);
     priv->device_caps_square_only = texture_caps & D3DPTEXTURECAPS_SQUAREONLY;
     priv->device_texture_sys      = dev_caps & D3DDEVCAPS_TEXTURESYSTEMMEMORY;
+    priv->device_caps_dyn_tex     = !!(disp_caps.Caps2 & D3DCAPS2_DYNAMICTEXTURES);
     priv->max_texture_width       = disp_caps.MaxTextureWidth;
     priv->max_texture_height      = disp_caps.MaxTextureHeight;
 
@@ -653,11 +687,11 @@ static bool init_d3d(d3d_priv *priv)
         priv->device_caps_power2_only = 1;
 
     MP_VERBOSE(priv, "device_caps_power2_only %d, device_caps_square_only %d\n"
-               "device_texture_sys %d\n"
+               "device_texture_sys %d, device_caps_dyn_tex %d\n"
                "max_texture_width %d, max_texture_height %d\n",
                priv->device_caps_power2_only, priv->device_caps_square_only,
-               priv->device_texture_sys, priv->max_texture_width,
-               priv->max_texture_height);
+               priv->device_texture_sys, priv->device_caps_dyn_tex,
+               priv->max_texture_width, priv->max_texture_height);
 
     return true;
 }
@@ -851,7 +885,8 @@ static uint32_t d3d_draw_frame(d3d_priv *priv)
 
         for (n = 0; n < priv->plane_count; n++) {
             IDirect3DDevice9_SetTexture(priv->d3d_device, n,
-                d3dtex_get_render_texture(priv, &priv->planes[n].texture));
+                d3dtex_get_render_texture(priv,
+                    &priv->planes[n].texture[priv->cur_frame_tex]));
         }
 
         RECT rm = priv->fs_movie_rect;
@@ -873,9 +908,9 @@ static uint32_t d3d_draw_frame(d3d_priv *priv)
 
         for (n = 0; n < priv->plane_count; n++) {
             float s_x = (1.0f / (1 << priv->planes[n].shift_x))
-                        / priv->planes[n].texture.tex_w;
+                        / priv->planes[n].texture[0].tex_w;
             float s_y = (1.0f / (1 << priv->planes[n].shift_y))
-                        / priv->planes[n].texture.tex_h;
+                        / priv->planes[n].texture[0].tex_h;
             for (int i = 0; i < 4; i++) {
                 vb[i].t[n][0] = texc[i][0] * s_x;
                 vb[i].t[n][1] = texc[i][1] * s_y;
@@ -1348,7 +1383,8 @@ static void uninit(struct vo *vo)
 
 // Lock buffers and fill out to point to them.
 // Must call d3d_unlock_video_objects() to unlock the buffers again.
-static bool get_video_buffer(d3d_priv *priv, struct mp_image *out)
+// If write is true, the old buffer contents may be discarded.
+static bool get_video_buffer(d3d_priv *priv, struct mp_image *out, bool write)
 {
     *out = (struct mp_image) {0};
     mp_image_set_size(out, priv->src_width, priv->src_height);
@@ -1358,7 +1394,8 @@ static bool get_video_buffer(d3d_priv *priv, struct mp_image *out)
         return false;
 
     if (priv->use_textures) {
-        if (!d3d_lock_video_textures(priv))
+        if (!d3d_lock_video_textures(priv,
+                                     write ? d3d_frame_tex_lockflags(priv) : 0))
             return false;
 
         for (int n = 0; n < priv->plane_count; n++) {
@@ -1405,8 +1442,14 @@ static void draw_image(struct vo *vo, mp_image_t *mpi)
     if (!priv->d3d_device)
         return;
 
+    if (priv->use_textures) {
+        // Rotate to the next texture set, so that the upload of the new frame
+        // can overlap with the GPU still presenting from the previous one.
+        priv->cur_frame_tex = (priv->cur_frame_tex + 1) % NUM_FRAME_TEX;
+    }
+
     struct mp_image buffer;
-    if (!get_video_buffer(priv, &buffer))
+    if (!get_video_buffer(priv, &buffer, true))
         return;
 
     mp_image_copy(&buffer, mpi);
@@ -1415,7 +1458,7 @@ static void draw_image(struct vo *vo, mp_image_t *mpi)
 
     if (priv->use_textures) {
         for (int n = 0; n < priv->plane_count; n++) {
-            d3dtex_update(priv, &priv->planes[n].texture);
+            d3dtex_update(priv, &priv->planes[n].texture[priv->cur_frame_tex]);
         }
     }
 
@@ -1433,7 +1476,7 @@ static mp_image_t *get_screenshot(d3d_priv *priv)
         return NULL;
 
     struct mp_image buffer;
-    if (!get_video_buffer(priv, &buffer))
+    if (!get_video_buffer(priv, &buffer, false))
         return NULL;
 
     struct mp_image *image = mp_image_new_copy(&buffer);
@@ -73,6 +73,10 @@ struct gl_priv {
     int vo_flipped;
 
     int frames_rendered;
+
+    // A VOCTRL_REDRAW_FRAME was deferred to draw_osd(), so that the redraw
+    // can be limited to the region the OSD actually damaged (buffer age).
+    bool partial_redraw_pending;
 };
 
 // Always called under mpgl_lock
@@ -102,7 +106,14 @@ static void flip_page(struct vo *vo)
     if (p->use_glFinish)
         gl->Finish();
 
+    if (p->partial_redraw_pending) {
+        // draw_osd() was never called - redraw the frame in full.
+        p->partial_redraw_pending = false;
+        gl_video_render_frame(p->renderer);
+    }
+
     p->glctx->swapGlBuffers(p->glctx);
+    gl_video_swapped(p->renderer);
 
     p->frames_rendered++;
     if (p->frames_rendered > 5)
@@ -117,6 +128,16 @@ static void draw_osd(struct vo *vo, struct osd_state *osd)
 
     mpgl_lock(p->glctx);
 
+    if (p->partial_redraw_pending) {
+        p->partial_redraw_pending = false;
+        int age = p->glctx->getBufferAge ? p->glctx->getBufferAge(p->glctx) : 0;
+        if (gl_video_redraw_partial(p->renderer, osd, age)) {
+            mpgl_unlock(p->glctx);
+            return;
+        }
+        gl_video_render_frame(p->renderer);
+    }
+
     gl_video_draw_osd(p->renderer, osd);
 
     mpgl_unlock(p->glctx);
@@ -302,6 +323,12 @@ static int control(struct vo *vo, uint32_t request, void *data)
         resize(p);
         mpgl_unlock(p->glctx);
         return VO_TRUE;
+    case VOCTRL_GET_GPU_PASS_TIMES: {
+        mpgl_lock(p->glctx);
+        bool r = gl_video_get_gpu_times(p->renderer, data);
+        mpgl_unlock(p->glctx);
+        return r ? VO_TRUE : VO_NOTIMPL;
+    }
     case VOCTRL_GET_EQUALIZER: {
         struct voctrl_get_equalizer_args *args = data;
         mpgl_lock(p->glctx);
@@ -340,7 +367,13 @@ static int control(struct vo *vo, uint32_t request, void *data)
     }
     case VOCTRL_REDRAW_FRAME:
         mpgl_lock(p->glctx);
-        gl_video_render_frame(p->renderer);
+        if (p->glctx->getBufferAge) {
+            // Defer rendering to draw_osd(), where the new OSD region is
+            // known and the repaint can be limited to the damaged area.
+            p->partial_redraw_pending = true;
+        } else {
+            gl_video_render_frame(p->renderer);
+        }
         mpgl_unlock(p->glctx);
         return true;
     case VOCTRL_SET_COMMAND_LINE: {
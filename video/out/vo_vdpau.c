@@ -33,6 +33,7 @@
 #include <assert.h>
 
 #include <libavutil/common.h>
+#include <libavutil/adler32.h>
 
 #include "config.h"
 #include "video/vdpau.h"
@@ -139,9 +140,15 @@ struct vdpctx {
     struct osd_bitmap_surface {
         VdpRGBAFormat format;
         VdpBitmapSurface surface;
+        uint32_t surface_w;
+        uint32_t surface_h;
         uint32_t max_width;
         uint32_t max_height;
         struct bitmap_packer *packer;
+        // Per sub-bitmap content checksums from the previous upload, used to
+        // skip re-uploading unchanged parts when the atlas layout is stable.
+        uint32_t *part_checksums;
+        int num_part_checksums;
         // List of surfaces to be rendered
         struct osd_target {
             VdpRect source;
@@ -906,6 +913,13 @@ static void generate_osd_part(struct vo *vo, struct sub_bitmaps *imgs)
     if (sfc->format != format) {
         talloc_free(sfc->packer);
         sfc->packer = NULL;
+        if (sfc->surface != VDP_INVALID_HANDLE) {
+            vdp_st = vdp->bitmap_surface_destroy(sfc->surface);
+            CHECK_ST_WARNING("Error when calling vdp_bitmap_surface_destroy");
+            sfc->surface = VDP_INVALID_HANDLE;
+        }
+        sfc->surface_w = sfc->surface_h = 0;
+        sfc->num_part_checksums = 0;
     };
     sfc->format = format;
     if (!sfc->packer)
@@ -916,7 +930,8 @@ static void generate_osd_part(struct vo *vo, struct sub_bitmaps *imgs)
         MP_ERR(vo, "OSD bitmaps do not fit on a surface with the maximum "
                "supported size\n");
         return;
-    } else if (r == 1) {
+    } else if (r == 1 && ((uint32_t)sfc->packer->w > sfc->surface_w ||
+                          (uint32_t)sfc->packer->h > sfc->surface_h)) {
         if (sfc->surface != VDP_INVALID_HANDLE) {
             vdp_st = vdp->bitmap_surface_destroy(sfc->surface);
             CHECK_ST_WARNING("Error when calling vdp_bitmap_surface_destroy");
@@ -929,8 +944,16 @@ static void generate_osd_part(struct vo *vo, struct sub_bitmaps *imgs)
         if (vdp_st != VDP_STATUS_OK)
             sfc->surface = VDP_INVALID_HANDLE;
         CHECK_ST_WARNING("OSD: error when creating surface");
+        sfc->surface_w = sfc->packer->w;
+        sfc->surface_h = sfc->packer->h;
+        // The old atlas contents are gone.
+        sfc->num_part_checksums = 0;
     }
-    if (imgs->scaled) {
+    // If the atlas layout is unchanged, only regions whose bitmap contents
+    // actually changed need to be re-uploaded (see upload loop below).
+    bool upload_all = sfc->packer->layout_changed ||
+                      sfc->packer->count > sfc->num_part_checksums;
+    if (imgs->scaled && upload_all) {
         char zeros[sfc->packer->used_width * format_size];
         memset(zeros, 0, sizeof(zeros));
         vdp_st = vdp->bitmap_surface_put_bits_native(sfc->surface,
@@ -948,6 +971,10 @@ osd_skip_upload:
         sfc->targets = talloc_size(vc, sfc->targets_size
                                        * sizeof(*sfc->targets));
     }
+    if (need_upload) {
+        sfc->part_checksums = talloc_realloc(vc, sfc->part_checksums,
+                                             uint32_t, sfc->packer->count);
+    }
 
     for (int i = 0 ;i < sfc->packer->count; i++) {
         struct sub_bitmap *b = &imgs->parts[i];
@@ -965,16 +992,30 @@ osd_skip_upload:
             target->color.red   = ((color >> 24) & 0xff) / 255.0;
         }
         if (need_upload) {
-            vdp_st = vdp->
-                bitmap_surface_put_bits_native(sfc->surface,
-                                               &(const void *){b->bitmap},
-                                               &(uint32_t){b->stride},
-                                               &target->source);
-                CHECK_ST_WARNING("OSD: putbits failed");
+            unsigned long sum = 1;
+            for (int y2 = 0; y2 < b->h; y2++) {
+                sum = av_adler32_update(sum,
+                        (uint8_t *)b->bitmap + y2 * b->stride,
+                        b->w * format_size);
+            }
+            if (upload_all || sfc->packer->dirty[i] ||
+                sum != sfc->part_checksums[i])
+            {
+                vdp_st = vdp->
+                    bitmap_surface_put_bits_native(sfc->surface,
+                                                   &(const void *){b->bitmap},
+                                                   &(uint32_t){b->stride},
+                                                   &target->source);
+                    CHECK_ST_WARNING("OSD: putbits failed");
+            }
+            sfc->part_checksums[i] = sum;
         }
         sfc->render_count++;
     }
 
+    if (need_upload)
+        sfc->num_part_checksums = sfc->packer->count;
+
     sfc->bitmap_id = imgs->bitmap_id;
     sfc->bitmap_pos_id = imgs->bitmap_pos_id;
 }
@@ -1434,6 +1475,14 @@ static int control(struct vo *vo, uint32_t request, void *data)
         arg->vdpau_ctx = vc->mpvdp;
         return true;
     }
+    case VOCTRL_GET_PRES_QUEUE_DEPTH: {
+        if (!status_ok(vo))
+            return false;
+        int *args = data;
+        args[0] = update_presentation_queue_status(vo);
+        args[1] = vc->num_output_surfaces;
+        return true;
+    }
     case VOCTRL_GET_PANSCAN:
         return VO_TRUE;
     case VOCTRL_SET_PANSCAN:
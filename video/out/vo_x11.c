@@ -217,7 +217,7 @@ shmemerror:
     p->ImageDataOrig[foo] =
         malloc(p->myximage[foo]->bytes_per_line * p->image_height + 32);
     p->myximage[foo]->data = p->ImageDataOrig[foo] + 16
-                           - ((long)p->ImageDataOrig & 15);
+                           - ((long)p->ImageDataOrig[foo] & 15);
     memset(p->myximage[foo]->data, 0, p->myximage[foo]->bytes_per_line
                                       * p->image_height);
     p->ImageData[foo] = p->myximage[foo]->data;
@@ -82,7 +82,13 @@ struct xvctx {
     int current_ip_buf;
     int num_buffers;
     XvImage *xvimage[2];
+    int buf_frame_serial[2];        // frame in the buffer (-1: unknown)
+    struct mp_rect buf_osd_rc[2];   // region the OSD was blended into
+    int frame_serial;               // frame in original_image
     struct mp_image *original_image;
+    struct mp_image *osd_scratch;   // normal memory staging for OSD blending
+    int scratch_frame_serial;       // frame in osd_scratch (-1: unknown)
+    struct mp_rect scratch_osd_rc;  // region the OSD was blended into
     uint32_t image_width;
     uint32_t image_height;
     uint32_t image_format;
@@ -428,6 +434,8 @@ static int config(struct vo *vo, uint32_t width, uint32_t height,
     int i;
 
     mp_image_unrefp(&ctx->original_image);
+    mp_image_unrefp(&ctx->osd_scratch);
+    ctx->scratch_frame_serial = -1;
 
     ctx->image_height = height;
     ctx->image_width = width;
@@ -478,6 +486,11 @@ static int config(struct vo *vo, uint32_t width, uint32_t height,
     ctx->current_buf = 0;
     ctx->current_ip_buf = 0;
 
+    for (i = 0; i < ctx->num_buffers; i++) {
+        ctx->buf_frame_serial[i] = -1;
+        ctx->buf_osd_rc[i] = (struct mp_rect){0};
+    }
+
 
     resize(vo);
 
@@ -610,6 +623,21 @@ static struct mp_image get_xv_buffer(struct vo *vo, int buf_index)
     return img;
 }
 
+// Copy the given region only, rounded out to the format's alignment.
+static void copy_image_region(struct mp_image *dst, struct mp_image *src,
+                              struct mp_rect rc)
+{
+    rc.x0 = MP_ALIGN_DOWN(rc.x0, dst->fmt.align_x);
+    rc.y0 = MP_ALIGN_DOWN(rc.y0, dst->fmt.align_y);
+    struct mp_rect bounds = {0, 0, dst->w, dst->h};
+    if (!mp_rect_intersection(&rc, &bounds))
+        return;
+    struct mp_image dst_rc = *dst, src_rc = *src;
+    mp_image_crop_rc(&dst_rc, rc);
+    mp_image_crop_rc(&src_rc, rc);
+    mp_image_copy(&dst_rc, &src_rc);
+}
+
 static void draw_osd(struct vo *vo, struct osd_state *osd)
 {
     struct xvctx *ctx = vo->priv;
@@ -622,7 +650,36 @@ static void draw_osd(struct vo *vo, struct osd_state *osd)
         .display_par = 1.0 / vo->aspdat.par,
     };
 
-    osd_draw_on_image(osd, res, osd->vo_pts, 0, &img);
+    /* The Xv buffer is (usually) write-combining shared memory, where the
+     * read-modify-write access pattern of alpha blending is pathologically
+     * slow. Blend into a normal memory copy of the frame instead, and copy
+     * only the composed region into the Xv buffer in one pass. */
+    if (ctx->original_image) {
+        if (!ctx->osd_scratch) {
+            ctx->osd_scratch = mp_image_alloc(ctx->image_format,
+                                              ctx->image_width,
+                                              ctx->image_height);
+            ctx->scratch_frame_serial = -1;
+        }
+        if (ctx->scratch_frame_serial != ctx->frame_serial) {
+            mp_image_copy(ctx->osd_scratch, ctx->original_image);
+            ctx->scratch_frame_serial = ctx->frame_serial;
+        } else {
+            // The scratch copy still contains this frame - only the region
+            // the OSD was blended into has to be restored.
+            copy_image_region(ctx->osd_scratch, ctx->original_image,
+                              ctx->scratch_osd_rc);
+        }
+        ctx->scratch_osd_rc = (struct mp_rect){0};
+        osd_draw_on_image_bb(osd, res, osd->vo_pts, 0, ctx->osd_scratch,
+                             &ctx->scratch_osd_rc);
+        copy_image_region(&img, ctx->osd_scratch, ctx->scratch_osd_rc);
+        ctx->buf_osd_rc[ctx->current_buf] = ctx->scratch_osd_rc;
+        return;
+    }
+
+    osd_draw_on_image_bb(osd, res, osd->vo_pts, 0, &img,
+                         &ctx->buf_osd_rc[ctx->current_buf]);
 }
 
 static void wait_for_completion(struct vo *vo, int max_outstanding)
@@ -670,14 +727,27 @@ static void draw_image(struct vo *vo, mp_image_t *mpi)
 {
     struct xvctx *ctx = vo->priv;
 
+    // A new frame, as opposed to redrawing the current one (see redraw_frame())
+    if (mpi && mpi != ctx->original_image)
+        ctx->frame_serial++;
+
     wait_for_completion(vo, ctx->num_buffers - 1);
 
-    struct mp_image xv_buffer = get_xv_buffer(vo, ctx->current_buf);
+    int buf = ctx->current_buf;
+    struct mp_image xv_buffer = get_xv_buffer(vo, buf);
     if (mpi) {
-        mp_image_copy(&xv_buffer, mpi);
+        if (ctx->buf_frame_serial[buf] == ctx->frame_serial) {
+            // The buffer still contains this frame - only the region the OSD
+            // was blended into has to be restored, not the whole frame.
+            copy_image_region(&xv_buffer, mpi, ctx->buf_osd_rc[buf]);
+        } else {
+            mp_image_copy(&xv_buffer, mpi);
+        }
     } else {
         mp_image_clear(&xv_buffer, 0, 0, xv_buffer.w, xv_buffer.h);
     }
+    ctx->buf_frame_serial[buf] = mpi ? ctx->frame_serial : -1;
+    ctx->buf_osd_rc[buf] = (struct mp_rect){0};
 
     mp_image_setrefp(&ctx->original_image, mpi);
 }
@@ -712,6 +782,7 @@ static void uninit(struct vo *vo)
     int i;
 
     talloc_free(ctx->original_image);
+    talloc_free(ctx->osd_scratch);
 
     if (ctx->ai)
         XvFreeAdaptorInfo(ctx->ai);
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <limits.h>
 #include <assert.h>
+#include <pthread.h>
 #include <windows.h>
 #include <windowsx.h>
 
@@ -112,6 +113,27 @@ static int mod_state(struct vo *vo)
     return res;
 }
 
+// Runs fn on the window thread (see run_on_gui_thread()).
+#define WM_RUN_ON_GUI (WM_USER + 1)
+
+struct gui_call {
+    int (*fn)(struct vo *vo, void *arg);
+    void *arg;
+    int ret;
+};
+
+// Run fn on the window thread and return its result. SendMessage() blocks
+// the caller until the call has finished, so fn cannot race with the VO
+// thread on window state; sent messages are also processed inside modal
+// size/move loops, so this works even while the user drags the window.
+static int run_on_gui_thread(struct vo *vo, int (*fn)(struct vo *, void *),
+                             void *arg)
+{
+    struct gui_call call = {fn, arg};
+    SendMessageW(vo->w32->window, WM_RUN_ON_GUI, 0, (LPARAM)&call);
+    return call.ret;
+}
+
 static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
                                 LPARAM lParam)
 {
@@ -130,7 +152,9 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
         case WM_ERASEBKGND: // no need to erase background seperately
             return 1;
         case WM_PAINT:
-            w32->event_flags |= VO_EVENT_EXPOSE;
+            pthread_mutex_lock(&w32->lock);
+            w32->pending_events |= VO_EVENT_EXPOSE;
+            pthread_mutex_unlock(&w32->lock);
             break;
         case WM_MOVE: {
             POINT p = {0};
@@ -142,13 +166,15 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
             break;
         }
         case WM_SIZE: {
-            w32->event_flags |= VO_EVENT_RESIZE;
             RECT r;
             GetClientRect(w32->window, &r);
-            vo->dwidth = r.right;
-            vo->dheight = r.bottom;
+            pthread_mutex_lock(&w32->lock);
+            w32->pending_events |= VO_EVENT_RESIZE;
+            w32->new_dwidth = r.right;
+            w32->new_dheight = r.bottom;
+            pthread_mutex_unlock(&w32->lock);
             MP_VERBOSE(vo, "resize window: %d:%d\n",
-                   vo->dwidth, vo->dheight);
+                   (int)r.right, (int)r.bottom);
             break;
         }
         case WM_SIZING:
@@ -176,6 +202,14 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
         case WM_CLOSE:
             mp_input_put_key(vo->input_ctx, MP_KEY_CLOSE_WIN);
             break;
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            break;
+        case WM_RUN_ON_GUI: {
+            struct gui_call *call = (void *)lParam;
+            call->ret = call->fn(vo, call->arg);
+            return 0;
+        }
         case WM_DROPFILES: {
             HDROP hDrop = (HDROP)wParam;
             UINT nfiles = DragQueryFileW(hDrop, 0xFFFFFFFF, NULL, 0);
@@ -270,6 +304,12 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
         case WM_MOUSEMOVE: {
             if (!w32->tracking)
                 w32->tracking = TrackMouseEvent(&w32->trackEvent);
+            // High polling rate mice flood the queue with mouse moves, and
+            // only the newest position matters - drop the older ones.
+            MSG next;
+            while (PeekMessageW(&next, hWnd, WM_MOUSEMOVE, WM_MOUSEMOVE,
+                                PM_REMOVE))
+                lParam = next.lParam;
             // Windows can send spurious mouse events, which would make the mpv
             // core unhide the mouse cursor on completely unrelated events. See:
             //  https://blogs.msdn.com/b/oldnewthing/archive/2003/10/01/55108.aspx
@@ -339,9 +379,11 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
 }
 
 /**
- * \brief Dispatch incoming window events and handle them.
+ * \brief Fetch events collected by the window thread.
  *
  * This function should be placed inside libvo's function "check_events".
+ * The actual message dispatching happens on the window thread; this only
+ * picks up the accumulated results.
  *
  * \return int with these flags possibly set, take care to handle in the right order
  *         if it matters in your driver:
@@ -354,12 +396,14 @@ static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam,
 int vo_w32_check_events(struct vo *vo)
 {
     struct vo_w32_state *w32 = vo->w32;
-    MSG msg;
-    w32->event_flags = 0;
-    while (PeekMessageW(&msg, 0, 0, 0, PM_REMOVE)) {
-        TranslateMessage(&msg);
-        DispatchMessageW(&msg);
+    pthread_mutex_lock(&w32->lock);
+    int events = w32->pending_events;
+    w32->pending_events = 0;
+    if (events & VO_EVENT_RESIZE) {
+        vo->dwidth = w32->new_dwidth;
+        vo->dheight = w32->new_dheight;
     }
+    pthread_mutex_unlock(&w32->lock);
     if (vo->opts->WinID >= 0) {
         BOOL res;
         RECT r;
@@ -367,7 +411,7 @@ int vo_w32_check_events(struct vo *vo)
         res = GetClientRect(w32->window, &r);
         if (res && (r.right != vo->dwidth || r.bottom != vo->dheight)) {
             vo->dwidth = r.right; vo->dheight = r.bottom;
-            w32->event_flags |= VO_EVENT_RESIZE;
+            events |= VO_EVENT_RESIZE;
         }
         p.x = 0; p.y = 0;
         ClientToScreen(w32->window, &p);
@@ -382,7 +426,7 @@ int vo_w32_check_events(struct vo *vo)
             mp_input_put_key(vo->input_ctx, MP_KEY_CLOSE_WIN);
     }
 
-    return w32->event_flags;
+    return events;
 }
 
 static BOOL CALLBACK mon_enum(HMONITOR hmon, HDC hdc, LPRECT r, LPARAM p)
@@ -543,6 +587,8 @@ static int reinit_window_state(struct vo *vo)
     return 1;
 }
 
+static int gui_config_window(struct vo *vo, void *ptr);
+
 /**
  * \brief Configure and show window on the screen.
  *
@@ -582,6 +628,17 @@ int vo_w32_config(struct vo *vo, uint32_t width, uint32_t height,
     if (flags & VOFLAG_HIDDEN)
         return 1;
 
+    uint32_t size[2] = {width, height};
+    return run_on_gui_thread(vo, gui_config_window, size);
+}
+
+// Window-state part of vo_w32_config(); runs on the window thread.
+static int gui_config_window(struct vo *vo, void *ptr)
+{
+    struct vo_w32_state *w32 = vo->w32;
+    uint32_t *size = ptr;
+    uint32_t width = size[0], height = size[1];
+
     bool reset_size = !(w32->o_dwidth == width && w32->o_dheight == height);
 
     w32->o_dwidth = width;
@@ -637,12 +694,14 @@ int vo_w32_config(struct vo *vo, uint32_t width, uint32_t height,
  *
  * \return 1 = Success, 0 = Failure
  */
-int vo_w32_init(struct vo *vo)
+// The window thread. The window is created and all its messages dispatched
+// here, so that modal operations started by the window manager (dragging or
+// resizing the window, opening the system menu) only block this thread and
+// video output continues during them.
+static void *w32_thread(void *ptr)
 {
-    assert(!vo->w32);
-
-    struct vo_w32_state *w32 = talloc_zero(vo, struct vo_w32_state);
-    vo->w32 = w32;
+    struct vo *vo = ptr;
+    struct vo_w32_state *w32 = vo->w32;
 
     HINSTANCE hInstance = GetModuleHandleW(NULL);
 
@@ -661,7 +720,7 @@ int vo_w32_init(struct vo *vo)
 
     if (!RegisterClassExW(&wcex)) {
         MP_ERR(vo, "win32: unable to register window class!\n");
-        return 0;
+        goto done;
     }
 
     if (vo->opts->WinID >= 0) {
@@ -684,7 +743,8 @@ int vo_w32_init(struct vo *vo)
 
     if (!w32->window) {
         MP_ERR(vo, "win32: unable to create window!\n");
-        return 0;
+        UnregisterClassW(classname, 0);
+        goto done;
     }
 
     DragAcceptFiles(w32->window, TRUE);
@@ -700,6 +760,51 @@ int vo_w32_init(struct vo *vo)
         EnableWindow(w32->window, 0);
     w32->cursor_visible = true;
 
+done:
+    pthread_mutex_lock(&w32->lock);
+    w32->init_done = true;
+    pthread_cond_broadcast(&w32->wakeup);
+    pthread_mutex_unlock(&w32->lock);
+
+    if (!w32->window)
+        return NULL;
+
+    MSG msg;
+    while (GetMessageW(&msg, 0, 0, 0) > 0) {
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    UnregisterClassW(classname, 0);
+    return NULL;
+}
+
+int vo_w32_init(struct vo *vo)
+{
+    assert(!vo->w32);
+
+    struct vo_w32_state *w32 = talloc_zero(vo, struct vo_w32_state);
+    vo->w32 = w32;
+
+    pthread_mutex_init(&w32->lock, NULL);
+    pthread_cond_init(&w32->wakeup, NULL);
+
+    if (pthread_create(&w32->thread, NULL, w32_thread, vo)) {
+        MP_ERR(vo, "win32: unable to create window thread!\n");
+        goto fail;
+    }
+    w32->thread_valid = true;
+
+    pthread_mutex_lock(&w32->lock);
+    while (!w32->init_done)
+        pthread_cond_wait(&w32->wakeup, &w32->lock);
+    pthread_mutex_unlock(&w32->lock);
+
+    if (!w32->window) {
+        pthread_join(w32->thread, NULL);
+        goto fail;
+    }
+
     // we don't have proper event handling
     vo->wakeup_period = 0.02;
 
@@ -709,6 +814,13 @@ int vo_w32_init(struct vo *vo)
            vo->opts->screenwidth, vo->opts->screenheight);
 
     return 1;
+
+fail:
+    pthread_cond_destroy(&w32->wakeup);
+    pthread_mutex_destroy(&w32->lock);
+    talloc_free(w32);
+    vo->w32 = NULL;
+    return 0;
 }
 
 /**
@@ -755,13 +867,21 @@ static bool vo_w32_is_cursor_in_client(struct vo *vo)
     return SendMessage(vo->w32->window, WM_NCHITTEST, 0, pos) == HTCLIENT;
 }
 
-int vo_w32_control(struct vo *vo, int *events, int request, void *arg)
+struct voctrl_call {
+    int request;
+    void *arg;
+    int *events;
+};
+
+// Runs on the window thread (see vo_w32_control()).
+static int gui_control(struct vo *vo, void *ptr)
 {
+    struct voctrl_call *call = ptr;
     struct vo_w32_state *w32 = vo->w32;
+    int request = call->request;
+    void *arg = call->arg;
+    int *events = call->events;
     switch (request) {
-    case VOCTRL_CHECK_EVENTS:
-        *events |= vo_w32_check_events(vo);
-        return VO_TRUE;
     case VOCTRL_FULLSCREEN:
         vo_w32_fullscreen(vo);
         *events |= VO_EVENT_RESIZE;
@@ -827,6 +947,17 @@ int vo_w32_control(struct vo *vo, int *events, int request, void *arg)
     return VO_NOTIMPL;
 }
 
+int vo_w32_control(struct vo *vo, int *events, int request, void *arg)
+{
+    if (request == VOCTRL_CHECK_EVENTS) {
+        *events |= vo_w32_check_events(vo);
+        return VO_TRUE;
+    }
+    // Everything else manipulates state owned by the window thread.
+    struct voctrl_call call = {request, arg, events};
+    return run_on_gui_thread(vo, gui_control, &call);
+}
+
 /**
  * \brief Uninitialize w32_common framework.
  *
@@ -834,15 +965,26 @@ int vo_w32_control(struct vo *vo, int *events, int request, void *arg)
  * anything built on top of the created window e.g. rendering context inside
  * and call vo_w32_uninit at the end.
  */
+// Runs on the window thread; WM_DESTROY makes the message loop exit.
+static int gui_terminate(struct vo *vo, void *arg)
+{
+    SetThreadExecutionState(ES_CONTINUOUS);
+    DestroyWindow(vo->w32->window);
+    return 0;
+}
+
 void vo_w32_uninit(struct vo *vo)
 {
     struct vo_w32_state *w32 = vo->w32;
     MP_VERBOSE(vo, "win32: uninit\n");
     if (!w32)
         return;
-    SetThreadExecutionState(ES_CONTINUOUS);
-    DestroyWindow(w32->window);
-    UnregisterClassW(classname, 0);
+    if (w32->window)
+        run_on_gui_thread(vo, gui_terminate, NULL);
+    if (w32->thread_valid)
+        pthread_join(w32->thread, NULL);
+    pthread_cond_destroy(&w32->wakeup);
+    pthread_mutex_destroy(&w32->lock);
     talloc_free(w32);
     vo->w32 = NULL;
 }
@@ -21,11 +21,29 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include <windows.h>
 
 struct vo_w32_state {
     HWND window;
 
+    // The win32 message loop runs on this thread, so that modal operations
+    // (window dragging, menus) don't block the VO.
+    pthread_t thread;
+    bool thread_valid;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+
+    // --- The following fields are protected by lock.
+    bool init_done;      // window creation finished (window set on success)
+    int pending_events;  // VO_EVENT_* accumulated for vo_w32_check_events()
+    int new_dwidth;      // client size as of the last WM_SIZE
+    int new_dheight;
+
+    // --- The remaining fields are owned by the window thread, or are only
+    //     accessed while it executes a synchronous call for the VO.
+
     // last non-fullscreen extends (updated only on fullscreen or on initialization)
     int prev_width;
     int prev_height;
@@ -46,7 +64,6 @@ struct vo_w32_state {
 
     bool disable_screensaver;
     bool cursor_visible;
-    int event_flags;
     int mon_cnt;
     int mon_id;
 
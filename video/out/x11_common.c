@@ -762,7 +762,14 @@ int vo_x11_check_events(struct vo *vo)
         case ConfigureNotify:
             if (x11->window == None)
                 break;
-            vo_x11_update_geometry(vo);
+            // The event carries the new size; cache it right away, but defer
+            // querying the position (a server round trip) until the event
+            // queue has been drained - window drags deliver these in bursts.
+            if (Event.xconfigure.width > 0 && Event.xconfigure.height > 0) {
+                x11->win_width = Event.xconfigure.width;
+                x11->win_height = Event.xconfigure.height;
+            }
+            x11->pending_geometry_change = true;
             break;
         case KeyPress: {
             char buf[100];
@@ -845,6 +852,11 @@ int vo_x11_check_events(struct vo *vo)
         }
     }
 
+    if (x11->pending_geometry_change) {
+        x11->pending_geometry_change = false;
+        vo_x11_update_geometry(vo);
+    }
+
     update_vo_size(vo);
     if (vo->opts->WinID >= 0 && (x11->pending_vo_events & VO_EVENT_RESIZE)) {
         int x = x11->win_x, y = x11->win_y;
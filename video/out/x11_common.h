@@ -69,6 +69,10 @@ struct vo_x11_state {
 
     int pending_vo_events;
 
+    // ConfigureNotify was received; the window position must be re-read from
+    // the server (a round trip), which is coalesced to once per event batch.
+    bool pending_geometry_change;
+
     // last non-fullscreen extends (updated on fullscreen or reinitialization)
     int nofs_width;
     int nofs_height;
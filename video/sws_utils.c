@@ -17,6 +17,7 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 
 #include <libswscale/swscale.h>
 #include <libavcodec/avcodec.h>
@@ -27,13 +28,20 @@
 #include "sws_utils.h"
 
 #include "common/common.h"
+#include "osdep/numcores.h"
 #include "video/mp_image.h"
 #include "video/img_format.h"
+#include "video/out/dither.h"
 #include "fmt-conversion.h"
 #include "csputils.h"
 #include "common/msg.h"
 #include "video/filter/vf.h"
 
+#define MAX_SWS_THREADS 16
+// Images with fewer output pixels than this are scaled on the caller's
+// thread; below that the sliced path doesn't win anything.
+#define MIN_SLICE_PIXELS (1920 * 1080)
+
 //global sws_flags from the command line
 int sws_flags = 2;
 
@@ -140,23 +148,35 @@ static int to_gbrp(struct mp_image *dst, struct mp_image *src,
     return 0;
 }
 
+static bool params_equal(struct mp_sws_context *a, struct mp_sws_context *b)
+{
+    return mp_image_params_equals(&a->src, &b->src) &&
+           mp_image_params_equals(&a->dst, &b->dst) &&
+           a->flags == b->flags &&
+           a->brightness == b->brightness &&
+           a->contrast == b->contrast &&
+           a->saturation == b->saturation;
+}
+
 static bool cache_valid(struct mp_sws_context *ctx)
 {
-    struct mp_sws_context *old = ctx->cached;
-    if (ctx->force_reload)
-        return false;
-    return mp_image_params_equals(&ctx->src, &old->src) &&
-           mp_image_params_equals(&ctx->dst, &old->dst) &&
-           ctx->flags == old->flags &&
-           ctx->brightness == old->brightness &&
-           ctx->contrast == old->contrast &&
-           ctx->saturation == old->saturation;
+    return !ctx->force_reload && params_equal(ctx, ctx->cached);
+}
+
+static void free_retained(struct mp_sws_context *ctx)
+{
+    for (int n = 0; n < MP_ARRAY_SIZE(ctx->retained); n++) {
+        sws_freeContext(ctx->retained[n].sws);
+        talloc_free(ctx->retained[n].params);
+        ctx->retained[n] = (struct mp_sws_retained) {0};
+    }
 }
 
 static void free_mp_sws(void *p)
 {
     struct mp_sws_context *ctx = p;
     sws_freeContext(ctx->sws);
+    free_retained(ctx);
     sws_freeFilter(ctx->src_filter);
     sws_freeFilter(ctx->dst_filter);
 }
@@ -193,7 +213,41 @@ int mp_sws_reinit(struct mp_sws_context *ctx)
     if (cache_valid(ctx))
         return 0;
 
-    sws_freeContext(ctx->sws);
+    if (ctx->force_reload) {
+        // Filters or params may have changed; retained contexts don't record
+        // those, so they can't be trusted anymore.
+        free_retained(ctx);
+    } else {
+        // A recently retired context may have been initialized with exactly
+        // the requested parameters (alternating between two configurations).
+        for (int n = 0; n < MP_ARRAY_SIZE(ctx->retained); n++) {
+            struct mp_sws_retained *r = &ctx->retained[n];
+            if (r->sws && params_equal(ctx, r->params)) {
+                // Swap, so the current context stays available for reuse.
+                struct SwsContext *sws = r->sws;
+                struct mp_sws_context params = *r->params;
+                r->sws = ctx->sws;
+                *r->params = *ctx->cached;
+                ctx->sws = sws;
+                *ctx->cached = params;
+                return 1;
+            }
+        }
+    }
+
+    // Retire the old context instead of freeing it; drop the oldest entry.
+    if (ctx->sws) {
+        int last = MP_ARRAY_SIZE(ctx->retained) - 1;
+        sws_freeContext(ctx->retained[last].sws);
+        struct mp_sws_context *params = ctx->retained[last].params;
+        if (!params)
+            params = talloc_zero(ctx, struct mp_sws_context);
+        for (int n = last; n > 0; n--)
+            ctx->retained[n] = ctx->retained[n - 1];
+        *params = *ctx->cached;
+        ctx->retained[0] = (struct mp_sws_retained) {ctx->sws, params};
+        ctx->sws = NULL;
+    }
     ctx->sws = sws_alloc_context();
     if (!ctx->sws)
         return -1;
@@ -267,6 +321,205 @@ int mp_sws_reinit(struct mp_sws_context *ctx)
     return 1;
 }
 
+struct slice_job {
+    struct mp_sws_context *sws;
+    struct mp_image src, dst;       // band views into the real images
+    int r;
+};
+
+static void *run_slice_job(void *p)
+{
+    struct slice_job *job = p;
+    job->r = mp_sws_scale(job->sws, &job->dst, &job->src);
+    return NULL;
+}
+
+// Number of threads to use for this conversion (1 = no threading).
+static int slice_threads(struct mp_sws_context *ctx, struct mp_image *dst,
+                         struct mp_image *src)
+{
+    if (ctx->num_threads == 1)
+        return 1;
+    // Vertical scaling would need filter taps across the band boundaries;
+    // restrict the sliced path to pure conversions (and horizontal scaling),
+    // where the bands are fully independent. Same for custom filters.
+    if (src->h != dst->h || ctx->src_filter || ctx->dst_filter)
+        return 1;
+    if (dst->w * dst->h < MIN_SLICE_PIXELS)
+        return 1;
+    int threads = ctx->num_threads ? ctx->num_threads : default_thread_count();
+    threads = MPCLAMP(threads, 1, MAX_SWS_THREADS);
+    // Band boundaries must not split chroma rows.
+    int align = MPMAX(src->fmt.align_y, dst->fmt.align_y);
+    return MPCLAMP(threads, 1, MPMAX(1, dst->h / align));
+}
+
+static int scale_sliced(struct mp_sws_context *ctx, struct mp_image *dst,
+                        struct mp_image *src, int threads)
+{
+    if (!ctx->slice_ctx)
+        ctx->slice_ctx = talloc_zero_array(ctx, struct mp_sws_context *,
+                                           MAX_SWS_THREADS);
+
+    int align = MPMAX(src->fmt.align_y, dst->fmt.align_y);
+    struct slice_job jobs[MAX_SWS_THREADS];
+    int num_jobs = 0;
+    int y = 0;
+    for (int n = 0; n < threads; n++) {
+        int y1 = n == threads - 1 ? dst->h
+                                  : (dst->h * (n + 1) / threads) & ~(align - 1);
+        if (y1 <= y)
+            continue;
+        if (!ctx->slice_ctx[num_jobs])
+            ctx->slice_ctx[num_jobs] = mp_sws_alloc(ctx->slice_ctx);
+        struct mp_sws_context *sws = ctx->slice_ctx[num_jobs];
+        sws->flags = ctx->flags;
+        sws->brightness = ctx->brightness;
+        sws->contrast = ctx->contrast;
+        sws->saturation = ctx->saturation;
+        sws->params[0] = ctx->params[0];
+        sws->params[1] = ctx->params[1];
+        sws->num_threads = 1;       // never recurse
+        struct slice_job *job = &jobs[num_jobs++];
+        job->sws = sws;
+        job->src = *src;
+        job->dst = *dst;
+        mp_image_crop(&job->src, 0, y, src->w, y1);
+        mp_image_crop(&job->dst, 0, y, dst->w, y1);
+        y = y1;
+    }
+
+    bool threaded[MAX_SWS_THREADS];
+    pthread_t pth[MAX_SWS_THREADS];
+    for (int n = 1; n < num_jobs; n++)
+        threaded[n] = pthread_create(&pth[n], NULL, run_slice_job, &jobs[n]) == 0;
+    run_slice_job(&jobs[0]);
+    int r = jobs[0].r;
+    for (int n = 1; n < num_jobs; n++) {
+        if (threaded[n]) {
+            pthread_join(pth[n], NULL);
+        } else {
+            run_slice_job(&jobs[n]);
+        }
+        r = MPMIN(r, jobs[n].r);
+    }
+    return r;
+}
+
+#define DITHER_SIZE 8
+
+// Check whether the conversion is a pure bit depth reduction of a planar
+// YUV format (e.g. 10 bit decode to an 8 bit display path), which is done
+// with a dedicated dither-down kernel instead of going through libswscale.
+static bool can_dither_down(struct mp_sws_context *ctx, struct mp_image *dst,
+                            struct mp_image *src)
+{
+    if (ctx->src_filter || ctx->dst_filter || ctx->brightness != 0 ||
+        ctx->contrast != (1 << 16) || ctx->saturation != (1 << 16))
+        return false;
+    if (src->w != dst->w || src->h != dst->h)
+        return false;
+    struct mp_imgfmt_desc *s = &src->fmt, *d = &dst->fmt;
+    if (!(s->flags & MP_IMGFLAG_YUV_P) || !(d->flags & MP_IMGFLAG_YUV_P) ||
+        !(s->flags & MP_IMGFLAG_NE) || !(d->flags & MP_IMGFLAG_NE))
+        return false;
+    if (s->num_planes != d->num_planes ||
+        s->chroma_xs != d->chroma_xs || s->chroma_ys != d->chroma_ys)
+        return false;
+    if (d->plane_bits != 8 || d->bytes[0] != 1 ||
+        s->plane_bits <= 8 || s->plane_bits > 16 || s->bytes[0] != 2)
+        return false;
+    // Must be a pure requantization - no color conversion.
+    if (src->colorspace != dst->colorspace || src->levels != dst->levels)
+        return false;
+    return true;
+}
+
+struct dither_job {
+    struct mp_image src, dst;       // band views into the real images
+    const unsigned char *matrix;
+    int y_start;                    // absolute luma row of the band
+};
+
+static void dither_down_band(struct dither_job *job)
+{
+    struct mp_image *src = &job->src, *dst = &job->dst;
+    int shift = src->fmt.plane_bits - 8;
+    for (int p = 0; p < dst->num_planes; p++) {
+        int w = dst->plane_w[p];
+        int h = dst->plane_h[p];
+        int py0 = job->y_start >> dst->fmt.ys[p];
+        for (int y = 0; y < h; y++) {
+            const uint16_t *s = (const uint16_t *)
+                (src->planes[p] + y * (intptr_t)src->stride[p]);
+            uint8_t *d = dst->planes[p] + y * (intptr_t)dst->stride[p];
+            const unsigned char *m =
+                &job->matrix[((py0 + y) & (DITHER_SIZE - 1)) * DITHER_SIZE];
+            // The matrix has thresholds 0-255; rescale them to the number of
+            // source bits that are dropped.
+            int bias[DITHER_SIZE];
+            for (int x = 0; x < DITHER_SIZE; x++)
+                bias[x] = m[x] >> (8 - shift);
+            for (int x = 0; x < w; x++) {
+                unsigned int v = (s[x] + bias[x & (DITHER_SIZE - 1)]) >> shift;
+                d[x] = MPMIN(v, 255);
+            }
+        }
+    }
+}
+
+static void *run_dither_job(void *p)
+{
+    dither_down_band(p);
+    return NULL;
+}
+
+// Bit depth reduction with ordered dither, threaded by slice. The bands use
+// absolute row numbers to index the dither matrix, so the sliced result is
+// identical to the unthreaded one.
+static int dither_down(struct mp_sws_context *ctx, struct mp_image *dst,
+                       struct mp_image *src, int threads)
+{
+    if (!ctx->dither_matrix) {
+        ctx->dither_matrix = talloc_array(ctx, unsigned char,
+                                          DITHER_SIZE * DITHER_SIZE);
+        mp_make_ordered_dither_matrix(ctx->dither_matrix, DITHER_SIZE);
+    }
+
+    int align = MPMAX(src->fmt.align_y, dst->fmt.align_y);
+    struct dither_job jobs[MAX_SWS_THREADS];
+    int num_jobs = 0;
+    int y = 0;
+    for (int n = 0; n < threads; n++) {
+        int y1 = n == threads - 1 ? dst->h
+                                  : (dst->h * (n + 1) / threads) & ~(align - 1);
+        if (y1 <= y)
+            continue;
+        struct dither_job *job = &jobs[num_jobs++];
+        job->src = *src;
+        job->dst = *dst;
+        job->matrix = ctx->dither_matrix;
+        job->y_start = y;
+        mp_image_crop(&job->src, 0, y, src->w, y1);
+        mp_image_crop(&job->dst, 0, y, dst->w, y1);
+        y = y1;
+    }
+
+    bool threaded[MAX_SWS_THREADS];
+    pthread_t pth[MAX_SWS_THREADS];
+    for (int n = 1; n < num_jobs; n++)
+        threaded[n] = pthread_create(&pth[n], NULL, run_dither_job, &jobs[n]) == 0;
+    dither_down_band(&jobs[0]);
+    for (int n = 1; n < num_jobs; n++) {
+        if (threaded[n]) {
+            pthread_join(pth[n], NULL);
+        } else {
+            dither_down_band(&jobs[n]);
+        }
+    }
+    return 0;
+}
+
 // Scale from src to dst - if src/dst have different parameters from previous
 // calls, the context is reinitialized. Return error code. (It can fail if
 // reinitialization was necessary, and swscale returned an error.)
@@ -278,6 +531,15 @@ int mp_sws_scale(struct mp_sws_context *ctx, struct mp_image *dst,
     if (dst->imgfmt == IMGFMT_GBRP && !sws_isSupportedOutput(AV_PIX_FMT_GBRP))
         return to_gbrp(dst, src, ctx->flags);
 
+    // Requantizing e.g. 10 bit video for an 8 bit display path doesn't need
+    // the generic (and much more expensive) libswscale machinery.
+    if (can_dither_down(ctx, dst, src))
+        return dither_down(ctx, dst, src, slice_threads(ctx, dst, src));
+
+    int threads = slice_threads(ctx, dst, src);
+    if (threads > 1)
+        return scale_sliced(ctx, dst, src, threads);
+
     mp_image_params_from_image(&ctx->src, src);
     mp_image_params_from_image(&ctx->dst, dst);
 
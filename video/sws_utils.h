@@ -29,6 +29,9 @@ struct mp_sws_context {
     // mp_sws_scale() will handle the changes transparently.
     int flags;
     int brightness, contrast, saturation;
+    // Number of threads for slice-parallel scaling of large images.
+    // 0 means determine automatically, 1 disables threading.
+    int num_threads;
     bool force_reload;
     // These are also implicitly set by mp_sws_scale(), and thus optional.
     // Setting them before that call makes sense when using mp_sws_reinit().
@@ -45,6 +48,20 @@ struct mp_sws_context {
 
     // Contains parameters for which sws is valid
     struct mp_sws_context *cached;
+
+    // Recently retired contexts, kept so that alternating between a small
+    // number of configurations (e.g. two window sizes) never reinitializes.
+    struct mp_sws_retained {
+        struct SwsContext *sws;
+        struct mp_sws_context *params; // parameters sws was initialized with
+    } retained[2];
+
+    // Per-thread contexts for slice-parallel scaling (created on demand)
+    struct mp_sws_context **slice_ctx;
+
+    // Ordered dither matrix for the bit depth reduction fast path (created
+    // on demand)
+    unsigned char *dither_matrix;
 };
 
 struct mp_sws_context *mp_sws_alloc(void *talloc_ctx);
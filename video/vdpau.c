@@ -283,3 +283,34 @@ bool mp_vdpau_get_format(int imgfmt, VdpChromaType *out_chroma_type,
         *out_pixel_format = ycbcr;
     return true;
 }
+
+// Read the decoded video surface back into a software image (4:2:0 only,
+// which covers everything the decoder produces). Returns a new image on
+// success, NULL on failure.
+struct mp_image *mp_vdpau_download_video_surface(struct mp_vdpau_ctx *ctx,
+                                                 struct mp_image *hw_image)
+{
+    struct vdp_functions *vdp = ctx->vdp;
+    VdpStatus vdp_st;
+
+    if (!hw_image || !IMGFMT_IS_VDPAU(hw_image->imgfmt))
+        return NULL;
+    VdpVideoSurface surface = (intptr_t)hw_image->planes[3];
+
+    struct mp_image *res = mp_image_alloc(IMGFMT_420P, hw_image->w,
+                                          hw_image->h);
+    // VDP_YCBCR_FORMAT_YV12 expects planes in Y, V, U order.
+    void *planes[3] = {res->planes[0], res->planes[2], res->planes[1]};
+    uint32_t pitches[3] = {res->stride[0], res->stride[2], res->stride[1]};
+    vdp_st = vdp->video_surface_get_bits_y_cb_cr(surface,
+                                                 VDP_YCBCR_FORMAT_YV12,
+                                                 planes, pitches);
+    if (vdp_st != VDP_STATUS_OK) {
+        mp_msg(MSGT_VO, MSGL_ERR, "[vdpau] Error reading video surface: %s\n",
+               vdp->get_error_string(vdp_st));
+        talloc_free(res);
+        return NULL;
+    }
+    mp_image_copy_attributes(res, hw_image);
+    return res;
+}
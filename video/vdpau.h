@@ -71,4 +71,7 @@ struct mp_image *mp_vdpau_get_video_surface(struct mp_vdpau_ctx *ctx, int fmt,
 bool mp_vdpau_get_format(int imgfmt, VdpChromaType *out_chroma_type,
                          VdpYCbCrFormat *out_pixel_format);
 
+struct mp_image *mp_vdpau_download_video_surface(struct mp_vdpau_ctx *ctx,
+                                                 struct mp_image *hw_image);
+
 #endif
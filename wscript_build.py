@@ -193,6 +193,7 @@ def build(ctx):
         ( "demux/demux_subreader.c" ),
         ( "demux/ebml.c" ),
         ( "demux/mf.c" ),
+        ( "demux/packet_pool.c" ),
 
         ## Input
         ( "input/input.c" ),
@@ -200,8 +201,10 @@ def build(ctx):
         ( "input/lirc.c",                        "lirc" ),
 
         ## Misc
+        ( "misc/intern.c" ),
         ( "misc/ring.c" ),
         ( "misc/charset_conv.c" ),
+        ( "misc/thread_pool.c" ),
 
         ## Options
         ( "options/m_config.c" ),
@@ -260,6 +263,7 @@ def build(ctx):
         ( "stream/stream_rar.c" ),
         ( "stream/stream_smb.c",                 "libsmbclient" ),
         ( "stream/stream_tv.c",                  "tv" ),
+        ( "stream/stream_udp.c",                 "recvmmsg" ),
         ( "stream/stream_vcd.c",                 "vcd" ),
         ( "stream/tv.c",                         "tv" ),
         ( "stream/tvi_dummy.c",                  "tv" ),
@@ -291,6 +295,7 @@ def build(ctx):
         ( "video/fmt-conversion.c" ),
         ( "video/image_writer.c" ),
         ( "video/img_format.c" ),
+        ( "video/memcpy_pic.c" ),
         ( "video/mp_image.c" ),
         ( "video/mp_image_pool.c" ),
         ( "video/sws_utils.c" ),
@@ -344,6 +349,7 @@ def build(ctx):
         ( "video/out/filter_kernels.c" ),
         ( "video/out/gl_cocoa.c",                "gl-cocoa" ),
         ( "video/out/gl_common.c",               "gl" ),
+        ( "video/out/gl_hwdec_vaegl.c",          "vaapi-egl" ),
         ( "video/out/gl_hwdec_vaglx.c",          "vaapi-glx" ),
         ( "video/out/gl_hwdec_vda.c",            "vda-gl" ),
         ( "video/out/gl_hwdec_vdpau.c",          "vdpau-gl-x11" ),